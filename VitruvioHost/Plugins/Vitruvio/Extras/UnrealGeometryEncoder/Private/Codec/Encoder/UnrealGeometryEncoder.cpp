@@ -33,11 +33,15 @@
 #pragma warning(pop)
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cwchar>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 namespace
@@ -74,6 +78,25 @@ struct SerializedGeometry
 	}
 };
 
+struct SerializedMeshV2
+{
+	std::vector<float> positions;
+	std::vector<float> normals;
+	std::vector<std::vector<float>> uvs;
+	std::vector<const float*> uvPtrs;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> triangleRanges;
+
+	// scratch buffers of serializeGeometryV2: the vertex index per vertex key and the source indices of each vertex of the current mesh
+	std::unordered_map<uint64_t, uint32_t> vertexIndexByKey;
+	std::vector<uint32_t> vertexKeys;
+
+	size_t getVertexCount() const
+	{
+		return positions.size() / 3;
+	}
+};
+
 using AttributeMapNOPtrVector = std::vector<const prt::AttributeMap*>;
 
 struct AttributeMapNOPtrVectorOwner
@@ -179,7 +202,7 @@ std::wstring uriToPath(const prtx::TexturePtr& t)
 
 // we blacklist all CGA-style material attribute keys, see prtx/Material.h
 // clang-format off
-	const std::set<std::wstring> MATERIAL_ATTRIBUTE_BLACKLIST = {
+	constexpr const wchar_t* MATERIAL_ATTRIBUTE_BLACKLIST[] = {
 		L"ambient.b",
 		L"ambient.g",
 		L"ambient.r",
@@ -257,13 +280,46 @@ std::wstring uriToPath(const prtx::TexturePtr& t)
 	};
 // clang-format on
 
+// filters keys by their first character and length before comparing them to the blacklisted keys, most keys of a material are accepted
+// or rejected without a string comparison
+class MaterialAttributeFilter
+{
+public:
+	MaterialAttributeFilter()
+	{
+		for (const wchar_t* key : MATERIAL_ATTRIBUTE_BLACKLIST)
+		{
+			assert(static_cast<uint32_t>(key[0]) < 128);
+			mKeysByFirstChar[key[0]].emplace_back(key, std::wcslen(key));
+		}
+	}
+
+	bool isBlacklisted(const std::wstring& key) const
+	{
+		if (key.empty() || static_cast<uint32_t>(key[0]) >= 128)
+			return false;
+
+		for (const auto& [blacklistedKey, length] : mKeysByFirstChar[key[0]])
+		{
+			if (key.size() == length && std::wmemcmp(key.data(), blacklistedKey, length) == 0)
+				return true;
+		}
+		return false;
+	}
+
+private:
+	std::vector<std::pair<const wchar_t*, size_t>> mKeysByFirstChar[128];
+};
+
+const MaterialAttributeFilter MATERIAL_ATTRIBUTE_FILTER;
+
 void convertMaterialToAttributeMap(prtx::PRTUtils::AttributeMapBuilderPtr& aBuilder, const prtx::Material& prtxAttr, const prtx::WStringVector& keys)
 {
 	if (DBG)
 		log_debug(L"-- converting material: %1%") % prtxAttr.name();
 	for (const auto& key : keys)
 	{
-		if (MATERIAL_ATTRIBUTE_BLACKLIST.count(key) > 0)
+		if (MATERIAL_ATTRIBUTE_FILTER.isBlacklisted(key))
 			continue;
 
 		if (DBG)
@@ -520,43 +576,240 @@ SerializedGeometry serializeGeometry(const prtx::GeometryPtrVector& geometries,
 	return sg;
 }
 
-void encodeMesh(IUnrealCallbacks* cb, const SerializedGeometry& sg, wchar_t const* name, wchar_t const* meshId, int32_t prototypeIndex, const std::wstring& uri,
-				prtx::GeometryPtrVector geometries, std::vector<prtx::MaterialPtrVector> materials)
+constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+// a split vertex is identified by its position, normal and uv indices. The key packs the position and normal index if there are no uv sets
+// and hashes all indices otherwise, collisions are resolved by comparing the indices of the emitted vertex and probing the next key.
+uint64_t getVertexKey(const std::vector<uint32_t>& indices)
+{
+	if (indices.size() == 2)
+		return (static_cast<uint64_t>(indices[0]) << 32) | indices[1];
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const uint32_t index : indices)
+	{
+		hash = (hash ^ index) * 0x9e3779b97f4a7c15ull;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+void writeCoords(float* target, const prtx::DoubleVector& source, uint32_t index, size_t dimension)
+{
+	for (size_t d = 0; d < dimension; d++)
+	{
+		const size_t sourceIndex = static_cast<size_t>(index) * dimension + d;
+		target[d] = index != NO_INDEX && sourceIndex < source.size() ? static_cast<float>(source[sourceIndex]) : 0.0f;
+	}
+}
+
+// serializes triangulated geometry into the UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2 layout by splitting vertices with differing attribute indices
+void serializeGeometryV2(const prtx::GeometryPtrVector& geometries, const std::vector<prtx::MaterialPtrVector>& materials, SerializedMeshV2& sm)
+{
+	// uv sets are emitted like in serializeGeometry: up to the highest set required by any mesh or material, sets which are empty for all
+	// meshes are left out and missing sets fall back to uv set 0
+	uint32_t maxNumUVSets = 0;
+	std::vector<bool> isUVSetEmptyVector(10, true);
+	size_t cornerCount = 0;
+	size_t triangleCount = 0;
+	size_t meshCount = 0;
+	auto matsIt = materials.cbegin();
+	for (const auto& geo : geometries)
+	{
+		auto matIt = matsIt->cbegin();
+		for (const auto& mesh : geo->getMeshes())
+		{
+			maxNumUVSets = std::max(maxNumUVSets, std::max(mesh->getUVSetsCount(), scanValidTextures(*matIt)));
+			for (uint32_t uvSet = 0; uvSet < mesh->getUVSetsCount(); uvSet++)
+			{
+				if (!mesh->getUVCoords(uvSet).empty())
+					isUVSetEmptyVector[uvSet] = false;
+			}
+			for (uint32_t fi = 0, faceCount = mesh->getFaceCount(); fi < faceCount; ++fi)
+			{
+				const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
+				cornerCount += vtxCnt;
+				triangleCount += vtxCnt > 2 ? vtxCnt - 2 : 0;
+			}
+			++meshCount;
+			++matIt;
+		}
+		++matsIt;
+	}
+
+	// the buffers are sized for one vertex per corner and written in place, then shrunk to the emitted vertices. Shrinking keeps the
+	// capacity, so later meshes serialized into the same arena do not allocate.
+	sm.positions.resize(3 * cornerCount);
+	sm.normals.resize(3 * cornerCount);
+	sm.uvs.resize(maxNumUVSets);
+	for (uint32_t uvSet = 0; uvSet < maxNumUVSets; uvSet++)
+		sm.uvs[uvSet].resize(isUVSetEmptyVector[uvSet] ? 0 : 2 * cornerCount);
+	sm.indices.resize(3 * triangleCount);
+	sm.triangleRanges.resize(meshCount);
+
+	const size_t keySize = 2 + maxNumUVSets;
+	std::vector<uint32_t> key(keySize);
+	std::vector<uint32_t> cornerIndices;
+	uint32_t* indices = sm.indices.data();
+	uint32_t* triangleRanges = sm.triangleRanges.data();
+	uint32_t vertexCount = 0;
+	for (const auto& geo : geometries)
+	{
+		for (const auto& mesh : geo->getMeshes())
+		{
+			// indices are local to a mesh, so split vertices are only shared within a mesh
+			sm.vertexIndexByKey.clear();
+			sm.vertexKeys.clear();
+			const uint32_t meshVertexBase = vertexCount;
+
+			const prtx::DoubleVector& verts = mesh->getVertexCoords();
+			const prtx::DoubleVector& norms = mesh->getVertexNormalsCoords();
+
+			// source uv set per emitted uv set or NO_INDEX if the mesh has no uvs for it
+			const uint32_t numUVSets = mesh->getUVSetsCount();
+			std::vector<uint32_t> srcUVSets(maxNumUVSets, NO_INDEX);
+			std::vector<prtx::IndexVector> srcFaceUVCounts(maxNumUVSets);
+			for (uint32_t uvSet = 0; uvSet < maxNumUVSets; uvSet++)
+			{
+				const uint32_t srcUVSet = (uvSet < numUVSets && !mesh->getUVCoords(uvSet).empty()) ? uvSet : 0;
+				if (isUVSetEmptyVector[uvSet] || srcUVSet >= numUVSets || mesh->getUVCoords(srcUVSet).empty())
+					continue;
+				srcUVSets[uvSet] = srcUVSet;
+				srcFaceUVCounts[uvSet] = mesh->getFaceUVCounts(srcUVSet);
+			}
+
+			uint32_t meshTriangleCount = 0;
+			for (uint32_t fi = 0, faceCount = mesh->getFaceCount(); fi < faceCount; ++fi)
+			{
+				const uint32_t vtxCnt = mesh->getFaceVertexCount(fi);
+				const uint32_t* vtxIdx = mesh->getFaceVertexIndices(fi);
+				const uint32_t* nrmIdx = mesh->getFaceVertexNormalIndices(fi);
+				const size_t nrmCnt = mesh->getFaceVertexNormalCount(fi);
+
+				cornerIndices.clear();
+				for (uint32_t vi = 0; vi < vtxCnt; vi++)
+				{
+					key[0] = vtxIdx[vi];
+					key[1] = nrmCnt > vi && nrmIdx != nullptr ? nrmIdx[vi] : NO_INDEX;
+					for (uint32_t uvSet = 0; uvSet < maxNumUVSets; uvSet++)
+					{
+						const bool hasUVs = srcUVSets[uvSet] != NO_INDEX && srcFaceUVCounts[uvSet][fi] > vi;
+						key[2 + uvSet] = hasUVs ? mesh->getFaceUVIndices(fi, srcUVSets[uvSet])[vi] : NO_INDEX;
+					}
+
+					uint32_t vertexIndex = NO_INDEX;
+					for (uint64_t vertexKey = getVertexKey(key); vertexIndex == NO_INDEX; ++vertexKey)
+					{
+						const auto [it, inserted] = sm.vertexIndexByKey.emplace(vertexKey, vertexCount);
+						if (inserted)
+						{
+							vertexIndex = vertexCount++;
+							sm.vertexKeys.insert(sm.vertexKeys.end(), key.begin(), key.end());
+
+							writeCoords(&sm.positions[3 * vertexIndex], verts, key[0], 3);
+							writeCoords(&sm.normals[3 * vertexIndex], norms, key[1], 3);
+							for (uint32_t uvSet = 0; uvSet < maxNumUVSets; uvSet++)
+							{
+								if (isUVSetEmptyVector[uvSet])
+									continue;
+								const uint32_t srcUVSet = srcUVSets[uvSet];
+								writeCoords(&sm.uvs[uvSet][2 * vertexIndex], srcUVSet != NO_INDEX ? mesh->getUVCoords(srcUVSet) : EMPTY_UVS,
+											key[2 + uvSet], 2);
+							}
+						}
+						else if (std::equal(key.begin(), key.end(), sm.vertexKeys.begin() + (it->second - meshVertexBase) * keySize))
+						{
+							vertexIndex = it->second;
+						}
+					}
+					cornerIndices.push_back(vertexIndex);
+				}
+
+				// faces are triangulated by the encode preparator, the fan only covers faces which it left untouched
+				for (uint32_t vi = 1; vi + 1 < vtxCnt; vi++)
+				{
+					*indices++ = cornerIndices[0];
+					*indices++ = cornerIndices[vi];
+					*indices++ = cornerIndices[vi + 1];
+					++meshTriangleCount;
+				}
+			}
+
+			*triangleRanges++ = meshTriangleCount;
+		} // for all meshes
+	}	  // for all geometries
+
+	sm.positions.resize(3 * static_cast<size_t>(vertexCount));
+	sm.normals.resize(3 * static_cast<size_t>(vertexCount));
+	for (uint32_t uvSet = 0; uvSet < maxNumUVSets; uvSet++)
+	{
+		if (!isUVSetEmptyVector[uvSet])
+			sm.uvs[uvSet].resize(2 * static_cast<size_t>(vertexCount));
+	}
+}
+
+void encodeMesh(IUnrealCallbacks* cb, int32_t initialShapeIndex, const SerializedGeometry& sg, wchar_t const* name, wchar_t const* meshId, int32_t prototypeIndex, const std::wstring& uri,
+				const prtx::GeometryPtrVector& geometries, AttributeMapNOPtrVector& matAttrMaps)
 {
 	auto puvs = toPtrVec(sg.uvs);
 	auto puvCounts = toPtrVec(sg.uvCounts);
 	auto puvIndices = toPtrVec(sg.uvIndices);
 
 	std::vector<uint32_t> faceRanges;
-	AttributeMapNOPtrVectorOwner matAttrMaps;
-
-	auto matIt = materials.cbegin();
-	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
 	for (const auto& geo : geometries)
 	{
-		const prtx::MeshPtrVector& meshes = geo->getMeshes();
+		for (const auto& m : geo->getMeshes())
+			faceRanges.push_back(m->getFaceCount());
+	}
 
-		for (size_t mi = 0; mi < meshes.size(); mi++)
-		{
-			const prtx::MeshPtr& m = meshes.at(mi);
-			const prtx::MaterialPtr& mat = matIt->at(mi);
+	const prt::AttributeMap** matAttrMapsPtr = matAttrMaps.empty() ? nullptr : matAttrMaps.data();
 
-			convertMaterialToAttributeMap(amb, *(mat.get()), mat->getKeys());
-			matAttrMaps.v.push_back(amb->createAttributeMapAndReset());
-			faceRanges.push_back(m->getFaceCount());
-		}
+	// addMesh keeps its original signature so that callbacks built against older encoders still work
+	if (initialShapeIndex == UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX)
+	{
+		cb->addMesh(name, meshId, prototypeIndex, uri.c_str(), sg.coords.data(), sg.coords.size(), sg.normals.data(), sg.normals.size(),
+					sg.faceVertexCounts.data(), sg.faceVertexCounts.size(), sg.vertexIndices.data(), sg.vertexIndices.size(), sg.normalIndices.data(),
+					sg.normalIndices.size(),
+
+					puvs.first.data(), puvs.second.data(), puvCounts.first.data(), puvCounts.second.data(), puvIndices.first.data(),
+					puvIndices.second.data(), sg.uvs.size(),
 
-		++matIt;
+					faceRanges.data(), faceRanges.size(), matAttrMapsPtr);
 	}
+	else
+	{
+		cb->addInitialShapeMesh(initialShapeIndex, name, meshId, prototypeIndex, uri.c_str(), sg.coords.data(), sg.coords.size(), sg.normals.data(),
+								sg.normals.size(), sg.faceVertexCounts.data(), sg.faceVertexCounts.size(), sg.vertexIndices.data(),
+								sg.vertexIndices.size(), sg.normalIndices.data(), sg.normalIndices.size(),
 
-	cb->addMesh(name, meshId, prototypeIndex, uri.c_str(), sg.coords.data(), sg.coords.size(), sg.normals.data(), sg.normals.size(),
-				sg.faceVertexCounts.data(), sg.faceVertexCounts.size(), sg.vertexIndices.data(), sg.vertexIndices.size(), sg.normalIndices.data(),
-				sg.normalIndices.size(),
+								puvs.first.data(), puvs.second.data(), puvCounts.first.data(), puvCounts.second.data(), puvIndices.first.data(),
+								puvIndices.second.data(), sg.uvs.size(),
 
-				puvs.first.data(), puvs.second.data(), puvCounts.first.data(), puvCounts.second.data(), puvIndices.first.data(),
-				puvIndices.second.data(), sg.uvs.size(),
+								faceRanges.data(), faceRanges.size(), matAttrMapsPtr);
+	}
+}
 
-				faceRanges.data(), faceRanges.size(), matAttrMaps.v.empty() ? nullptr : matAttrMaps.v.data());
+void encodeMeshV2(IUnrealCallbacks* cb, int32_t initialShapeIndex, SerializedMeshV2& sm, UnrealMeshArena* arena, wchar_t const* name,
+				  wchar_t const* meshId, int32_t prototypeIndex, const std::wstring& uri, AttributeMapNOPtrVector& matAttrMaps)
+{
+	sm.uvPtrs.resize(sm.uvs.size());
+	for (size_t uvSet = 0; uvSet < sm.uvs.size(); uvSet++)
+		sm.uvPtrs[uvSet] = sm.uvs[uvSet].empty() ? nullptr : sm.uvs[uvSet].data();
+
+	UnrealMeshV2 mesh;
+	mesh.positions = sm.positions.data();
+	mesh.normals = sm.normals.data();
+	mesh.uvs = sm.uvPtrs.data();
+	mesh.uvSets = sm.uvPtrs.size();
+	mesh.vertexCount = sm.getVertexCount();
+	mesh.indices = sm.indices.data();
+	mesh.triangleCount = sm.indices.size() / 3;
+	mesh.triangleRanges = sm.triangleRanges.data();
+	mesh.triangleRangesSize = sm.triangleRanges.size();
+	mesh.materials = matAttrMaps.empty() ? nullptr : matAttrMaps.data();
+	mesh.arena = arena;
+
+	cb->addMeshV2(initialShapeIndex, name, meshId, prototypeIndex, uri.c_str(), mesh);
 }
 
 const prtx::PRTUtils::AttributeMapPtr convertReportToAttributeMap(const prtx::ReportsPtr& r) {
@@ -571,11 +824,111 @@ const prtx::PRTUtils::AttributeMapPtr convertReportToAttributeMap(const prtx::Re
 
 	return prtx::PRTUtils::AttributeMapPtr{amb->createAttributeMap()};
 }
+
+const prtx::EncodePreparator::PreparationFlags PREP_FLAGS =
+	prtx::EncodePreparator::PreparationFlags()
+		.instancing(true)
+		.meshMerging(prtx::MeshMerging::ALL_OF_SAME_MATERIAL_AND_TYPE)
+		.triangulate(false)
+		.processHoles(prtx::HoleProcessor::TRIANGULATE_FACES_WITH_HOLES)
+		.mergeVertices(true)
+		.cleanupVertexNormals(true)
+		.cleanupUVs(true)
+		.processVertexNormals(prtx::VertexNormalProcessor::SET_MISSING_TO_FACE_NORMALS)
+		.indexSharing(prtx::EncodePreparator::PreparationFlags::INDICES_SEPARATE_FOR_ALL_VERTEX_ATTRIBUTES);
+
+// the V2 mesh format is triangulated, vertices are split after preparation in serializeGeometryV2
+const prtx::EncodePreparator::PreparationFlags PREP_FLAGS_V2 = prtx::EncodePreparator::PreparationFlags(PREP_FLAGS).triangulate(true);
 } // namespace
 
+// the buffers of a V2 mesh, handed to the callbacks and reused for later meshes once released
+class UnrealGeometryEncoder::MeshArena final : public UnrealMeshArena
+{
+public:
+	SerializedMeshV2 mesh;
+	std::atomic<bool> inUse{false};
+
+	void release() override
+	{
+		inUse = false;
+	}
+};
+
 UnrealGeometryEncoder::UnrealGeometryEncoder(const std::wstring& id, const prt::AttributeMap* options, prt::Callbacks* callbacks)
-	: prtx::GeometryEncoder(id, options, callbacks)
+	: prtx::GeometryEncoder(id, options, callbacks), mMaterialBuilder(prt::AttributeMapBuilder::create())
+{
+}
+
+UnrealGeometryEncoder::~UnrealGeometryEncoder() = default;
+
+UnrealGeometryEncoder::MeshArena& UnrealGeometryEncoder::acquireMeshArena()
+{
+	for (const auto& arena : mMeshArenas)
+	{
+		bool expected = false;
+		if (arena->inUse.compare_exchange_strong(expected, true))
+			return *arena;
+	}
+
+	mMeshArenas.push_back(std::make_unique<MeshArena>());
+	mMeshArenas.back()->inUse = true;
+	return *mMeshArenas.back();
+}
+
+const prt::AttributeMap* UnrealGeometryEncoder::convertMaterial(const prtx::MaterialPtr& material, std::vector<const prt::AttributeMap*>& uncachedMaterials)
+{
+	const bool cacheMaterials = getOptions()->getBool(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS);
+	if (cacheMaterials)
+	{
+		const auto it = mMaterialCache.find(material);
+		if (it != mMaterialCache.end())
+		{
+			++mMaterialCacheHits;
+			return it->second.get();
+		}
+	}
+	++mMaterialConversions;
+
+	convertMaterialToAttributeMap(mMaterialBuilder, *(material.get()), material->getKeys());
+	const prt::AttributeMap* attributeMap = mMaterialBuilder->createAttributeMapAndReset();
+
+	// cached attribute maps live as long as the encoder, which allows the callbacks to identify materials by their attribute map
+	if (cacheMaterials)
+		mMaterialCache.emplace(material, prtx::PRTUtils::AttributeMapPtr(attributeMap));
+	else
+		uncachedMaterials.push_back(attributeMap);
+
+	return attributeMap;
+}
+
+bool UnrealGeometryEncoder::useMeshFormatV2() const
 {
+	return getOptions()->getInt(UNREAL_GEOMETRY_ENCODER_MESH_FORMAT) == UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2;
+}
+
+void UnrealGeometryEncoder::encodeGeometry(IUnrealCallbacks* cb, int32_t initialShapeIndex, wchar_t const* name, wchar_t const* meshId,
+										   int32_t prototypeIndex, const std::wstring& uri, const prtx::GeometryPtrVector& geometries,
+										   const std::vector<prtx::MaterialPtrVector>& materials)
+{
+	AttributeMapNOPtrVectorOwner uncachedMaterials;
+	AttributeMapNOPtrVector matAttrMaps;
+	for (const auto& mats : materials)
+	{
+		for (const auto& mat : mats)
+			matAttrMaps.push_back(convertMaterial(mat, uncachedMaterials.v));
+	}
+
+	if (useMeshFormatV2())
+	{
+		MeshArena& arena = acquireMeshArena();
+		serializeGeometryV2(geometries, materials, arena.mesh);
+		encodeMeshV2(cb, initialShapeIndex, arena.mesh, &arena, name, meshId, prototypeIndex, uri, matAttrMaps);
+	}
+	else
+	{
+		const SerializedGeometry sg = serializeGeometry(geometries, materials);
+		encodeMesh(cb, initialShapeIndex, sg, name, meshId, prototypeIndex, uri, geometries, matAttrMaps);
+	}
 }
 
 void UnrealGeometryEncoder::init(prtx::GenerateContext&)
@@ -589,6 +942,11 @@ void UnrealGeometryEncoder::init(prtx::GenerateContext&)
 	if (callbacks == nullptr)
 		throw prtx::StatusException(prt::STATUS_ILLEGAL_CALLBACK_OBJECT);
 
+	size_t cachedMeshIdsCount = 0;
+	wchar_t const* const* cachedMeshIds = getOptions()->getStringArray(UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS, &cachedMeshIdsCount);
+	if (cachedMeshIds != nullptr)
+		mCachedMeshIds.insert(cachedMeshIds, cachedMeshIds + cachedMeshIdsCount);
+
 	callbacks->init();
 }
 
@@ -598,10 +956,22 @@ void UnrealGeometryEncoder::encode(prtx::GenerateContext& context, size_t initia
 
 	IUnrealCallbacks* cb = static_cast<IUnrealCallbacks*>(getCallbacks());
 
+	// in per initial shape mode every initial shape gets its own preparator which is finalized right away
+	const bool emitPerInitialShape = getOptions()->getBool(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE);
+	const prtx::EncodePreparatorPtr encPrep =
+		emitPerInitialShape ? prtx::EncodePreparator::create(true, mNamePrep, mNsMesh, mNsMaterial) : mEncPrep;
+
 	prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
 	for (prtx::ShapePtr shape = li->getNext(); shape; shape = li->getNext())
 	{
-		mEncPrep->add(context.getCache(), shape, initialShape.getAttributeMap());
+		encPrep->add(context.getCache(), shape, initialShape.getAttributeMap());
+	}
+
+	if (emitPerInitialShape)
+	{
+		prtx::EncodePreparator::InstanceVector instances;
+		encPrep->fetchFinalizedInstances(instances, useMeshFormatV2() ? PREP_FLAGS_V2 : PREP_FLAGS);
+		convertGeometry(instances, cb, static_cast<int32_t>(initialShapeIndex));
 	}
 
 	const bool emitAttrs = getOptions()->getBool(EO_EMIT_ATTRIBUTES);
@@ -617,11 +987,10 @@ void UnrealGeometryEncoder::encode(prtx::GenerateContext& context, size_t initia
 	}
 }
 
-void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::InstanceVector& instances, IUnrealCallbacks* cb)
+void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::InstanceVector& instances, IUnrealCallbacks* cb, int32_t initialShapeIndex)
 {
 	prtx::GeometryPtrVector geometries;
 	std::vector<prtx::MaterialPtrVector> materials;
-	prtx::PRTUtils::AttributeMapBuilderPtr instanceMatAmb(prt::AttributeMapBuilder::create());
 	for (const auto& inst : instances)
 	{
 		if (inst.getPrototypeIndex() != prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX)
@@ -629,29 +998,36 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::Instan
 			const prtx::MaterialPtrVector& instMaterials = inst.getMaterials();
 			const prtx::GeometryPtr& instGeom = inst.getGeometry();
 
-			AttributeMapNOPtrVectorOwner instMaterialsAttributeMap;
+			AttributeMapNOPtrVectorOwner uncachedInstMaterials;
+			AttributeMapNOPtrVector instMaterialsAttributeMap;
 
 			InstanceIdentifier identifier = createInstanceIdentifier(inst);
 			
 			if (serializedPrototypes.find(identifier.meshId) == serializedPrototypes.end())
 			{
 				const std::wstring uri = instGeom->getURI()->wstring();
-				const SerializedGeometry sg = serializeGeometry({instGeom}, {instMaterials});
-				encodeMesh(cb, sg, identifier.name.c_str(), identifier.meshId.c_str(), inst.getPrototypeIndex(), uri, {instGeom}, {instMaterials});
+				// prototypes are shared between all initial shapes, the ones the callbacks already hold are not serialized again
+				if (mCachedMeshIds.find(identifier.meshId) != mCachedMeshIds.end())
+					cb->addCachedMesh(UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX, identifier.name.c_str(), identifier.meshId.c_str(),
+									  inst.getPrototypeIndex(), uri.c_str());
+				else
+					encodeGeometry(cb, UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX, identifier.name.c_str(), identifier.meshId.c_str(),
+								   inst.getPrototypeIndex(), uri, {instGeom}, {instMaterials});
 				serializedPrototypes.insert(identifier.meshId);
 			}
 
 			const prtx::MeshPtrVector& meshes = instGeom->getMeshes();
 			for (size_t mi = 0; mi < meshes.size(); mi++)
 			{
-				const prtx::MaterialPtr& mat = instMaterials[mi];
-
-				convertMaterialToAttributeMap(instanceMatAmb, *(mat.get()), mat->getKeys());
-				instMaterialsAttributeMap.v.push_back(instanceMatAmb->createAttributeMapAndReset());
+				instMaterialsAttributeMap.push_back(convertMaterial(instMaterials[mi], uncachedInstMaterials.v));
 			}
 
-			cb->addInstance(inst.getPrototypeIndex(), identifier.meshId.c_str(), inst.getTransformation().data(), instMaterialsAttributeMap.v.data(),
-							instMaterialsAttributeMap.v.size());
+			if (initialShapeIndex == UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX)
+				cb->addInstance(inst.getPrototypeIndex(), identifier.meshId.c_str(), inst.getTransformation().data(), instMaterialsAttributeMap.data(),
+								instMaterialsAttributeMap.size());
+			else
+				cb->addInitialShapeInstance(initialShapeIndex, inst.getPrototypeIndex(), identifier.meshId.c_str(), inst.getTransformation().data(),
+											instMaterialsAttributeMap.data(), instMaterialsAttributeMap.size());
 		}
 		else
 		{
@@ -662,8 +1038,7 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::EncodePreparator::Instan
 
 	if (geometries.size() > 0)
 	{
-		const SerializedGeometry sg = serializeGeometry(geometries, materials);
-		encodeMesh(cb, sg, L"", L"", prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX, L"", geometries, materials);
+		encodeGeometry(cb, initialShapeIndex, L"", L"", prtx::EncodePreparator::FinalizedInstance::NO_PROTOTYPE_INDEX, L"", geometries, materials);
 	}
 
 	if (DBG)
@@ -674,23 +1049,18 @@ void UnrealGeometryEncoder::finish(prtx::GenerateContext& /*context*/)
 {
 	IUnrealCallbacks* cb = static_cast<IUnrealCallbacks*>(getCallbacks());
 
-	const prtx::EncodePreparator::PreparationFlags PREP_FLAGS =
-		prtx::EncodePreparator::PreparationFlags()
-			.instancing(true)
-			.meshMerging(prtx::MeshMerging::ALL_OF_SAME_MATERIAL_AND_TYPE)
-			.triangulate(false)
-			.processHoles(prtx::HoleProcessor::TRIANGULATE_FACES_WITH_HOLES)
-			.mergeVertices(true)
-			.cleanupVertexNormals(true)
-			.cleanupUVs(true)
-			.processVertexNormals(prtx::VertexNormalProcessor::SET_MISSING_TO_FACE_NORMALS)
-			.indexSharing(prtx::EncodePreparator::PreparationFlags::INDICES_SEPARATE_FOR_ALL_VERTEX_ATTRIBUTES);
-	
-	prtx::EncodePreparator::InstanceVector instances;
-	mEncPrep->fetchFinalizedInstances(instances, PREP_FLAGS);
-	
-	convertGeometry(instances, cb);
-	
+	// in per initial shape mode the geometry has already been emitted in encode
+	if (!getOptions()->getBool(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE))
+	{
+		prtx::EncodePreparator::InstanceVector instances;
+		mEncPrep->fetchFinalizedInstances(instances, useMeshFormatV2() ? PREP_FLAGS_V2 : PREP_FLAGS);
+
+		convertGeometry(instances, cb, UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX);
+	}
+
+	if (getOptions()->getBool(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS))
+		cb->addMaterialCacheStats(mMaterialConversions, mMaterialCacheHits);
+
 	cb->finish();
 }
 
@@ -706,6 +1076,10 @@ UnrealGeometryEncoderFactory* UnrealGeometryEncoderFactory::createInstance()
 	prtx::PRTUtils::AttributeMapBuilderPtr amb(prt::AttributeMapBuilder::create());
 	amb->setBool(EO_EMIT_ATTRIBUTES, true);
 	amb->setBool(EO_EMIT_MATERIALS, true);
+	amb->setBool(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE, false);
+	amb->setInt(UNREAL_GEOMETRY_ENCODER_MESH_FORMAT, UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V1);
+	amb->setStringArray(UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS, nullptr, 0);
+	amb->setBool(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS, false);
 	encoderInfoBuilder.setDefaultOptions(amb->createAttributeMap());
 
 	return new UnrealGeometryEncoderFactory(encoderInfoBuilder.create());
@@ -21,6 +21,7 @@
 #include "prtx/Encoder.h"
 #include "prtx/EncoderFactory.h"
 #include "prtx/EncoderInfoBuilder.h"
+#include "prtx/Material.h"
 #include "prtx/PRTUtils.h"
 #include "prtx/ResolveMap.h"
 #include "prtx/Singleton.h"
@@ -34,9 +35,12 @@
 #include "Codec/CodecMain.h"
 
 #include <iostream>
+#include <map>
+#include <memory>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 class IUnrealCallbacks;
 
@@ -46,7 +50,7 @@ class UnrealGeometryEncoder final : public prtx::GeometryEncoder
 {
 public:
 	UnrealGeometryEncoder(const std::wstring& id, const prt::AttributeMap* options, prt::Callbacks* callbacks);
-	virtual ~UnrealGeometryEncoder() override = default;
+	virtual ~UnrealGeometryEncoder() override;
 
 public:
 	virtual void init(prtx::GenerateContext& context) override;
@@ -54,7 +58,14 @@ public:
 	virtual void finish(prtx::GenerateContext& context) override;
 
 private:
-	void convertGeometry(const prtx::EncodePreparator::InstanceVector& instances, IUnrealCallbacks* callbacks);
+	class MeshArena;
+
+	bool useMeshFormatV2() const;
+	MeshArena& acquireMeshArena();
+	const prt::AttributeMap* convertMaterial(const prtx::MaterialPtr& material, std::vector<const prt::AttributeMap*>& uncachedMaterials);
+	void encodeGeometry(IUnrealCallbacks* cb, int32_t initialShapeIndex, wchar_t const* name, wchar_t const* meshId, int32_t prototypeIndex,
+						const std::wstring& uri, const prtx::GeometryPtrVector& geometries, const std::vector<prtx::MaterialPtrVector>& materials);
+	void convertGeometry(const prtx::EncodePreparator::InstanceVector& instances, IUnrealCallbacks* callbacks, int32_t initialShapeIndex);
 
 	prtx::DefaultNamePreparator mNamePrep;
     prtx::EncodePreparatorPtr mEncPrep;
@@ -62,6 +73,15 @@ private:
     prtx::NamePreparator::NamespacePtr mNsMaterial;
     	
 	std::set<std::wstring> serializedPrototypes;
+	std::set<std::wstring> mCachedMeshIds;
+
+	prtx::PRTUtils::AttributeMapBuilderPtr mMaterialBuilder;
+	// converted materials, only filled if UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS is set
+	std::map<prtx::MaterialPtr, prtx::PRTUtils::AttributeMapPtr> mMaterialCache;
+	size_t mMaterialConversions = 0;
+	size_t mMaterialCacheHits = 0;
+	// buffers of V2 meshes, reused once the callbacks released them
+	std::vector<std::unique_ptr<MeshArena>> mMeshArenas;
 };
 
 class UnrealGeometryEncoderFactory final : public prtx::EncoderFactory, public prtx::Singleton<UnrealGeometryEncoderFactory>
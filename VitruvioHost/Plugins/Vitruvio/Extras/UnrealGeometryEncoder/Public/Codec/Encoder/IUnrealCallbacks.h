@@ -20,6 +20,87 @@
 
 constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_ID = L"UnrealGeometryEncoder";
 
+/**
+ * Encoder option (bool): if true, the geometry of each initial shape is finalized and emitted separately with addInitialShapeMesh and
+ * addInitialShapeInstance instead of merging the geometry of all initial shapes of a generate call into a single mesh. Encoders which do not
+ * know this option drop it from their validated options and always merge.
+ */
+constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE = L"emitPerInitialShape";
+
+/**
+ * Encoder option (int): the mesh format the callbacks accept. Geometry is passed to addMesh for UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V1 and to
+ * addMeshV2 for UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2. Encoders which do not know this option always call addMesh.
+ */
+constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_MESH_FORMAT = L"meshFormat";
+constexpr int32_t UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V1 = 1;
+constexpr int32_t UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2 = 2;
+
+/**
+ * Encoder option (string array): meshIds (see addMesh) of prototypes which the callbacks already hold from previous generate calls. These
+ * prototypes are not serialized, addCachedMesh is called instead of addMesh or addMeshV2 and instances reference them as usual.
+ */
+constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS = L"cachedMeshIds";
+
+/**
+ * Encoder option (bool): if true, the encoder converts each material once and keeps the converted attribute maps alive until it is
+ * destroyed. Equal materials are then passed to addMesh, addMeshV2 and addInstance as the same attribute map, which lets the callbacks
+ * cache their own conversion per attribute map. Encoders which do not know this option drop it from their validated options.
+ */
+constexpr const wchar_t* UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS = L"cacheMaterials";
+
+/**
+ * Passed as initialShapeIndex to the callbacks if the geometry is not associated with a single initial shape.
+ */
+constexpr int32_t UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX = -1;
+
+/**
+ * Encoder owned memory holding the buffers of an UnrealMeshV2. The encoder reuses released memory for later meshes and frees all of it when
+ * it is destroyed, so the callbacks must release it before the generate call returns.
+ */
+class UnrealMeshArena
+{
+public:
+	/**
+	 * Returns the memory to the encoder. Must be called exactly once, the buffers of the mesh are invalid afterwards.
+	 */
+	virtual void release() = 0;
+
+protected:
+	virtual ~UnrealMeshArena() = default;
+};
+
+/**
+ * Pre-triangulated mesh in struct of arrays layout. Vertices are split wherever normals or texture coordinates differ, so that all vertex
+ * attributes share a single index buffer. Coordinates are in the PRT coordinate system (meters, y-up).
+ */
+struct UnrealMeshV2
+{
+	/** xyz positions, 3 * vertexCount floats */
+	const float* positions = nullptr;
+	/** xyz normals, 3 * vertexCount floats */
+	const float* normals = nullptr;
+	/** uv coordinates per uv set, 2 * vertexCount floats or nullptr if the uv set is not used */
+	float const* const* uvs = nullptr;
+	size_t uvSets = 0;
+	size_t vertexCount = 0;
+
+	/** 3 * triangleCount vertex indices */
+	const uint32_t* indices = nullptr;
+	size_t triangleCount = 0;
+
+	/** number of consecutive triangles per material */
+	const uint32_t* triangleRanges = nullptr;
+	size_t triangleRangesSize = 0;
+	/** contains triangleRangesSize attribute maps */
+	const prt::AttributeMap** materials = nullptr;
+
+	/**
+	 * If not nullptr, the buffers above stay valid after addMeshV2 returns until the callbacks call release on the arena. Otherwise they are
+	 * only valid during the call.
+	 */
+	UnrealMeshArena* arena = nullptr;
+};
+
 class IUnrealCallbacks : public prt::Callbacks
 {
 public:
@@ -80,4 +161,62 @@ public:
 	virtual void init() = 0;
 	virtual void finish() = 0;
 	virtual void addReport(const prt::AttributeMap* reports) = 0;
+
+	// New callbacks are only ever appended below to keep the vtable layout compatible with previously built encoders
+
+	/**
+	 * Same as @ref addMesh for the geometry of a single initial shape. Only called if the encoder option
+	 * UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE is set, prototypes shared between initial shapes are still passed to @ref addMesh.
+	 *
+	 * @param initialShapeIndex the index of the initial shape this mesh belongs to
+	 */
+	// clang-format off
+	virtual void addInitialShapeMesh(int32_t initialShapeIndex,
+	                                 const wchar_t* name, const wchar_t* meshId,
+	                                 int32_t prototypeId, const wchar_t* uri,
+	                                 const double* vtx, size_t vtxSize,
+	                                 const double* nrm, size_t nrmSize,
+	                                 const uint32_t* faceVertexCounts, size_t faceVertexCountsSize,
+	                                 const uint32_t* vertexIndices, size_t vertexIndicesSize,
+	                                 const uint32_t* normalIndices, size_t normalIndicesSize,
+
+	                                 double const* const* uvs, size_t const* uvsSizes,
+	                                 uint32_t const* const* uvCounts, size_t const* uvCountsSizes,
+	                                 uint32_t const* const* uvIndices, size_t const* uvIndicesSizes,
+	                                 size_t uvSets,
+
+	                                 const uint32_t* faceRanges, size_t faceRangesSize,
+	                                 const prt::AttributeMap** materials
+	) = 0;
+	// clang-format on
+
+	/**
+	 * Same as @ref addInstance for an instance of a single initial shape. Only called if the encoder option
+	 * UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE is set.
+	 *
+	 * @param initialShapeIndex the index of the initial shape this instance belongs to
+	 */
+	virtual void addInitialShapeInstance(int32_t initialShapeIndex, int32_t prototypeId, const wchar_t* meshId, const double* transform,
+										 const prt::AttributeMap** instanceMaterial, size_t numInstanceMaterials) = 0;
+
+	/**
+	 * Same as @ref addMesh but with the mesh in the UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2 format. Only called if the encoder option
+	 * UNREAL_GEOMETRY_ENCODER_MESH_FORMAT is set to UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2.
+	 */
+	virtual void addMeshV2(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId, const wchar_t* uri,
+						   const UnrealMeshV2& mesh) = 0;
+
+	/**
+	 * Called instead of @ref addMesh for prototypes whose meshId is listed in the UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS encoder option.
+	 */
+	virtual void addCachedMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+							   const wchar_t* uri) = 0;
+
+	/**
+	 * Called once before @ref finish if the encoder option UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS is set.
+	 *
+	 * @param conversions number of materials converted to attribute maps
+	 * @param cacheHits number of materials whose attribute map was reused instead of being converted again
+	 */
+	virtual void addMaterialCacheStats(size_t conversions, size_t cacheHits) = 0;
 };
@@ -53,9 +53,20 @@ public sealed class UnrealGeometryEncoderTarget : TargetRules
 		{
 			AddWindowsPreAndPostBuildSteps(Target);
 		}
+		else if (Target.Platform == UnrealTargetPlatform.Linux)
+		{
+			// The encoder uses the C++ API of PRT (prtx) which is built against libstdc++ on Linux, while Unreal uses its bundled libc++
+			// by default. Mixing both breaks the std types passed across the PRT interface.
+			if (Environment.GetEnvironmentVariable("UE_LINUX_USE_LIBCXX") != "0")
+			{
+				throw new BuildException("The UnrealGeometryEncoder must be built with UE_LINUX_USE_LIBCXX=0 on Linux to match the C++ standard library of PRT");
+			}
+
+			AddLinuxPreAndPostBuildSteps(Target);
+		}
 	}
 
-	void AddWindowsPreAndPostBuildSteps(TargetInfo Target)
+	string GetVitruvioPath(TargetInfo Target)
 	{
 		string VitruvioPath = string.Empty;
 
@@ -68,6 +79,13 @@ public sealed class UnrealGeometryEncoderTarget : TargetRules
 			}
 		}
 
+		return VitruvioPath;
+	}
+
+	void AddWindowsPreAndPostBuildSteps(TargetInfo Target)
+	{
+		string VitruvioPath = GetVitruvioPath(Target);
+
 		string ProjectPath = Path.GetDirectoryName(Target.ProjectFile.FullName);
 
 		if (ProjectPath == null)
@@ -105,4 +123,46 @@ public sealed class UnrealGeometryEncoderTarget : TargetRules
 			PostBuildSteps.Add(string.Format("xcopy \"{0}\" \"{1}\" /R /Y /S", SrcPath, DestPath));
 		}
 	}
+
+	void AddLinuxPreAndPostBuildSteps(TargetInfo Target)
+	{
+		string VitruvioPath = GetVitruvioPath(Target);
+
+		string ProjectPath = Path.GetDirectoryName(Target.ProjectFile.FullName);
+
+		if (ProjectPath == null)
+		{
+			throw new InvalidOperationException("Project Path is null");
+		}
+
+		string BinaryFolder = Path.Combine(ProjectPath, "Binaries", "Linux", "UnrealGeometryEncoder");
+		string SourceIncludeFolder = Path.Combine(ProjectPath, "Source", "UnrealGeometryEncoder", "Public");
+
+		if (Directory.Exists(BinaryFolder)) {
+			// We want to delete all old encoder libraries because there might be old builds with different build settings
+			PreBuildSteps.Add(string.Format("echo deleting old encoder libraries \"{0}\"", BinaryFolder));
+			PreBuildSteps.Add(string.Format("rm -f \"{0}\"/*", BinaryFolder));
+		}
+
+		// If Vitruvio is installed, copy the include and library files into the ThirdParty folder of Vitruvio
+		if (!string.IsNullOrEmpty(VitruvioPath))
+		{
+			string VitruvioEncoderLib = Path.Combine(VitruvioPath, "Source", "ThirdParty", "UnrealGeometryEncoderLib");
+			string LibFolder = Path.Combine(VitruvioEncoderLib, "lib", "Linux", "Release");
+
+			// PRT loads the encoder from this folder as an extension (see GetEncoderExtensionPath in VitruvioModule.cpp)
+			string SrcPath = Path.Combine(BinaryFolder, "libUnrealGeometryEncoder.so");
+			string DestPath = LibFolder;
+
+			PostBuildSteps.Add(string.Format("echo Copying \"{0}\" to \"{1}\"", SrcPath, DestPath));
+			PostBuildSteps.Add(string.Format("mkdir -p \"{0}\"", DestPath));
+			PostBuildSteps.Add(string.Format("cp -f \"{0}\" \"{1}\"", SrcPath, DestPath));
+
+			SrcPath = SourceIncludeFolder;
+			DestPath = Path.Combine(VitruvioEncoderLib, "include");
+
+			PostBuildSteps.Add(string.Format("echo Copying \"{0}\" to \"{1}\"", SrcPath, DestPath));
+			PostBuildSteps.Add(string.Format("cp -rf \"{0}\"/. \"{1}\"", SrcPath, DestPath));
+		}
+	}
 }
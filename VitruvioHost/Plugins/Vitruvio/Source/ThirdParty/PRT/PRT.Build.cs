@@ -30,11 +30,12 @@ public class PRT : ModuleRules
 	private const int PrtMajor = 3;
 	private const int PrtMinor = 3;
 	private const int PrtBuild = 11173;
-	private const string PrtToolchain = "win10-vc1438-x86_64-rel-opt";
 
-	private const string PrtCoreDllName = "com.esri.prt.core.dll";
-
-	private static readonly List<string> FilteredExtensionLibraries = new List<string>() { "DatasmithSDK.dll", "FreeImage317.dll", "com.esri.prt.unreal.dll" };
+	private static readonly List<string> FilteredExtensionLibraries = new List<string>()
+	{
+		"DatasmithSDK.dll", "FreeImage317.dll", "com.esri.prt.unreal.dll",
+		"libDatasmithSDK.so", "libcom.esri.prt.unreal.so"
+	};
 
 	public PRT(ReadOnlyTargetRules Target) : base(Target)
 	{
@@ -50,6 +51,10 @@ public class PRT : ModuleRules
 		{
 			Platform = new WindowsPlatform(Debug);
 		}
+		else if (Target.Platform == UnrealTargetPlatform.Linux)
+		{
+			Platform = new LinuxPlatform(Debug);
+		}
 		else
 		{
 			throw new System.PlatformNotSupportedException();
@@ -62,7 +67,7 @@ public class PRT : ModuleRules
 		// 1. Check if prt is already available and has correct version, otherwise download from official github repo
 		bool PrtInstalled = Directory.Exists(LibDir) && Directory.Exists(BinDir);
 		
-		string PrtCorePath = Path.Combine(BinDir, PrtCoreDllName);
+		string PrtCorePath = Path.Combine(Platform.CoreLibraryInBinDir ? BinDir : LibDir, Platform.CoreLibraryName);
 		bool PrtCoreExists = File.Exists(PrtCorePath);
 		bool PrtVersionMatch = PrtCoreExists && CheckDllVersion(Platform, PrtCorePath, PrtMajor, PrtMinor, PrtBuild);
 
@@ -72,7 +77,7 @@ public class PRT : ModuleRules
 			string PrtUrl = "https://github.com/Esri/esri-cityengine-sdk/releases/download";
 			string PrtVersion = string.Format("{0}.{1}.{2}", PrtMajor, PrtMinor, PrtBuild);
 
-			string PrtLibName = string.Format("esri_ce_sdk-{0}-{1}", PrtVersion, PrtToolchain);
+			string PrtLibName = string.Format("esri_ce_sdk-{0}-{1}", PrtVersion, Platform.Toolchain);
 			string PrtLibZipFile = PrtLibName + ".zip";
 			string PrtDownloadUrl = Path.Combine(PrtUrl, PrtVersion, PrtLibZipFile);
 
@@ -101,6 +106,8 @@ public class PRT : ModuleRules
 				Copy(Path.Combine(ModuleDirectory, PrtLibName, "lib"), Path.Combine(ModuleDirectory, LibDir), FilteredExtensionLibraries);
 				Copy(Path.Combine(ModuleDirectory, PrtLibName, "bin"), Path.Combine(ModuleDirectory, BinDir));
 				Copy(Path.Combine(ModuleDirectory, PrtLibName, "include"), Path.Combine(ModuleDirectory, "include"));
+
+				Platform.OnPrtInstalled(PrtCorePath, PrtVersion);
 			}
 			finally
 			{
@@ -129,7 +136,7 @@ public class PRT : ModuleRules
 
 		// Add PRT core libraries
 		if (Debug) Console.WriteLine("Adding PRT core libraries");
-		foreach (string FilePath in Directory.GetFiles(BinDir))
+		foreach (string FilePath in Directory.GetFiles(Platform.CoreLibraryInBinDir ? BinDir : LibDir))
 		{
 			string LibraryName = Path.GetFileName(FilePath);
 
@@ -153,6 +160,12 @@ public class PRT : ModuleRules
 	{
 		Directory.CreateDirectory(DstDir);
 
+		// Not every SDK contains all folders, e.g. the Linux SDK has no bin folder
+		if (!Directory.Exists(SrcDir))
+		{
+			return;
+		}
+
 		foreach (string CopyFile in Directory.GetFiles(SrcDir))
 		{
 			if (Filter == null || !Filter.Contains(Path.GetFileName(CopyFile)))
@@ -225,12 +238,28 @@ public class PRT : ModuleRules
 		}
 	}
 
+	private class LinuxZipExtractor : AbstractZipExtractor
+	{
+		public override string Command { get { return "unzip"; } }
+
+		public override string Arguments
+		{
+			get
+			{
+				return "-q -o {0} -d {1}";
+			}
+		}
+	}
+
 	private abstract class AbstractPlatform
 	{
 		public abstract AbstractZipExtractor ZipExtractor { get; }
 
 		public abstract string Name { get; }
 		public abstract string DynamicLibExtension { get; }
+		public abstract string Toolchain { get; }
+		public abstract string CoreLibraryName { get; }
+		public abstract bool CoreLibraryInBinDir { get; }
 
 		protected bool Debug;
 		public AbstractPlatform(bool Debug)
@@ -263,6 +292,10 @@ public class PRT : ModuleRules
 		}
 		public abstract string GetFileVersionInfo(string WorkingDir, string Path);
 		public abstract void DownloadFile(string Url, string Destination);
+
+		public virtual void OnPrtInstalled(string CoreLibraryPath, string PrtVersion)
+		{
+		}
 	}
 
 	private class WindowsPlatform : AbstractPlatform
@@ -271,6 +304,9 @@ public class PRT : ModuleRules
 
 		public override string Name { get { return "Win64"; } }
 		public override string DynamicLibExtension { get { return ".dll"; } }
+		public override string Toolchain { get { return "win10-vc1438-x86_64-rel-opt"; } }
+		public override string CoreLibraryName { get { return "com.esri.prt.core.dll"; } }
+		public override bool CoreLibraryInBinDir { get { return true; } }
 		
 		public WindowsPlatform(bool Debug) : base(Debug)
 		{
@@ -335,4 +371,87 @@ public class PRT : ModuleRules
 			FileVersionProcess.WaitForExit();
 		}
 	}
+
+	private class LinuxPlatform : AbstractPlatform
+	{
+		public override AbstractZipExtractor ZipExtractor { get { return new LinuxZipExtractor(); } }
+
+		public override string Name { get { return "Linux"; } }
+		public override string DynamicLibExtension { get { return ".so"; } }
+		public override string Toolchain { get { return "rhel8-gcc112-x86_64-rel-opt"; } }
+		public override string CoreLibraryName { get { return "libcom.esri.prt.core.so"; } }
+		public override bool CoreLibraryInBinDir { get { return false; } }
+
+		// Shared objects carry no version resource, so the installed version is recorded next to the core library
+		private static string GetVersionFilePath(string CoreLibraryPath)
+		{
+			return CoreLibraryPath + ".version";
+		}
+
+		public LinuxPlatform(bool Debug) : base(Debug)
+		{
+		}
+
+		public override void AddExtensionLibraries(string SourceFolder, ModuleRules Rules)
+		{
+			foreach (string Dir in Directory.GetDirectories(SourceFolder))
+			{
+				AddExtensionLibraries(Dir, Rules);
+			}
+
+			// The core library is located in the same folder and added separately
+			foreach (string FilePath in Directory.GetFiles(SourceFolder))
+			{
+				if (Path.GetFileName(FilePath) != CoreLibraryName)
+				{
+					Rules.RuntimeDependencies.Add(FilePath);
+				}
+			}
+		}
+
+		public override void AddPrtCoreLibrary(string LibraryPath, string LibraryName, ModuleRules Rules)
+		{
+			if (LibraryName != CoreLibraryName)
+			{
+				return;
+			}
+
+			if (Debug) Console.WriteLine("Adding Runtime Library " + LibraryName);
+
+			// Linked directly and staged next to the module binaries, which are on the rpath
+			string ModuleBinariesDir = Path.GetFullPath(Path.Combine(Rules.ModuleDirectory, "../../..", "Binaries", Name));
+			Rules.PublicAdditionalLibraries.Add(LibraryPath);
+			Rules.RuntimeDependencies.Add(Path.Combine(ModuleBinariesDir, LibraryName), LibraryPath);
+		}
+
+		public override string GetFileVersionInfo(string WorkingDir, string Path)
+		{
+			// Same format as the Windows file version: "<Major>.<Minor>.<Patch> <Build>"
+			string VersionFilePath = GetVersionFilePath(Path);
+			return File.Exists(VersionFilePath) ? File.ReadAllText(VersionFilePath).Trim() : "0.0.0 0";
+		}
+
+		public override void OnPrtInstalled(string CoreLibraryPath, string PrtVersion)
+		{
+			string[] Versions = PrtVersion.Split('.');
+			File.WriteAllText(GetVersionFilePath(CoreLibraryPath), string.Format("{0}.{1}.0 {2}", Versions[0], Versions[1], Versions[2]));
+		}
+
+		public override void DownloadFile(string Url, string Destination)
+		{
+			ProcessStartInfo ProcStartInfo = new System.Diagnostics.ProcessStartInfo("curl", string.Format("-sSL -o \"{0}\" {1}", Destination, Url))
+			{
+				UseShellExecute = false,
+				CreateNoWindow = true,
+			};
+
+			Process DownloadProcess = new Process
+			{
+				StartInfo = ProcStartInfo,
+				EnableRaisingEvents = true
+			};
+			DownloadProcess.Start();
+			DownloadProcess.WaitForExit();
+		}
+	}
 }
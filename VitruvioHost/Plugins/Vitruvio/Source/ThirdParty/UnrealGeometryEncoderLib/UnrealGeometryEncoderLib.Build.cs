@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 
+using System;
 using System.IO;
 using UnrealBuildTool;
 
@@ -24,14 +25,43 @@ public class UnrealGeometryEncoderLib : ModuleRules
 		bEnableExceptions = true;
 		Type = ModuleType.External;
 
-		string LibDir = Path.Combine(ModuleDirectory, "lib", "Win64", "Release");
 		string IncludeDir = Path.Combine(ModuleDirectory, "include");
-		string EncoderDllName = "UnrealGeometryEncoder.dll";
 
-		RuntimeDependencies.Add(Path.Combine(LibDir, EncoderDllName));
-		PublicDelayLoadDLLs.Add(EncoderDllName);
+		if (Target.Platform == UnrealTargetPlatform.Win64)
+		{
+			string LibDir = Path.Combine(ModuleDirectory, "lib", "Win64", "Release");
+			string EncoderDllName = "UnrealGeometryEncoder.dll";
 
-		PublicAdditionalLibraries.Add(Path.Combine(LibDir, "UnrealGeometryEncoder.lib"));
+			RuntimeDependencies.Add(Path.Combine(LibDir, EncoderDllName));
+			PublicDelayLoadDLLs.Add(EncoderDllName);
+
+			PublicAdditionalLibraries.Add(Path.Combine(LibDir, "UnrealGeometryEncoder.lib"));
+			PublicDefinitions.Add("WITH_UNREAL_GEOMETRY_ENCODER=1");
+		}
+		else if (Target.Platform == UnrealTargetPlatform.Linux)
+		{
+			// Loaded by PRT as an extension from this folder (see GetEncoderExtensionPath in VitruvioModule.cpp)
+			string LibDir = Path.Combine(ModuleDirectory, "lib", "Linux", "Release");
+			string EncoderLibraryPath = Path.Combine(LibDir, "libUnrealGeometryEncoder.so");
+
+			// Without the extension the plugin still builds and loads, but PRT stays uninitialized (see InitializePrtLibrary)
+			if (File.Exists(EncoderLibraryPath))
+			{
+				RuntimeDependencies.Add(EncoderLibraryPath);
+				PublicAdditionalLibraries.Add(EncoderLibraryPath);
+				PublicDefinitions.Add("WITH_UNREAL_GEOMETRY_ENCODER=1");
+			}
+			else
+			{
+				Console.WriteLine("Warning: Missing Linux build of the UnrealGeometryEncoder extension at " + EncoderLibraryPath +
+					", generating models is disabled");
+				PublicDefinitions.Add("WITH_UNREAL_GEOMETRY_ENCODER=0");
+			}
+		}
+		else
+		{
+			throw new System.PlatformNotSupportedException();
+		}
 
 		PublicSystemIncludePaths.Add(IncludeDir);
 	}
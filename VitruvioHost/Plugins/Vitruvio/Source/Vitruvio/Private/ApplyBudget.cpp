@@ -0,0 +1,169 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ApplyBudget.h"
+
+#include "VitruvioModule.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Backlog"), STAT_ApplyBacklog, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Apply Mesh Build Time (ms)"), STAT_ApplyMeshBuildTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Apply Materials Time (ms)"), STAT_ApplyMaterialsTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Apply Components Time (ms)"), STAT_ApplyComponentsTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Apply Instances Time (ms)"), STAT_ApplyInstancesTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Apply Physics Time (ms)"), STAT_ApplyPhysicsTime, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames < 1 ms"), STAT_ApplyFrames_1ms, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames 1-2 ms"), STAT_ApplyFrames_2ms, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames 2-4 ms"), STAT_ApplyFrames_4ms, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames 4-8 ms"), STAT_ApplyFrames_8ms, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames 8-16 ms"), STAT_ApplyFrames_16ms, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Apply Frames > 16 ms"), STAT_ApplyFrames_Over16ms, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Material Creation Blocked Time (ms)"), STAT_MaterialBlockedTime, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Material Creation Blocked Count"), STAT_MaterialBlockedCount, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Instances Kept"), STAT_InstancesKept, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Instances Updated"), STAT_InstancesUpdated, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Instances Added"), STAT_InstancesAdded, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Instances Removed"), STAT_InstancesRemoved, STATGROUP_Vitruvio);
+
+namespace
+{
+void IncrementFrameTimeStat(int32 Bin)
+{
+	switch (Bin)
+	{
+	case 0:
+		INC_DWORD_STAT(STAT_ApplyFrames_1ms);
+		break;
+	case 1:
+		INC_DWORD_STAT(STAT_ApplyFrames_2ms);
+		break;
+	case 2:
+		INC_DWORD_STAT(STAT_ApplyFrames_4ms);
+		break;
+	case 3:
+		INC_DWORD_STAT(STAT_ApplyFrames_8ms);
+		break;
+	case 4:
+		INC_DWORD_STAT(STAT_ApplyFrames_16ms);
+		break;
+	default:
+		INC_DWORD_STAT(STAT_ApplyFrames_Over16ms);
+		break;
+	}
+}
+
+void AddStepTimeStat(EApplyStep Step, double TimeMs)
+{
+	switch (Step)
+	{
+	case EApplyStep::MeshBuild:
+		INC_FLOAT_STAT_BY(STAT_ApplyMeshBuildTime, TimeMs);
+		break;
+	case EApplyStep::Materials:
+		INC_FLOAT_STAT_BY(STAT_ApplyMaterialsTime, TimeMs);
+		break;
+	case EApplyStep::Components:
+		INC_FLOAT_STAT_BY(STAT_ApplyComponentsTime, TimeMs);
+		break;
+	case EApplyStep::Instances:
+		INC_FLOAT_STAT_BY(STAT_ApplyInstancesTime, TimeMs);
+		break;
+	case EApplyStep::Physics:
+		INC_FLOAT_STAT_BY(STAT_ApplyPhysicsTime, TimeMs);
+		break;
+	default:
+		break;
+	}
+}
+} // namespace
+
+bool FApplyBudget::HasTimeLeft(double BudgetMs)
+{
+	check(IsInGameThread());
+
+	UpdateFrame();
+	return BudgetMs <= 0 || CurrentFrameTimeMs < BudgetMs;
+}
+
+TSharedPtr<FApplyBudget::FBacklogEntry> FApplyBudget::CreateBacklogEntry()
+{
+	return MakeShared<FBacklogEntry>(Backlog);
+}
+
+void FApplyBudget::AddStepTime(EApplyStep Step, double TimeMs)
+{
+	check(IsInGameThread());
+
+	UpdateFrame();
+	CurrentFrameTimeMs += TimeMs;
+
+	Stats.StepTimeMs[static_cast<int32>(Step)] += TimeMs;
+	Stats.StepCount[static_cast<int32>(Step)]++;
+	AddStepTimeStat(Step, TimeMs);
+}
+
+void FApplyBudget::UpdateFrame()
+{
+	if (CurrentFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	// Frames in which nothing has been applied are not part of the histogram
+	if (CurrentFrameTimeMs > 0)
+	{
+		int32 Bin = 0;
+		while (Bin < FApplyStats::NumFrameTimeBins - 1 && CurrentFrameTimeMs >= FApplyStats::FrameTimeBinBounds[Bin])
+		{
+			++Bin;
+		}
+		Stats.FrameTimeHistogram[Bin]++;
+		IncrementFrameTimeStat(Bin);
+	}
+
+	CurrentFrame = GFrameCounter;
+	CurrentFrameTimeMs = 0;
+	SET_DWORD_STAT(STAT_ApplyBacklog, Backlog.GetValue());
+}
+
+void FApplyBudget::AddMaterialBlockedTime(double TimeMs)
+{
+	check(IsInGameThread());
+
+	Stats.MaterialBlockedTimeMs += TimeMs;
+	Stats.MaterialBlockedCount++;
+	INC_FLOAT_STAT_BY(STAT_MaterialBlockedTime, TimeMs);
+	INC_DWORD_STAT(STAT_MaterialBlockedCount);
+}
+
+void FApplyBudget::AddInstanceDiff(const FInstanceDiff& InstanceDiff)
+{
+	check(IsInGameThread());
+
+	Stats.InstanceDiff.Kept += InstanceDiff.Kept;
+	Stats.InstanceDiff.Updated += InstanceDiff.Updated;
+	Stats.InstanceDiff.Added += InstanceDiff.Added;
+	Stats.InstanceDiff.Removed += InstanceDiff.Removed;
+	INC_DWORD_STAT_BY(STAT_InstancesKept, InstanceDiff.Kept);
+	INC_DWORD_STAT_BY(STAT_InstancesUpdated, InstanceDiff.Updated);
+	INC_DWORD_STAT_BY(STAT_InstancesAdded, InstanceDiff.Added);
+	INC_DWORD_STAT_BY(STAT_InstancesRemoved, InstanceDiff.Removed);
+}
+
+FApplyStats FApplyBudget::GetStats() const
+{
+	FApplyStats Result = Stats;
+	Result.Backlog = Backlog.GetValue();
+	return Result;
+}
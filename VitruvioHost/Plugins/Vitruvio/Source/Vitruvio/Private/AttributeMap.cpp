@@ -19,5 +19,5 @@
 
 void FAttributeMap::UpdateUnrealAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, UObject* const Outer)
 {
-	Vitruvio::UpdateAttributeMap(AttributeMapOut, AttributeMap, RuleInfo, Outer);
+	Vitruvio::UpdateAttributeMap(AttributeMapOut, AttributeMap, *RuleInfo, Outer);
 }
@@ -0,0 +1,336 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerateCache.h"
+
+#include "RuleAttributes.h"
+#include "VitruvioModule.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Generate Cache Hits"), STAT_GenerateCache_Hits, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Generate Cache Misses"), STAT_GenerateCache_Misses, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Generate Cache Evictions"), STAT_GenerateCache_Evictions, STATGROUP_Vitruvio);
+DECLARE_MEMORY_STAT(TEXT("Generate Cache Memory"), STAT_GenerateCache_Memory, STATGROUP_Vitruvio);
+
+namespace
+{
+// Vertices are quantized to 1/1024 cm so that floating point noise (eg. from transforming the initial shape) does not cause cache misses
+constexpr double VERTEX_QUANTIZATION = 1024.0;
+
+constexpr int64 ESTIMATED_BYTES_PER_ATTRIBUTE_MAP = 1024;
+
+template <typename T>
+void HashValue(FXxHash128Builder& Builder, const T& Value)
+{
+	static_assert(TIsTriviallyCopyConstructible<T>::Value, "Only trivially copyable types can be hashed by value");
+	Builder.Update(&Value, sizeof(T));
+}
+
+template <typename T>
+void HashArray(FXxHash128Builder& Builder, const TArray<T>& Values)
+{
+	HashValue(Builder, Values.Num());
+	Builder.Update(Values.GetData(), Values.Num() * sizeof(T));
+}
+
+void HashString(FXxHash128Builder& Builder, const FString& Value)
+{
+	HashValue(Builder, Value.Len());
+	Builder.Update(*Value, Value.Len() * sizeof(TCHAR));
+}
+
+void HashPolygon(FXxHash128Builder& Builder, const FInitialShapePolygon& Polygon)
+{
+	HashValue(Builder, Polygon.Vertices.Num());
+	for (const FVector& Vertex : Polygon.Vertices)
+	{
+		HashValue(Builder, FMath::RoundToInt64(Vertex.X * VERTEX_QUANTIZATION));
+		HashValue(Builder, FMath::RoundToInt64(Vertex.Y * VERTEX_QUANTIZATION));
+		HashValue(Builder, FMath::RoundToInt64(Vertex.Z * VERTEX_QUANTIZATION));
+	}
+
+	HashValue(Builder, Polygon.Faces.Num());
+	for (const FInitialShapeFace& Face : Polygon.Faces)
+	{
+		HashArray(Builder, Face.Indices);
+		HashValue(Builder, Face.Holes.Num());
+		for (const FInitialShapeHole& Hole : Face.Holes)
+		{
+			HashArray(Builder, Hole.Indices);
+		}
+	}
+
+	HashValue(Builder, Polygon.TextureCoordinateSets.Num());
+	for (const FTextureCoordinateSet& TextureCoordinateSet : Polygon.TextureCoordinateSets)
+	{
+		HashArray(Builder, TextureCoordinateSet.TextureCoordinates);
+	}
+}
+
+void HashAttribute(FXxHash128Builder& Builder, const URuleAttribute* Attribute)
+{
+	HashString(Builder, Attribute->Name);
+
+	if (const UFloatAttribute* FloatAttribute = Cast<UFloatAttribute>(Attribute))
+	{
+		HashValue(Builder, 0);
+		HashValue(Builder, FloatAttribute->Value);
+	}
+	else if (const UStringAttribute* StringAttribute = Cast<UStringAttribute>(Attribute))
+	{
+		HashValue(Builder, 1);
+		HashString(Builder, StringAttribute->Value);
+	}
+	else if (const UBoolAttribute* BoolAttribute = Cast<UBoolAttribute>(Attribute))
+	{
+		HashValue(Builder, 2);
+		HashValue(Builder, BoolAttribute->Value);
+	}
+	else if (const UStringArrayAttribute* StringArrayAttribute = Cast<UStringArrayAttribute>(Attribute))
+	{
+		HashValue(Builder, 3);
+		HashValue(Builder, StringArrayAttribute->Values.Num());
+		for (const FString& Value : StringArrayAttribute->Values)
+		{
+			HashString(Builder, Value);
+		}
+	}
+	else if (const UBoolArrayAttribute* BoolArrayAttribute = Cast<UBoolArrayAttribute>(Attribute))
+	{
+		HashValue(Builder, 4);
+		HashArray(Builder, BoolArrayAttribute->Values);
+	}
+	else if (const UFloatArrayAttribute* FloatArrayAttribute = Cast<UFloatArrayAttribute>(Attribute))
+	{
+		HashValue(Builder, 5);
+		HashArray(Builder, FloatArrayAttribute->Values);
+	}
+}
+
+void HashInitialShape(FXxHash128Builder& Builder, const FInitialShape& InitialShape)
+{
+	HashPolygon(Builder, InitialShape.Polygon);
+
+	// The resolve map of a rule package is only reloaded after the rule package has changed, in which case the cache is emptied
+	HashString(Builder, InitialShape.RulePackage ? InitialShape.RulePackage->GetPathName() : FString());
+
+	// Only user set attributes are passed to PRT (see Vitruvio::CreateAttributeMap). Sort them since the map order is arbitrary.
+	TArray<const URuleAttribute*> UserSetAttributes;
+	for (const auto& [Key, Attribute] : InitialShape.Attributes)
+	{
+		if (Attribute.IsValid() && Attribute->bUserSet)
+		{
+			UserSetAttributes.Add(Attribute.Get());
+		}
+	}
+	UserSetAttributes.Sort([](const URuleAttribute& A, const URuleAttribute& B) { return A.Name < B.Name; });
+
+	HashValue(Builder, UserSetAttributes.Num());
+	for (const URuleAttribute* Attribute : UserSetAttributes)
+	{
+		HashAttribute(Builder, Attribute);
+	}
+
+	HashValue(Builder, InitialShape.RandomSeed);
+}
+
+int64 EstimateSize(const TSharedPtr<FVitruvioMesh>& Mesh)
+{
+	return Mesh ? Mesh->GetEstimatedSize() : 0;
+}
+
+int64 EstimateSize(const Vitruvio::FInstanceMap& Instances)
+{
+	int64 Size = 0;
+	for (const auto& [Key, Transforms] : Instances)
+	{
+		Size += sizeof(Key) + Transforms.GetAllocatedSize();
+	}
+	return Size;
+}
+
+int64 EstimateSize(const FGenerateResultDescription& Result)
+{
+	// Instance meshes are shared with the mesh cache and therefore not accounted for
+	int64 Size = sizeof(FGenerateResultDescription);
+	Size += EstimateSize(Result.GeneratedModel);
+	Size += EstimateSize(Result.Instances);
+	Size += Result.EvaluatedAttributes.Num() * ESTIMATED_BYTES_PER_ATTRIBUTE_MAP;
+
+	for (const auto& [InitialShapeIndex, InitialShapeResult] : Result.InitialShapeResults)
+	{
+		Size += EstimateSize(InitialShapeResult.GeneratedModel);
+		Size += EstimateSize(InitialShapeResult.Instances);
+		Size += InitialShapeResult.EvaluatedAttributes ? ESTIMATED_BYTES_PER_ATTRIBUTE_MAP : 0;
+	}
+
+	return Size;
+}
+
+} // namespace
+
+FXxHash128 FGenerateCache::ComputeKey(const FInitialShape& InitialShape)
+{
+	FXxHash128Builder Builder;
+	HashInitialShape(Builder, InitialShape);
+	return Builder.Finalize();
+}
+
+FXxHash128 FGenerateCache::ComputeInitialShapeKey(const FInitialShape& InitialShape)
+{
+	FXxHash128Builder Builder;
+	HashInitialShape(Builder, InitialShape);
+
+	// Distinguishes the entries from single generate results of the same initial shape which do not contain the evaluated attributes
+	HashString(Builder, TEXT("BatchInitialShape"));
+	return Builder.Finalize();
+}
+
+FXxHash128 FGenerateCache::ComputeOccluderKey(const FInitialShape& InitialShape)
+{
+	FXxHash128Builder Builder;
+	HashInitialShape(Builder, InitialShape);
+	HashValue(Builder, InitialShape.Position);
+	return Builder.Finalize();
+}
+
+FXxHash128 FGenerateCache::ComputeBatchKey(const TArray<FInitialShape>& InitialShapes, bool bEnableOcclusionQueries,
+										   const TArray<FInitialShape>& OccluderOnlyShapes, bool bGeneratePerInitialShape)
+{
+	FXxHash128Builder Builder;
+
+	auto HashInitialShapes = [&Builder, bGeneratePerInitialShape](const TArray<FInitialShape>& Shapes) {
+		HashValue(Builder, Shapes.Num());
+		for (const FInitialShape& InitialShape : Shapes)
+		{
+			HashInitialShape(Builder, InitialShape);
+			HashValue(Builder, InitialShape.Position);
+			HashValue(Builder, InitialShape.bOccluderOnly);
+
+			// Per initial shape results are returned by initial shape index
+			if (bGeneratePerInitialShape)
+			{
+				HashValue(Builder, InitialShape.InitialShapeIndex);
+			}
+		}
+	};
+
+	HashInitialShapes(InitialShapes);
+	HashValue(Builder, bGeneratePerInitialShape);
+	HashValue(Builder, bEnableOcclusionQueries);
+	if (bEnableOcclusionQueries)
+	{
+		HashInitialShapes(OccluderOnlyShapes);
+	}
+
+	return Builder.Finalize();
+}
+
+TSharedPtr<const FGenerateResultDescription> FGenerateCache::Find(const FXxHash128& Key)
+{
+	FScopeLock Lock(&CacheLock);
+
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		NumMisses.Increment();
+		INC_DWORD_STAT(STAT_GenerateCache_Misses);
+		return {};
+	}
+
+	LruList.RemoveNode(Entry->LruNode, false);
+	LruList.AddHead(Entry->LruNode);
+
+	NumHits.Increment();
+	INC_DWORD_STAT(STAT_GenerateCache_Hits);
+	return Entry->Result;
+}
+
+void FGenerateCache::Add(const FXxHash128& Key, const FGenerateResultDescription& Result)
+{
+	const int64 Size = EstimateSize(Result);
+
+	FScopeLock Lock(&CacheLock);
+
+	// Results larger than the whole budget would only flush the cache
+	if (Size > MemoryBudget)
+	{
+		return;
+	}
+
+	if (FEntry* Entry = Entries.Find(Key))
+	{
+		// Another generate call with the same key finished first
+		LruList.RemoveNode(Entry->LruNode, false);
+		LruList.AddHead(Entry->LruNode);
+		return;
+	}
+
+	LruList.AddHead(Key);
+	Entries.Add(Key, FEntry{MakeShared<FGenerateResultDescription>(Result), Size, LruList.GetHead()});
+	MemoryUsage += Size;
+
+	EvictToBudget();
+}
+
+void FGenerateCache::Empty()
+{
+	FScopeLock Lock(&CacheLock);
+
+	Entries.Empty();
+	LruList.Empty();
+	MemoryUsage = 0;
+	SET_MEMORY_STAT(STAT_GenerateCache_Memory, MemoryUsage);
+}
+
+void FGenerateCache::SetMemoryBudget(int64 NewMemoryBudget)
+{
+	FScopeLock Lock(&CacheLock);
+
+	MemoryBudget = FMath::Max<int64>(0, NewMemoryBudget);
+	EvictToBudget();
+}
+
+FGenerateCacheStats FGenerateCache::GetStats() const
+{
+	FScopeLock Lock(&CacheLock);
+
+	FGenerateCacheStats Stats;
+	Stats.NumHits = NumHits.GetValue();
+	Stats.NumMisses = NumMisses.GetValue();
+	Stats.NumEvictions = NumEvictions.GetValue();
+	Stats.NumEntries = Entries.Num();
+	Stats.MemoryUsage = MemoryUsage;
+	Stats.MemoryBudget = MemoryBudget;
+	return Stats;
+}
+
+void FGenerateCache::EvictToBudget()
+{
+	while (MemoryUsage > MemoryBudget && LruList.GetTail())
+	{
+		FLruList::TDoubleLinkedListNode* LeastRecentlyUsed = LruList.GetTail();
+
+		FEntry Entry;
+		Entries.RemoveAndCopyValue(LeastRecentlyUsed->GetValue(), Entry);
+		LruList.RemoveNode(LeastRecentlyUsed);
+
+		MemoryUsage -= Entry.Size;
+
+		NumEvictions.Increment();
+		INC_DWORD_STAT(STAT_GenerateCache_Evictions);
+	}
+
+	SET_MEMORY_STAT(STAT_GenerateCache_Memory, MemoryUsage);
+}
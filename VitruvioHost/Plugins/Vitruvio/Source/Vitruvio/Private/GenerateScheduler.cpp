@@ -0,0 +1,326 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerateScheduler.h"
+
+#include "VitruvioModule.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/RunnableThread.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Tasks"), STAT_GenerateScheduler_QueueDepth, STATGROUP_Vitruvio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Workers"), STAT_GenerateScheduler_ActiveWorkers, STATGROUP_Vitruvio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overflow Queued Tasks"), STAT_GenerateScheduler_OverflowQueueDepth, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Average Queue Wait Time (ms)"), STAT_GenerateScheduler_AverageWaitTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("P50 Queue Wait Time (ms)"), STAT_GenerateScheduler_P50WaitTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("P95 Queue Wait Time (ms)"), STAT_GenerateScheduler_P95WaitTime, STATGROUP_Vitruvio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("P99 Queue Wait Time (ms)"), STAT_GenerateScheduler_P99WaitTime, STATGROUP_Vitruvio);
+
+FGenerateScheduler::~FGenerateScheduler()
+{
+	Stop();
+}
+
+void FGenerateScheduler::Start(int32 NumWorkers, int32 InMaxQueueDepth, int32 InHighPriorityBurst)
+{
+	if (bRunning)
+	{
+		return;
+	}
+
+	MaxQueueDepth = FMath::Max(1, InMaxQueueDepth);
+	HighPriorityBurst = FMath::Max(0, InHighPriorityBurst);
+	NumConsecutiveHighPriorityTasks = 0;
+	bStopping = false;
+	bRunning = true;
+
+	WorkAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	SpaceAvailableEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	FScopeLock Lock(&QueueLock);
+	for (int32 WorkerIndex = 0; WorkerIndex < FMath::Max(1, NumWorkers); ++WorkerIndex)
+	{
+		TUniquePtr<FWorker>& Worker = Workers.Add_GetRef(MakeUnique<FWorker>(*this));
+		const FString ThreadName = FString::Printf(TEXT("VitruvioGenerateWorker %d"), WorkerIndex);
+		FRunnableThread* Thread = FRunnableThread::Create(Worker.Get(), *ThreadName, 0, TPri_Normal);
+		WorkerThreadIds.Add(Thread->GetThreadID());
+		Threads.Emplace(Thread);
+	}
+}
+
+void FGenerateScheduler::Stop()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+
+	// Workers only exit once both queues have been drained
+	{
+		FScopeLock Lock(&QueueLock);
+		bStopping = true;
+	}
+	WorkAvailableEvent->Trigger();
+	SpaceAvailableEvent->Trigger();
+
+	for (const TUniquePtr<FRunnableThread>& Thread : Threads)
+	{
+		Thread->WaitForCompletion();
+	}
+
+	{
+		FScopeLock Lock(&QueueLock);
+		Threads.Empty();
+		Workers.Empty();
+		WorkerThreadIds.Empty();
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkAvailableEvent);
+	FPlatformProcess::ReturnSynchEventToPool(SpaceAvailableEvent);
+	WorkAvailableEvent = nullptr;
+	SpaceAvailableEvent = nullptr;
+
+	bRunning = false;
+}
+
+bool FGenerateScheduler::IsWorkerThread() const
+{
+	FScopeLock Lock(&QueueLock);
+	return WorkerThreadIds.Contains(FPlatformTLS::GetCurrentThreadId());
+}
+
+FGenerateSchedulerStats FGenerateScheduler::GetStats() const
+{
+	FScopeLock Lock(&QueueLock);
+
+	FGenerateSchedulerStats Stats;
+	Stats.NumWorkers = Workers.Num();
+	Stats.NumActiveWorkers = NumActiveWorkers.GetValue();
+	Stats.QueueDepth = NumHighPriorityTasks + NumNormalPriorityTasks;
+	Stats.HighPriorityQueueDepth = NumHighPriorityTasks;
+	Stats.MaxQueueDepth = MaxQueueDepth;
+	Stats.OverflowQueueDepth = NumOverflowTasks;
+	Stats.NumCompletedTasks = NumCompletedTasks.GetValue();
+	Stats.AverageWaitTimeMs = Stats.NumCompletedTasks > 0 ? TotalWaitTimeUs.GetValue() / 1000.0 / Stats.NumCompletedTasks : 0.0;
+	Stats.MaxWaitTimeMs = MaxWaitTimeUs.Load() / 1000.0;
+	Stats.P50WaitTimeMs = GetWaitTimePercentileMs(0.5);
+	Stats.P95WaitTimeMs = GetWaitTimePercentileMs(0.95);
+	Stats.P99WaitTimeMs = GetWaitTimePercentileMs(0.99);
+	return Stats;
+}
+
+double FGenerateScheduler::GetWaitTimePercentileMs(double Percentile) const
+{
+	int64 Counts[NumWaitTimeBuckets];
+	int64 TotalCount = 0;
+	for (int32 BucketIndex = 0; BucketIndex < NumWaitTimeBuckets; ++BucketIndex)
+	{
+		Counts[BucketIndex] = WaitTimeHistogram[BucketIndex].GetValue();
+		TotalCount += Counts[BucketIndex];
+	}
+
+	if (TotalCount == 0)
+	{
+		return 0.0;
+	}
+
+	const int64 Rank = FMath::Max<int64>(1, FMath::CeilToInt64(Percentile * TotalCount));
+	int64 CumulativeCount = 0;
+	for (int32 BucketIndex = 0; BucketIndex < NumWaitTimeBuckets - 1; ++BucketIndex)
+	{
+		CumulativeCount += Counts[BucketIndex];
+		if (CumulativeCount >= Rank)
+		{
+			return (int64(1) << BucketIndex) / 1000.0;
+		}
+	}
+
+	// The last bucket is unbounded
+	return MaxWaitTimeUs.Load() / 1000.0;
+}
+
+void FGenerateScheduler::EnqueueLocked(EGeneratePriority Priority, FTask&& Task)
+{
+	if (Priority == EGeneratePriority::High)
+	{
+		HighPriorityQueue.Enqueue(MoveTemp(Task));
+		NumHighPriorityTasks++;
+	}
+	else
+	{
+		NormalPriorityQueue.Enqueue(MoveTemp(Task));
+		NumNormalPriorityTasks++;
+	}
+}
+
+void FGenerateScheduler::Enqueue(EGeneratePriority Priority, TUniqueFunction<void()> Function)
+{
+	// Tasks submitted from a worker (or after the scheduler has been stopped) are executed directly, otherwise a worker waiting for a
+	// full queue could end up waiting for itself.
+	if (!bRunning || bStopping || IsWorkerThread())
+	{
+		Function();
+		return;
+	}
+
+	FTask Task{MoveTemp(Function), FPlatformTime::Seconds()};
+
+	while (true)
+	{
+		{
+			FScopeLock Lock(&QueueLock);
+			if (bStopping)
+			{
+				break;
+			}
+
+			const int32 QueueDepth = NumHighPriorityTasks + NumNormalPriorityTasks;
+			if (QueueDepth < MaxQueueDepth)
+			{
+				EnqueueLocked(Priority, MoveTemp(Task));
+
+				SET_DWORD_STAT(STAT_GenerateScheduler_QueueDepth, QueueDepth + 1);
+
+				// Pass the signal on to other waiting producers if there is still room left
+				if (QueueDepth + 1 < MaxQueueDepth)
+				{
+					SpaceAvailableEvent->Trigger();
+				}
+
+				WorkAvailableEvent->Trigger();
+				return;
+			}
+
+			// The game thread must never stall on backpressure. Its task is moved to the queue by the next worker which dequeues a task.
+			if (IsInGameThread())
+			{
+				OverflowQueue.Enqueue(MakeTuple(Priority, MoveTemp(Task)));
+				NumOverflowTasks++;
+				SET_DWORD_STAT(STAT_GenerateScheduler_OverflowQueueDepth, NumOverflowTasks);
+				return;
+			}
+		}
+
+		// Backpressure: wait until a worker has taken a task from the queue
+		SpaceAvailableEvent->Wait();
+	}
+
+	// The scheduler has been stopped while waiting for space in the queue. Wake up the next waiting producer and execute the task directly.
+	SpaceAvailableEvent->Trigger();
+	Task.Function();
+}
+
+bool FGenerateScheduler::TryDequeue(FTask& OutTask)
+{
+	FScopeLock Lock(&QueueLock);
+
+	// Give a waiting normal priority task its turn once a full burst of high priority tasks has been processed
+	const bool bHighPriorityFirst = HighPriorityBurst == 0 || NumConsecutiveHighPriorityTasks < HighPriorityBurst || NumNormalPriorityTasks == 0;
+
+	if (bHighPriorityFirst && HighPriorityQueue.Dequeue(OutTask))
+	{
+		NumHighPriorityTasks--;
+		NumConsecutiveHighPriorityTasks++;
+	}
+	else if (NormalPriorityQueue.Dequeue(OutTask))
+	{
+		NumNormalPriorityTasks--;
+		NumConsecutiveHighPriorityTasks = 0;
+	}
+	else
+	{
+		return false;
+	}
+
+	// The overflow queue is only used while the queue is full, so there is always room for exactly one overflowed task now. Overflowed
+	// tasks take precedence over blocked producers to keep the submission order of the game thread.
+	TPair<EGeneratePriority, FTask> OverflowTask;
+	if (OverflowQueue.Dequeue(OverflowTask))
+	{
+		NumOverflowTasks--;
+		SET_DWORD_STAT(STAT_GenerateScheduler_OverflowQueueDepth, NumOverflowTasks);
+		EnqueueLocked(OverflowTask.Key, MoveTemp(OverflowTask.Value));
+	}
+
+	const int32 QueueDepth = NumHighPriorityTasks + NumNormalPriorityTasks;
+	SET_DWORD_STAT(STAT_GenerateScheduler_QueueDepth, QueueDepth);
+
+	if (QueueDepth < MaxQueueDepth)
+	{
+		SpaceAvailableEvent->Trigger();
+	}
+
+	// Wake up another worker if there is more work left
+	if (QueueDepth > 0)
+	{
+		WorkAvailableEvent->Trigger();
+	}
+
+	return true;
+}
+
+void FGenerateScheduler::Execute(FTask& Task)
+{
+	const int64 WaitTimeUs = static_cast<int64>((FPlatformTime::Seconds() - Task.EnqueueTime) * 1000000.0);
+	TotalWaitTimeUs.Add(WaitTimeUs);
+
+	int64 CurrentMaxWaitTimeUs = MaxWaitTimeUs.Load();
+	while (WaitTimeUs > CurrentMaxWaitTimeUs && !MaxWaitTimeUs.CompareExchange(CurrentMaxWaitTimeUs, WaitTimeUs))
+	{
+	}
+
+	const int32 BucketIndex = WaitTimeUs > 0 ? FMath::Min(FMath::FloorLog2_64(static_cast<uint64>(WaitTimeUs)) + 1, NumWaitTimeBuckets - 1) : 0;
+	WaitTimeHistogram[BucketIndex].Increment();
+
+	SET_DWORD_STAT(STAT_GenerateScheduler_ActiveWorkers, NumActiveWorkers.Increment());
+
+	Task.Function();
+
+	SET_DWORD_STAT(STAT_GenerateScheduler_ActiveWorkers, NumActiveWorkers.Decrement());
+
+	const int64 NumCompleted = NumCompletedTasks.Increment();
+	SET_FLOAT_STAT(STAT_GenerateScheduler_AverageWaitTime, TotalWaitTimeUs.GetValue() / 1000.0 / NumCompleted);
+	SET_FLOAT_STAT(STAT_GenerateScheduler_P50WaitTime, GetWaitTimePercentileMs(0.5));
+	SET_FLOAT_STAT(STAT_GenerateScheduler_P95WaitTime, GetWaitTimePercentileMs(0.95));
+	SET_FLOAT_STAT(STAT_GenerateScheduler_P99WaitTime, GetWaitTimePercentileMs(0.99));
+}
+
+uint32 FGenerateScheduler::FWorker::Run()
+{
+	while (true)
+	{
+		const bool bStopping = Scheduler.bStopping;
+
+		FTask Task;
+		if (Scheduler.TryDequeue(Task))
+		{
+			Scheduler.Execute(Task);
+			continue;
+		}
+
+		// No more tasks can be queued once stopping has been requested, so the queue is guaranteed to stay empty
+		if (bStopping)
+		{
+			// Wake up the next worker so that all of them can exit
+			Scheduler.WorkAvailableEvent->Trigger();
+			break;
+		}
+
+		Scheduler.WorkAvailableEvent->Wait();
+	}
+
+	return 0;
+}
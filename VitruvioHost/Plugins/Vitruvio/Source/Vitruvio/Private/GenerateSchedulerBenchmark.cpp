@@ -0,0 +1,90 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "GenerateSchedulerBenchmark.h"
+
+#include "GenerateScheduler.h"
+
+namespace
+{
+/** Busy time of every task, roughly a small PRT call. */
+constexpr double TaskTimeSeconds = 0.0001;
+
+constexpr int32 HighPriorityTasksPerNormalPriorityTask = 4;
+
+FGenerateSchedulerBenchmarkResult RunScheduler(int32 NumTasks, int32 NumWorkers, int32 HighPriorityBurst)
+{
+	FGenerateSchedulerBenchmarkResult Result;
+	Result.HighPriorityBurst = HighPriorityBurst;
+	Result.NumTasks = NumTasks;
+
+	// All tasks fit into the queue, so the submission order is not changed by the game thread overflow queue
+	FGenerateScheduler Scheduler;
+	Scheduler.Start(NumWorkers, NumTasks, HighPriorityBurst);
+
+	TArray<TFuture<double>> HighPriorityFutures;
+	TArray<TFuture<double>> NormalPriorityFutures;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 TaskIndex = 0; TaskIndex < NumTasks; ++TaskIndex)
+	{
+		const bool bNormalPriority = TaskIndex % (HighPriorityTasksPerNormalPriorityTask + 1) == 0;
+		const double EnqueueTime = FPlatformTime::Seconds();
+
+		TFuture<double> Future = Scheduler.Submit(bNormalPriority ? EGeneratePriority::Normal : EGeneratePriority::High, [EnqueueTime]() {
+			const double DequeueTime = FPlatformTime::Seconds();
+			while (FPlatformTime::Seconds() - DequeueTime < TaskTimeSeconds)
+			{
+			}
+			return (DequeueTime - EnqueueTime) * 1000.0;
+		});
+
+		(bNormalPriority ? NormalPriorityFutures : HighPriorityFutures).Add(MoveTemp(Future));
+	}
+
+	auto GetWaitTimes = [](TArray<TFuture<double>>& Futures, double& OutAverageMs, double& OutMaxMs) {
+		double TotalMs = 0;
+		for (TFuture<double>& Future : Futures)
+		{
+			const double WaitMs = Future.Get();
+			TotalMs += WaitMs;
+			OutMaxMs = FMath::Max(OutMaxMs, WaitMs);
+		}
+		OutAverageMs = Futures.IsEmpty() ? 0.0 : TotalMs / Futures.Num();
+	};
+
+	GetWaitTimes(HighPriorityFutures, Result.HighPriorityAverageWaitMs, Result.HighPriorityMaxWaitMs);
+	GetWaitTimes(NormalPriorityFutures, Result.NormalPriorityAverageWaitMs, Result.NormalPriorityMaxWaitMs);
+
+	Result.WallTimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	Scheduler.Stop();
+
+	return Result;
+}
+} // namespace
+
+TArray<FGenerateSchedulerBenchmarkResult> RunGenerateSchedulerBenchmark(int32 NumTasks, int32 NumWorkers)
+{
+	NumTasks = FMath::Max(1, NumTasks);
+	NumWorkers = FMath::Max(1, NumWorkers);
+
+	TArray<FGenerateSchedulerBenchmarkResult> Results;
+	Results.Add(RunScheduler(NumTasks, NumWorkers, 0));
+	Results.Add(RunScheduler(NumTasks, NumWorkers, FGenerateScheduler::DefaultHighPriorityBurst));
+	return Results;
+}
@@ -16,6 +16,7 @@
 #include "InitialShape.h"
 #include "PolygonWindings.h"
 #include "StaticMeshAttributes.h"
+#include "VertexWelding.h"
 #include "VitruvioComponent.h"
 
 #include "CompGeom/PolygonTriangulation.h"
@@ -80,47 +81,39 @@ FMeshDescription CreateMeshDescription(const FInitialShapePolygon& InPolygon)
 	return Description;
 }
 
-// Returns false if all faces are degenerate or true otherwise
-bool HasValidGeometry(const FInitialShapePolygon& Polygon)
-{
-	// 1. Construct MeshDescription from Polygon
-	FMeshDescription Description = CreateMeshDescription(Polygon);
-
-	// 2. Triangulate as the input initial shape is in non triangulated form
-	Description.TriangulateMesh();
+// Faces with a smaller area are degenerate
+constexpr double MinFaceArea = 0.005;
 
-	// 3. Check if any of the triangles is NOT degenerate (which means the polygon has valid geometry) if all
-	// faces are degenerate we return false (meaning non valid geometry)
-	const float ComparisonThreshold = 0.0001;
-	const float AdjustedComparisonThreshold = FMath::Max(ComparisonThreshold, MIN_flt);
-
-	FStaticMeshAttributes Attributes(Description);
-	const auto VertexPositions = Attributes.GetVertexPositions();
-	for (const FPolygonID& PolygonID : Description.Polygons().GetElementIDs())
+bool HasValidVertices(const TArray<int32>& Indices, const TArray<FVector>& Vertices)
+{
+	for (const int32 Index : Indices)
 	{
-		for (const FTriangleID TriangleID : Description.GetPolygonTriangles(PolygonID))
+		if (!Vertices.IsValidIndex(Index) || Vertices[Index].ContainsNaN())
 		{
-			TArrayView<const FVertexInstanceID> TriangleVertexInstances = Description.GetTriangleVertexInstances(TriangleID);
-			const FVertexID VertexID0 = Description.GetVertexInstanceVertex(TriangleVertexInstances[0]);
-			const FVertexID VertexID1 = Description.GetVertexInstanceVertex(TriangleVertexInstances[1]);
-			const FVertexID VertexID2 = Description.GetVertexInstanceVertex(TriangleVertexInstances[2]);
-
-			const FVector3f Position0 = VertexPositions[VertexID0];
-			const FVector3f DPosition1 = VertexPositions[VertexID1] - Position0;
-			const FVector3f DPosition2 = VertexPositions[VertexID2] - Position0;
-
-			FVector3f TmpNormal = FVector3f::CrossProduct(DPosition2, DPosition1).GetSafeNormal(AdjustedComparisonThreshold);
-			if (!TmpNormal.IsNearlyZero(ComparisonThreshold))
-			{
-				return true;
-			}
+			return false;
 		}
 	}
+	return true;
+}
 
-	return false;
+double GetFaceArea(const TArray<int32>& Indices, const TArray<FVector>& Vertices)
+{
+	if (Indices.Num() < 3)
+	{
+		return 0;
+	}
+
+	// Newell's method, relative to the first vertex to reduce the loss of precision far away from the origin
+	const FVector& Origin = Vertices[Indices[0]];
+	FVector Normal = FVector::ZeroVector;
+	for (int32 Index = 1; Index + 1 < Indices.Num(); ++Index)
+	{
+		Normal += FVector::CrossProduct(Vertices[Indices[Index]] - Origin, Vertices[Indices[Index + 1]] - Origin);
+	}
+	return Normal.Size() * 0.5;
 }
 
-FInitialShapePolygon CreateInitialPolygonFromStaticMesh(const UStaticMesh* StaticMesh)
+FInitialShapePolygon CreateInitialPolygonFromStaticMesh(const UStaticMesh* StaticMesh, double VertexWeldTolerance)
 {
 	if (!StaticMesh)
 	{
@@ -129,44 +122,25 @@ FInitialShapePolygon CreateInitialPolygonFromStaticMesh(const UStaticMesh* Stati
 
 	TArray<FVector> MeshVertices;
 	TArray<int32> MeshIndices;
-	TArray<FTextureCoordinateSet> MeshTextureCoordinateSets;
-	MeshTextureCoordinateSets.AddDefaulted(8);
 
 	if (StaticMesh->GetRenderData() && StaticMesh->GetRenderData()->LODResources.IsValidIndex(0))
 	{
-		TArray<int32> RemappedIndices;
 		const FStaticMeshLODResources& LOD = StaticMesh->GetRenderData()->LODResources[0];
 
-		for (auto SectionIndex = 0; SectionIndex < LOD.Sections.Num(); ++SectionIndex)
+		// All sections share the vertex buffer, so the vertices only have to be welded once
+		const FPositionVertexBuffer& PositionVertexBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+		TArray<FVector> Vertices;
+		Vertices.Reserve(PositionVertexBuffer.GetNumVertices());
+		for (uint32 VertexIndex = 0; VertexIndex < PositionVertexBuffer.GetNumVertices(); ++VertexIndex)
 		{
-			for (uint32 VertexIndex = 0; VertexIndex < LOD.VertexBuffers.PositionVertexBuffer.GetNumVertices(); ++VertexIndex)
-			{
-				FVector Vertex = FVector(LOD.VertexBuffers.PositionVertexBuffer.VertexPosition(VertexIndex));
-
-				auto VertexFindPredicate = [Vertex](const FVector& In) {
-					return Vertex.Equals(In);
-				};
-				int32 MappedVertexIndex = MeshVertices.IndexOfByPredicate(VertexFindPredicate);
-
-				if (MappedVertexIndex == INDEX_NONE)
-				{
-					RemappedIndices.Add(MeshVertices.Num());
-					MeshVertices.Add(Vertex);
-					for (uint32 TextCoordIndex = 0; TextCoordIndex < LOD.VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords(); ++TextCoordIndex)
-					{
-						FVector2f TexCoord = LOD.VertexBuffers.StaticMeshVertexBuffer.GetVertexUV(VertexIndex, TextCoordIndex);
-						MeshTextureCoordinateSets[TextCoordIndex].TextureCoordinates.Add(TexCoord);
-					}
-				}
-				else
-				{
-					RemappedIndices.Add(MappedVertexIndex);
-				}
-			}
+			Vertices.Add(FVector(PositionVertexBuffer.VertexPosition(VertexIndex)));
+		}
 
-			const FStaticMeshSection& Section = LOD.Sections[SectionIndex];
-			FIndexArrayView IndicesView = LOD.IndexBuffer.GetArrayView();
+		const TArray<int32> RemappedIndices = Vitruvio::WeldVertices(Vertices, VertexWeldTolerance, MeshVertices);
 
+		FIndexArrayView IndicesView = LOD.IndexBuffer.GetArrayView();
+		for (const FStaticMeshSection& Section : LOD.Sections)
+		{
 			for (uint32 Triangle = 0; Triangle < Section.NumTriangles; ++Triangle)
 			{
 				for (uint32 TriangleVertexIndex = 0; TriangleVertexIndex < 3; ++TriangleVertexIndex)
@@ -377,6 +351,30 @@ TArray<FSplinePoint> CreateSplinePointsFromInitialShapePolygon(const FInitialSha
 
 } // namespace
 
+bool FInitialShapePolygon::HasValidGeometry() const
+{
+	// Degenerate faces are skipped, but faces with missing or non finite vertices can not be generated at all
+	bool bHasArea = false;
+	for (const FInitialShapeFace& Face : Faces)
+	{
+		if (!HasValidVertices(Face.Indices, Vertices))
+		{
+			return false;
+		}
+		for (const FInitialShapeHole& Hole : Face.Holes)
+		{
+			if (!HasValidVertices(Hole.Indices, Vertices))
+			{
+				return false;
+			}
+		}
+
+		bHasArea = bHasArea || GetFaceArea(Face.Indices, Vertices) >= MinFaceArea;
+	}
+
+	return bHasArea;
+}
+
 void FInitialShapePolygon::FixOrientation()
 {
 	for (FInitialShapeFace& Face : Faces)
@@ -412,8 +410,13 @@ void FInitialShapePolygon::FixOrientation()
 
 void UInitialShape::SetPolygon(const FInitialShapePolygon& NewPolygon)
 {
+	// The polygon is often set again with unchanged geometry, e.g. on every property change, in which case the validity is still up to date
+	const bool bGeometryChanged = NewPolygon.Faces != Polygon.Faces || NewPolygon.Vertices != Polygon.Vertices;
 	Polygon = NewPolygon;
-	bIsPolygonValid = HasValidGeometry(Polygon);
+	if (bGeometryChanged)
+	{
+		bIsPolygonValid = Polygon.HasValidGeometry();
+	}
 }
 
 const TArray<FVector>& UInitialShape::GetVertices() const
@@ -484,7 +487,7 @@ void UStaticMeshInitialShape::UpdatePolygon(UVitruvioComponent* Component)
 #endif
 
 	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component->InitialShapeSceneComponent);
-	SetPolygon(StaticMeshComponent ? CreateInitialPolygonFromStaticMesh(StaticMeshComponent->GetStaticMesh()) : CreateDefaultInitialShapePolygon());
+	SetPolygon(StaticMeshComponent ? CreateInitialPolygonFromStaticMesh(StaticMeshComponent->GetStaticMesh(), VertexWeldTolerance) : CreateDefaultInitialShapePolygon());
 }
 
 void UStaticMeshInitialShape::UpdateSceneComponent(UVitruvioComponent* Component)
@@ -497,7 +500,7 @@ void UStaticMeshInitialShape::UpdateSceneComponent(UVitruvioComponent* Component
 
 	if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component->InitialShapeSceneComponent))
 	{
-		FInitialShapePolygon OldPolygon = CreateInitialPolygonFromStaticMesh(StaticMeshComponent->GetStaticMesh());
+		FInitialShapePolygon OldPolygon = CreateInitialPolygonFromStaticMesh(StaticMeshComponent->GetStaticMesh(), VertexWeldTolerance);
 
 		if (OldPolygon != GetPolygon())
 		{
@@ -575,7 +578,8 @@ bool UStaticMeshInitialShape::IsRelevantProperty(UObject* Object, const FPropert
 	if (Object)
 	{
 		FProperty* Property = PropertyChangedEvent.Property;
-		return Property && (Property->GetFName() == TEXT("StaticMesh") || Property->GetFName() == TEXT("StaticMeshComponent"));
+		return Property && (Property->GetFName() == TEXT("StaticMesh") || Property->GetFName() == TEXT("StaticMeshComponent") ||
+							(Property->GetFName() == TEXT("VertexWeldTolerance") && PropertyChangedEvent.ChangeType == EPropertyChangeType::ValueSet));
 	}
 	return false;
 }
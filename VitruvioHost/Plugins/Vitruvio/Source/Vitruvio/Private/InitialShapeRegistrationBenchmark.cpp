@@ -0,0 +1,182 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "InitialShapeRegistrationBenchmark.h"
+
+#include "Engine/World.h"
+#include "InitialShape.h"
+#include "StaticMeshAttributes.h"
+#include "VitruvioBatchSubsystem.h"
+#include "VitruvioComponent.h"
+
+namespace
+{
+constexpr double LotSize = 2000.0;
+constexpr double LotSpacing = 3000.0;
+
+FInitialShapePolygon CreateLot(int32 LotIndex, FRandomStream& Random)
+{
+	FInitialShapePolygon Polygon;
+	const bool bDegenerate = LotIndex % 10 == 0;
+	for (const FVector2D& Corner : {FVector2D(0, 0), FVector2D(1, 0), FVector2D(1, 1), FVector2D(0, 1)})
+	{
+		const FVector2D Jitter(Random.FRandRange(-0.1, 0.1), Random.FRandRange(-0.1, 0.1));
+		const FVector2D Position = (Corner + Jitter) * LotSize;
+		// Degenerate lots collapse onto a line
+		Polygon.Vertices.Add(FVector(Position.X, bDegenerate ? 0 : Position.Y, 0));
+	}
+	Polygon.Faces.Add(FInitialShapeFace{{0, 1, 2, 3}});
+	return Polygon;
+}
+
+/**
+ * \brief The previous validity check, which triangulates a mesh description of the polygon and checks for non degenerate triangles.
+ */
+bool HasValidMeshDescription(const FInitialShapePolygon& Polygon)
+{
+	FMeshDescription Description;
+	FStaticMeshAttributes Attributes(Description);
+	Attributes.Register();
+	Attributes.GetVertexInstanceUVs().SetNumChannels(1);
+
+	const auto VertexPositions = Attributes.GetVertexPositions();
+	const FPolygonGroupID PolygonGroupId = Description.CreatePolygonGroup();
+	for (const FVector& Vertex : Polygon.Vertices)
+	{
+		VertexPositions[Description.CreateVertex()] = FVector3f(Vertex);
+	}
+
+	for (const FInitialShapeFace& Face : Polygon.Faces)
+	{
+		TArray<FVertexInstanceID> PolygonVertexInstances;
+		for (const int32 VertexIndex : Face.Indices)
+		{
+			PolygonVertexInstances.Add(Description.CreateVertexInstance(FVertexID(VertexIndex)));
+		}
+		if (PolygonVertexInstances.Num() >= 3)
+		{
+			Description.CreatePolygon(PolygonGroupId, PolygonVertexInstances);
+		}
+	}
+
+	Description.TriangulateMesh();
+
+	const float ComparisonThreshold = 0.0001;
+	for (const FTriangleID TriangleID : Description.Triangles().GetElementIDs())
+	{
+		const TArrayView<const FVertexID> TriangleVertices = Description.GetTriangleVertices(TriangleID);
+		const FVector3f Position0 = VertexPositions[TriangleVertices[0]];
+		const FVector3f DPosition1 = VertexPositions[TriangleVertices[1]] - Position0;
+		const FVector3f DPosition2 = VertexPositions[TriangleVertices[2]] - Position0;
+		const FVector3f Normal = FVector3f::CrossProduct(DPosition2, DPosition1).GetSafeNormal(ComparisonThreshold);
+		if (!Normal.IsNearlyZero(ComparisonThreshold))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename FunctionType>
+double MeasureMs(FunctionType Function)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	Function();
+	return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+} // namespace
+
+FInitialShapeRegistrationBenchmarkResult RunInitialShapeRegistrationBenchmark(UWorld* World, int32 NumShapes)
+{
+	FInitialShapeRegistrationBenchmarkResult Result;
+
+	UVitruvioBatchSubsystem* BatchSubsystem = World->GetSubsystem<UVitruvioBatchSubsystem>();
+	if (!BatchSubsystem)
+	{
+		return Result;
+	}
+
+	FRandomStream Random(0);
+	const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<double>(NumShapes)));
+
+	TArray<FInitialShapePolygon> Polygons;
+	TArray<AActor*> Actors;
+	TArray<UVitruvioComponent*> Components;
+	for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+	{
+		Polygons.Add(CreateLot(LotIndex, Random));
+
+		// The batch actor sorts components into tiles by the location of their owner
+		AActor* Actor = World->SpawnActor<AActor>();
+		USceneComponent* Root = NewObject<USceneComponent>(Actor);
+		Actor->SetRootComponent(Root);
+		Root->SetWorldLocation(FVector((LotIndex % GridSize) * LotSpacing, (LotIndex / GridSize) * LotSpacing, 0));
+		Root->RegisterComponent();
+		Actors.Add(Actor);
+
+		UVitruvioComponent* Component = NewObject<UVitruvioComponent>(Actor);
+		Component->InitialShape = NewObject<UPolygonInitialShape>(Actor);
+		Components.Add(Component);
+	}
+
+	Result.NumShapes = NumShapes;
+
+	TArray<bool> MeshDescriptionValidity;
+	MeshDescriptionValidity.Reserve(NumShapes);
+	Result.MeshDescriptionValidityMs = MeasureMs([&]() {
+		for (const FInitialShapePolygon& Polygon : Polygons)
+		{
+			MeshDescriptionValidity.Add(HasValidMeshDescription(Polygon));
+		}
+	});
+
+	TArray<bool> Validity;
+	Validity.Reserve(NumShapes);
+	Result.ValidityMs = MeasureMs([&]() {
+		for (const FInitialShapePolygon& Polygon : Polygons)
+		{
+			Validity.Add(Polygon.HasValidGeometry());
+		}
+	});
+	Result.bEquivalent = Validity == MeshDescriptionValidity;
+
+	Result.RegisterMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			Components[LotIndex]->InitialShape->SetPolygon(Polygons[LotIndex]);
+			BatchSubsystem->RegisterVitruvioComponent(Components[LotIndex], false);
+		}
+	});
+
+	Result.UnchangedPolygonMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			Components[LotIndex]->InitialShape->SetPolygon(Polygons[LotIndex]);
+		}
+	});
+
+	for (UVitruvioComponent* Component : Components)
+	{
+		BatchSubsystem->RemoveFromNeighborIndex(Component);
+		BatchSubsystem->UnregisterVitruvioComponent(Component);
+	}
+	for (AActor* Actor : Actors)
+	{
+		Actor->Destroy();
+	}
+
+	return Result;
+}
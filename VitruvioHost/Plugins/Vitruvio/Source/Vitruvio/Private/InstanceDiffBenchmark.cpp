@@ -0,0 +1,103 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "InstanceDiffBenchmark.h"
+
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "VitruvioComponent.h"
+
+namespace
+{
+constexpr double WindowSpacing = 300.0;
+constexpr double FloorHeight = 350.0;
+
+TArray<FTransform> CreateFacade(int32 NumFloors, int32 WindowsPerFloor, double Height)
+{
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(NumFloors * WindowsPerFloor);
+	for (int32 Floor = 0; Floor < NumFloors; ++Floor)
+	{
+		for (int32 Window = 0; Window < WindowsPerFloor; ++Window)
+		{
+			Transforms.Emplace(FVector(Window * WindowSpacing, 0, Floor * Height));
+		}
+	}
+	return Transforms;
+}
+
+UHierarchicalInstancedStaticMeshComponent* CreateComponent(AActor* Actor, UStaticMesh* Mesh, const TArray<FTransform>& Transforms)
+{
+	UHierarchicalInstancedStaticMeshComponent* Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(Actor);
+	Component->SetStaticMesh(Mesh);
+	Component->AddInstances(Transforms, false);
+	Actor->AddOwnedComponent(Component);
+	Component->RegisterComponent();
+	return Component;
+}
+
+template <typename FunctionType>
+double MeasureMs(FunctionType Function)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	Function();
+	return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+FInstanceDiffBenchmarkResult MeasureScenario(const TCHAR* Scenario, AActor* Actor, UStaticMesh* Mesh, const TArray<FTransform>& Before,
+											 const TArray<FTransform>& After)
+{
+	FInstanceDiffBenchmarkResult Result;
+	Result.Scenario = Scenario;
+	Result.NumInstances = Before.Num();
+
+	UHierarchicalInstancedStaticMeshComponent* Previous = CreateComponent(Actor, Mesh, Before);
+	Result.RecreateMs = MeasureMs([&]() {
+		Previous->DestroyComponent();
+		Previous = CreateComponent(Actor, Mesh, After);
+	});
+	Previous->DestroyComponent();
+
+	UHierarchicalInstancedStaticMeshComponent* Existing = CreateComponent(Actor, Mesh, Before);
+	Result.DiffMs = MeasureMs([&]() {
+		TArray<FTransform> AddedTransforms;
+		Result.Diff = UpdateInstances(Existing, After, AddedTransforms);
+		Existing->AddInstances(AddedTransforms, false);
+	});
+	Existing->DestroyComponent();
+
+	return Result;
+}
+} // namespace
+
+TArray<FInstanceDiffBenchmarkResult> RunInstanceDiffBenchmark(UWorld* World, int32 NumInstances)
+{
+	UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	AActor* Actor = World->SpawnActor<AActor>();
+
+	const int32 WindowsPerFloor = FMath::Max(1, FMath::RoundToInt32(FMath::Sqrt(static_cast<double>(NumInstances))));
+	const int32 NumFloors = FMath::DivideAndRoundUp(NumInstances, WindowsPerFloor);
+	const TArray<FTransform> Before = CreateFacade(NumFloors, WindowsPerFloor, FloorHeight);
+
+	TArray<FInstanceDiffBenchmarkResult> Results;
+	// One more floor only adds instances, a different floor height moves all instances but the ground floor
+	Results.Add(MeasureScenario(TEXT("floors"), Actor, Mesh, Before, CreateFacade(NumFloors + 1, WindowsPerFloor, FloorHeight)));
+	Results.Add(MeasureScenario(TEXT("floorHeight"), Actor, Mesh, Before, CreateFacade(NumFloors, WindowsPerFloor, FloorHeight * 1.1)));
+
+	Actor->Destroy();
+	return Results;
+}
@@ -15,28 +15,246 @@
 
 #include "MeshCache.h"
 
-TSharedPtr<FVitruvioMesh> FMeshCache::Get(const FString& Id)
+#include "VitruvioModule.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Hits"), STAT_MeshCache_Hits, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Misses"), STAT_MeshCache_Misses, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Evictions"), STAT_MeshCache_Evictions, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Entries"), STAT_MeshCache_Entries, STATGROUP_Vitruvio);
+DECLARE_MEMORY_STAT(TEXT("Mesh Cache Memory"), STAT_MeshCache_Memory, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Skipped Prototypes"), STAT_MeshCache_SkippedPrototypes, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mesh Cache Skipped Prototype Bytes"), STAT_MeshCache_SkippedPrototypeBytes, STATGROUP_Vitruvio);
+
+FMeshCache::FPin::FPin(FMeshCache& MeshCache) : MeshCache(MeshCache)
+{
+	FScopeLock Lock(&MeshCache.CachedMeshIdsLock);
+	MeshCache.NumPins++;
+
+	if (!MeshCache.CachedMeshIdsSnapshot)
+	{
+		TSharedPtr<FCachedMeshIds> Snapshot = MakeShared<FCachedMeshIds>();
+		Snapshot->Ids.reserve(MeshCache.CachedMeshIdsByHandle.Num());
+		for (const auto& [Handle, Id] : MeshCache.CachedMeshIdsByHandle)
+		{
+			Snapshot->Ids.push_back(Id);
+		}
+		Snapshot->IdPtrs.reserve(Snapshot->Ids.size());
+		for (const std::wstring& Id : Snapshot->Ids)
+		{
+			Snapshot->IdPtrs.push_back(Id.c_str());
+		}
+		MeshCache.CachedMeshIdsSnapshot = MoveTemp(Snapshot);
+	}
+	CachedMeshIds = MeshCache.CachedMeshIdsSnapshot;
+}
+
+FMeshCache::FPin::~FPin()
+{
+	bool bLastPin;
+	{
+		FScopeLock Lock(&MeshCache.CachedMeshIdsLock);
+		bLastPin = --MeshCache.NumPins == 0;
+	}
+
+	if (bLastPin)
+	{
+		MeshCache.Trim();
+	}
+}
+
+FMeshHandle FMeshCache::GetHandle(const FString& Uri)
+{
+	const uint32 ShardIndex = GetTypeHash(Uri) & (NumShards - 1);
+	FShard& Shard = Shards[ShardIndex];
+
+	FScopeLock Lock(&Shard.Lock);
+	if (const FMeshHandle* Handle = Shard.Handles.Find(Uri))
+	{
+		return *Handle;
+	}
+
+	const FMeshHandle Handle = (Shard.NextHandleIndex++ << NumShardBits) | ShardIndex;
+	Shard.Handles.Add(Uri, Handle);
+	return Handle;
+}
+
+TSharedPtr<FVitruvioMesh> FMeshCache::Get(FMeshHandle Handle)
 {
-	FScopeLock Lock(&MeshCacheCriticalSection);
-	const auto Result = Cache.Find(Id);
+	FShard& Shard = Shards[GetShardIndex(Handle)];
+
+	FScopeLock Lock(&Shard.Lock);
+	FEntry* Entry = Shard.Entries.Find(Handle);
+	if (!Entry)
+	{
+		NumMisses.Increment();
+		INC_DWORD_STAT(STAT_MeshCache_Misses);
+		return {};
+	}
+
+	Shard.LruList.RemoveNode(Entry->LruNode, false);
+	Shard.LruList.AddHead(Entry->LruNode);
 
-	return Result ? *Result : TSharedPtr<FVitruvioMesh>{};
+	NumHits.Increment();
+	INC_DWORD_STAT(STAT_MeshCache_Hits);
+	return Entry->Mesh;
 }
 
-TSharedPtr<FVitruvioMesh> FMeshCache::InsertOrGet(const FString& Id, const TSharedPtr<FVitruvioMesh>& Mesh)
+TSharedPtr<FVitruvioMesh> FMeshCache::InsertOrGet(FMeshHandle Handle, const TSharedPtr<FVitruvioMesh>& Mesh)
 {
-	FScopeLock Lock(&MeshCacheCriticalSection);
-	const auto Result = Cache.Find(Id);
-	if (Result)
+	const int64 Size = Mesh->GetEstimatedSize();
+	FShard& Shard = Shards[GetShardIndex(Handle)];
+
+	// Destroyed after the lock is released
+	TArray<TSharedPtr<FVitruvioMesh>> Evicted;
+
+	FScopeLock Lock(&Shard.Lock);
+
+	// The handle may have been released while the mesh was converted, possibly with the identifier already interned again
+	Handle = Shard.Handles.FindOrAdd(Mesh->GetIdentifier(), Handle);
+
+	if (FEntry* Entry = Shard.Entries.Find(Handle))
 	{
-		return *Result;
+		// Another generate call with the same mesh finished first
+		Shard.LruList.RemoveNode(Entry->LruNode, false);
+		Shard.LruList.AddHead(Entry->LruNode);
+		return Entry->Mesh;
 	}
-	Cache.Add(Id, Mesh);
+
+	Shard.LruList.AddHead(Handle);
+	Shard.Entries.Add(Handle, FEntry{Mesh, Size, Shard.LruList.GetHead()});
+	Shard.MemoryUsage += Size;
+	INC_MEMORY_STAT_BY(STAT_MeshCache_Memory, Size);
+	INC_DWORD_STAT(STAT_MeshCache_Entries);
+
+	{
+		FScopeLock IdsLock(&CachedMeshIdsLock);
+		CachedMeshIdsByHandle.Add(Handle, TCHAR_TO_WCHAR(*Mesh->GetIdentifier()));
+		CachedMeshIdsSnapshot.Reset();
+	}
+
+	EvictToBudget(Shard, Evicted);
 	return Mesh;
 }
 
 void FMeshCache::Empty()
 {
-	FScopeLock Lock(&MeshCacheCriticalSection);
-	Cache.Empty();
+	for (FShard& Shard : Shards)
+	{
+		TMap<FMeshHandle, FEntry> Entries;
+		{
+			FScopeLock Lock(&Shard.Lock);
+			Entries = MoveTemp(Shard.Entries);
+			Shard.Entries.Empty();
+			Shard.Handles.Empty();
+			Shard.LruList.Empty();
+
+			DEC_MEMORY_STAT_BY(STAT_MeshCache_Memory, Shard.MemoryUsage);
+			DEC_DWORD_STAT_BY(STAT_MeshCache_Entries, Entries.Num());
+			Shard.MemoryUsage = 0;
+
+			FScopeLock IdsLock(&CachedMeshIdsLock);
+			for (const auto& [Handle, Entry] : Entries)
+			{
+				CachedMeshIdsByHandle.Remove(Handle);
+			}
+			CachedMeshIdsSnapshot.Reset();
+		}
+	}
+}
+
+void FMeshCache::AddSkippedBytes(int64 Bytes)
+{
+	NumSkippedPrototypes.Increment();
+	SkippedPrototypeBytes.Add(Bytes);
+	INC_DWORD_STAT(STAT_MeshCache_SkippedPrototypes);
+	INC_DWORD_STAT_BY(STAT_MeshCache_SkippedPrototypeBytes, Bytes);
+}
+
+void FMeshCache::SetMemoryBudget(int64 NewMemoryBudget)
+{
+	MemoryBudget = FMath::Max<int64>(0, NewMemoryBudget);
+	Trim();
 }
+
+void FMeshCache::Trim()
+{
+	for (FShard& Shard : Shards)
+	{
+		TArray<TSharedPtr<FVitruvioMesh>> Evicted;
+		FScopeLock Lock(&Shard.Lock);
+		EvictToBudget(Shard, Evicted);
+
+		// Handles of evicted meshes are released on eviction, this only catches identifiers which were never inserted
+		if (Shard.Handles.Num() > 2 * Shard.Entries.Num() + 64)
+		{
+			for (auto It = Shard.Handles.CreateIterator(); It; ++It)
+			{
+				if (!Shard.Entries.Contains(It.Value()))
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
+	}
+}
+
+FMeshCacheStats FMeshCache::GetStats() const
+{
+	FMeshCacheStats Stats;
+	Stats.NumHits = NumHits.GetValue();
+	Stats.NumMisses = NumMisses.GetValue();
+	Stats.NumEvictions = NumEvictions.GetValue();
+	Stats.MemoryBudget = MemoryBudget;
+	Stats.NumSkippedPrototypes = NumSkippedPrototypes.GetValue();
+	Stats.SkippedPrototypeBytes = SkippedPrototypeBytes.GetValue();
+
+	for (const FShard& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Lock);
+		Stats.NumEntries += Shard.Entries.Num();
+		Stats.MemoryUsage += Shard.MemoryUsage;
+	}
+	return Stats;
+}
+
+void FMeshCache::EvictToBudget(FShard& Shard, TArray<TSharedPtr<FVitruvioMesh>>& OutEvicted)
+{
+	const int64 ShardBudget = MemoryBudget / NumShards;
+
+	// Pinned meshes may have been announced to the encoder, evicting them is deferred until the last pin is released
+	FScopeLock IdsLock(&CachedMeshIdsLock);
+	if (NumPins > 0)
+	{
+		return;
+	}
+
+	FLruList::TDoubleLinkedListNode* Node = Shard.LruList.GetTail();
+	while (Shard.MemoryUsage > ShardBudget && Node)
+	{
+		FLruList::TDoubleLinkedListNode* PreviousNode = Node->GetPrevNode();
+
+		// Meshes which are still referenced by generate results or components are kept
+		const FEntry& Entry = Shard.Entries.FindChecked(Node->GetValue());
+		if (Entry.Mesh.GetSharedReferenceCount() == 1)
+		{
+			Shard.MemoryUsage -= Entry.Size;
+			DEC_MEMORY_STAT_BY(STAT_MeshCache_Memory, Entry.Size);
+			DEC_DWORD_STAT(STAT_MeshCache_Entries);
+
+			const FMeshHandle EvictedHandle = Node->GetValue();
+			FEntry EvictedEntry;
+			Shard.Entries.RemoveAndCopyValue(EvictedHandle, EvictedEntry);
+			Shard.LruList.RemoveNode(Node);
+			Shard.Handles.Remove(EvictedEntry.Mesh->GetIdentifier());
+			OutEvicted.Add(MoveTemp(EvictedEntry.Mesh));
+
+			CachedMeshIdsByHandle.Remove(EvictedHandle);
+			CachedMeshIdsSnapshot.Reset();
+
+			NumEvictions.Increment();
+			INC_DWORD_STAT(STAT_MeshCache_Evictions);
+		}
+
+		Node = PreviousNode;
+	}
+}
\ No newline at end of file
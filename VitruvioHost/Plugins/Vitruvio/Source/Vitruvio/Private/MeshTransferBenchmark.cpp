@@ -0,0 +1,132 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshTransferBenchmark.h"
+
+#include "UnrealCallbacks.h"
+
+namespace
+{
+template <typename T>
+int64 GetBytes(const TArray<T>& Array)
+{
+	return static_cast<int64>(Array.Num()) * sizeof(T);
+}
+} // namespace
+
+FMeshTransferBenchmarkResult RunMeshTransferBenchmark(int32 NumTriangles)
+{
+	// A grid of GridSize x GridSize quads with one normal and uv per grid vertex
+	const int32 GridSize = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(NumTriangles / 2.0)));
+	const int32 NumVertices = (GridSize + 1) * (GridSize + 1);
+	const int32 NumQuads = GridSize * GridSize;
+
+	AttributeMapBuilderUPtr MaterialBuilder(prt::AttributeMapBuilder::create());
+	const AttributeMapUPtr Material(MaterialBuilder->createAttributeMap());
+	const prt::AttributeMap* Materials[] = {Material.get()};
+
+	TArray<double> Vertices;
+	TArray<double> Normals;
+	TArray<double> UVs;
+	TArray<float> PositionsV2;
+	TArray<float> NormalsV2;
+	TArray<float> UVsV2;
+	for (int32 Y = 0; Y <= GridSize; ++Y)
+	{
+		for (int32 X = 0; X <= GridSize; ++X)
+		{
+			Vertices.Append({static_cast<double>(X), 0.0, static_cast<double>(Y)});
+			Normals.Append({0.0, 1.0, 0.0});
+			UVs.Append({static_cast<double>(X) / GridSize, static_cast<double>(Y) / GridSize});
+
+			PositionsV2.Append({static_cast<float>(X), 0.0f, static_cast<float>(Y)});
+			NormalsV2.Append({0.0f, 1.0f, 0.0f});
+			UVsV2.Append({static_cast<float>(X) / GridSize, static_cast<float>(Y) / GridSize});
+		}
+	}
+
+	TArray<uint32> FaceVertexCounts;
+	TArray<uint32> VertexIndices;
+	TArray<uint32> IndicesV2;
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const uint32 V0 = Y * (GridSize + 1) + X;
+			const uint32 V1 = V0 + 1;
+			const uint32 V2 = V0 + GridSize + 2;
+			const uint32 V3 = V0 + GridSize + 1;
+
+			FaceVertexCounts.Add(4);
+			VertexIndices.Append({V0, V1, V2, V3});
+			IndicesV2.Append({V0, V1, V2, V0, V2, V3});
+		}
+	}
+
+	// PRT passes separate normal and uv indices even if they are identical to the vertex indices
+	const TArray<uint32>& NormalIndices = VertexIndices;
+	const TArray<uint32>& UVCounts = FaceVertexCounts;
+	const TArray<uint32>& UVIndices = VertexIndices;
+
+	const double* UVSets[] = {UVs.GetData()};
+	const size_t UVSetSizes[] = {static_cast<size_t>(UVs.Num())};
+	const uint32_t* UVCountSets[] = {UVCounts.GetData()};
+	const size_t UVCountSetSizes[] = {static_cast<size_t>(UVCounts.Num())};
+	const uint32_t* UVIndexSets[] = {UVIndices.GetData()};
+	const size_t UVIndexSetSizes[] = {static_cast<size_t>(UVIndices.Num())};
+	const uint32_t FaceRanges[] = {static_cast<uint32_t>(NumQuads)};
+
+	const float* UVSetsV2[] = {UVsV2.GetData()};
+	const uint32_t TriangleRanges[] = {static_cast<uint32_t>(IndicesV2.Num() / 3)};
+
+	UnrealMeshV2 MeshV2;
+	MeshV2.positions = PositionsV2.GetData();
+	MeshV2.normals = NormalsV2.GetData();
+	MeshV2.uvs = UVSetsV2;
+	MeshV2.uvSets = 1;
+	MeshV2.vertexCount = NumVertices;
+	MeshV2.indices = IndicesV2.GetData();
+	MeshV2.triangleCount = IndicesV2.Num() / 3;
+	MeshV2.triangleRanges = TriangleRanges;
+	MeshV2.triangleRangesSize = 1;
+	MeshV2.materials = Materials;
+
+	FMeshTransferBenchmarkResult Result;
+	Result.NumTriangles = IndicesV2.Num() / 3;
+	Result.BytesV1 = GetBytes(Vertices) + GetBytes(Normals) + GetBytes(UVs) + GetBytes(FaceVertexCounts) + GetBytes(VertexIndices) +
+					 GetBytes(NormalIndices) + GetBytes(UVCounts) + GetBytes(UVIndices) + sizeof(FaceRanges);
+	Result.BytesV2 = GetBytes(PositionsV2) + GetBytes(NormalsV2) + GetBytes(UVsV2) + GetBytes(IndicesV2) + sizeof(TriangleRanges);
+
+	TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
+	{
+		UnrealCallbacks Callbacks(AttributeMapBuilders);
+		const double StartTime = FPlatformTime::Seconds();
+		Callbacks.addMesh(L"Benchmark", L"Benchmark", UnrealCallbacks::NoPrototypeIndex, L"",
+						  Vertices.GetData(), Vertices.Num(), Normals.GetData(), Normals.Num(), FaceVertexCounts.GetData(), FaceVertexCounts.Num(),
+						  VertexIndices.GetData(), VertexIndices.Num(), NormalIndices.GetData(), NormalIndices.Num(), UVSets, UVSetSizes,
+						  UVCountSets, UVCountSetSizes, UVIndexSets, UVIndexSetSizes, 1, FaceRanges, 1, Materials);
+		Result.ConvertSecondsV1 = FPlatformTime::Seconds() - StartTime;
+	}
+
+	{
+		UnrealCallbacks Callbacks(AttributeMapBuilders);
+		const double StartTime = FPlatformTime::Seconds();
+		Callbacks.addMeshV2(UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX, L"Benchmark", L"Benchmark", UnrealCallbacks::NoPrototypeIndex, L"",
+							MeshV2);
+		Result.ConvertSecondsV2 = FPlatformTime::Seconds() - StartTime;
+	}
+
+	return Result;
+}
@@ -0,0 +1,124 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "NeighborQueryBenchmark.h"
+
+#include "Util/LooseQuadtree.h"
+
+namespace
+{
+constexpr double LotSize = 2000.0;
+constexpr double LotSpacing = 3000.0;
+
+/** The default of Esri.Vitruvio.InterOcclusionNeighborQueryDistance. */
+constexpr double QueryDistance = 10000.0;
+
+/** The linear search is quadratic in the number of shapes, so only this many queries are compared against it. */
+constexpr int32 NumReferenceQueries = 1000;
+
+template <typename FunctionType>
+double MeasureMs(FunctionType Function)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	Function();
+	return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+} // namespace
+
+FNeighborQueryBenchmarkResult RunNeighborQueryBenchmark(int32 NumShapes)
+{
+	FNeighborQueryBenchmarkResult Result;
+	Result.NumShapes = NumShapes = FMath::Max(1, NumShapes);
+
+	FRandomStream Random(0);
+	const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<double>(NumShapes)));
+
+	TArray<FBox2D> Bounds;
+	Bounds.Reserve(NumShapes);
+	for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+	{
+		const FVector2D Position((LotIndex % GridSize) * LotSpacing, (LotIndex / GridSize) * LotSpacing);
+		const FVector2D Size = LotSize * FVector2D(Random.FRandRange(0.5, 1.0), Random.FRandRange(0.5, 1.0));
+		Bounds.Add(FBox2D(Position, Position + Size));
+	}
+
+	Vitruvio::TLooseQuadtree<int32> NeighborIndex;
+
+	Result.BuildMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			NeighborIndex.Update(LotIndex, Bounds[LotIndex]);
+		}
+	});
+
+	int64 NumNeighbors = 0;
+	Result.QueryMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			NeighborIndex.ForEachInRadius(Bounds[LotIndex].Min, QueryDistance, [&NumNeighbors](int32) { NumNeighbors++; });
+		}
+	});
+	Result.AverageNeighbors = static_cast<double>(NumNeighbors) / NumShapes;
+	Result.QueryUs = Result.QueryMs * 1000.0 / NumShapes;
+
+	// Spread the reference queries over the whole grid
+	const int32 NumReferenceLots = FMath::Min(NumShapes, NumReferenceQueries);
+	const int32 ReferenceStride = NumShapes / NumReferenceLots;
+	const double RadiusSquared = QueryDistance * QueryDistance;
+
+	TArray<TArray<int32>> LinearNeighbors;
+	LinearNeighbors.SetNum(NumReferenceLots);
+	const double LinearQueryMs = MeasureMs([&]() {
+		for (int32 QueryIndex = 0; QueryIndex < NumReferenceLots; ++QueryIndex)
+		{
+			const FVector2D& Position = Bounds[QueryIndex * ReferenceStride].Min;
+			for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+			{
+				if (Bounds[LotIndex].ComputeSquaredDistanceToPoint(Position) < RadiusSquared)
+				{
+					LinearNeighbors[QueryIndex].Add(LotIndex);
+				}
+			}
+		}
+	});
+	Result.LinearQueryUs = LinearQueryMs * 1000.0 / NumReferenceLots;
+
+	Result.bEquivalent = true;
+	for (int32 QueryIndex = 0; QueryIndex < NumReferenceLots && Result.bEquivalent; ++QueryIndex)
+	{
+		TArray<int32> Neighbors;
+		NeighborIndex.ForEachInRadius(Bounds[QueryIndex * ReferenceStride].Min, QueryDistance,
+									  [&Neighbors](int32 LotIndex) { Neighbors.Add(LotIndex); });
+		Neighbors.Sort();
+		Result.bEquivalent = Neighbors == LinearNeighbors[QueryIndex];
+	}
+
+	Result.MoveMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			NeighborIndex.Update(LotIndex, Bounds[LotIndex].ShiftBy(FVector2D(LotSpacing * 0.5, 0)));
+		}
+	});
+
+	Result.RemoveMs = MeasureMs([&]() {
+		for (int32 LotIndex = 0; LotIndex < NumShapes; ++LotIndex)
+		{
+			NeighborIndex.Remove(LotIndex);
+		}
+	});
+
+	return Result;
+}
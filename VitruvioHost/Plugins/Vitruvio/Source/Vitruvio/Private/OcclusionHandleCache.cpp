@@ -0,0 +1,255 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OcclusionHandleCache.h"
+
+#include "PRTTypes.h"
+#include "VitruvioModule.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Occlusion Handles Reused"), STAT_OcclusionHandles_Reused, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Occlusion Handles Generated"), STAT_OcclusionHandles_Generated, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Occlusion Lock Wait Time (ms)"), STAT_OcclusionLockWaitTime, STATGROUP_Vitruvio);
+
+namespace
+{
+/**
+ * \brief Scope lock which accumulates the time spent waiting if the lock is contended.
+ */
+class FTimedScopeLock
+{
+	FCriticalSection& Lock;
+
+public:
+	FTimedScopeLock(FCriticalSection& InLock, FThreadSafeCounter64& WaitTimeUs) : Lock(InLock)
+	{
+		if (!Lock.TryLock())
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Lock.Lock();
+			const double WaitTimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+			WaitTimeUs.Add(static_cast<int64>(WaitTimeMs * 1000.0));
+			INC_FLOAT_STAT_BY(STAT_OcclusionLockWaitTime, WaitTimeMs);
+		}
+	}
+
+	~FTimedScopeLock()
+	{
+		Lock.Unlock();
+	}
+};
+} // namespace
+
+struct FOcclusionHandleCache::FShard
+{
+	struct FEntry
+	{
+		FXxHash128 Key;
+		prt::OcclusionSet::Handle Handle;
+	};
+
+	FCriticalSection Lock;
+
+	/** The current handle per initial shape index. */
+	TMap<int64, FEntry> Entries;
+
+	/** The number of scopes using a handle. Also contains invalidated handles which are disposed once they are released. */
+	TMap<prt::OcclusionSet::Handle, int32> RefCounts;
+
+	bool IsCurrent(int64 InitialShapeIndex, prt::OcclusionSet::Handle Handle) const
+	{
+		const FEntry* Entry = Entries.Find(InitialShapeIndex);
+		return Entry && Entry->Handle == Handle;
+	}
+
+	/** Removes the entry of the given initial shape and disposes its handle unless it is still in use. */
+	void Remove(int64 InitialShapeIndex, prt::OcclusionSet& OcclusionSet)
+	{
+		FEntry Entry;
+		if (Entries.RemoveAndCopyValue(InitialShapeIndex, Entry) && !RefCounts.Contains(Entry.Handle))
+		{
+			OcclusionSet.dispose(&Entry.Handle, 1);
+		}
+	}
+};
+
+FOcclusionHandleCache::FScope::~FScope()
+{
+	Cache.Release(*this);
+}
+
+bool FOcclusionHandleCache::FScope::Acquire(int64 InitialShapeIndex, const FXxHash128& Key)
+{
+	FShard& Shard = Cache.GetShard(InitialShapeIndex);
+	FTimedScopeLock Lock(Shard.Lock, Cache.LockWaitTimeUs);
+
+	if (Generation != Cache.Generation)
+	{
+		return false;
+	}
+
+	const FShard::FEntry* Entry = Shard.Entries.Find(InitialShapeIndex);
+	if (!Entry)
+	{
+		return false;
+	}
+
+	if (Entry->Key != Key)
+	{
+		Shard.Remove(InitialShapeIndex, *OcclusionSet);
+		return false;
+	}
+
+	Shard.RefCounts.FindOrAdd(Entry->Handle)++;
+	Handles.Add(InitialShapeIndex, Entry->Handle);
+
+	Cache.NumReusedHandles.Increment();
+	INC_DWORD_STAT(STAT_OcclusionHandles_Reused);
+	return true;
+}
+
+void FOcclusionHandleCache::FScope::Add(int64 InitialShapeIndex, const FXxHash128& Key, prt::OcclusionSet::Handle Handle)
+{
+	Handles.Add(InitialShapeIndex, Handle);
+
+	Cache.NumGeneratedHandles.Increment();
+	INC_DWORD_STAT(STAT_OcclusionHandles_Generated);
+
+	FShard& Shard = Cache.GetShard(InitialShapeIndex);
+	FTimedScopeLock Lock(Shard.Lock, Cache.LockWaitTimeUs);
+
+	// The occlusion set has been reset in the meantime, the handle is only used by this scope
+	if (Generation != Cache.Generation)
+	{
+		return;
+	}
+
+	// Another generate call might have added a handle for the same initial shape concurrently
+	Shard.Remove(InitialShapeIndex, *OcclusionSet);
+
+	Shard.Entries.Add(InitialShapeIndex, {Key, Handle});
+	Shard.RefCounts.FindOrAdd(Handle)++;
+}
+
+FOcclusionHandleCache::FOcclusionHandleCache()
+{
+	for (int32 ShardIndex = 0; ShardIndex < NumShards; ++ShardIndex)
+	{
+		Shards.Add(MakeUnique<FShard>());
+	}
+}
+
+FOcclusionHandleCache::~FOcclusionHandleCache() = default;
+
+FOcclusionHandleCache::FShard& FOcclusionHandleCache::GetShard(int64 InitialShapeIndex) const
+{
+	return *Shards[GetTypeHash(InitialShapeIndex) % NumShards];
+}
+
+FOcclusionHandleCache::FScope FOcclusionHandleCache::BeginScope()
+{
+	FTimedScopeLock Lock(OcclusionSetLock, LockWaitTimeUs);
+
+	if (!OcclusionSet)
+	{
+		OcclusionSet = prt_make_shared(prt::OcclusionSet::create());
+	}
+
+	return FScope(*this, OcclusionSet, Generation);
+}
+
+void FOcclusionHandleCache::Release(const FScope& Scope)
+{
+	for (const auto& [InitialShapeIndex, Handle] : Scope.Handles)
+	{
+		FShard& Shard = GetShard(InitialShapeIndex);
+		FTimedScopeLock Lock(Shard.Lock, LockWaitTimeUs);
+
+		// Handles of a previous generation are destroyed together with their occlusion set
+		if (Scope.Generation != Generation)
+		{
+			return;
+		}
+
+		int32* RefCount = Shard.RefCounts.Find(Handle);
+		if (RefCount && --(*RefCount) == 0)
+		{
+			Shard.RefCounts.Remove(Handle);
+			if (!Shard.IsCurrent(InitialShapeIndex, Handle))
+			{
+				Scope.OcclusionSet->dispose(&Handle, 1);
+			}
+		}
+	}
+}
+
+void FOcclusionHandleCache::Invalidate(const TArray<int64>& InitialShapeIndices)
+{
+	std::shared_ptr<prt::OcclusionSet> CurrentOcclusionSet;
+	{
+		FTimedScopeLock Lock(OcclusionSetLock, LockWaitTimeUs);
+		CurrentOcclusionSet = OcclusionSet;
+	}
+
+	if (!CurrentOcclusionSet)
+	{
+		return;
+	}
+
+	for (const int64 InitialShapeIndex : InitialShapeIndices)
+	{
+		FShard& Shard = GetShard(InitialShapeIndex);
+		FTimedScopeLock Lock(Shard.Lock, LockWaitTimeUs);
+		Shard.Remove(InitialShapeIndex, *CurrentOcclusionSet);
+	}
+}
+
+void FOcclusionHandleCache::Reset()
+{
+	FTimedScopeLock Lock(OcclusionSetLock, LockWaitTimeUs);
+
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		Shard->Lock.Lock();
+	}
+
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		Shard->Entries.Empty();
+		Shard->RefCounts.Empty();
+	}
+
+	// Running scopes keep the previous occlusion set alive until they are finished
+	OcclusionSet.reset();
+	++Generation;
+
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		Shard->Lock.Unlock();
+	}
+}
+
+FOcclusionStats FOcclusionHandleCache::GetStats() const
+{
+	FOcclusionStats Stats;
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard->Lock);
+		Stats.NumHandles += Shard->Entries.Num();
+	}
+	Stats.NumReusedHandles = NumReusedHandles.GetValue();
+	Stats.NumGeneratedHandles = NumGeneratedHandles.GetValue();
+	Stats.LockWaitTimeMs = LockWaitTimeUs.GetValue() / 1000.0;
+	return Stats;
+}
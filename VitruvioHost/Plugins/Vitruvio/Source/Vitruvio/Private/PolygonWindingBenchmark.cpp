@@ -0,0 +1,210 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "PolygonWindingBenchmark.h"
+
+#include "PolygonWindings.h"
+
+namespace
+{
+constexpr double CellSize = 100.0;
+
+struct FSyntheticFootprint
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Indices;
+
+	int32 ExpectedFaces = 1;
+	int32 ExpectedHoles = 0;
+	int32 ExpectedWindingVertices = 0;
+};
+
+void AddQuad(TArray<int32>& Indices, int32 V00, int32 V10, int32 V11, int32 V01)
+{
+	Indices.Append({V00, V10, V11, V00, V11, V01});
+}
+
+/**
+ * \brief Adds a grid of NumCells x NumCells quads starting at Origin, leaving out the cells for which SkipCell returns true.
+ *
+ * \return the index of the first grid vertex. Vertex (X, Y) has index First + Y * (NumCells + 1) + X.
+ */
+template <typename SkipCellType>
+int32 AddGrid(FSyntheticFootprint& Footprint, const FVector& Origin, double Size, int32 NumCells, SkipCellType SkipCell)
+{
+	const int32 First = Footprint.Vertices.Num();
+	for (int32 Y = 0; Y <= NumCells; ++Y)
+	{
+		for (int32 X = 0; X <= NumCells; ++X)
+		{
+			Footprint.Vertices.Add(Origin + FVector(X * Size, Y * Size, 0));
+		}
+	}
+
+	for (int32 Y = 0; Y < NumCells; ++Y)
+	{
+		for (int32 X = 0; X < NumCells; ++X)
+		{
+			if (SkipCell(X, Y))
+			{
+				continue;
+			}
+
+			const int32 V00 = First + Y * (NumCells + 1) + X;
+			const int32 V10 = V00 + 1;
+			const int32 V01 = V00 + NumCells + 1;
+			const int32 V11 = V01 + 1;
+			AddQuad(Footprint.Indices, V00, V10, V11, V01);
+
+			// Degenerate triangles as left behind by welding slivers must not change the outline
+			if ((X + Y) % 5 == 0)
+			{
+				Footprint.Indices.Append({V00, V00, V11, V10, V11, V10});
+			}
+		}
+	}
+	return First;
+}
+
+FSyntheticFootprint CreateFootprint(int32 NumEdges)
+{
+	// Every cell consists of two triangles with three edges each
+	const int32 NumCells = FMath::Max(FMath::RoundToInt32(FMath::Sqrt(NumEdges / 6.0) / 3.0), 1) * 3;
+
+	FSyntheticFootprint Footprint;
+	Footprint.ExpectedWindingVertices = 4 * NumCells;
+
+	TArray<FVector> HoleOrigins;
+	const auto IsHole = [](int32 X, int32 Y) {
+		return X % 3 == 1 && Y % 3 == 1;
+	};
+	AddGrid(Footprint, FVector::ZeroVector, CellSize, NumCells, [&](int32 X, int32 Y) {
+		if (IsHole(X, Y))
+		{
+			HoleOrigins.Add(FVector(X * CellSize, Y * CellSize, 0));
+			return true;
+		}
+		return false;
+	});
+
+	for (int32 HoleIndex = 0; HoleIndex < HoleOrigins.Num(); ++HoleIndex)
+	{
+		const FVector& Origin = HoleOrigins[HoleIndex];
+		Footprint.ExpectedHoles++;
+		Footprint.ExpectedWindingVertices += 4;
+
+		if (HoleIndex % 3 == 1)
+		{
+			// Island
+			AddGrid(Footprint, Origin + FVector(0.25, 0.25, 0) * CellSize, 0.5 * CellSize, 1, [](int32, int32) { return false; });
+			Footprint.ExpectedFaces++;
+			Footprint.ExpectedWindingVertices += 4;
+		}
+		else if (HoleIndex % 3 == 2)
+		{
+			// Island with a hole which contains another island
+			AddGrid(Footprint, Origin + FVector(0.2, 0.2, 0) * CellSize, 0.2 * CellSize, 3, IsHole);
+			AddGrid(Footprint, Origin + FVector(0.45, 0.45, 0) * CellSize, 0.1 * CellSize, 1, [](int32, int32) { return false; });
+			Footprint.ExpectedFaces += 2;
+			Footprint.ExpectedHoles++;
+			Footprint.ExpectedWindingVertices += 12 + 4 + 4;
+		}
+	}
+
+	return Footprint;
+}
+
+double GetSignedArea2D(const TArray<int32>& Indices, const TArray<FVector>& Vertices)
+{
+	double DoubleSignedArea = 0;
+	for (int32 Index = 0; Index < Indices.Num(); ++Index)
+	{
+		const FVector& Current = Vertices[Indices[Index]];
+		const FVector& Next = Vertices[Indices[(Index + 1) % Indices.Num()]];
+		DoubleSignedArea += Current.X * Next.Y - Next.X * Current.Y;
+	}
+	return DoubleSignedArea * 0.5;
+}
+
+bool PointInPolygon2D(const FVector& Point, const TArray<int32>& Indices, const TArray<FVector>& Vertices)
+{
+	bool bIsInside = false;
+	for (int32 Index = 0; Index < Indices.Num(); ++Index)
+	{
+		const FVector& Current = Vertices[Indices[Index]];
+		const FVector& Next = Vertices[Indices[(Index + 1) % Indices.Num()]];
+		if ((Current.Y < Point.Y) != (Next.Y < Point.Y) &&
+			Current.X + (Point.Y - Current.Y) / (Next.Y - Current.Y) * (Next.X - Current.X) < Point.X)
+		{
+			bIsInside = !bIsInside;
+		}
+	}
+	return bIsInside;
+}
+
+bool IsValid(const FInitialShapePolygon& Polygon, const FSyntheticFootprint& Footprint, int32 NumHoles)
+{
+	if (Polygon.Faces.Num() != Footprint.ExpectedFaces || NumHoles != Footprint.ExpectedHoles)
+	{
+		return false;
+	}
+
+	int32 NumWindingVertices = 0;
+	for (const FInitialShapeFace& Face : Polygon.Faces)
+	{
+		const double FaceArea = GetSignedArea2D(Face.Indices, Polygon.Vertices);
+		if (Face.Indices.Num() < 3 || FaceArea <= 0)
+		{
+			return false;
+		}
+		NumWindingVertices += Face.Indices.Num();
+
+		// Holes lie inside of their face and are wound the other way around
+		for (const FInitialShapeHole& Hole : Face.Holes)
+		{
+			if (Hole.Indices.Num() < 3 || GetSignedArea2D(Hole.Indices, Polygon.Vertices) >= 0 ||
+				!PointInPolygon2D(Polygon.Vertices[Hole.Indices[0]], Face.Indices, Polygon.Vertices))
+			{
+				return false;
+			}
+			NumWindingVertices += Hole.Indices.Num();
+		}
+	}
+
+	return NumWindingVertices == Footprint.ExpectedWindingVertices;
+}
+} // namespace
+
+FPolygonWindingBenchmarkResult RunPolygonWindingBenchmark(int32 NumEdges)
+{
+	const FSyntheticFootprint Footprint = CreateFootprint(NumEdges);
+
+	FPolygonWindingBenchmarkResult Result;
+	Result.NumEdges = Footprint.Indices.Num();
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FInitialShapePolygon Polygon = Vitruvio::GetPolygon(Footprint.Vertices, Footprint.Indices);
+	Result.GetPolygonMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	Result.NumFaces = Polygon.Faces.Num();
+	for (const FInitialShapeFace& Face : Polygon.Faces)
+	{
+		Result.NumHoles += Face.Holes.Num();
+	}
+	Result.bValid = IsValid(Polygon, Footprint, Result.NumHoles);
+
+	return Result;
+}
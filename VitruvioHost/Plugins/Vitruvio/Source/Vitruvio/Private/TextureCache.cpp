@@ -0,0 +1,246 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "TextureCache.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "VitruvioModule.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Texture Cache Hits"), STAT_TextureCache_Hits, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Texture Cache Misses"), STAT_TextureCache_Misses, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Texture Cache Evictions"), STAT_TextureCache_Evictions, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Texture Cache Deduplicated"), STAT_TextureCache_Deduplicated, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Texture Cache Entries"), STAT_TextureCache_Entries, STATGROUP_Vitruvio);
+DECLARE_MEMORY_STAT(TEXT("Texture Cache Memory"), STAT_TextureCache_Memory, STATGROUP_Vitruvio);
+
+bool FTextureCache::Find(const FString& Path, Vitruvio::FTextureData& OutTextureData)
+{
+	uint64 ContentHash = 0;
+	{
+		FShard& PathShard = GetShard(GetTypeHash(Path));
+		FScopeLock Lock(&PathShard.Lock);
+		FPathEntry* PathEntry = PathShard.Paths.Find(Path);
+		if (!PathEntry)
+		{
+			NumMisses.Increment();
+			INC_DWORD_STAT(STAT_TextureCache_Misses);
+			return false;
+		}
+
+		const uint32 CurrentGeneration = Generation;
+		if (PathEntry->Generation != CurrentGeneration)
+		{
+			const FDateTime FileSystemTimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*Path);
+			if (FileSystemTimeStamp > PathEntry->LoadTime)
+			{
+				// The file has changed since the texture was loaded, so it has to be reloaded. The old content stays cached until it is evicted
+				// since other paths might share it.
+				PathShard.Paths.Remove(Path);
+				NumChanged.Increment();
+				NumMisses.Increment();
+				INC_DWORD_STAT(STAT_TextureCache_Misses);
+				return false;
+			}
+			PathEntry->Generation = CurrentGeneration;
+		}
+		ContentHash = PathEntry->ContentHash;
+	}
+
+	FShard& TextureShard = GetShard(static_cast<uint32>(ContentHash));
+	FScopeLock Lock(&TextureShard.Lock);
+	FTextureEntry* Entry = TextureShard.Textures.Find(ContentHash);
+	if (!Entry)
+	{
+		// The texture has been evicted, the path is updated once the texture has been reloaded
+		NumMisses.Increment();
+		INC_DWORD_STAT(STAT_TextureCache_Misses);
+		return false;
+	}
+
+	Touch(TextureShard, *Entry);
+
+	NumHits.Increment();
+	INC_DWORD_STAT(STAT_TextureCache_Hits);
+	OutTextureData = Entry->TextureData;
+	return true;
+}
+
+Vitruvio::FTextureData FTextureCache::InsertOrGet(const FString& Path, const Vitruvio::FTextureData& TextureData)
+{
+	const uint64 ContentHash = TextureData.ContentHash;
+	Vitruvio::FTextureData Result = TextureData;
+	bool bInserted = false;
+	{
+		FShard& TextureShard = GetShard(static_cast<uint32>(ContentHash));
+		FScopeLock Lock(&TextureShard.Lock);
+		if (FTextureEntry* Entry = TextureShard.Textures.Find(ContentHash))
+		{
+			// Either the same image under a different path or the same path loaded by concurrent generate results
+			Touch(TextureShard, *Entry);
+			Result = Entry->TextureData;
+
+			NumDeduplicated.Increment();
+			INC_DWORD_STAT(STAT_TextureCache_Deduplicated);
+		}
+		else
+		{
+			TextureShard.LruList.AddHead(ContentHash);
+			TextureShard.Textures.Add(ContentHash, FTextureEntry{TextureData, TextureShard.LruList.GetHead(), ++UseClock});
+			MemoryUsage += TextureData.MemorySize;
+			INC_MEMORY_STAT_BY(STAT_TextureCache_Memory, TextureData.MemorySize);
+			INC_DWORD_STAT(STAT_TextureCache_Entries);
+			bInserted = true;
+		}
+	}
+
+	if (bInserted)
+	{
+		EvictToBudget(ContentHash);
+	}
+
+	{
+		FShard& PathShard = GetShard(GetTypeHash(Path));
+		FScopeLock Lock(&PathShard.Lock);
+		PathShard.Paths.Add(Path, FPathEntry{ContentHash, TextureData.LoadTime, Generation});
+	}
+
+	return Result;
+}
+
+void FTextureCache::Invalidate()
+{
+	++Generation;
+}
+
+void FTextureCache::Empty()
+{
+	for (FShard& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Lock);
+		DEC_DWORD_STAT_BY(STAT_TextureCache_Entries, Shard.Textures.Num());
+
+		for (const auto& [ContentHash, Entry] : Shard.Textures)
+		{
+			MemoryUsage -= Entry.TextureData.MemorySize;
+			DEC_MEMORY_STAT_BY(STAT_TextureCache_Memory, Entry.TextureData.MemorySize);
+		}
+
+		Shard.Paths.Empty();
+		Shard.Textures.Empty();
+		Shard.LruList.Empty();
+	}
+}
+
+void FTextureCache::SetMemoryBudget(int64 NewMemoryBudget)
+{
+	MemoryBudget = FMath::Max<int64>(0, NewMemoryBudget);
+	EvictToBudget({});
+}
+
+FTextureCacheStats FTextureCache::GetStats() const
+{
+	FTextureCacheStats Stats;
+	Stats.NumHits = NumHits.GetValue();
+	Stats.NumMisses = NumMisses.GetValue();
+	Stats.NumEvictions = NumEvictions.GetValue();
+	Stats.NumDeduplicated = NumDeduplicated.GetValue();
+	Stats.NumChanged = NumChanged.GetValue();
+	Stats.MemoryBudget = MemoryBudget;
+	Stats.Generation = Generation;
+	Stats.MemoryUsage = MemoryUsage;
+
+	for (const FShard& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Lock);
+		Stats.NumTextures += Shard.Textures.Num();
+		Stats.NumPaths += Shard.Paths.Num();
+	}
+	return Stats;
+}
+
+void FTextureCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FShard& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Lock);
+		for (auto& [ContentHash, Entry] : Shard.Textures)
+		{
+			Collector.AddReferencedObject(Entry.TextureData.Texture);
+		}
+	}
+}
+
+void FTextureCache::Touch(FShard& Shard, FTextureEntry& Entry)
+{
+	Shard.LruList.RemoveNode(Entry.LruNode, false);
+	Shard.LruList.AddHead(Entry.LruNode);
+	Entry.LastUse = ++UseClock;
+}
+
+void FTextureCache::EvictToBudget(TOptional<uint64> KeepContentHash)
+{
+	auto IsKept = [&KeepContentHash](const FLruList::TDoubleLinkedListNode* Node) {
+		return KeepContentHash.IsSet() && Node->GetValue() == KeepContentHash.GetValue();
+	};
+
+	// Paths of evicted textures are not removed here since they live in other shards, they are treated as misses on their next lookup
+	while (MemoryUsage > MemoryBudget)
+	{
+		// Find the shard whose least recently used texture is the oldest one. Textures might be used concurrently, so this is only
+		// approximately the least recently used texture of the whole cache.
+		FShard* OldestShard = nullptr;
+		uint64 OldestUse = MAX_uint64;
+		for (FShard& Shard : Shards)
+		{
+			FScopeLock Lock(&Shard.Lock);
+			const FLruList::TDoubleLinkedListNode* Node = Shard.LruList.GetTail();
+			if (!Node || IsKept(Node))
+			{
+				continue;
+			}
+
+			const uint64 LastUse = Shard.Textures.FindChecked(Node->GetValue()).LastUse;
+			if (LastUse < OldestUse)
+			{
+				OldestUse = LastUse;
+				OldestShard = &Shard;
+			}
+		}
+
+		if (!OldestShard)
+		{
+			break;
+		}
+
+		FScopeLock Lock(&OldestShard->Lock);
+		FLruList::TDoubleLinkedListNode* Node = OldestShard->LruList.GetTail();
+		if (!Node || IsKept(Node))
+		{
+			continue;
+		}
+
+		FTextureEntry EvictedEntry;
+		OldestShard->Textures.RemoveAndCopyValue(Node->GetValue(), EvictedEntry);
+		OldestShard->LruList.RemoveNode(Node);
+
+		MemoryUsage -= EvictedEntry.TextureData.MemorySize;
+		DEC_MEMORY_STAT_BY(STAT_TextureCache_Memory, EvictedEntry.TextureData.MemorySize);
+		DEC_DWORD_STAT(STAT_TextureCache_Entries);
+
+		NumEvictions.Increment();
+		INC_DWORD_STAT(STAT_TextureCache_Evictions);
+	}
+}
@@ -0,0 +1,113 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "TextureDecodeBenchmark.h"
+
+#include "Util/TextureDecoding.h"
+
+namespace
+{
+// Every format is measured for at least this long to get stable numbers for small textures
+constexpr double MinMeasureSeconds = 0.5;
+
+template <typename FunctionType>
+double MeasureMegapixelsPerSecond(int64 NumPixels, FunctionType Function)
+{
+	int32 Iterations = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	double ElapsedSeconds = 0;
+	do
+	{
+		Function();
+		++Iterations;
+		ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+	} while (ElapsedSeconds < MinMeasureSeconds);
+
+	return static_cast<double>(NumPixels) * Iterations / 1000000.0 / ElapsedSeconds;
+}
+
+FTextureDecodeBenchmarkResult MeasureFormat(const TCHAR* Format, Vitruvio::EPRTPixelFormat PixelFormat, size_t Bands, size_t BytesPerBand,
+											int32 Size)
+{
+	Vitruvio::FTextureMetadata TextureMetadata;
+	TextureMetadata.Width = Size;
+	TextureMetadata.Height = Size;
+	TextureMetadata.Bands = Bands;
+	TextureMetadata.BytesPerBand = BytesPerBand;
+	TextureMetadata.PixelFormat = PixelFormat;
+
+	const int64 NumPixels = static_cast<int64>(Size) * Size;
+	const EPixelFormat UnrealPixelFormat = Vitruvio::GetUnrealPixelFormat(PixelFormat);
+
+	// Random bytes are valid pixels for all formats, float pixels are kept in [0, 1] to avoid denormals and infinities
+	TArray<uint8> Src;
+	Src.SetNumUninitialized(NumPixels * Bands * BytesPerBand);
+	FRandomStream RandomStream(0);
+	if (PixelFormat == Vitruvio::EPRTPixelFormat::FLOAT32)
+	{
+		float* Floats = reinterpret_cast<float*>(Src.GetData());
+		for (int64 Index = 0; Index < NumPixels; ++Index)
+		{
+			Floats[Index] = RandomStream.GetFraction();
+		}
+	}
+	else
+	{
+		for (uint8& Byte : Src)
+		{
+			Byte = static_cast<uint8>(RandomStream.RandHelper(256));
+		}
+	}
+
+	const int32 NumMips = Vitruvio::GetNumMips(Size, Size);
+	TArray<TArray<uint8>> Mips;
+	Mips.SetNum(NumMips);
+	for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+	{
+		const int32 MipSize = FMath::Max(1, Size >> MipIndex);
+		Mips[MipIndex].SetNumUninitialized(CalculateImageBytes(MipSize, MipSize, 0, UnrealPixelFormat));
+	}
+
+	FTextureDecodeBenchmarkResult Result;
+	Result.Format = Format;
+	Result.ConvertMegapixelsPerSecond =
+		MeasureMegapixelsPerSecond(NumPixels, [&]() { Vitruvio::ConvertPixels(TextureMetadata, Src.GetData(), Mips[0].GetData()); });
+	Result.MipChainMegapixelsPerSecond = MeasureMegapixelsPerSecond(NumPixels, [&]() {
+		for (int32 MipIndex = 1; MipIndex < NumMips; ++MipIndex)
+		{
+			const int32 PreviousMipSize = FMath::Max(1, Size >> (MipIndex - 1));
+			Vitruvio::DownsampleMip(UnrealPixelFormat, Mips[MipIndex - 1].GetData(), PreviousMipSize, PreviousMipSize, Mips[MipIndex].GetData());
+		}
+	});
+	if (UnrealPixelFormat != PF_FloatRGBA)
+	{
+		Result.OpacityMegapixelsPerSecond = MeasureMegapixelsPerSecond(
+			NumPixels, [&]() { Vitruvio::ClassifyOpacity(UnrealPixelFormat, Mips[0].GetData(), Size, Size); });
+	}
+	return Result;
+}
+} // namespace
+
+TArray<FTextureDecodeBenchmarkResult> RunTextureDecodeBenchmark(int32 Size)
+{
+	TArray<FTextureDecodeBenchmarkResult> Results;
+	Results.Add(MeasureFormat(TEXT("GREY8"), Vitruvio::EPRTPixelFormat::GREY8, 1, 1, Size));
+	Results.Add(MeasureFormat(TEXT("GREY16"), Vitruvio::EPRTPixelFormat::GREY16, 1, 2, Size));
+	Results.Add(MeasureFormat(TEXT("RGB8"), Vitruvio::EPRTPixelFormat::RGB8, 3, 1, Size));
+	Results.Add(MeasureFormat(TEXT("RGBA8"), Vitruvio::EPRTPixelFormat::RGBA8, 4, 1, Size));
+	Results.Add(MeasureFormat(TEXT("FLOAT32"), Vitruvio::EPRTPixelFormat::FLOAT32, 1, 4, Size));
+	return Results;
+}
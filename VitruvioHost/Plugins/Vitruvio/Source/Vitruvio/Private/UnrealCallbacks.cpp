@@ -31,6 +31,10 @@
 
 DEFINE_LOG_CATEGORY(LogUnrealCallbacks);
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Material Conversions Avoided"), STAT_MaterialConversionsAvoided, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Encoder Material Conversions"), STAT_EncoderMaterialConversions, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Encoder Material Cache Hits"), STAT_EncoderMaterialCacheHits, STATGROUP_Vitruvio);
+
 namespace
 {
 
@@ -74,19 +78,31 @@ const TMap<Vitruvio::EUnrealUvSetType, FString> UnrealUVSetToMaterialParamString
 };
 // clang-format on
 
-TMap<FString, double> CreateAvailableUVSetMaterialParameterMap(uint32_t const* const* UVCounts, size_t UVSets)
+template <typename T>
+uint32 GetAvailableUVSetMask(T const* const* UVCounts, size_t UVSets)
 {
-	TMap<FString, double> AvailableUvSetAttributeMap;
+	uint32 AvailableUVSets = 0;
+	for (size_t PrtUvSet = 0; PrtUvSet < UVSets && PrtUvSet < 32; ++PrtUvSet)
+	{
+		if (UVCounts[PrtUvSet] != nullptr)
+		{
+			AvailableUVSets |= 1u << PrtUvSet;
+		}
+	}
+	return AvailableUVSets;
+}
 
+void AddAvailableUVSetMaterialParameters(Vitruvio::FMaterialAttributeContainer& MaterialContainer, uint32 AvailableUVSets)
+{
 	// Check which uv sets are available and set the corresponding information in the MaterialContainer
-	for (size_t PrtUvSet = 0; PrtUvSet < UVSets; ++PrtUvSet)
+	for (uint32 PrtUvSet = 0; AvailableUVSets >> PrtUvSet; ++PrtUvSet)
 	{
 		const Vitruvio::EUnrealUvSetType* UnrealUVSetPtr = PRTToUnrealUVSetMap.Find(static_cast<Vitruvio::EPrtUvSetType>(PrtUvSet));
 		bool bIsValidUnrealUVSet = (UnrealUVSetPtr != nullptr);
 
 		if (bIsValidUnrealUVSet)
 		{
-			bool bHasUVSet = UVCounts[PrtUvSet] != nullptr;
+			bool bHasUVSet = (AvailableUVSets & (1u << PrtUvSet)) != 0;
 
 			const Vitruvio::EUnrealUvSetType UnrealUVSet = *UnrealUVSetPtr;
 			if (UnrealUVSet != Vitruvio::EUnrealUvSetType::ColorMap && UnrealUVSet != Vitruvio::EUnrealUvSetType::None)
@@ -95,16 +111,16 @@ TMap<FString, double> CreateAvailableUVSetMaterialParameterMap(uint32_t const* c
 
 				if (bHasUVSet)
 				{
-					AvailableUvSetAttributeMap.Add(UVSetMaterialParamString, 1.0);
+					MaterialContainer.ScalarProperties.Add(UVSetMaterialParamString, 1.0);
 				}
 			}
 		}
 	}
-	return AvailableUvSetAttributeMap;
 }
 
 FModelDescription ConvertMesh(const double* vtx, size_t vtxSize, const double* nrm, size_t nrmSize, const uint32_t* faceVertexCounts, size_t faceVertexCountsSize, const uint32_t* vertexIndices, size_t vertexIndicesSize, const uint32_t* normalIndices, size_t normalIndicesSize,
-	double const* const* uvs, uint32_t const* const* uvCounts, uint32_t const* const* uvIndices, size_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials, const FVector3f& VertexOffset = FVector3f::ZeroVector)
+	double const* const* uvs, uint32_t const* const* uvCounts, uint32_t const* const* uvIndices, size_t uvSets, const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials,
+	FMaterialConversionCache& MaterialConversionCache, const FVector3f& VertexOffset = FVector3f::ZeroVector)
 {
 	FModelDescription ModelDescription;
     FStaticMeshAttributes Attributes(ModelDescription.MeshDescription);
@@ -126,17 +142,13 @@ FModelDescription ConvertMesh(const double* vtx, size_t vtxSize, const double* n
 	BaseUVIndex.Init(0, uvSets);
 
 	size_t PolygonGroupStartIndex = 0;
+	const uint32 AvailableUVSets = GetAvailableUVSetMask(uvCounts, uvSets);
 	
 	for (size_t PolygonGroupIndex = 0; PolygonGroupIndex < faceRangesSize; ++PolygonGroupIndex)
 	{
 		const size_t PolygonFaceCount = faceRanges[PolygonGroupIndex];
 
-		Vitruvio::FMaterialAttributeContainer MaterialContainer(materials[PolygonGroupIndex]);
-		TMap<FString, double> AvailableUvSetAttributeMap = CreateAvailableUVSetMaterialParameterMap(uvCounts, uvSets);
-		for (auto& AvailableUvSetAttribute : AvailableUvSetAttributeMap)
-		{
-			MaterialContainer.ScalarProperties.Add(AvailableUvSetAttribute);
-		}
+		const Vitruvio::FMaterialAttributeContainer MaterialContainer = MaterialConversionCache.Convert(materials[PolygonGroupIndex], AvailableUVSets);
 
 		FPolygonGroupID PolygonGroupId;
 		if (ModelDescription.MaterialToPolygonMap.Contains(MaterialContainer))
@@ -213,6 +225,92 @@ FModelDescription ConvertMesh(const double* vtx, size_t vtxSize, const double* n
 	return ModelDescription;
 }
 
+FModelDescription ConvertMeshV2(const UnrealMeshV2& Mesh, FMaterialConversionCache& MaterialConversionCache,
+							   const FVector3f& VertexOffset = FVector3f::ZeroVector)
+{
+	FModelDescription ModelDescription;
+	FMeshDescription& MeshDescription = ModelDescription.MeshDescription;
+	FStaticMeshAttributes Attributes(MeshDescription);
+	Attributes.Register();
+
+	const auto VertexUVs = Attributes.GetVertexInstanceUVs();
+	VertexUVs.SetNumChannels(8);
+
+	const int32 VertexCount = static_cast<int32>(Mesh.vertexCount);
+	const int32 TriangleCount = static_cast<int32>(Mesh.triangleCount);
+	MeshDescription.ReserveNewVertices(VertexCount);
+	MeshDescription.ReserveNewVertexInstances(VertexCount);
+	MeshDescription.ReserveNewTriangles(TriangleCount);
+	MeshDescription.ReserveNewPolygons(TriangleCount);
+
+	// Every vertex has exactly one vertex instance with the same index, so the attributes are written directly into the attribute arrays
+	for (int32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+	{
+		MeshDescription.CreateVertexInstance(MeshDescription.CreateVertex());
+	}
+
+	const TArrayView<FVector3f> VertexPositions = Attributes.GetVertexPositions().GetRawArray();
+	const TArrayView<FVector3f> Normals = Attributes.GetVertexInstanceNormals().GetRawArray();
+	for (int32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+	{
+		const float* Position = Mesh.positions + VertexIndex * 3;
+		const float* Normal = Mesh.normals + VertexIndex * 3;
+		VertexPositions[VertexIndex] = FVector3f(Position[0], Position[2], Position[1]) * PRT_TO_UE_SCALE - VertexOffset;
+		Normals[VertexIndex] = FVector3f(Normal[0], Normal[2], Normal[1]);
+	}
+
+	for (size_t PrtUVSet = 0; PrtUVSet < Mesh.uvSets; ++PrtUVSet)
+	{
+		const Vitruvio::EUnrealUvSetType* UnrealUVSetPtr = PRTToUnrealUVSetMap.Find(static_cast<Vitruvio::EPrtUvSetType>(PrtUVSet));
+		if (!UnrealUVSetPtr || !Mesh.uvs[PrtUVSet])
+		{
+			continue;
+		}
+
+		const TArrayView<FVector2f> UVs = VertexUVs.GetRawArray(static_cast<int32>(*UnrealUVSetPtr));
+		const float* PrtUVs = Mesh.uvs[PrtUVSet];
+		for (int32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+		{
+			UVs[VertexIndex] = FVector2f(PrtUVs[VertexIndex * 2], -PrtUVs[VertexIndex * 2 + 1]);
+		}
+	}
+
+	const uint32 AvailableUVSets = GetAvailableUVSetMask(Mesh.uvs, Mesh.uvSets);
+
+	size_t TriangleIndex = 0;
+	for (size_t PolygonGroupIndex = 0; PolygonGroupIndex < Mesh.triangleRangesSize; ++PolygonGroupIndex)
+	{
+		const Vitruvio::FMaterialAttributeContainer MaterialContainer = MaterialConversionCache.Convert(Mesh.materials[PolygonGroupIndex], AvailableUVSets);
+
+		FPolygonGroupID PolygonGroupId;
+		if (const FPolygonGroupID* ExistingPolygonGroupId = ModelDescription.MaterialToPolygonMap.Find(MaterialContainer))
+		{
+			PolygonGroupId = *ExistingPolygonGroupId;
+		}
+		else
+		{
+			ModelDescription.Materials.Add(MaterialContainer);
+			PolygonGroupId = MeshDescription.CreatePolygonGroup();
+			ModelDescription.MaterialToPolygonMap.Add(MaterialContainer, PolygonGroupId);
+		}
+
+		const size_t RangeEnd = FMath::Min<size_t>(TriangleIndex + Mesh.triangleRanges[PolygonGroupIndex], Mesh.triangleCount);
+		for (; TriangleIndex < RangeEnd; ++TriangleIndex)
+		{
+			const uint32_t* Indices = Mesh.indices + TriangleIndex * 3;
+			check(Indices[0] < Mesh.vertexCount && Indices[1] < Mesh.vertexCount && Indices[2] < Mesh.vertexCount);
+
+			const FVertexInstanceID TriangleVertexInstances[3] = {FVertexInstanceID(Indices[0]), FVertexInstanceID(Indices[1]),
+																  FVertexInstanceID(Indices[2])};
+			MeshDescription.CreateTriangle(PolygonGroupId, TriangleVertexInstances);
+		}
+	}
+
+	ModelDescription.VertexIndexOffset += Mesh.vertexCount;
+
+	return ModelDescription;
+}
+
 TSharedPtr<FVitruvioMesh> CreateVitruvioMesh(const FString& Identifier, FMeshDescription Description, TArray<Vitruvio::FMaterialAttributeContainer> ModelMaterials)
 {
 	bool bHasInvalidNormals;
@@ -280,6 +378,27 @@ TMap<FString, FReport> ExtractReports(const prt::AttributeMap* reports)
 
 } // namespace
 
+Vitruvio::FMaterialAttributeContainer FMaterialConversionCache::Convert(const prt::AttributeMap* Material, uint32 AvailableUVSets)
+{
+	if (bEnabled)
+	{
+		if (const Vitruvio::FMaterialAttributeContainer* CachedMaterial = Cache.Find({Material, AvailableUVSets}))
+		{
+			INC_DWORD_STAT(STAT_MaterialConversionsAvoided);
+			return *CachedMaterial;
+		}
+	}
+
+	Vitruvio::FMaterialAttributeContainer MaterialContainer(Material);
+	AddAvailableUVSetMaterialParameters(MaterialContainer, AvailableUVSets);
+	MaterialContainer.Intern();
+
+	if (bEnabled)
+	{
+		Cache.Add({Material, AvailableUVSets}, MaterialContainer);
+	}
+	return MaterialContainer;
+}
 
 void UnrealCallbacks::init()
 {
@@ -298,33 +417,112 @@ void UnrealCallbacks::addMesh(const wchar_t* name, const wchar_t* meshId, int32_
                               uint32_t const* const* uvIndices, size_t const* uvIndicesSizes, size_t uvSets,
 
                               const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials)
+{
+	addInitialShapeMesh(UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX, name, meshId, prototypeId, uri, vtx, vtxSize, nrm, nrmSize, faceVertexCounts,
+						faceVertexCountsSize, vertexIndices, vertexIndicesSize, normalIndices, normalIndicesSize, uvs, uvsSizes, uvCounts,
+						uvCountsSizes, uvIndices, uvIndicesSizes, uvSets, faceRanges, faceRangesSize, materials);
+}
+
+void UnrealCallbacks::addInitialShapeMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+										  const wchar_t* uri, const double* vtx, size_t vtxSize, const double* nrm, size_t nrmSize,
+										  const uint32_t* faceVertexCounts, size_t faceVertexCountsSize, const uint32_t* vertexIndices,
+										  size_t vertexIndicesSize, const uint32_t* normalIndices, size_t normalIndicesSize,
+
+										  double const* const* uvs, size_t const* uvsSizes, uint32_t const* const* uvCounts,
+										  size_t const* uvCountsSizes, uint32_t const* const* uvIndices, size_t const* uvIndicesSizes, size_t uvSets,
+
+										  const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials)
+{
+	AddMesh(initialShapeIndex, name, meshId, prototypeId, [&](const FVector3f& VertexOffset) {
+		return ConvertMesh(vtx, vtxSize, nrm, nrmSize, faceVertexCounts, faceVertexCountsSize, vertexIndices, vertexIndicesSize, normalIndices,
+						   normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials, MaterialConversionCache,
+						   VertexOffset);
+	});
+}
+
+void UnrealCallbacks::addMeshV2(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId, const wchar_t* uri,
+								const UnrealMeshV2& mesh)
+{
+	AddMesh(initialShapeIndex, name, meshId, prototypeId,
+			[this, &mesh](const FVector3f& VertexOffset) { return ConvertMeshV2(mesh, MaterialConversionCache, VertexOffset); });
+
+	// The mesh is copied into the mesh description, so the encoder can reuse its memory right away
+	if (mesh.arena)
+	{
+		mesh.arena->release();
+	}
+}
+
+const FCachedMeshIds& UnrealCallbacks::PinCachedMeshes(FMeshCache& MeshCache)
+{
+	MeshCachePin = MakeUnique<FMeshCache::FPin>(MeshCache);
+	return MeshCachePin->GetCachedMeshIds();
+}
+
+void UnrealCallbacks::addCachedMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+									const wchar_t* uri)
+{
+	const FString IdentifierString(meshId);
+
+	// Resolving the handle also marks the mesh as recently used
+	FMeshCache& MeshCache = VitruvioModule::Get().GetMeshCache();
+	const TSharedPtr<FVitruvioMesh> Mesh = MeshCachePin ? MeshCache.Get(MeshCache.GetHandle(IdentifierString)) : nullptr;
+	if (!Mesh)
+	{
+		UE_LOG(LogUnrealCallbacks, Warning, TEXT("No cached mesh found for meshId %s"), meshId);
+		return;
+	}
+
+	InstanceMeshes.Add(IdentifierString, Mesh);
+	InstanceNames.Add(IdentifierString, FString(name));
+
+	MeshCache.AddSkippedBytes(Mesh->GetEstimatedSize());
+}
+
+void UnrealCallbacks::addMaterialCacheStats(size_t conversions, size_t cacheHits)
+{
+	INC_DWORD_STAT_BY(STAT_EncoderMaterialConversions, conversions);
+	INC_DWORD_STAT_BY(STAT_EncoderMaterialCacheHits, cacheHits);
+}
+
+void UnrealCallbacks::AddMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+							  TFunctionRef<FModelDescription(const FVector3f& VertexOffset)> ConvertMesh)
 {
 	if (prototypeId == NoPrototypeIndex)
 	{
-		ModelDescription = ConvertMesh(vtx, vtxSize, nrm, nrmSize, faceVertexCounts, faceVertexCountsSize, vertexIndices, vertexIndicesSize,
-			normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials, FVector3f(Offset));
+		FModelDescription ConvertedModelDescription = ConvertMesh(FVector3f(GetOffset(initialShapeIndex)));
+
+		if (initialShapeIndex == UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX)
+		{
+			ModelDescription = MoveTemp(ConvertedModelDescription);
+		}
+		else
+		{
+			InitialShapeModelDescriptions.Add(initialShapeIndex, MoveTemp(ConvertedModelDescription));
+		}
 	}
 	else
 	{
 		const FString NameString(name);
 		const FString IdentifierString(meshId);
 
-		if (const TSharedPtr<FVitruvioMesh> Mesh = VitruvioModule::Get().GetMeshCache().Get(IdentifierString))
+		FMeshCache& MeshCache = VitruvioModule::Get().GetMeshCache();
+		const FMeshHandle MeshHandle = MeshCache.GetHandle(IdentifierString);
+		if (const TSharedPtr<FVitruvioMesh> Mesh = MeshCache.Get(MeshHandle))
 		{
 			InstanceMeshes.Add(meshId, Mesh);
 			InstanceNames.Add(meshId, NameString);
 			return;
 		}
 		
-		FModelDescription InstanceModelDescription = ConvertMesh(vtx, vtxSize, nrm, nrmSize, faceVertexCounts, faceVertexCountsSize,
-			vertexIndices, vertexIndicesSize, normalIndices, normalIndicesSize, uvs, uvCounts, uvIndices, uvSets, faceRanges, faceRangesSize, materials);
+		FModelDescription InstanceModelDescription = ConvertMesh(FVector3f::ZeroVector);
 
 		if (!InstanceModelDescription.MeshDescription.IsEmpty())
 		{
 			InstanceModelDescription.MeshDescription.TriangulateMesh();
 			
 			TSharedPtr<FVitruvioMesh> Mesh = CreateVitruvioMesh(IdentifierString, InstanceModelDescription.MeshDescription, InstanceModelDescription.Materials);
-			Mesh = VitruvioModule::Get().GetMeshCache().InsertOrGet(IdentifierString, Mesh);
+			Mesh = MeshCache.InsertOrGet(MeshHandle, Mesh);
 
 			InstanceMeshes.Add(meshId, Mesh);
 			InstanceNames.Add(meshId, NameString);
@@ -338,6 +536,17 @@ void UnrealCallbacks::finish()
 	{
 		GeneratedModel = CreateVitruvioMesh(TEXT("GeneratedMesh"), ModelDescription.MeshDescription, ModelDescription.Materials);
 	}
+
+	for (const auto& [InitialShapeIndex, InitialShapeModelDescription] : InitialShapeModelDescriptions)
+	{
+		if (!InitialShapeModelDescription.MeshDescription.IsEmpty())
+		{
+			const FString Identifier = FString::Printf(TEXT("GeneratedMesh_%d"), InitialShapeIndex);
+			InitialShapeGeneratedModels.Add(InitialShapeIndex, CreateVitruvioMesh(Identifier, InitialShapeModelDescription.MeshDescription,
+																				  InitialShapeModelDescription.Materials));
+		}
+	}
+	InitialShapeModelDescriptions.Empty();
 }
 
 void UnrealCallbacks::addReport(const prt::AttributeMap* reports)
@@ -352,7 +561,13 @@ void UnrealCallbacks::addReport(const prt::AttributeMap* reports)
 }
 
 void UnrealCallbacks::addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterials,
-                                  size_t numInstanceMaterials)
+								  size_t numInstanceMaterials)
+{
+	addInitialShapeInstance(UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX, prototypeId, meshId, transform, instanceMaterials, numInstanceMaterials);
+}
+
+void UnrealCallbacks::addInitialShapeInstance(int32_t initialShapeIndex, int32_t prototypeId, const wchar_t* meshId, const double* transform,
+											  const prt::AttributeMap** instanceMaterials, size_t numInstanceMaterials)
 {
 	const FMatrix TransformationMat(GetColumn(transform, 0), GetColumn(transform, 1), GetColumn(transform, 2), GetColumn(transform, 3));
 	const int32 SignumDet = FMath::Sign(TransformationMat.Determinant());
@@ -371,7 +586,7 @@ void UnrealCallbacks::addInstance(int32_t prototypeId, const wchar_t* meshId, co
 	// https://stackoverflow.com/questions/16099979/can-i-switch-x-y-z-in-a-quaternion)
 	const FQuat CERotation = FQuat(Rotation.X, Rotation.Z, Rotation.Y, Rotation.W);
 	const FVector CEScale = FVector(Scale.X, Scale.Z, Scale.Y);
-	const FVector CETranslation = FVector(Translation.X, Translation.Z, Translation.Y) * PRT_TO_UE_SCALE - Offset;
+	const FVector CETranslation = FVector(Translation.X, Translation.Z, Translation.Y) * PRT_TO_UE_SCALE - GetOffset(initialShapeIndex);
 
 	if (!InstanceMeshes.Contains(meshId))
 	{
@@ -386,12 +601,20 @@ void UnrealCallbacks::addInstance(int32_t prototypeId, const wchar_t* meshId, co
 	{
 		for (size_t MatIndex = 0; MatIndex < numInstanceMaterials; ++MatIndex)
 		{
-			Vitruvio::FMaterialAttributeContainer MaterialContainer(instanceMaterials[MatIndex]);
-			MaterialOverrides.Add(MaterialContainer);
+			MaterialOverrides.Add(MaterialConversionCache.Convert(instanceMaterials[MatIndex], 0));
 		}
 	}
 
-	Instances.FindOrAdd({meshId, MaterialOverrides}).Add(Transform);
+	const Vitruvio::FInstanceCacheKey InstanceCacheKey{meshId, MaterialOverrides};
+	if (initialShapeIndex == UNREAL_GEOMETRY_ENCODER_NO_INITIAL_SHAPE_INDEX)
+	{
+		Instances.FindOrAdd(InstanceCacheKey).Add(Transform);
+	}
+	else
+	{
+		// Relative to the initial shape offset, the merged instances are recomposed from the per initial shape instances if needed
+		InitialShapeInstances.FindOrAdd(initialShapeIndex).FindOrAdd(InstanceCacheKey).Add(Transform);
+	}
 }
 
 prt::Status UnrealCallbacks::attrBool(size_t isIndex, int32_t shapeID, const wchar_t* key, bool value)
@@ -18,6 +18,7 @@
 #include "PRTTypes.h"
 
 #include "Codec/Encoder/IUnrealCallbacks.h"
+#include "MeshCache.h"
 #include "Report.h"
 #include "VitruvioTypes.h"
 
@@ -29,6 +30,30 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealCallbacks, Log, All);
 
+/**
+ * Converts PRT materials to interned material containers. If enabled, conversions are cached per attribute map and set of available uv
+ * sets for the lifetime of the callbacks. This is only valid if the encoder keeps its attribute maps alive for the whole generate call (see
+ * UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS), otherwise the address of a destroyed attribute map could be reused for a different material.
+ */
+class FMaterialConversionCache
+{
+public:
+	void SetEnabled(bool bInEnabled)
+	{
+		bEnabled = bInEnabled;
+		Cache.Empty();
+	}
+
+	/**
+	 * \param AvailableUVSets bit mask of the PRT uv sets which are present on the mesh (0 for instance materials)
+	 */
+	Vitruvio::FMaterialAttributeContainer Convert(const prt::AttributeMap* Material, uint32 AvailableUVSets);
+
+private:
+	bool bEnabled = false;
+	TMap<TPair<const prt::AttributeMap*, uint32>, Vitruvio::FMaterialAttributeContainer> Cache;
+};
+
 struct FModelDescription
 {
 	FMeshDescription MeshDescription;
@@ -49,6 +74,28 @@ class UnrealCallbacks final : public IUnrealCallbacks
 	FModelDescription ModelDescription;
 	TSharedPtr<FVitruvioMesh> GeneratedModel;
 	TMap<FString, FReport> Reports;
+
+	TMap<int32, FModelDescription> InitialShapeModelDescriptions;
+	TMap<int32, TSharedPtr<FVitruvioMesh>> InitialShapeGeneratedModels;
+	TMap<int32, Vitruvio::FInstanceMap> InitialShapeInstances;
+	TArray<FVector> InitialShapeOffsets;
+
+	/** Keeps the instance meshes announced to the encoder by meshId from being evicted during the generate call. */
+	TUniquePtr<FMeshCache::FPin> MeshCachePin;
+
+	FMaterialConversionCache MaterialConversionCache;
+
+	/**
+	 * Adds the mesh converted by ConvertMesh either as the generated model or as a (cached) instance mesh. Instance meshes which are already
+	 * cached are not converted.
+	 */
+	void AddMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+				 TFunctionRef<FModelDescription(const FVector3f& VertexOffset)> ConvertMesh);
+
+	const FVector& GetOffset(int32_t initialShapeIndex) const
+	{
+		return InitialShapeOffsets.IsValidIndex(initialShapeIndex) ? InitialShapeOffsets[initialShapeIndex] : Offset;
+	}
 	
 public:
 	virtual ~UnrealCallbacks() override = default;
@@ -56,6 +103,30 @@ public:
 
 	static constexpr int32 NoPrototypeIndex = -1;
 
+	/**
+	 * Pins the mesh cache for the lifetime of the callbacks.
+	 * @return the meshIds of the cached instance meshes to be passed to the encoder with UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS.
+	 */
+	const FCachedMeshIds& PinCachedMeshes(FMeshCache& MeshCache);
+
+	/**
+	 * Sets the offsets of the geometry emitted per initial shape by index into the initial shapes passed to generate. Geometry of initial
+	 * shapes without an offset is relative to the offset passed to the constructor.
+	 */
+	void SetInitialShapeOffsets(TArray<FVector> Offsets)
+	{
+		InitialShapeOffsets = MoveTemp(Offsets);
+	}
+
+	/**
+	 * Enables caching of material conversions per attribute map. Must only be enabled if the encoder accepted
+	 * UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS.
+	 */
+	void SetCacheConvertedMaterials(bool bCacheConvertedMaterials)
+	{
+		MaterialConversionCache.SetEnabled(bCacheConvertedMaterials);
+	}
+
 	const Vitruvio::FInstanceMap& GetInstances() const
 	{
 		return Instances;
@@ -81,6 +152,24 @@ public:
 		return InstanceNames;
 	}
 
+	/**
+	 * @return the generated models by initial shape index (index into the initial shapes passed to generate). Only filled if the encoder
+	 * emits geometry per initial shape.
+	 */
+	const TMap<int32, TSharedPtr<FVitruvioMesh>>& GetInitialShapeGeneratedModels() const
+	{
+		return InitialShapeGeneratedModels;
+	}
+
+	/**
+	 * @return the instances by initial shape index (index into the initial shapes passed to generate). Only filled if the encoder
+	 * emits geometry per initial shape.
+	 */
+	const TMap<int32, Vitruvio::FInstanceMap>& GetInitialShapeInstances() const
+	{
+		return InitialShapeInstances;
+	}
+
 	/**
 	 * @param name either the name of the inserted asset or the shape name
 	 * @param identifier unique identifier of this mesh if originates from an inserted asset or empty otherwise
@@ -119,6 +208,46 @@ public:
 	) override;
 	// clang-format on
 
+	/**
+	 * Same as addMesh for the geometry of the initial shape with the given index (index into the initial shapes passed to generate).
+	 */
+	// clang-format off
+	virtual void addInitialShapeMesh(int32_t initialShapeIndex,
+	                                 const wchar_t* name, const wchar_t* identifier,
+	                                 int32_t prototypeId, const wchar_t* uri,
+	                                 const double* vtx, size_t vtxSize,
+	                                 const double* nrm, size_t nrmSize,
+	                                 const uint32_t* faceVertexCounts, size_t faceVertexCountsSize,
+	                                 const uint32_t* vertexIndices, size_t vertexIndicesSize,
+	                                 const uint32_t* normalIndices, size_t normalIndicesSize,
+
+	                                 double const* const* uvs, size_t const* uvsSizes,
+	                                 uint32_t const* const* uvCounts, size_t const* uvCountsSizes,
+	                                 uint32_t const* const* uvIndices, size_t const* uvIndicesSizes,
+	                                 size_t uvSets,
+
+	                                 const uint32_t* faceRanges, size_t faceRangesSize,
+	                                 const prt::AttributeMap** materials
+	) override;
+	// clang-format on
+
+	/**
+	 * Same as addMesh with a pre-triangulated float mesh which shares a single index buffer between all vertex attributes.
+	 */
+	virtual void addMeshV2(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId, const wchar_t* uri,
+						   const UnrealMeshV2& mesh) override;
+
+	/**
+	 * Adds a prototype which has been announced by PinCachedMeshes without it being serialized by the encoder.
+	 */
+	virtual void addCachedMesh(int32_t initialShapeIndex, const wchar_t* name, const wchar_t* meshId, int32_t prototypeId,
+							   const wchar_t* uri) override;
+
+	/**
+	 * Records the material conversions of the encoder in the Vitruvio stats.
+	 */
+	virtual void addMaterialCacheStats(size_t conversions, size_t cacheHits) override;
+
 	/**
 	 * Add a new instance with a given id, transform and optional set of overriding attributes for this instance
 	 *
@@ -132,6 +261,12 @@ public:
 	virtual void addInstance(int32_t prototypeId, const wchar_t* meshId, const double* transform, const prt::AttributeMap** instanceMaterial,
 							 size_t numInstanceMaterials) override;
 
+	/**
+	 * Same as addInstance for an instance of the initial shape with the given index (index into the initial shapes passed to generate).
+	 */
+	virtual void addInitialShapeInstance(int32_t initialShapeIndex, int32_t prototypeId, const wchar_t* meshId, const double* transform,
+										 const prt::AttributeMap** instanceMaterial, size_t numInstanceMaterials) override;
+
 	/**
 	 * Add a new report
 	 *
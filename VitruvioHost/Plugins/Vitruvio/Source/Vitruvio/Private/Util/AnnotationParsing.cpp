@@ -155,17 +155,17 @@ int ParseOrder(const prt::Annotation* Annotation)
 	return INT32_MAX;
 }
 
-void ParseGroups(const prt::Annotation* Annotation, URuleAttribute& InAttribute)
+void ParseGroups(const prt::Annotation* Annotation, FRuleAttributeInfo& InAttributeInfo)
 {
 	for (int AnnotationIndex = 0; AnnotationIndex < Annotation->getNumArguments(); AnnotationIndex++)
 	{
 		if (Annotation->getArgument(AnnotationIndex)->getType() == prt::AAT_STR)
 		{
-			InAttribute.Groups.Add(WCHAR_TO_TCHAR(Annotation->getArgument(AnnotationIndex)->getStr()));
+			InAttributeInfo.Groups.Add(WCHAR_TO_TCHAR(Annotation->getArgument(AnnotationIndex)->getStr()));
 		}
 		else if (AnnotationIndex == Annotation->getNumArguments() - 1 && Annotation->getArgument(AnnotationIndex)->getType() == prt::AAT_FLOAT)
 		{
-			InAttribute.GroupOrder = static_cast<int>(Annotation->getArgument(AnnotationIndex)->getFloat());
+			InAttributeInfo.GroupOrder = static_cast<int>(Annotation->getArgument(AnnotationIndex)->getFloat());
 		}
 	}
 }
@@ -218,18 +218,27 @@ void ParseAttributeAnnotations(const prt::RuleFileInfo::Entry* AttributeInfo, UR
 		{
 			InAttribute.SetAnnotation(NewObject<UColorAnnotation>(Outer));
 		}
+	}
+}
+
+void ParseAttributeInfoAnnotations(const prt::RuleFileInfo::Entry* AttributeInfo, FRuleAttributeInfo& InAttributeInfo)
+{
+	for (size_t AnnotationIndex = 0; AnnotationIndex < AttributeInfo->getNumAnnotations(); ++AnnotationIndex)
+	{
+		const prt::Annotation* CEAnnotation = AttributeInfo->getAnnotation(AnnotationIndex);
 
+		const wchar_t* Name = CEAnnotation->getName();
 		if (!std::wcscmp(Name, ANNOT_HIDDEN))
 		{
-			InAttribute.bHidden = true;
+			InAttributeInfo.bHidden = true;
 		}
 		else if (!std::wcscmp(Name, ANNOT_ORDER))
 		{
-			InAttribute.Order = ParseOrder(CEAnnotation);
+			InAttributeInfo.Order = ParseOrder(CEAnnotation);
 		}
 		else if (!std::wcscmp(Name, ANNOT_GROUP))
 		{
-			ParseGroups(CEAnnotation, InAttribute);
+			ParseGroups(CEAnnotation, InAttributeInfo);
 		}
 	}
 }
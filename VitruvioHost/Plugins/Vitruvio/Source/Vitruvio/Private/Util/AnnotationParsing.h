@@ -17,10 +17,19 @@
 
 #include "PRTTypes.h"
 #include "RuleAttributes.h"
+#include "RuleInfo.h"
 
 namespace Vitruvio
 {
+/**
+ * \brief Creates the value annotation (eg. @Range or @Enum) of the given attribute.
+ */
 void ParseAttributeAnnotations(const prt::RuleFileInfo::Entry* AttributeInfo, URuleAttribute& InAttribute, UObject* const Outer);
 
+/**
+ * \brief Parses the value independent annotations (@Hidden, @Order and @Group) of the given attribute.
+ */
+void ParseAttributeInfoAnnotations(const prt::RuleFileInfo::Entry* AttributeInfo, FRuleAttributeInfo& InAttributeInfo);
+
 TMap<FString, int> ParseImportOrderMap(const RuleFileInfoPtr& RuleFileInfo);
 } // namespace Vitruvio
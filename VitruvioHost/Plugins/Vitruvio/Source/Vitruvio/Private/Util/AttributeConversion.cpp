@@ -22,6 +22,7 @@
 #include "PRTTypes.h"
 #include "PRTUtils.h"
 #include "RuleAttributes.h"
+#include "Algo/AllOf.h"
 #include "Misc/DefaultValueHelper.h"
 
 namespace
@@ -113,7 +114,8 @@ struct FGroupOrderKey
 	TArray<FString> Groups;
 	FString ImportPath;
 
-	explicit FGroupOrderKey(const URuleAttribute& Attribute)
+	template <typename TAttribute>
+	explicit FGroupOrderKey(const TAttribute& Attribute)
 	{
 		Groups = Attribute.Groups;
 		ImportPath = Attribute.ImportPath;
@@ -144,30 +146,47 @@ struct FGroupOrderKey
 
 constexpr int AttributeGroupOrderNone = INT32_MAX;
 
+template <typename TAttribute>
+void AddToGlobalGroupOrderMap(TMap<FGroupOrderKey, int>& GlobalGroupOrderMap, const TAttribute& Attribute)
+{
+	for (int32 GroupIndex = 0; GroupIndex < Attribute.Groups.Num(); ++GroupIndex)
+	{
+		int& ValueRef = GlobalGroupOrderMap.FindOrAdd(FGroupOrderKey(Attribute), AttributeGroupOrderNone);
+		ValueRef = FMath::Min(ValueRef, Attribute.GroupOrder);
+	}
+}
+
 // maps the highest attribute order from all attributes within a group to its group string key
 TMap<FGroupOrderKey, int> GetGlobalGroupOrderMap(const TMap<FString, URuleAttribute*>& Attributes)
 {
 	TMap<FGroupOrderKey, int> GlobalGroupOrderMap;
-
 	for (const auto& AttributeTuple : Attributes)
 	{
-		URuleAttribute* Attribute = AttributeTuple.Value;
-		TArray<FString> CurrGroups;
-		for (const FString& CurrGroup : Attribute->Groups)
-		{
-			CurrGroups.Add(CurrGroup);
+		AddToGlobalGroupOrderMap(GlobalGroupOrderMap, *AttributeTuple.Value);
+	}
+	return GlobalGroupOrderMap;
+}
 
-			int& ValueRef = GlobalGroupOrderMap.FindOrAdd(FGroupOrderKey(*Attribute), AttributeGroupOrderNone);
-			ValueRef = FMath::Min(ValueRef, Attribute->GroupOrder);
+TMap<FGroupOrderKey, int> GetGlobalGroupOrderMap(const TArray<FRuleAttributeInfo>& AttributeInfos)
+{
+	TMap<FGroupOrderKey, int> GlobalGroupOrderMap;
+	for (const FRuleAttributeInfo& AttributeInfo : AttributeInfos)
+	{
+		// Hidden attributes are never added to the attribute map and therefore do not influence the order
+		if (!AttributeInfo.bHidden)
+		{
+			AddToGlobalGroupOrderMap(GlobalGroupOrderMap, AttributeInfo);
 		}
 	}
 	return GlobalGroupOrderMap;
 }
 
-bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribute& OtherAttribute,
-                            const TMap<FGroupOrderKey, int> GlobalGroupOrderMap)
+// Works on URuleAttribute as well as on FRuleAttributeInfo since both provide the same ordering fields
+template <typename TAttribute>
+bool IsAttributeBeforeOther(const TAttribute& Attribute, const TAttribute& OtherAttribute,
+                            const TMap<FGroupOrderKey, int>& GlobalGroupOrderMap)
 {
-	auto AreImportPathsInOrder = [](const URuleAttribute& A, const URuleAttribute& B)
+	auto AreImportPathsInOrder = [](const TAttribute& A, const TAttribute& B)
 	{
 		// sort main rule attributes before the rest
 		if (A.ImportPath.Len() == 0 && B.ImportPath.Len() > 0)
@@ -188,7 +207,7 @@ bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribut
 		return A.ImportPath.Compare(B.ImportPath, ESearchCase::CaseSensitive) < 0;
 	};
 
-	auto IsChildOf = [](const URuleAttribute& Child, const URuleAttribute& Parent)
+	auto IsChildOf = [](const TAttribute& Child, const TAttribute& Parent)
 	{
 		const size_t ParentGroupNum = Parent.Groups.Num();
 		const size_t ChildGroupNum = Child.Groups.Num();
@@ -210,13 +229,13 @@ bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribut
 		return true;
 	};
 
-	auto GetGlobalGroupOrder = [&GlobalGroupOrderMap](const URuleAttribute& RuleAttribute)
+	auto GetGlobalGroupOrder = [&GlobalGroupOrderMap](const TAttribute& RuleAttribute)
 	{
 		const int* GroupOrderPtr = GlobalGroupOrderMap.Find(FGroupOrderKey(RuleAttribute));
 		return (GroupOrderPtr == nullptr) ? AttributeGroupOrderNone : (*GroupOrderPtr);
 	};
 
-	auto AreAttributeGroupsInOrder = [](const URuleAttribute& A, const URuleAttribute& B)
+	auto AreAttributeGroupsInOrder = [](const TAttribute& A, const TAttribute& B)
 	{
 		const size_t GroupSizeA = A.Groups.Num();
 		const size_t GroupSizeB = B.Groups.Num();
@@ -238,8 +257,8 @@ bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribut
 		return false;
 	};
 
-	auto AreAttributesWithAndWithoutGroupInOrder = [&](const URuleAttribute& RuleAttributeWithGroups,
-	                                                   const URuleAttribute& RuleAttributeWithoutGroup)
+	auto AreAttributesWithAndWithoutGroupInOrder = [&](const TAttribute& RuleAttributeWithGroups,
+	                                                   const TAttribute& RuleAttributeWithoutGroup)
 	{
 		if (!RuleAttributeWithGroups.Groups.IsEmpty() &&
 		    (RuleAttributeWithGroups.GroupOrder == RuleAttributeWithoutGroup.Order))
@@ -248,7 +267,7 @@ bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribut
 		return GetGlobalGroupOrder(RuleAttributeWithGroups) < RuleAttributeWithoutGroup.Order;
 	};
 
-	auto AreAttributeGroupOrdersInOrder = [&](const URuleAttribute& A, const URuleAttribute& B)
+	auto AreAttributeGroupOrdersInOrder = [&](const TAttribute& A, const TAttribute& B)
 	{
 		if (B.Groups.IsEmpty())
 			return AreAttributesWithAndWithoutGroupInOrder(A, B);
@@ -276,7 +295,7 @@ bool IsAttributeBeforeOther(const URuleAttribute& Attribute, const URuleAttribut
 		return AreAttributeGroupsInOrder(A, B);
 	};
 
-	auto AreAttributesInOrder = [&](const URuleAttribute& A, const URuleAttribute& B)
+	auto AreAttributesInOrder = [&](const TAttribute& A, const TAttribute& B)
 	{
 		if (A.ImportPath != B.ImportPath)
 		{
@@ -367,15 +386,18 @@ bool TryParseString(const FString& InStr, FString& OutValue)
 
 namespace Vitruvio
 {
-void UpdateAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, const AttributeMapUPtr& AttributeMap, const RuleFileInfoPtr& RuleInfo,
-                        UObject* const Outer)
+FRuleInfoPtr CreateRuleInfo(const RuleFileInfoPtr& RuleFileInfo, const std::wstring& RuleFile)
 {
-	bool bNeedsResorting = false;
-	TMap<FString, int> ImportOrderMap = ParseImportOrderMap(RuleInfo);
+	const TSharedPtr<FRuleInfo> RuleInfo = MakeShared<FRuleInfo>();
+	RuleInfo->RuleFileInfo = RuleFileInfo;
+	RuleInfo->RuleFile = WCHAR_TO_TCHAR(RuleFile.c_str());
+	RuleInfo->StartRule = WCHAR_TO_TCHAR(prtu::detectStartRule(RuleFileInfo).c_str());
 
-	for (size_t AttributeIndex = 0; AttributeIndex < RuleInfo->getNumAttributes(); AttributeIndex++)
+	const TMap<FString, int> ImportOrderMap = ParseImportOrderMap(RuleFileInfo);
+
+	for (size_t AttributeIndex = 0; AttributeIndex < RuleFileInfo->getNumAttributes(); AttributeIndex++)
 	{
-		const prt::RuleFileInfo::Entry* AttrInfo = RuleInfo->getAttribute(AttributeIndex);
+		const prt::RuleFileInfo::Entry* AttrInfo = RuleFileInfo->getAttribute(AttributeIndex);
 		if (AttrInfo->getNumParameters() != 0)
 		{
 			continue;
@@ -389,51 +411,100 @@ void UpdateAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, const A
 		}
 
 		const std::wstring Name(AttrInfo->getName());
-		URuleAttribute* Attribute = ::CreateAttribute(AttributeMap, AttrInfo, Outer);
+
+		FRuleAttributeInfo& AttributeInfo = RuleInfo->Attributes.AddDefaulted_GetRef();
+		AttributeInfo.Entry = AttrInfo;
+		AttributeInfo.Name = WCHAR_TO_TCHAR(Name.c_str());
+		AttributeInfo.DisplayName = WCHAR_TO_TCHAR(prtu::removeImport(prtu::removeStyle(Name.c_str())).c_str());
+		AttributeInfo.ImportPath = WCHAR_TO_TCHAR(prtu::getFullImportPath(Name.c_str()).c_str());
+		if (const int* ImportOrder = ImportOrderMap.Find(AttributeInfo.ImportPath))
+		{
+			AttributeInfo.ImportOrder = *ImportOrder;
+		}
+
+		ParseAttributeInfoAnnotations(AttrInfo, AttributeInfo);
+	}
+
+	// Attributes are always displayed in the same order, so we only need to sort them once per rule file
+	const TMap<FGroupOrderKey, int> GlobalGroupOrder = GetGlobalGroupOrderMap(RuleInfo->Attributes);
+	RuleInfo->Attributes.StableSort([&GlobalGroupOrder](const FRuleAttributeInfo& A, const FRuleAttributeInfo& B)
+	{
+		return IsAttributeBeforeOther(A, B, GlobalGroupOrder);
+	});
+
+	for (int32 AttributeIndex = 0; AttributeIndex < RuleInfo->Attributes.Num(); ++AttributeIndex)
+	{
+		RuleInfo->AttributeIndices.Add(RuleInfo->Attributes[AttributeIndex].Name, AttributeIndex);
+	}
+
+	return RuleInfo;
+}
+
+void UpdateAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, const AttributeMapUPtr& AttributeMap, const FRuleInfo& RuleInfo,
+                        UObject* const Outer)
+{
+	bool bNeedsResorting = false;
+
+	for (const FRuleAttributeInfo& AttributeInfo : RuleInfo.Attributes)
+	{
+		// update/add attributes if they aren't hidden
+		if (AttributeInfo.bHidden)
+		{
+			continue;
+		}
+
+		URuleAttribute* Attribute = ::CreateAttribute(AttributeMap, AttributeInfo.Entry, Outer);
 
 		if (Attribute)
 		{
-			const FString AttributeName = WCHAR_TO_TCHAR(Name.c_str());
-			Attribute->Name = AttributeName;
+			Attribute->Name = AttributeInfo.Name;
 
-			ParseAttributeAnnotations(AttrInfo, *Attribute, Outer);
-			if (!Attribute->bHidden)
+			if (AttributeMapOut.Contains(AttributeInfo.Name))
 			{
-				// update/add attributes if they aren't hidden
-				if (AttributeMapOut.Contains(AttributeName))
-				{
-					const URuleAttribute* OutAttribute = AttributeMapOut[AttributeName];
-					if (!OutAttribute->bUserSet)
-					{
-						AttributeMapOut[AttributeName]->CopyValue(Attribute);
-					}
-				}
-				else
+				const URuleAttribute* OutAttribute = AttributeMapOut[AttributeInfo.Name];
+				if (!OutAttribute->bUserSet)
 				{
-					const FString DisplayName = WCHAR_TO_TCHAR(prtu::removeImport(prtu::removeStyle(Name.c_str())).c_str());
-					const FString ImportPath = WCHAR_TO_TCHAR(prtu::getFullImportPath(Name.c_str()).c_str());
-
-					Attribute->DisplayName = DisplayName;
-					Attribute->ImportPath = ImportPath;
-					int* ImportOrder = ImportOrderMap.Find(ImportPath);
-					if (ImportOrder != nullptr)
-					{
-						Attribute->ImportOrder = *ImportOrder;
-					}
-					AttributeMapOut.Add(AttributeName, Attribute);
-					bNeedsResorting = true;
+					AttributeMapOut[AttributeInfo.Name]->CopyValue(Attribute);
 				}
 			}
+			else
+			{
+				ParseAttributeAnnotations(AttributeInfo.Entry, *Attribute, Outer);
+
+				Attribute->DisplayName = AttributeInfo.DisplayName;
+				Attribute->ImportPath = AttributeInfo.ImportPath;
+				Attribute->ImportOrder = AttributeInfo.ImportOrder;
+				Attribute->Groups = AttributeInfo.Groups;
+				Attribute->Order = AttributeInfo.Order;
+				Attribute->GroupOrder = AttributeInfo.GroupOrder;
+
+				AttributeMapOut.Add(AttributeInfo.Name, Attribute);
+				bNeedsResorting = true;
+			}
 		}
 	}
 	if (bNeedsResorting)
 	{
-		TMap<FGroupOrderKey, int> GlobalGroupOrder = GetGlobalGroupOrderMap(AttributeMapOut);
-		AttributeMapOut.ValueSort(
-			[&GlobalGroupOrder](const URuleAttribute& A, const URuleAttribute& B)
-			{
-				return IsAttributeBeforeOther(A, B, GlobalGroupOrder);
+		const bool bOnlyRuleAttributes = Algo::AllOf(AttributeMapOut, [&RuleInfo](const TPair<FString, URuleAttribute*>& Entry) {
+			return RuleInfo.AttributeIndices.Contains(Entry.Key);
+		});
+
+		if (bOnlyRuleAttributes)
+		{
+			// Use the precomputed order of the rule file
+			AttributeMapOut.KeySort([&RuleInfo](const FString& A, const FString& B) {
+				return RuleInfo.AttributeIndices[A] < RuleInfo.AttributeIndices[B];
 			});
+		}
+		else
+		{
+			TMap<FGroupOrderKey, int> GlobalGroupOrder = GetGlobalGroupOrderMap(AttributeMapOut);
+			AttributeMapOut.ValueSort(
+				[&GlobalGroupOrder](const URuleAttribute& A, const URuleAttribute& B)
+				{
+					return IsAttributeBeforeOther(A, B, GlobalGroupOrder);
+				});
+		}
 	}
 }
 
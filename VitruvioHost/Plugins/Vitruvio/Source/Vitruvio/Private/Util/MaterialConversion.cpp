@@ -18,7 +18,7 @@
 #include "MaterialConversion.h"
 #include "Runtime/Engine/Public/TextureResource.h"
 #include "Engine/Texture2D.h"
-#include "HAL/PlatformFileManager.h"
+#include "TextureCache.h"
 #include "Runtime/ImageCore/Public/ImageCore.h"
 #include "VitruvioModule.h"
 #include "VitruvioTypes.h"
@@ -30,97 +30,11 @@ DEFINE_LOG_CATEGORY(LogMaterialConversion);
 namespace
 {
 
-constexpr double BlackColorThreshold = 0.02;
-constexpr double WhiteColorThreshold = 1.0 - BlackColorThreshold;
 constexpr double OpacityThreshold = 0.98;
 
 const FString CityEngineDefaultShaderName("CityEngineShader");
 const FString CityEnginePBRShaderName("CityEnginePBRShader");
 
-template <typename T, typename F>
-void CountOpacityMapPixels(const T* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels, F Accessor)
-{
-	BlackPixels = 0;
-	WhitePixels = 0;
-
-	const T* LastColor = SrcColors + (SizeX * SizeY);
-	while (SrcColors < LastColor)
-	{
-		const float Value = Accessor(SrcColors);
-
-		if (Value < BlackColorThreshold)
-		{
-			BlackPixels++;
-		}
-		else if (Value > WhiteColorThreshold)
-		{
-			WhitePixels++;
-		}
-		++SrcColors;
-	}
-}
-
-void CountOpacityMapPixels(const FColor* SrcColors, bool UseAlphaChannel, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [UseAlphaChannel](const FColor* Color) { return static_cast<float>(UseAlphaChannel ? Color->A : Color->R) / 0xFF; });
-}
-
-void CountOpacityMapPixels(const uint8* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint8* Color) { return static_cast<float>(*Color) / 0xFF; });
-}
-
-void CountOpacityMapPixels(const uint16* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint16* Color) { return static_cast<float>(*Color) / 0xFFFF; });
-}
-
-EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMapData, bool UseAlphaAsOpacity)
-{
-	const UTexture2D* OpacityMap = OpacityMapData.Texture;
-	const EPixelFormat PixelFormat = OpacityMap->GetPixelFormat();
-	check(PixelFormat == PF_B8G8R8A8 || PixelFormat == PF_A16B16G16R16 || PixelFormat == PF_FloatRGBA);
-
-	uint32 BlackPixels = 0;
-	uint32 WhitePixels = 0;
-
-	// Now count the black and white pixels of the appropriate opacity map channel to determine the opacity mode
-	const FTexturePlatformData* PlatformData = OpacityMap->GetPlatformData();
-	switch (PixelFormat)
-	{
-	case PF_B8G8R8A8:
-	{
-		const FColor* ImageData = reinterpret_cast<const FColor*>(PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, UseAlphaAsOpacity, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
-		break;
-	}
-	case PF_A16B16G16R16:
-	{
-		const uint16* ImageData = reinterpret_cast<const uint16*>(PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
-		break;
-	}
-	default:
-		check(0)
-	}
-
-	OpacityMap->GetPlatformData()->Mips[0].BulkData.Unlock();
-
-	const uint32 TotalPixels = OpacityMap->GetSizeX() * OpacityMap->GetSizeY();
-	if (WhitePixels >= TotalPixels * OpacityThreshold)
-	{
-		return BLEND_Opaque;
-	}
-	if (WhitePixels + BlackPixels >= TotalPixels * OpacityThreshold)
-	{
-		return BLEND_Masked;
-	}
-	return BLEND_Translucent;
-}
-
 EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double Opacity, EBlendMode BlendMode, bool UseAlphaAsOpacity)
 {
 	if (Opacity < OpacityThreshold)
@@ -134,9 +48,9 @@ EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double
 	else if (BlendMode == BLEND_Translucent && OpacityMapData.Texture && OpacityMapData.Texture->GetPixelFormat() != PF_FloatRGBA)
 	// explicitly don't check FloatRGBA textures as they were converted from grayscale float16/32 textures which will never have alpha channels
 	{
-		// OpacityMap exists and opacitymap.mode is blend (which is the default value) so we need to check the content of the OpacityMap
-		// to really decide which material we need for Unreal
-		return ChooseBlendModeFromOpacityMap(OpacityMapData, UseAlphaAsOpacity);
+		// OpacityMap exists and opacitymap.mode is blend (which is the default value) so the content of the OpacityMap decides which
+		// material we need for Unreal. It has been classified when the texture was decoded.
+		return UseAlphaAsOpacity ? OpacityMapData.AlphaBlendMode : OpacityMapData.RedBlendMode;
 	}
 	else
 	{
@@ -170,21 +84,36 @@ UMaterialInterface* GetMaterialByBlendMode(EBlendMode Mode, UMaterialInterface*
 	}
 }
 
+using FSharedTextureData = TSharedRef<Vitruvio::FTextureData, ESPMode::ThreadSafe>;
+
+/**
+ * \return the texture of the future. Waiting for a texture which is still being decoded is recorded as blocked game thread time.
+ */
+const Vitruvio::FTextureData& GetTextureData(const TFuture<Vitruvio::FTextureData>& Future)
+{
+	if (!Future.IsReady())
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Future.Wait();
+		VitruvioModule::Get().GetApplyBudget().AddMaterialBlockedTime((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+	return Future.Get();
+}
+
 class FLoadTextureTask
 {
 	TPromise<Vitruvio::FTextureData> Promise;
 	UObject* Outer;
-	TMap<FString, Vitruvio::FTextureData>& Cache;
-	FCriticalSection& CacheCriticalSection;
+	FTextureCache& Cache;
+	FSharedTextureData Result;
 
 	FString ImagePath;
 	FString TextureKey;
 
 public:
-	FLoadTextureTask(TPromise<Vitruvio::FTextureData>&& InPromise, UObject* Outer, TMap<FString, Vitruvio::FTextureData>& Cache,
-					 FCriticalSection& CacheCriticalSection, const FString& ImagePath, const FString& TextureKey)
-		: Promise(MoveTemp(InPromise)), Outer(Outer), Cache(Cache), CacheCriticalSection(CacheCriticalSection), ImagePath(ImagePath),
-		  TextureKey(TextureKey)
+	FLoadTextureTask(TPromise<Vitruvio::FTextureData>&& InPromise, UObject* Outer, FTextureCache& Cache, const FSharedTextureData& Result,
+					 const FString& ImagePath, const FString& TextureKey)
+		: Promise(MoveTemp(InPromise)), Outer(Outer), Cache(Cache), Result(Result), ImagePath(ImagePath), TextureKey(TextureKey)
 	{
 	}
 
@@ -211,14 +140,11 @@ public:
 	{
 		QUICK_SCOPE_CYCLE_COUNTER(STAT_MaterialConversion_LoadTexture);
 		FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
-		Vitruvio::FTextureData TextureData = VitruvioModule::Get().DecodeTexture(Outer, ImagePath, TextureKey);
-		{
-			FScopeLock CacheLock(&CacheCriticalSection);
+		const Vitruvio::FTextureData TextureData = VitruvioModule::Get().DecodeTexture(Outer, ImagePath, TextureKey);
 
-			Cache.Add(ImagePath, TextureData);
-		}
-
-		Promise.SetValue(TextureData);
+		// Properties of the same material which use the same path read the result after this task has completed
+		*Result = TextureData.Texture ? Cache.InsertOrGet(ImagePath, TextureData) : TextureData;
+		Promise.SetValue(*Result);
 	}
 };
 
@@ -229,65 +155,50 @@ namespace Vitruvio
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FString& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
 															const FMaterialAttributeContainer& MaterialContainer,
-															TMap<FString, FTextureData>& TextureCache)
+															FTextureCache& TextureCache, const FPrefetchedTextures* PrefetchedTextures)
 {
 	check(IsInGameThread());
 
-	TMap<FString, FGraphEventRef> TexturePropertyTasks;
+	TMap<FString, TPair<FGraphEventRef, FSharedTextureData>> TexturePropertyTasks;
 	TMap<FString, TFuture<FTextureData>> TextureProperties;
 
-	FCriticalSection CacheCriticalSection;
-
 	for (const auto& TextureProperty : MaterialContainer.TextureProperties)
 	{
 		const FString TexturePath = TextureProperty.Value;
 		TPromise<FTextureData> Promise;
 		TFuture<FTextureData> Future = Promise.GetFuture();
 
-		bool ValidCache = false;
+		const TSharedRef<FPrefetchedTexture, ESPMode::ThreadSafe>* PrefetchedTexture =
+			PrefetchedTextures ? PrefetchedTextures->Find(TexturePath) : nullptr;
+		FTextureData CachedTextureData;
+		if (PrefetchedTexture && (*PrefetchedTexture)->TextureData.Texture)
 		{
-			FScopeLock CacheLock(&CacheCriticalSection);
-
-			auto Cached = TextureCache.Find(TexturePath);
-			if (Cached)
-			{
-				auto FileSystemTimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*TexturePath);
-				if (FileSystemTimeStamp > Cached->LoadTime)
-				{
-					// If the timestamp on the filesystem is newer than our cached version we have to evict it from the cache and reload the texture
-					// because it has changed
-					TextureCache.Remove(*TextureCache.FindKey(*Cached));
-				}
-				else
-				{
-					// Found a valid entry in the cache which we can just use
-					Promise.SetValue(*Cached);
-					ValidCache = true;
-				}
-			}
+			// Decoded ahead of time, the prefetch tasks have completed before materials are created
+			Promise.SetValue((*PrefetchedTexture)->TextureData);
 		}
-
-		if (!ValidCache)
+		else if (!TexturePath.IsEmpty() && TextureCache.Find(TexturePath, CachedTextureData))
+		{
+			// Found a valid entry in the cache which we can just use
+			Promise.SetValue(CachedTextureData);
+		}
+		else
 		{
 			// No valid entry found in the cache so we have to load it from the disk
 			auto LoadTextureTask = TexturePropertyTasks.Find(TexturePath);
 			if (LoadTextureTask)
 			{
 				FGraphEventArray Prerequisites;
-				Prerequisites.Add(*LoadTextureTask);
+				Prerequisites.Add(LoadTextureTask->Key);
 				TGraphTask<TAsyncGraphTask<FTextureData>>::CreateTask(&Prerequisites)
-					.ConstructAndDispatchWhenReady(
-						[&TextureCache, TexturePath, &CacheCriticalSection]() {
-							FScopeLock CacheLock(&CacheCriticalSection);
-							return TextureCache[TexturePath];
-						},
-						MoveTemp(Promise), ENamedThreads::AnyThread);
+					.ConstructAndDispatchWhenReady([Result = LoadTextureTask->Value]() { return *Result; }, MoveTemp(Promise),
+												   ENamedThreads::AnyThread);
 			}
 			else if (!TexturePath.IsEmpty())
 			{
+				FSharedTextureData Result = MakeShared<FTextureData, ESPMode::ThreadSafe>();
 				FGraphEventRef LoadTask = TGraphTask<FLoadTextureTask>::CreateTask().ConstructAndDispatchWhenReady(
-					MoveTemp(Promise), Outer, TextureCache, CacheCriticalSection, TextureProperty.Value, TextureProperty.Key);
-				TexturePropertyTasks.Add(TexturePath, LoadTask);
+					MoveTemp(Promise), Outer, TextureCache, Result, TextureProperty.Value, TextureProperty.Key);
+				TexturePropertyTasks.Add(TexturePath, {LoadTask, Result});
 			}
 			else
 			{
@@ -298,7 +209,7 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 		TextureProperties.Add(TextureProperty.Key, MoveTemp(Future));
 	}
 	const float Opacity = MaterialContainer.ScalarProperties["opacity"];
-	const FTextureData OpacityMapData = TextureProperties.Contains("opacityMap") ? TextureProperties["opacityMap"].Get() : FTextureData{};
+	const FTextureData OpacityMapData = TextureProperties.Contains("opacityMap") ? GetTextureData(TextureProperties["opacityMap"]) : FTextureData{};
 	const bool UseAlphaAsOpacity = OpacityMapData.Texture && OpacityMapData.NumChannels == 4;
 	const EBlendMode ChosenBlendMode = ChooseBlendMode(OpacityMapData, Opacity, GetBlendMode(MaterialContainer.BlendMode), UseAlphaAsOpacity);
 
@@ -327,7 +238,7 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 
 	for (const TPair<FString, TFuture<FTextureData>>& TextureFuture : TextureProperties)
 	{
-		const auto Result = TextureFuture.Value.Get();
+		const FTextureData& Result = GetTextureData(TextureFuture.Value);
 		MaterialInstance->SetTextureParameterValue(FName(TextureFuture.Key), Result.Texture);
 	}
 	for (const TPair<FString, double>& ScalarProperty : MaterialContainer.ScalarProperties)
@@ -341,4 +252,41 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 
 	return MaterialInstance;
 }
+
+void LoadTexturesAsync(const FMaterialAttributeContainer& MaterialAttributes, FTextureCache& TextureCache,
+					   FPrefetchedTextures& PrefetchedTextures, FGraphEventArray& OutTasks)
+{
+	for (const auto& [TextureKey, TexturePath] : MaterialAttributes.TextureProperties)
+	{
+		if (TexturePath.IsEmpty() || PrefetchedTextures.Contains(TexturePath))
+		{
+			continue;
+		}
+
+		// Each task only writes its own entry, the map itself is only modified on the game thread
+		TSharedRef<FPrefetchedTexture, ESPMode::ThreadSafe> PrefetchedTexture = MakeShared<FPrefetchedTexture, ESPMode::ThreadSafe>();
+		PrefetchedTextures.Add(TexturePath, PrefetchedTexture);
+
+		FTextureData CachedTextureData;
+		if (TextureCache.Find(TexturePath, CachedTextureData))
+		{
+			PrefetchedTexture->TextureData = CachedTextureData;
+			PrefetchedTexture->TextureRef.Reset(CachedTextureData.Texture);
+			continue;
+		}
+
+		OutTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&TextureCache, PrefetchedTexture, TexturePath = TexturePath, TextureKey = TextureKey]() {
+				QUICK_SCOPE_CYCLE_COUNTER(STAT_MaterialConversion_LoadTexture);
+				FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
+				const FTextureData TextureData = VitruvioModule::Get().DecodeTexture(GetTransientPackage(), TexturePath, TextureKey);
+				if (TextureData.Texture)
+				{
+					PrefetchedTexture->TextureData = TextureCache.InsertOrGet(TexturePath, TextureData);
+					PrefetchedTexture->TextureRef.Reset(PrefetchedTexture->TextureData.Texture);
+				}
+			},
+			TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask));
+	}
+}
 } // namespace Vitruvio
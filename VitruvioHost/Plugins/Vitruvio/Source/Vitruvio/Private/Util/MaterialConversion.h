@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include "TextureCache.h"
 #include "VitruvioTypes.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogMaterialConversion, Log, All);
@@ -24,5 +25,14 @@ namespace Vitruvio
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FString& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
 															const FMaterialAttributeContainer& MaterialAttributes,
-															TMap<FString, FTextureData>& TextureCache);
+															FTextureCache& TextureCache,
+															const FPrefetchedTextures* PrefetchedTextures = nullptr);
+
+/**
+ * \brief Starts decoding the textures of the material which are not yet in PrefetchedTextures. Cached textures are added right away. Once the
+ * returned tasks have completed, GameThread_CreateMaterialInstance takes all textures of the material from PrefetchedTextures and neither
+ * decodes nor blocks, independent of the texture cache budget.
+ */
+void LoadTexturesAsync(const FMaterialAttributeContainer& MaterialAttributes, FTextureCache& TextureCache,
+					   FPrefetchedTextures& PrefetchedTextures, FGraphEventArray& OutTasks);
 }
@@ -17,59 +17,75 @@
 
 #include "PolygonWindings.h"
 
-#include "Engine/Polys.h"
+#include "Algo/Sort.h"
 
 namespace
 {
-struct FWindingEdge
-{
-	const int32 Index0;
-	const int32 Index1;
-	int32 Color;
-
-	FWindingEdge() : Index0(-1), Index1(-1), Color(-1) {}
-
-	FWindingEdge(const int32 Index0, const int32 Index1, const int32 Color) : Index0(Index0), Index1(Index1), Color(Color) {}
-
-	bool operator==(const FWindingEdge& E) const
-	{
-		return (E.Index0 == Index0 && E.Index1 == Index1);
-	}
-};
-
 struct FWinding
 {
 	TArray<int32> Indices;
-	int Color;
 
-	FWinding(const TArray<int32>& Indices, const int Color) : Indices(Indices), Color(Color) {}
+	/** The connected component of the mesh the winding belongs to (see FVertexUnionFind). */
+	int32 Component = INDEX_NONE;
+
+	/** Bounds and absolute area of the winding projected onto the xy plane. */
+	FBox2D Bounds = FBox2D(ForceInit);
+	double Area = 0;
 };
 
-uint32 GetTypeHash(const FWindingEdge& Edge)
+uint64 GetEdgeKey(int32 Index0, int32 Index1)
 {
-	std::size_t Hash = 0x04C76972;
-	Hash = HashCombine(Hash, Edge.Index0);
-	return HashCombine(Hash, Edge.Index1);
+	return (static_cast<uint64>(static_cast<uint32>(Index0)) << 32) | static_cast<uint32>(Index1);
 }
 
-void ColorEdges(FWindingEdge& Edge, TSortedMap<int32, TArray<FWindingEdge>>& EdgeMap, TSet<FWindingEdge>& Visited, int Color)
+/**
+ * \brief Disjoint sets of vertex indices. Vertices which are connected by edges end up in the same set, which identifies the connected
+ * component of the mesh they belong to.
+ */
+class FVertexUnionFind
 {
-	if (Visited.Contains(Edge))
+public:
+	explicit FVertexUnionFind(int32 NumVertices)
 	{
-		return;
+		Parents.SetNumUninitialized(NumVertices);
+		for (int32 Index = 0; Index < NumVertices; ++Index)
+		{
+			Parents[Index] = Index;
+		}
+		Sizes.Init(1, NumVertices);
 	}
 
-	Edge.Color = Color;
-	Visited.Add(Edge);
-	for (FWindingEdge& Connected : EdgeMap[Edge.Index0])
+	int32 Find(int32 Index)
 	{
-		ColorEdges(Connected, EdgeMap, Visited, Color);
+		while (Parents[Index] != Index)
+		{
+			Parents[Index] = Parents[Parents[Index]];
+			Index = Parents[Index];
+		}
+		return Index;
 	}
-	for (FWindingEdge& Connected : EdgeMap[Edge.Index1])
+
+	void Union(int32 IndexA, int32 IndexB)
 	{
-		ColorEdges(Connected, EdgeMap, Visited, Color);
+		int32 RootA = Find(IndexA);
+		int32 RootB = Find(IndexB);
+		if (RootA == RootB)
+		{
+			return;
+		}
+
+		if (Sizes[RootA] < Sizes[RootB])
+		{
+			Swap(RootA, RootB);
+		}
+		Parents[RootB] = RootA;
+		Sizes[RootA] += Sizes[RootB];
 	}
-}
+
+private:
+	TArray<int32> Parents;
+	TArray<int32> Sizes;
+};
 
 bool PointInPolygon2D(const FVector& Point, const TArray<int32>& PolygonIndices, const TArray<FVector>& PolygonVertices)
 {
@@ -95,29 +111,28 @@ bool PointInPolygon2D(const FVector& Point, const TArray<int32>& PolygonIndices,
 	return bIsInside;
 }
 
-bool IsInsideOf2D(const TArray<int32>& FaceA, const TArray<int32>& FaceB, const TArray<FVector>& Vertices)
+bool ContainsBounds(const FBox2D& Outer, const FBox2D& Inner)
 {
-	if (FaceB.Num() == 1)
-	{
-		return false;
-	}
+	return Outer.Min.X <= Inner.Min.X && Outer.Min.Y <= Inner.Min.Y && Outer.Max.X >= Inner.Max.X && Outer.Max.Y >= Inner.Max.Y;
+}
+
+FWinding CreateWinding(TArray<int32>&& Indices, int32 Component, const TArray<FVector>& Vertices)
+{
+	FWinding Winding;
+	Winding.Component = Component;
 
-	for (int IndexA = 0; IndexA < FaceA.Num() - 1; IndexA++)
+	double DoubleSignedArea = 0;
+	for (int32 Index = 0; Index < Indices.Num(); ++Index)
 	{
-		for (int IndexB = 0; IndexB < FaceB.Num() - 1; IndexB++)
-		{
-			FVector Intersection;
-			const bool Intersected =
-				FMath::SegmentIntersection2D(FVector(Vertices[FaceA[IndexA]]), FVector(Vertices[FaceA[IndexA + 1]]), FVector(Vertices[FaceB[IndexB]]),
-											 FVector(Vertices[FaceB[IndexB + 1]]), Intersection);
-			if (Intersected)
-			{
-				return false;
-			}
-		}
+		const FVector& Current = Vertices[Indices[Index]];
+		const FVector& Next = Vertices[Indices[Index + 1 >= Indices.Num() ? 0 : Index + 1]];
+		DoubleSignedArea += Current.X * Next.Y - Next.X * Current.Y;
+		Winding.Bounds += FVector2D(Current.X, Current.Y);
 	}
+	Winding.Area = FMath::Abs(DoubleSignedArea) * 0.5;
+	Winding.Indices = MoveTemp(Indices);
 
-	return PointInPolygon2D(Vertices[FaceA[0]], FaceB, Vertices);
+	return Winding;
 }
 
 } // namespace
@@ -128,137 +143,164 @@ namespace Vitruvio
 FInitialShapePolygon GetPolygon(const TArray<FVector>& InVertices, const TArray<int32>& InIndices)
 {
 	// The algorithm works as follows:
-	// 1. We construct a graph of all edges and "color" all connected edges. Note that we can have multiple faces (with holes) in a single polygon
-	// and we need to be able to find which hole belongs to which face.
+	// 1. We group all vertices which are connected by edges into connected components using union-find. Note that we can have multiple faces
+	// (with holes) in a single polygon and we need to be able to find which hole belongs to which face.
 	// 2. We find and remove opposite edges, this will leave us with all edges at the outside of a face or a hole.
 	// 3. We combine all connected edges which form either faces or holes. Note that the ordering is already correct. Holes will have opposite
 	// ordering of their encircling face.
-	// 4. We check which hole belongs to which face by projecting the face/hole onto the xy plane and then doing edge intersection tests.
+	// 4. We check which hole belongs to which face by projecting the windings onto the xy plane. Windings of the same component are swept by
+	// their bounds, and only windings with a larger area and enclosing bounds are tested with a point in polygon test. The innermost
+	// enclosing winding is the parent, windings with an even number of ancestors are faces and the others are holes of their parent.
 	// This might break with certain non planar polygons but CityEngine handles holes in a similar way.
 
 	const int32 NumTriangles = InIndices.Num() / 3;
 
-	// Construct edges
-	TSet<FWindingEdge> Edges;
+	// Construct edges, degenerate triangles do not contribute to the outline
+	TSet<uint64> Edges;
+	Edges.Reserve(InIndices.Num());
+	FVertexUnionFind Components(InVertices.Num());
 	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
 	{
-		for (int32 VertexIndex = 0; VertexIndex < 3; ++VertexIndex)
+		const int32 Index0 = InIndices[TriangleIndex * 3];
+		const int32 Index1 = InIndices[TriangleIndex * 3 + 1];
+		const int32 Index2 = InIndices[TriangleIndex * 3 + 2];
+		if (Index0 == Index1 || Index1 == Index2 || Index2 == Index0 || !InVertices.IsValidIndex(Index0) || !InVertices.IsValidIndex(Index1) ||
+			!InVertices.IsValidIndex(Index2))
 		{
-			const int32 Index0 = InIndices[TriangleIndex * 3 + VertexIndex];
-			const int32 Index1 = InIndices[TriangleIndex * 3 + (VertexIndex + 1) % 3];
-			Edges.Add({Index0, Index1, -1});
+			continue;
 		}
-	}
 
-	// Color connected edges
-	TSortedMap<int32, TArray<FWindingEdge>> EdgeMap;
-	for (const FWindingEdge& Edge : Edges)
-	{
-		EdgeMap.FindOrAdd(Edge.Index0).Add(Edge);
+		Edges.Add(GetEdgeKey(Index0, Index1));
+		Edges.Add(GetEdgeKey(Index1, Index2));
+		Edges.Add(GetEdgeKey(Index2, Index0));
+		Components.Union(Index0, Index1);
+		Components.Union(Index0, Index2);
 	}
 
-	TSet<FWindingEdge> Visited;
-	int CurrentColor = 0;
-	for (auto& KeyValue : EdgeMap)
+	// Remove opposite edges to only keep the outside of either a face or a hole
+	TMap<int32, int32> NextVertices;
+	for (const uint64 Edge : Edges)
 	{
-		for (FWindingEdge& Edge : KeyValue.Value)
+		const int32 Index0 = static_cast<int32>(Edge >> 32);
+		const int32 Index1 = static_cast<int32>(Edge & 0xFFFFFFFF);
+		if (!Edges.Contains(GetEdgeKey(Index1, Index0)))
 		{
-			if (!Visited.Contains(Edge))
-			{
-				ColorEdges(Edge, EdgeMap, Visited, CurrentColor++);
-			}
+			// Note that at this point there should not be multiple edges connected to a single vertex
+			NextVertices.Add(Index0, Index1);
 		}
 	}
 
-	// Remove opposite edges to only keep the outside of either a face or a hole
-	TSortedMap<int32, FWindingEdge> WindingEdgeMap;
-	for (auto& KeyValue : EdgeMap)
+	TArray<int32> StartVertices;
+	NextVertices.GenerateKeyArray(StartVertices);
+	Algo::Sort(StartVertices);
+
+	// Organize the remaining edges so that the vertices will meet up to form a continuous outline of either a face or a hole
+	TArray<FWinding> Windings;
+	for (const int32 StartVertex : StartVertices)
 	{
-		for (const FWindingEdge& Current : KeyValue.Value)
+		int32 NextIndex;
+		if (!NextVertices.RemoveAndCopyValue(StartVertex, NextIndex))
 		{
-			const FWindingEdge Opposite(Current.Index1, Current.Index0, Current.Color);
-			if (!Edges.Contains(Opposite))
-			{
-				// Note that at this point there should not be multiple edges connected to a single vertex
-				WindingEdgeMap.Add(Current.Index0, Current);
-			}
+			// Already part of a previous winding
+			continue;
 		}
-	}
 
-	// Organize the remaining edges in the list so that the vertices will meet up to form a continuous outline of either a face or a hole
-	TArray<FWinding> Windings;
-	while (WindingEdgeMap.Num() > 0)
-	{
 		TArray<int32> WindingIndices;
-
-		// Get and remove first edge
-		auto EdgeIter = WindingEdgeMap.CreateIterator();
-		const FWindingEdge FirstEdge = EdgeIter.Value();
-		EdgeIter.RemoveCurrent();
-
-		WindingIndices.Add(FirstEdge.Index0);
-		int NextIndex = FirstEdge.Index1;
+		WindingIndices.Add(StartVertex);
 
 		// Find connected edges
-		while (WindingEdgeMap.Contains(NextIndex))
+		int32 FollowingIndex;
+		while (NextVertices.RemoveAndCopyValue(NextIndex, FollowingIndex))
 		{
-			const FWindingEdge& Current = WindingEdgeMap.FindAndRemoveChecked(NextIndex);
-			WindingIndices.Add(Current.Index0);
-			NextIndex = Current.Index1;
+			WindingIndices.Add(NextIndex);
+			NextIndex = FollowingIndex;
 		}
 
-		Windings.Add({WindingIndices, FirstEdge.Color});
+		Windings.Add(CreateWinding(MoveTemp(WindingIndices), Components.Find(StartVertex), InVertices));
 	}
 
-	// Find the relation between the faces
-	TMap<int32, int32> InsideOf;
-	for (int32 IndexA = 0; IndexA < Windings.Num(); IndexA++)
+	// Sweep the windings of each component by their bounds. Enclosing windings start further left or, on ties, have a larger area and are
+	// therefore always visited before the windings they enclose
+	TArray<int32> SweepOrder;
+	SweepOrder.SetNumUninitialized(Windings.Num());
+	for (int32 WindingIndex = 0; WindingIndex < Windings.Num(); ++WindingIndex)
 	{
-		for (int32 IndexB = IndexA + 1; IndexB < Windings.Num(); IndexB++)
+		SweepOrder[WindingIndex] = WindingIndex;
+	}
+	Algo::Sort(SweepOrder, [&Windings](int32 IndexA, int32 IndexB) {
+		const FWinding& A = Windings[IndexA];
+		const FWinding& B = Windings[IndexB];
+		if (A.Component != B.Component)
 		{
-			// No possible relation if they are not connected
-			if (Windings[IndexA].Color != Windings[IndexB].Color)
+			return A.Component < B.Component;
+		}
+		if (A.Bounds.Min.X != B.Bounds.Min.X)
+		{
+			return A.Bounds.Min.X < B.Bounds.Min.X;
+		}
+		return A.Area > B.Area;
+	});
+
+	TArray<int32> Parents;
+	Parents.Init(INDEX_NONE, Windings.Num());
+	TArray<int32> Depths;
+	Depths.Init(0, Windings.Num());
+	TArray<int32> ActiveWindings;
+	for (int32 SweepIndex = 0; SweepIndex < SweepOrder.Num(); ++SweepIndex)
+	{
+		const int32 WindingIndex = SweepOrder[SweepIndex];
+		const FWinding& Winding = Windings[WindingIndex];
+
+		// No possible relation if they are not connected
+		if (SweepIndex > 0 && Windings[SweepOrder[SweepIndex - 1]].Component != Winding.Component)
+		{
+			ActiveWindings.Reset();
+		}
+
+		// Windings which end left of this one can not enclose it or any of the following windings
+		ActiveWindings.RemoveAllSwap([&Windings, &Winding](int32 ActiveIndex) {
+			return Windings[ActiveIndex].Bounds.Max.X < Winding.Bounds.Min.X;
+		});
+
+		int32& Parent = Parents[WindingIndex];
+		for (const int32 CandidateIndex : ActiveWindings)
+		{
+			const FWinding& Candidate = Windings[CandidateIndex];
+			if (Candidate.Area <= Winding.Area || (Parent != INDEX_NONE && Candidate.Area >= Windings[Parent].Area) ||
+				!ContainsBounds(Candidate.Bounds, Winding.Bounds))
 			{
 				continue;
 			}
 
-			if (IsInsideOf2D(Windings[IndexA].Indices, Windings[IndexB].Indices, InVertices))
-			{
-				InsideOf.Add(IndexA, IndexB);
-			}
-			else if (IsInsideOf2D(Windings[IndexB].Indices, Windings[IndexA].Indices, InVertices))
+			if (PointInPolygon2D(InVertices[Winding.Indices[0]], Candidate.Indices, InVertices))
 			{
-				InsideOf.Add(IndexB, IndexA);
+				Parent = CandidateIndex;
 			}
 		}
+
+		Depths[WindingIndex] = Parent != INDEX_NONE ? Depths[Parent] + 1 : 0;
+		ActiveWindings.Add(WindingIndex);
 	}
 
-	TSet<int32> HoleSet;
-	TMap<int32, FInitialShapeFace> FaceMap;
-	for (int32 FaceIndex = 0; FaceIndex < Windings.Num(); ++FaceIndex)
+	TArray<FInitialShapeFace> Faces;
+	TArray<int32> FaceIndices;
+	FaceIndices.Init(INDEX_NONE, Windings.Num());
+	for (int32 WindingIndex = 0; WindingIndex < Windings.Num(); ++WindingIndex)
 	{
-		if (!InsideOf.Contains(FaceIndex))
-		{
-			FaceMap.Add(FaceIndex, FInitialShapeFace{Windings[FaceIndex].Indices});
-		}
-		else
+		if (Depths[WindingIndex] % 2 == 0)
 		{
-			HoleSet.Add(FaceIndex);
+			FaceIndices[WindingIndex] = Faces.Add(FInitialShapeFace{Windings[WindingIndex].Indices});
 		}
 	}
 
-	for (int32 HoleIndex : HoleSet)
+	for (int32 WindingIndex = 0; WindingIndex < Windings.Num(); ++WindingIndex)
 	{
-		int32 InsideOfIndex = InsideOf[HoleIndex];
-		if (FaceMap.Contains(InsideOfIndex))
+		if (Depths[WindingIndex] % 2 == 1)
 		{
-			FInitialShapeFace& ParentFace = FaceMap[InsideOfIndex];
-			ParentFace.Holes.Add(FInitialShapeHole{Windings[HoleIndex].Indices});
+			Faces[FaceIndices[Parents[WindingIndex]]].Holes.Add(FInitialShapeHole{Windings[WindingIndex].Indices});
 		}
 	}
 
-	TArray<FInitialShapeFace> Faces;
-	FaceMap.GenerateValueArray(Faces);
 	FInitialShapePolygon Result = {Faces, InVertices};
 	return Result;
 }
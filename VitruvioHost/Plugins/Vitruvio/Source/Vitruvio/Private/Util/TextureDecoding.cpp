@@ -14,14 +14,21 @@
  */
 
 #include "TextureDecoding.h"
+#include "Async/ParallelFor.h"
 #include "Engine/TextureDefines.h"
+#include "HAL/ThreadSafeCounter64.h"
 #include "HAL/PlatformFileManager.h"
+#include "Hash/xxhash.h"
 #include "Engine/Texture2D.h"
 #include "Runtime/Engine/Public/TextureResource.h"
 #include "UObject/Package.h"
 
 #include <string>
 
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+#include <smmintrin.h>
+#endif
+
 namespace
 {
 struct FTextureSettings
@@ -43,6 +50,278 @@ FTextureSettings GetTextureSettings(const FString& Key, EPixelFormat PixelFormat
 	bool IsGrayscale = PixelFormat == EPixelFormat::PF_G8 || PixelFormat == EPixelFormat::PF_G16 || EPixelFormat::PF_R32_FLOAT;
 	return {!IsGrayscale, TC_Default};
 }
+
+// Rows are converted in chunks so that small textures and mips do not pay for task dispatch
+constexpr int32 RowsPerTask = 64;
+
+template <typename RowFunctionType>
+void ParallelForRows(int32 NumRows, RowFunctionType RowFunction)
+{
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumRows, RowsPerTask);
+	ParallelFor(
+		NumTasks,
+		[NumRows, &RowFunction](int32 TaskIndex) {
+			const int32 RowEnd = FMath::Min(NumRows, (TaskIndex + 1) * RowsPerTask);
+			for (int32 Row = TaskIndex * RowsPerTask; Row < RowEnd; ++Row)
+			{
+				RowFunction(Row);
+			}
+		},
+		NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+// The row converters write the pixel formats returned by GetUnrealPixelFormat. Alpha is only kept for RGBA8, all other formats are
+// written with an alpha of 0 (1 for float textures).
+
+void ConvertRowRGBA8(const uint8* RESTRICT Src, uint8* RESTRICT Dst, int32 Width)
+{
+	int32 X = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+	const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	for (; X + 4 <= Width; X += 4)
+	{
+		const __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + X * 4), _mm_shuffle_epi8(Pixels, Shuffle));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		Dst[X * 4 + 0] = Src[X * 4 + 2];
+		Dst[X * 4 + 1] = Src[X * 4 + 1];
+		Dst[X * 4 + 2] = Src[X * 4 + 0];
+		Dst[X * 4 + 3] = Src[X * 4 + 3];
+	}
+}
+
+void ConvertRowRGB8(const uint8* RESTRICT Src, uint8* RESTRICT Dst, int32 Width)
+{
+	int32 X = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+	// Converts 4 pixels per iteration but loads 16 bytes, so the last pixels of a row are left to the scalar loop
+	const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	for (; X + 6 <= Width; X += 4)
+	{
+		const __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X * 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + X * 4), _mm_shuffle_epi8(Pixels, Shuffle));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		Dst[X * 4 + 0] = Src[X * 3 + 2];
+		Dst[X * 4 + 1] = Src[X * 3 + 1];
+		Dst[X * 4 + 2] = Src[X * 3 + 0];
+		Dst[X * 4 + 3] = 0;
+	}
+}
+
+void ConvertRowGrey8(const uint8* RESTRICT Src, uint8* RESTRICT Dst, int32 Width)
+{
+	int32 X = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+	const __m128i Shuffle0 = _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1);
+	const __m128i Shuffle1 = _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1);
+	const __m128i Shuffle2 = _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1);
+	const __m128i Shuffle3 = _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1);
+	for (; X + 16 <= Width; X += 16)
+	{
+		const __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X));
+		__m128i* DstPixels = reinterpret_cast<__m128i*>(Dst + X * 4);
+		_mm_storeu_si128(DstPixels + 0, _mm_shuffle_epi8(Pixels, Shuffle0));
+		_mm_storeu_si128(DstPixels + 1, _mm_shuffle_epi8(Pixels, Shuffle1));
+		_mm_storeu_si128(DstPixels + 2, _mm_shuffle_epi8(Pixels, Shuffle2));
+		_mm_storeu_si128(DstPixels + 3, _mm_shuffle_epi8(Pixels, Shuffle3));
+	}
+#endif
+	for (; X < Width; ++X)
+	{
+		Dst[X * 4 + 0] = Src[X];
+		Dst[X * 4 + 1] = Src[X];
+		Dst[X * 4 + 2] = Src[X];
+		Dst[X * 4 + 3] = 0;
+	}
+}
+
+void ConvertRowGrey16(const uint8* RESTRICT Src, uint8* RESTRICT Dst, int32 Width)
+{
+	// Operates on whole pixels so that the compiler can vectorize the loop
+	const uint16* RESTRICT SrcPixels = reinterpret_cast<const uint16*>(Src);
+	uint64* RESTRICT DstPixels = reinterpret_cast<uint64*>(Dst);
+	for (int32 X = 0; X < Width; ++X)
+	{
+		const uint64 Grey = SrcPixels[X];
+		DstPixels[X] = Grey | (Grey << 16) | (Grey << 32);
+	}
+}
+
+void ConvertRowFloat32(const uint8* RESTRICT Src, uint8* RESTRICT Dst, int32 Width)
+{
+	// Convert 32 bit grayscale float textures to 16 bit RGBA float textures
+	const float* RESTRICT SrcPixels = reinterpret_cast<const float*>(Src);
+	FFloat16Color* RESTRICT DstPixels = reinterpret_cast<FFloat16Color*>(Dst);
+	const FFloat16 One(1.0f);
+	for (int32 X = 0; X < Width; ++X)
+	{
+		const FFloat16 Grey(SrcPixels[X]);
+		DstPixels[X].R = Grey;
+		DstPixels[X].G = Grey;
+		DstPixels[X].B = Grey;
+		DstPixels[X].A = One;
+	}
+}
+
+uint8 Average(uint8 A, uint8 B, uint8 C, uint8 D)
+{
+	return static_cast<uint8>((static_cast<uint32>(A) + B + C + D + 2) >> 2);
+}
+
+uint16 Average(uint16 A, uint16 B, uint16 C, uint16 D)
+{
+	return static_cast<uint16>((static_cast<uint32>(A) + B + C + D + 2) >> 2);
+}
+
+FFloat16 Average(FFloat16 A, FFloat16 B, FFloat16 C, FFloat16 D)
+{
+	return FFloat16((A.GetFloat() + B.GetFloat() + C.GetFloat() + D.GetFloat()) * 0.25f);
+}
+
+/**
+ * \brief 2x2 box filter on 4 channel pixels. Odd source sizes drop the last row or column, which is how mips are sized anyway.
+ */
+template <typename ChannelType>
+void DownsampleMipChannels(const uint8* Src, int32 SrcSizeX, int32 SrcSizeY, uint8* Dst)
+{
+	const int32 DstSizeX = FMath::Max(1, SrcSizeX / 2);
+	const int32 DstSizeY = FMath::Max(1, SrcSizeY / 2);
+	const ChannelType* SrcChannels = reinterpret_cast<const ChannelType*>(Src);
+	ChannelType* DstChannels = reinterpret_cast<ChannelType*>(Dst);
+
+	ParallelForRows(DstSizeY, [=](int32 Y) {
+		const ChannelType* RESTRICT Row0 = SrcChannels + static_cast<int64>(FMath::Min(Y * 2, SrcSizeY - 1)) * SrcSizeX * 4;
+		const ChannelType* RESTRICT Row1 = SrcChannels + static_cast<int64>(FMath::Min(Y * 2 + 1, SrcSizeY - 1)) * SrcSizeX * 4;
+		ChannelType* RESTRICT DstRow = DstChannels + static_cast<int64>(Y) * DstSizeX * 4;
+		for (int32 X = 0; X < DstSizeX; ++X)
+		{
+			const int32 X0 = FMath::Min(X * 2, SrcSizeX - 1) * 4;
+			const int32 X1 = FMath::Min(X * 2 + 1, SrcSizeX - 1) * 4;
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				DstRow[X * 4 + Channel] = Average(Row0[X0 + Channel], Row0[X1 + Channel], Row1[X0 + Channel], Row1[X1 + Channel]);
+			}
+		}
+	});
+}
+
+// A pixel counts as black below and as white above these opacity values
+constexpr double BlackColorThreshold = 0.02;
+constexpr double WhiteColorThreshold = 1.0 - BlackColorThreshold;
+// Share of white (or black and white) pixels above which an opacity map is treated as opaque (or masked)
+constexpr double OpacityThreshold = 0.98;
+
+/**
+ * \brief Integer bounds of the black and white opacity thresholds for channels with the given maximum value.
+ */
+struct FOpacityLimits
+{
+	int32 MaxBlack;
+	int32 MinWhite;
+
+	explicit FOpacityLimits(int32 MaxValue)
+		: MaxBlack(FMath::CeilToInt32(BlackColorThreshold * MaxValue) - 1), MinWhite(FMath::FloorToInt32(WhiteColorThreshold * MaxValue) + 1)
+	{
+	}
+};
+
+struct FOpacityPixelCounts
+{
+	int64 AlphaBlack = 0;
+	int64 AlphaWhite = 0;
+	int64 RedBlack = 0;
+	int64 RedWhite = 0;
+};
+
+void CountOpacityRowB8G8R8A8(const uint8* RESTRICT Src, int32 Width, FOpacityPixelCounts& Counts)
+{
+	static const FOpacityLimits Limits(0xFF);
+
+	int32 X = 0;
+#if PLATFORM_ALWAYS_HAS_SSE4_1
+	// Counts 4 pixels per iteration, comparisons yield -1 per matching lane which is subtracted from the lane counters
+	const __m128i ChannelMask = _mm_set1_epi32(0xFF);
+	const __m128i BlackBound = _mm_set1_epi32(Limits.MaxBlack + 1);
+	const __m128i WhiteBound = _mm_set1_epi32(Limits.MinWhite - 1);
+	__m128i AlphaBlack = _mm_setzero_si128();
+	__m128i AlphaWhite = _mm_setzero_si128();
+	__m128i RedBlack = _mm_setzero_si128();
+	__m128i RedWhite = _mm_setzero_si128();
+	for (; X + 4 <= Width; X += 4)
+	{
+		const __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + X * 4));
+		const __m128i Alpha = _mm_srli_epi32(Pixels, 24);
+		const __m128i Red = _mm_and_si128(_mm_srli_epi32(Pixels, 16), ChannelMask);
+		AlphaBlack = _mm_sub_epi32(AlphaBlack, _mm_cmplt_epi32(Alpha, BlackBound));
+		AlphaWhite = _mm_sub_epi32(AlphaWhite, _mm_cmpgt_epi32(Alpha, WhiteBound));
+		RedBlack = _mm_sub_epi32(RedBlack, _mm_cmplt_epi32(Red, BlackBound));
+		RedWhite = _mm_sub_epi32(RedWhite, _mm_cmpgt_epi32(Red, WhiteBound));
+	}
+
+	alignas(16) int32 Lanes[4][4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes[0]), AlphaBlack);
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes[1]), AlphaWhite);
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes[2]), RedBlack);
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes[3]), RedWhite);
+	Counts.AlphaBlack += Lanes[0][0] + Lanes[0][1] + Lanes[0][2] + Lanes[0][3];
+	Counts.AlphaWhite += Lanes[1][0] + Lanes[1][1] + Lanes[1][2] + Lanes[1][3];
+	Counts.RedBlack += Lanes[2][0] + Lanes[2][1] + Lanes[2][2] + Lanes[2][3];
+	Counts.RedWhite += Lanes[3][0] + Lanes[3][1] + Lanes[3][2] + Lanes[3][3];
+#endif
+	for (; X < Width; ++X)
+	{
+		const int32 Alpha = Src[X * 4 + 3];
+		const int32 Red = Src[X * 4 + 2];
+		Counts.AlphaBlack += Alpha <= Limits.MaxBlack;
+		Counts.AlphaWhite += Alpha >= Limits.MinWhite;
+		Counts.RedBlack += Red <= Limits.MaxBlack;
+		Counts.RedWhite += Red >= Limits.MinWhite;
+	}
+}
+
+void CountOpacityRowA16B16G16R16(const uint8* RESTRICT Src, int32 Width, FOpacityPixelCounts& Counts)
+{
+	static const FOpacityLimits Limits(0xFFFF);
+
+	// Branchless so that the compiler can vectorize the loop
+	const uint16* RESTRICT Channels = reinterpret_cast<const uint16*>(Src);
+	int32 AlphaBlack = 0;
+	int32 AlphaWhite = 0;
+	int32 RedBlack = 0;
+	int32 RedWhite = 0;
+	for (int32 X = 0; X < Width; ++X)
+	{
+		const int32 Red = Channels[X * 4 + 0];
+		const int32 Alpha = Channels[X * 4 + 3];
+		AlphaBlack += Alpha <= Limits.MaxBlack;
+		AlphaWhite += Alpha >= Limits.MinWhite;
+		RedBlack += Red <= Limits.MaxBlack;
+		RedWhite += Red >= Limits.MinWhite;
+	}
+	Counts.AlphaBlack += AlphaBlack;
+	Counts.AlphaWhite += AlphaWhite;
+	Counts.RedBlack += RedBlack;
+	Counts.RedWhite += RedWhite;
+}
+
+EBlendMode ChooseBlendModeFromPixelCounts(int64 BlackPixels, int64 WhitePixels, int64 TotalPixels)
+{
+	if (WhitePixels >= TotalPixels * OpacityThreshold)
+	{
+		return BLEND_Opaque;
+	}
+	if (WhitePixels + BlackPixels >= TotalPixels * OpacityThreshold)
+	{
+		return BLEND_Masked;
+	}
+	return BLEND_Translucent;
+}
 } // namespace
 
 namespace Vitruvio
@@ -120,54 +399,113 @@ EPixelFormat GetUnrealPixelFormat(EPRTPixelFormat PRTPixelFormat)
 	}
 }
 
-FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Path, const FTextureMetadata& TextureMetadata,
-						   std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize)
+int32 GetNumMips(int32 SizeX, int32 SizeY)
 {
-	EPixelFormat UnrealPixelFormat = GetUnrealPixelFormat(TextureMetadata.PixelFormat);
-	check(UnrealPixelFormat != EPixelFormat::PF_Unknown);
+	return FMath::FloorLog2(static_cast<uint32>(FMath::Max3(SizeX, SizeY, 1))) + 1;
+}
+
+void ConvertPixels(const FTextureMetadata& TextureMetadata, const uint8* Src, uint8* Dst)
+{
+	using FConvertRowFunction = void (*)(const uint8*, uint8*, int32);
+	FConvertRowFunction ConvertRow = nullptr;
+	switch (TextureMetadata.PixelFormat)
+	{
+	case EPRTPixelFormat::GREY8:
+		ConvertRow = &ConvertRowGrey8;
+		break;
+	case EPRTPixelFormat::GREY16:
+		ConvertRow = &ConvertRowGrey16;
+		break;
+	case EPRTPixelFormat::FLOAT32:
+		ConvertRow = &ConvertRowFloat32;
+		break;
+	case EPRTPixelFormat::RGB8:
+		ConvertRow = &ConvertRowRGB8;
+		break;
+	case EPRTPixelFormat::RGBA8:
+		ConvertRow = &ConvertRowRGBA8;
+		break;
+	default:
+		checkNoEntry();
+		return;
+	}
 
-	const size_t BytesPerBand = FMath::Min<size_t>(2, TextureMetadata.BytesPerBand);
-	const bool bIsColor = (TextureMetadata.Bands >= 3);
+	const int32 Width = static_cast<int32>(TextureMetadata.Width);
+	const int32 Height = static_cast<int32>(TextureMetadata.Height);
+	const int64 SrcRowSize = static_cast<int64>(Width) * TextureMetadata.Bands * TextureMetadata.BytesPerBand;
+	const int64 DstRowSize = CalculateImageBytes(Width, 1, 0, GetUnrealPixelFormat(TextureMetadata.PixelFormat));
 
-	size_t NewBufferSize = TextureMetadata.Width * TextureMetadata.Height * 4 * BytesPerBand;
-	auto NewBuffer = std::make_unique<uint8_t[]>(NewBufferSize);
+	// PRT rows are stored bottom up
+	ParallelForRows(Height, [=](int32 Y) { ConvertRow(Src + (Height - Y - 1) * SrcRowSize, Dst + Y * DstRowSize, Width); });
+}
 
-	for (int Y = 0; Y < TextureMetadata.Height; ++Y)
+void DownsampleMip(EPixelFormat PixelFormat, const uint8* Src, int32 SrcSizeX, int32 SrcSizeY, uint8* Dst)
+{
+	switch (PixelFormat)
 	{
-		for (int X = 0; X < TextureMetadata.Width; ++X)
-		{
-			if (TextureMetadata.PixelFormat == EPRTPixelFormat::FLOAT32)
-			{
-				// Convert 32 bit grayscale float textures to 16 bit RGBA float textures
-				const int OldOffset = ((TextureMetadata.Height - Y - 1) * TextureMetadata.Width + X) * TextureMetadata.Bands;
-				const int NewOffset = (Y * TextureMetadata.Width + X);
-				const float* FloatBuffer = reinterpret_cast<const float*>(Buffer.get());
-				FFloat16Color* NewFloat16Buffer = reinterpret_cast<FFloat16Color*>(NewBuffer.get());
-				const float Float32Value = FloatBuffer[OldOffset];
-				const FFloat16 Float16Value(Float32Value);
-				FFloat16Color Color;
-				Color.R = Float16Value;
-				Color.G = Float16Value;
-				Color.B = Float16Value;
-				Color.A = FFloat16(1.0f);
-				NewFloat16Buffer[NewOffset] = Color;
-			}
-			else
-			{
-				// Workaround: Also convert grayscale images to rgba, since texture params don't automatically update their sample method
-				const int OldOffset = ((TextureMetadata.Height - Y - 1) * TextureMetadata.Width + X) * TextureMetadata.Bands * BytesPerBand;
-				const int NewOffset = (Y * TextureMetadata.Width + X) * 4 * BytesPerBand;
-				for (int B = 0; B < BytesPerBand; ++B)
-				{
-					NewBuffer[NewOffset + 0 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 2 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 1 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 1 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 2 * BytesPerBand + B] = bIsColor ? Buffer[OldOffset + 0 + B] : Buffer[OldOffset + B];
-					NewBuffer[NewOffset + 3 * BytesPerBand + B] = (TextureMetadata.Bands == 4) ? Buffer[OldOffset + 3 + B] : 0;
-				}
-			}
-		}
+	case EPixelFormat::PF_B8G8R8A8:
+		DownsampleMipChannels<uint8>(Src, SrcSizeX, SrcSizeY, Dst);
+		break;
+	case EPixelFormat::PF_A16B16G16R16:
+		DownsampleMipChannels<uint16>(Src, SrcSizeX, SrcSizeY, Dst);
+		break;
+	case EPixelFormat::PF_FloatRGBA:
+		DownsampleMipChannels<FFloat16>(Src, SrcSizeX, SrcSizeY, Dst);
+		break;
+	default:
+		checkNoEntry();
+	}
+}
+
+FOpacityClassification ClassifyOpacity(EPixelFormat PixelFormat, const uint8* Pixels, int32 SizeX, int32 SizeY)
+{
+	using FCountOpacityRowFunction = void (*)(const uint8*, int32, FOpacityPixelCounts&);
+	FCountOpacityRowFunction CountOpacityRow = nullptr;
+	switch (PixelFormat)
+	{
+	case EPixelFormat::PF_B8G8R8A8:
+		CountOpacityRow = &CountOpacityRowB8G8R8A8;
+		break;
+	case EPixelFormat::PF_A16B16G16R16:
+		CountOpacityRow = &CountOpacityRowA16B16G16R16;
+		break;
+	default:
+		// Float textures are converted from grayscale float textures and never carry opacity
+		return {};
 	}
 
+	FThreadSafeCounter64 AlphaBlack;
+	FThreadSafeCounter64 AlphaWhite;
+	FThreadSafeCounter64 RedBlack;
+	FThreadSafeCounter64 RedWhite;
+
+	const int64 RowSize = CalculateImageBytes(SizeX, 1, 0, PixelFormat);
+	ParallelForRows(SizeY, [&](int32 Y) {
+		FOpacityPixelCounts Counts;
+		CountOpacityRow(Pixels + Y * RowSize, SizeX, Counts);
+		AlphaBlack.Add(Counts.AlphaBlack);
+		AlphaWhite.Add(Counts.AlphaWhite);
+		RedBlack.Add(Counts.RedBlack);
+		RedWhite.Add(Counts.RedWhite);
+	});
+
+	const int64 TotalPixels = static_cast<int64>(SizeX) * SizeY;
+	FOpacityClassification Result;
+	Result.AlphaBlendMode = ChooseBlendModeFromPixelCounts(AlphaBlack.GetValue(), AlphaWhite.GetValue(), TotalPixels);
+	Result.RedBlendMode = ChooseBlendModeFromPixelCounts(RedBlack.GetValue(), RedWhite.GetValue(), TotalPixels);
+	return Result;
+}
+
+FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Path, const FTextureMetadata& TextureMetadata,
+						   std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize)
+{
+	EPixelFormat UnrealPixelFormat = GetUnrealPixelFormat(TextureMetadata.PixelFormat);
+	check(UnrealPixelFormat != EPixelFormat::PF_Unknown);
+	check(BufferSize >= TextureMetadata.Width * TextureMetadata.Height * TextureMetadata.Bands * TextureMetadata.BytesPerBand);
+
+	const int32 Width = static_cast<int32>(TextureMetadata.Width);
+	const int32 Height = static_cast<int32>(TextureMetadata.Height);
+
 	const FTextureSettings Settings = GetTextureSettings(Key, UnrealPixelFormat);
 
 	const FString TextureBaseName = TEXT("T_") + FPaths::GetBaseFilename(Path);
@@ -175,28 +513,66 @@ FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Pa
 	UTexture2D* NewTexture = NewObject<UTexture2D>(GetTransientPackage(), TextureName, RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
 	NewTexture->CompressionSettings = Settings.Compression;
 	NewTexture->SRGB = Settings.SRGB;
+	// All mips are created here and there is no bulk data file to stream them from
+	NewTexture->NeverStream = true;
 
 	FTexturePlatformData* PlatformData = new FTexturePlatformData();
-	PlatformData = new FTexturePlatformData();
-	PlatformData->SizeX = TextureMetadata.Width;
-	PlatformData->SizeY = TextureMetadata.Height;
+	PlatformData->SizeX = Width;
+	PlatformData->SizeY = Height;
 	PlatformData->PixelFormat = UnrealPixelFormat;
 
-	// Allocate first mipmap and upload the pixel data
-	FTexture2DMipMap* Mip = new FTexture2DMipMap();
-	PlatformData->Mips.Add(Mip);
-	Mip->SizeX = TextureMetadata.Width;
-	Mip->SizeY = TextureMetadata.Height;
-	Mip->BulkData.Lock(LOCK_READ_WRITE);
-	void* TextureData = Mip->BulkData.Realloc(CalculateImageBytes(TextureMetadata.Width, TextureMetadata.Height, 0, UnrealPixelFormat));
-	FMemory::Memcpy(TextureData, NewBuffer.get(), NewBufferSize);
-	Mip->BulkData.Unlock();
+	// Convert the pixel data into the first mip and downsample each mip from the previous one. The previous mip stays locked until the
+	// next one has been written.
+	const int32 NumMips = GetNumMips(Width, Height);
+	int64 MemorySize = 0;
+	FOpacityClassification Opacity;
+	FTexture2DMipMap* PreviousMip = nullptr;
+	const uint8* PreviousMipData = nullptr;
+	for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+	{
+		FTexture2DMipMap* Mip = new FTexture2DMipMap();
+		PlatformData->Mips.Add(Mip);
+		Mip->SizeX = FMath::Max(1, Width >> MipIndex);
+		Mip->SizeY = FMath::Max(1, Height >> MipIndex);
+		Mip->BulkData.Lock(LOCK_READ_WRITE);
+		const int64 MipSize = CalculateImageBytes(Mip->SizeX, Mip->SizeY, 0, UnrealPixelFormat);
+		uint8* MipData = static_cast<uint8*>(Mip->BulkData.Realloc(MipSize));
+		MemorySize += MipSize;
+
+		if (PreviousMip)
+		{
+			DownsampleMip(UnrealPixelFormat, PreviousMipData, PreviousMip->SizeX, PreviousMip->SizeY, MipData);
+			PreviousMip->BulkData.Unlock();
+		}
+		else
+		{
+			ConvertPixels(TextureMetadata, Buffer.get(), MipData);
+			// Classified once here so that materials using this texture as opacity map never have to scan its pixels again
+			Opacity = ClassifyOpacity(UnrealPixelFormat, MipData, Width, Height);
+		}
+
+		PreviousMip = Mip;
+		PreviousMipData = MipData;
+	}
+	PreviousMip->BulkData.Unlock();
 
 	NewTexture->SetPlatformData(PlatformData);
 
 	NewTexture->UpdateResource();
 
+	// Identical images are shared by the texture cache as long as they are used with the same settings
+	FXxHash64Builder ContentHashBuilder;
+	ContentHashBuilder.Update(Buffer.get(), BufferSize);
+	ContentHashBuilder.Update(&TextureMetadata.Width, sizeof(TextureMetadata.Width));
+	ContentHashBuilder.Update(&TextureMetadata.Height, sizeof(TextureMetadata.Height));
+	ContentHashBuilder.Update(&TextureMetadata.PixelFormat, sizeof(TextureMetadata.PixelFormat));
+	ContentHashBuilder.Update(&Settings.SRGB, sizeof(Settings.SRGB));
+	ContentHashBuilder.Update(&Settings.Compression, sizeof(Settings.Compression));
+
 	const auto TimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*Path);
-	return FTextureData { NewTexture, static_cast<uint32>(TextureMetadata.Bands), TimeStamp };
+	FTextureData Result{NewTexture, static_cast<uint32>(TextureMetadata.Bands), TimeStamp, ContentHashBuilder.Finalize().Hash, MemorySize};
+	Result.AlphaBlendMode = Opacity.AlphaBlendMode;
+	Result.RedBlendMode = Opacity.RedBlendMode;
+	return Result;
 }
 } // namespace Vitruvio
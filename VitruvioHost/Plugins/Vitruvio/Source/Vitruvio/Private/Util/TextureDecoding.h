@@ -17,6 +17,8 @@
 
 #include "VitruvioTypes.h"
 
+#include "PixelFormat.h"
+
 #include "prt/AttributeMap.h"
 
 #include <memory>
@@ -46,6 +48,42 @@ struct FTextureMetadata
 
 VITRUVIO_API FTextureMetadata ParseTextureMetadata(const prt::AttributeMap* TextureMetadata);
 
+/**
+ * \return the Unreal pixel format PRT pixel data is converted to (grayscale textures are expanded to 4 channels)
+ */
+EPixelFormat GetUnrealPixelFormat(EPRTPixelFormat PRTPixelFormat);
+
+/**
+ * \return the number of mips of a full mip chain down to 1x1
+ */
+int32 GetNumMips(int32 SizeX, int32 SizeY);
+
+/**
+ * \brief Converts PRT pixel data into the Unreal pixel format returned by GetUnrealPixelFormat and flips it vertically. Rows are
+ * converted in parallel.
+ */
+void ConvertPixels(const FTextureMetadata& TextureMetadata, const uint8* Src, uint8* Dst);
+
+/**
+ * \brief Writes the next mip of Src with a 2x2 box filter. PixelFormat must be one of the formats returned by GetUnrealPixelFormat.
+ */
+void DownsampleMip(EPixelFormat PixelFormat, const uint8* Src, int32 SrcSizeX, int32 SrcSizeY, uint8* Dst);
+
+struct FOpacityClassification
+{
+	EBlendMode AlphaBlendMode = BLEND_Opaque;
+	EBlendMode RedBlendMode = BLEND_Opaque;
+};
+
+/**
+ * \brief Classifies the alpha and the red channel of a mip as opaque, masked or translucent opacity map by counting its black and white
+ * pixels. Rows are counted in parallel. Float textures are always classified as opaque.
+ */
+FOpacityClassification ClassifyOpacity(EPixelFormat PixelFormat, const uint8* Pixels, int32 SizeX, int32 SizeY);
+
+/**
+ * \brief Creates a transient texture with a full mip chain from PRT pixel data. May be called from any thread.
+ */
 VITRUVIO_API FTextureData DecodeTexture(UObject* Outer, const FString& Key, const FString& Path, const FTextureMetadata& TextureMetadata,
 										std::unique_ptr<uint8_t[]> Buffer, size_t BufferSize);
 
@@ -0,0 +1,87 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "VertexWelding.h"
+
+namespace
+{
+// Cells must not become degenerate for a tolerance of 0, in which case only equal vertices are welded
+constexpr double MinCellSize = UE_DOUBLE_SMALL_NUMBER;
+
+FInt64Vector GetCell(const FVector& Vertex, double CellSize)
+{
+	return FInt64Vector(FMath::FloorToInt64(Vertex.X / CellSize), FMath::FloorToInt64(Vertex.Y / CellSize),
+						FMath::FloorToInt64(Vertex.Z / CellSize));
+}
+
+uint32 GetCellHash(const FInt64Vector& Cell)
+{
+	return HashCombineFast(GetTypeHash(Cell.X), HashCombineFast(GetTypeHash(Cell.Y), GetTypeHash(Cell.Z)));
+}
+} // namespace
+
+namespace Vitruvio
+{
+
+TArray<int32> WeldVertices(const TArray<FVector>& Vertices, double Tolerance, TArray<FVector>& OutWeldedVertices)
+{
+	// Vertices within tolerance are at most half a cell apart on every axis and therefore in the same or a directly neighbouring cell, even
+	// with rounding errors of the cell computation
+	const double CellSize = FMath::Max(2.0 * Tolerance, MinCellSize);
+
+	TArray<int32> RemappedIndices;
+	RemappedIndices.Reserve(Vertices.Num());
+	OutWeldedVertices.Reset();
+
+	// Different cells may share a hash, which only results in additional comparisons
+	TMultiMap<uint32, int32> Cells;
+	Cells.Reserve(Vertices.Num());
+
+	for (const FVector& Vertex : Vertices)
+	{
+		const FInt64Vector Cell = GetCell(Vertex, CellSize);
+
+		int32 WeldedIndex = INDEX_NONE;
+		for (int64 Z = Cell.Z - 1; Z <= Cell.Z + 1; ++Z)
+		{
+			for (int64 Y = Cell.Y - 1; Y <= Cell.Y + 1; ++Y)
+			{
+				for (int64 X = Cell.X - 1; X <= Cell.X + 1; ++X)
+				{
+					for (auto It = Cells.CreateConstKeyIterator(GetCellHash(FInt64Vector(X, Y, Z))); It; ++It)
+					{
+						const int32 CandidateIndex = It.Value();
+						if ((WeldedIndex == INDEX_NONE || CandidateIndex < WeldedIndex) && Vertex.Equals(OutWeldedVertices[CandidateIndex], Tolerance))
+						{
+							WeldedIndex = CandidateIndex;
+						}
+					}
+				}
+			}
+		}
+
+		if (WeldedIndex == INDEX_NONE)
+		{
+			WeldedIndex = OutWeldedVertices.Add(Vertex);
+			Cells.Add(GetCellHash(Cell), WeldedIndex);
+		}
+		RemappedIndices.Add(WeldedIndex);
+	}
+
+	return RemappedIndices;
+}
+
+} // namespace Vitruvio
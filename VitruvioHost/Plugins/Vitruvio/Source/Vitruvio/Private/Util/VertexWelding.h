@@ -0,0 +1,33 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Vitruvio
+{
+
+/**
+ * \brief Merges vertices which are within Tolerance of each other on every axis (see FVector::Equals). Every vertex is mapped to the first
+ * welded vertex within tolerance, which is the same result as a linear search over the welded vertices. Vertices are hashed into cells of
+ * twice the tolerance so that only the vertices of neighbouring cells have to be compared, which results in linear run time.
+ *
+ * \return the index into OutWeldedVertices per vertex of Vertices.
+ */
+TArray<int32> WeldVertices(const TArray<FVector>& Vertices, double Tolerance, TArray<FVector>& OutWeldedVertices);
+
+} // namespace Vitruvio
@@ -0,0 +1,87 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "VertexWeldBenchmark.h"
+
+#include "VertexWelding.h"
+
+namespace
+{
+constexpr double QuadSize = 100.0;
+constexpr double Tolerance = UE_KINDA_SMALL_NUMBER;
+
+TArray<FVector> CreateFootprintVertices(int32 NumVertices)
+{
+	FRandomStream Random(0);
+
+	// Every quad has its own four vertices, as in a static mesh with split normals or texture coordinates
+	const int32 NumQuads = FMath::Max(NumVertices / 4, 1);
+	const int32 QuadsPerRow = FMath::Max(FMath::CeilToInt32(FMath::Sqrt(static_cast<double>(NumQuads))), 1);
+	const FVector Corners[] = {FVector(0, 0, 0), FVector(1, 0, 0), FVector(1, 1, 0), FVector(0, 1, 0)};
+
+	TArray<FVector> Vertices;
+	Vertices.Reserve(NumVertices);
+	for (int32 Quad = 0; Vertices.Num() < NumVertices; ++Quad)
+	{
+		const FVector Origin((Quad % QuadsPerRow) * QuadSize, (Quad / QuadsPerRow) * QuadSize, 0);
+		for (int32 Corner = 0; Corner < 4 && Vertices.Num() < NumVertices; ++Corner)
+		{
+			// Jitter of up to the tolerance, so that some shared positions are welded and some are not
+			const FVector Jitter(Random.FRandRange(-Tolerance, Tolerance), Random.FRandRange(-Tolerance, Tolerance), 0);
+			Vertices.Add(Origin + Corners[Corner] * QuadSize + Jitter);
+		}
+	}
+	return Vertices;
+}
+
+TArray<int32> WeldVerticesReference(const TArray<FVector>& Vertices, double WeldTolerance, TArray<FVector>& OutWeldedVertices)
+{
+	TArray<int32> RemappedIndices;
+	RemappedIndices.Reserve(Vertices.Num());
+	OutWeldedVertices.Reset();
+
+	for (const FVector& Vertex : Vertices)
+	{
+		const int32 WeldedIndex = OutWeldedVertices.IndexOfByPredicate([&Vertex, WeldTolerance](const FVector& In) {
+			return Vertex.Equals(In, WeldTolerance);
+		});
+		RemappedIndices.Add(WeldedIndex == INDEX_NONE ? OutWeldedVertices.Add(Vertex) : WeldedIndex);
+	}
+	return RemappedIndices;
+}
+} // namespace
+
+FVertexWeldBenchmarkResult RunVertexWeldBenchmark(int32 NumVertices)
+{
+	const TArray<FVector> Vertices = CreateFootprintVertices(NumVertices);
+
+	FVertexWeldBenchmarkResult Result;
+	Result.NumVertices = Vertices.Num();
+
+	TArray<FVector> WeldedVertices;
+	double StartTime = FPlatformTime::Seconds();
+	const TArray<int32> Indices = Vitruvio::WeldVertices(Vertices, Tolerance, WeldedVertices);
+	Result.WeldMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	Result.NumWeldedVertices = WeldedVertices.Num();
+
+	TArray<FVector> ReferenceVertices;
+	StartTime = FPlatformTime::Seconds();
+	const TArray<int32> ReferenceIndices = WeldVerticesReference(Vertices, Tolerance, ReferenceVertices);
+	Result.ReferenceMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	Result.bEquivalent = Indices == ReferenceIndices && WeldedVertices == ReferenceVertices;
+	return Result;
+}
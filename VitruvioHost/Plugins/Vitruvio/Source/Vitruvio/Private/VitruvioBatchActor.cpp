@@ -18,6 +18,7 @@
 #include "Materials/Material.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
 #include "GenerateCompletedCallbackProxy.h"
+#include "VitruvioBatchSubsystem.h"
 
 void UTile::MarkForAttributeEvaluation(UVitruvioComponent* VitruvioComponent, UGenerateCompletedCallbackProxy* CallbackProxy)
 {
@@ -236,45 +237,34 @@ void FGrid::UnmarkAllForAttributeEvaluation()
 	}
 }
 
-TArray<FInitialShape> FGrid::GetNeighboringShapes(const UTile* Tile, const TArray<FInitialShape>& InitialShapes)
+TArray<FInitialShape> FGrid::GetNeighboringShapes(const UTile* Tile, const TArray<FInitialShape>& InitialShapes,
+												  const UVitruvioBatchSubsystem& Subsystem) const
 {
-	TArray<FInitialShape> NeighboringShapes;
-	
-	const TArray Directions = {
-		FIntPoint(-1, 0), FIntPoint(1, 0), FIntPoint(0, -1), FIntPoint(0, 1),
-		FIntPoint(-1, -1), FIntPoint(-1, 1), FIntPoint(1, -1), FIntPoint(1, 1)
-	};
+	const double QueryDistance = CVarInterOcclusionNeighborQueryDistance.GetValueOnAnyThread();
 
-	for (const FIntPoint& Dir : Directions)
+	TSet<UVitruvioComponent*> Neighbors;
+	for (const FInitialShape& InitialShape : InitialShapes)
 	{
-		FIntPoint NeighborPos = Tile->Location + Dir;
-		UTile** NeighborTilePtr = Tiles.Find(NeighborPos);
-		if (!NeighborTilePtr)
+		Subsystem.ForEachNeighbor(InitialShape.Position, QueryDistance, [this, Tile, &Neighbors](UVitruvioComponent* VitruvioComponent)
 		{
-			continue;
-		}
-			
-		UTile* NeighborTile = *NeighborTilePtr;
-		auto [NeighborInitialShapes, _] = NeighborTile->GetInitialShapes([&InitialShapes](UVitruvioComponent* VitruvioComponent)
-		{
-			FVector Position = VitruvioComponent->GetOwner()->GetTransform().GetLocation();
-			for (const FInitialShape& InputShape : InitialShapes)
+			if (!Tile->Contains(VitruvioComponent) && TilesByComponent.Contains(VitruvioComponent))
 			{
-				if (FVector::Dist(Position, InputShape.Position) < CVarInterOcclusionNeighborQueryDistance.GetValueOnAnyThread())
-				{
-					return true;
-				}
+				Neighbors.Add(VitruvioComponent);
 			}
-
-			return false;
 		});
+	}
 
-		for (FInitialShape& NeighborShape : NeighborInitialShapes)
+	TArray<FInitialShape> NeighboringShapes;
+	for (UVitruvioComponent* Neighbor : Neighbors)
+	{
+		if (!Neighbor->HasValidInputData())
 		{
-			NeighborShape.bOccluderOnly = true;
+			continue;
 		}
-		
-		NeighboringShapes.Append(MoveTemp(NeighborInitialShapes));
+
+		FInitialShape NeighborShape = Neighbor->GetInitialShape();
+		NeighborShape.bOccluderOnly = true;
+		NeighboringShapes.Add(MoveTemp(NeighborShape));
 	}
 
 	return NeighboringShapes;
@@ -357,16 +347,20 @@ void AVitruvioBatchActor::ProcessTiles()
 			TArray<FInitialShape> OccluderOnlyShapes;
 			if (bEnableOcclusionQueries)
 			{
-				OccluderOnlyShapes = Grid.GetNeighboringShapes(Tile, InitialShapes);
+				OccluderOnlyShapes = Grid.GetNeighboringShapes(Tile, InitialShapes, *GetWorld()->GetSubsystem<UVitruvioBatchSubsystem>());
 			}
 			
-			FBatchGenerateResult GenerateResult = VitruvioModule::Get().BatchGenerateAsync(MoveTemp(InitialShapes), bEnableOcclusionQueries, MoveTemp(OccluderOnlyShapes));
+			const bool bGeneratePerInitialShape = CVarBatchGeneratePerInitialShape.GetValueOnGameThread();
+			FBatchGenerateResult GenerateResult = VitruvioModule::Get().BatchGenerateAsync(MoveTemp(InitialShapes), bEnableOcclusionQueries,
+																						   MoveTemp(OccluderOnlyShapes), bGeneratePerInitialShape);
 			
 			Tile->GenerateToken = GenerateResult.Token;
 			Tile->bIsGenerating = true;
+
+			FApplyBudget* ApplyBudget = &VitruvioModule::Get().GetApplyBudget();
 		
 			// clang-format off
-			GenerateResult.Result.Next([WeakThis = MakeWeakObjectPtr(this), Tile, InitialShapeVitruvioComponents](const FBatchGenerateResult::ResultType& Result)
+			GenerateResult.Result.Next([WeakThis = MakeWeakObjectPtr(this), Tile, InitialShapeVitruvioComponents, ApplyBudget](const FBatchGenerateResult::ResultType& Result)
 			{
 				if (!WeakThis.IsValid())
 				{
@@ -383,7 +377,7 @@ void AVitruvioBatchActor::ProcessTiles()
 				Tile->GenerateToken.Reset();
 
 				FScopeLock QueueLock(&WeakThis->ProcessGenerateQueueCriticalSection);
-				WeakThis->GenerateQueue.Enqueue({Result.Value, Tile, InitialShapeVitruvioComponents});
+				WeakThis->GenerateQueue.Enqueue({Result.Value, Tile, InitialShapeVitruvioComponents, ApplyBudget->CreateBacklogEntry()});
 			});
 			// clang-format on
 		}
@@ -432,117 +426,218 @@ void AVitruvioBatchActor::ProcessTiles()
 
 void AVitruvioBatchActor::ProcessGenerateQueue()
 {
-	ProcessGenerateQueueCriticalSection.Lock();
-	
-	if (!GenerateQueue.IsEmpty())
-	{
-		FBatchGenerateQueueItem Item;
-		GenerateQueue.Dequeue(Item);
-
-		ProcessGenerateQueueCriticalSection.Unlock();
+	FApplyBudget& ApplyBudget = VitruvioModule::Get().GetApplyBudget();
+	const double BudgetMs = ApplyBudgetMs > 0 ? ApplyBudgetMs : ApplyBudget.GetDefaultBudgetMs();
 
-		if (Item.GenerateResultDescription.EvaluatedAttributes.Num() ==  Item.VitruvioComponents.Num())
+	// Apply at least one step per frame, then continue as long as there is time left in the frame
+	bool bAppliedStep = false;
+	while (!bAppliedStep || ApplyBudget.HasTimeLeft(BudgetMs))
+	{
+		if (!ApplyState)
 		{
-			for (int ComponentIndex = 0; ComponentIndex < Item.VitruvioComponents.Num(); ++ComponentIndex)
 			{
-				UVitruvioComponent* VitruvioComponent = Item.VitruvioComponents[ComponentIndex];
-				Item.GenerateResultDescription.EvaluatedAttributes[ComponentIndex]->UpdateUnrealAttributeMap(VitruvioComponent->Attributes, VitruvioComponent);
-				VitruvioComponent->bAttributesReady = true;
-				VitruvioComponent->NotifyAttributesChanged();
+				FScopeLock QueueLock(&ProcessGenerateQueueCriticalSection);
+				if (!GenerateQueue.Dequeue(ApplyItem))
+				{
+					break;
+				}
 			}
+
+			if (ApplyItem.GenerateResultDescription.EvaluatedAttributes.Num() == ApplyItem.VitruvioComponents.Num())
+			{
+				for (int ComponentIndex = 0; ComponentIndex < ApplyItem.VitruvioComponents.Num(); ++ComponentIndex)
+				{
+					UVitruvioComponent* VitruvioComponent = ApplyItem.VitruvioComponents[ComponentIndex];
+					ApplyItem.GenerateResultDescription.EvaluatedAttributes[ComponentIndex]->UpdateUnrealAttributeMap(VitruvioComponent->Attributes,
+																													   VitruvioComponent);
+					VitruvioComponent->bAttributesReady = true;
+					VitruvioComponent->NotifyAttributesChanged();
+				}
+			}
+
+			ApplyState = MakeUnique<FGenerateApplyState>();
+			ApplyState->Builder = MakeUnique<FGenerateResultBuilder>(MoveTemp(ApplyItem.GenerateResultDescription), VitruvioModule::Get().GetMaterialCache(),
+																	 VitruvioModule::Get().GetTextureCache(), MaterialIdentifiers,
+																	 UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld(),
+																	 CVarAsyncMeshBuild.GetValueOnGameThread(), CVarAsyncTextureLoad.GetValueOnGameThread());
+			ApplyState->ModelComponent = ApplyItem.Tile->GeneratedModelComponent;
 		}
 
-		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = Item.Tile->GeneratedModelComponent;
+		// Meshes or textures are still being built on worker threads, continue in the next frame
+		if (!ApplyState->IsReady())
+		{
+			break;
+		}
 
-		const FConvertedGenerateResult ConvertedResult = BuildGenerateResult(Item.GenerateResultDescription,
-	VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(),
-				MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld());
+		bool bDone;
+		{
+			FApplyBudget::FStepScope StepScope(ApplyBudget, ApplyState->GetCurrentStep());
+			bDone = ApplyNextStep();
+		}
+		bAppliedStep = true;
 
-		if (ConvertedResult.ShapeMesh)
+		if (bDone)
 		{
-			VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
-			
-			// Reset Material replacements
-			for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+			FinishApply();
+		}
+	}
+
+	if (GenerateAllCallbackProxy)
+	{
+		TArray<UTile*> Tiles;
+		Grid.Tiles.GenerateValueArray(Tiles);
+		bool bAllGenerated = Algo::NoneOf(Tiles, [](const UTile* Tile) { return Tile->bIsGenerating; });
+		if (bAllGenerated)
+		{
+			GenerateAllCallbackProxy->OnGenerateCompleted.Broadcast();
+			GenerateAllCallbackProxy = nullptr;
+		}
+	}
+}
+
+bool AVitruvioBatchActor::ApplyNextStep()
+{
+	FGenerateApplyState& State = *ApplyState;
+
+	if (!State.Builder->IsDone())
+	{
+		State.Builder->Step();
+		return false;
+	}
+
+	const FConvertedGenerateResult& ConvertedResult = State.Builder->GetResult();
+
+	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = State.ModelComponent.Get();
+	if (!VitruvioModelComponent)
+	{
+		return true;
+	}
+
+	switch (State.Step)
+	{
+	case EApplyStep::Components:
+	{
+		if (State.NextIndex == 0)
+		{
+			if (ConvertedResult.ShapeMesh)
 			{
-				VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+				VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
+
+				// Reset Material replacements
+				for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+				{
+					VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+				}
+
+				ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
 			}
 
-			ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
-		}
+			// Keep the hierarchical instances of the previous generate result to only apply the changes
+			CollectInstanceComponents(VitruvioModelComponent, State);
 
-		// Cleanup old hierarchical instances
-		TArray<USceneComponent*> ChildInstanceComponents;
-		VitruvioModelComponent->GetChildrenComponents(true, ChildInstanceComponents);
-		for (USceneComponent* InstanceComponent : ChildInstanceComponents)
+			State.Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, State.NameMap);
+		}
+		else
 		{
-			InstanceComponent->DestroyComponent(true);
+			const int32 InstanceIndex = State.NextIndex - 1;
+			const FInstance& Instance = ConvertedResult.Instances[InstanceIndex];
+
+			if (!State.Replaced.Contains(Instance))
+			{
+				UGeneratedModelHISMComponent* InstancedComponent = AcquireInstanceComponent(VitruvioModelComponent, Instance, State);
+				State.InstanceComponents.Emplace(InstancedComponent, InstanceIndex);
+			}
 		}
 
-		TMap<FString, int32> NameMap;
-		TSet<FInstance> Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, NameMap);
-		for (const FInstance& Instance : ConvertedResult.Instances)
+		if (++State.NextIndex > ConvertedResult.Instances.Num())
 		{
-			if (Replaced.Contains(Instance))
+			ReleaseInstanceComponents(State);
+			State.Step = EApplyStep::Instances;
+			State.NextIndex = 0;
+		}
+		return false;
+	}
+	case EApplyStep::Instances:
+	{
+		if (State.NextIndex < State.InstanceComponents.Num())
+		{
+			const auto& [InstancedComponent, InstanceIndex] = State.InstanceComponents[State.NextIndex];
+
+			// Diff against the instances of the previous generate result first, the remaining transforms are added in batches
+			if (State.NextTransformIndex == 0)
 			{
-				continue;
+				State.AddedTransforms.Reset();
+				if (InstancedComponent.IsValid())
+				{
+					const FInstanceDiff InstanceDiff =
+						UpdateInstances(InstancedComponent.Get(), ConvertedResult.Instances[InstanceIndex].Transforms, State.AddedTransforms);
+					VitruvioModule::Get().GetApplyBudget().AddInstanceDiff(InstanceDiff);
+				}
 			}
 
-			FString UniqueName = UniqueComponentName(Instance.Name, NameMap);
-			auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, FName(UniqueName),
-																			  RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-			const TArray<FTransform>& Transforms = Instance.Transforms;
-			InstancedComponent->SetStaticMesh(Instance.InstanceMesh->GetStaticMesh());
-			InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
-			
-			// Add all instance transforms
-			for (const FTransform& Transform : Transforms)
+			const TArray<FTransform>& Transforms = State.AddedTransforms;
+			const int32 NumTransforms = FMath::Min(FGenerateApplyState::InstanceBatchSize, Transforms.Num() - State.NextTransformIndex);
+
+			if (InstancedComponent.IsValid() && NumTransforms > 0)
 			{
-				InstancedComponent->AddInstance(Transform);
+				InstancedComponent->AddInstances(TArray<FTransform>(Transforms.GetData() + State.NextTransformIndex, NumTransforms), false);
 			}
 
-			// Apply override materials
-			for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
+			State.NextTransformIndex += NumTransforms;
+			if (State.NextTransformIndex < Transforms.Num())
 			{
-				InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
+				return false;
 			}
 
-			// Attach and register instance component
-			InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
-			InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
-			RootComponent->GetOwner()->AddOwnedComponent(InstancedComponent);
-			InstancedComponent->OnComponentCreated();
-			InstancedComponent->RegisterComponent();
+			State.NextTransformIndex = 0;
+			++State.NextIndex;
 		}
 
-		for (auto& [VitruvioComponent, CallbackProxy] : Item.Tile->GenerateCallbackProxies)
+		if (State.NextIndex >= State.InstanceComponents.Num())
 		{
-			CallbackProxy->OnAttributesEvaluatedBlueprint.Broadcast();
-			CallbackProxy->OnAttributesEvaluated.Broadcast();
-			CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
-			CallbackProxy->OnGenerateCompleted.Broadcast();
-			CallbackProxy->SetReadyToDestroy();
+			State.Step = EApplyStep::Physics;
+			State.NextIndex = 0;
 		}
-
-		Item.Tile->GenerateCallbackProxies.Empty();
-		Item.Tile->bIsGenerating = false;
+		return false;
 	}
-	else
+	case EApplyStep::Physics:
 	{
-		ProcessGenerateQueueCriticalSection.Unlock();
+		if (State.NextIndex < State.InstanceComponents.Num())
+		{
+			UGeneratedModelHISMComponent* InstancedComponent = State.InstanceComponents[State.NextIndex].Key.Get();
+			// Reused components are registered already and have updated their physics state along with their instances
+			if (InstancedComponent && !InstancedComponent->IsRegistered())
+			{
+				InstancedComponent->OnComponentCreated();
+				InstancedComponent->RegisterComponent();
+			}
+		}
+
+		return ++State.NextIndex >= State.InstanceComponents.Num();
 	}
+	default:
+		return true;
+	}
+}
 
-	if (GenerateAllCallbackProxy)
+void AVitruvioBatchActor::FinishApply()
+{
+	UTile* Tile = ApplyItem.Tile;
+
+	ApplyState.Reset();
+	ApplyItem = {};
+
+	for (auto& [VitruvioComponent, CallbackProxy] : Tile->GenerateCallbackProxies)
 	{
-		TArray<UTile*> Tiles;
-		Grid.Tiles.GenerateValueArray(Tiles);
-		bool bAllGenerated = Algo::NoneOf(Tiles, [](const UTile* Tile) { return Tile->bIsGenerating; });
-		if (bAllGenerated)
-		{
-			GenerateAllCallbackProxy->OnGenerateCompleted.Broadcast();
-			GenerateAllCallbackProxy = nullptr;
-		}
+		CallbackProxy->OnAttributesEvaluatedBlueprint.Broadcast();
+		CallbackProxy->OnAttributesEvaluated.Broadcast();
+		CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
+		CallbackProxy->OnGenerateCompleted.Broadcast();
+		CallbackProxy->SetReadyToDestroy();
 	}
+
+	Tile->GenerateCallbackProxies.Empty();
+	Tile->bIsGenerating = false;
 }
 
 void AVitruvioBatchActor::ProcessAttributeEvaluationQueue()
@@ -17,11 +17,27 @@
 
 #include "EngineUtils.h"
 
+namespace
+{
+FBox2D GetInitialShapeBounds(const UVitruvioComponent* VitruvioComponent)
+{
+	const FTransform Transform = VitruvioComponent->GetOwner()->GetActorTransform();
+
+	FBox2D Bounds(ForceInit);
+	for (const FVector& Vertex : VitruvioComponent->InitialShape->GetVertices())
+	{
+		Bounds += FVector2D(Transform.TransformPosition(Vertex));
+	}
+	return Bounds;
+}
+} // namespace
+
 void UVitruvioBatchSubsystem::RegisterVitruvioComponent(UVitruvioComponent* VitruvioComponent, bool bGenerateModel)
 {
 	GetBatchActor()->RegisterVitruvioComponent(VitruvioComponent, bGenerateModel);
 	
 	RegisteredComponents.Add(VitruvioComponent);
+	UpdateNeighborIndex(VitruvioComponent);
 	OnComponentRegistered.Broadcast();
 }
 
@@ -84,6 +100,23 @@ bool UVitruvioBatchSubsystem::HasRegisteredVitruvioComponents() const
 	return RegisteredComponents.Num() > 0;
 }
 
+void UVitruvioBatchSubsystem::UpdateNeighborIndex(UVitruvioComponent* VitruvioComponent)
+{
+	if (VitruvioComponent->GetOwner() && VitruvioComponent->InitialShape && VitruvioComponent->InitialShape->IsValid())
+	{
+		NeighborIndex.Update(VitruvioComponent, GetInitialShapeBounds(VitruvioComponent));
+	}
+	else
+	{
+		NeighborIndex.Remove(VitruvioComponent);
+	}
+}
+
+void UVitruvioBatchSubsystem::RemoveFromNeighborIndex(UVitruvioComponent* VitruvioComponent)
+{
+	NeighborIndex.Remove(VitruvioComponent);
+}
+
 void UVitruvioBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	UWorldSubsystem::Initialize(Collection);
@@ -93,6 +126,8 @@ void UVitruvioBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	{
 		if (UVitruvioComponent* VitruvioComponent = Actor->FindComponentByClass<UVitruvioComponent>())
 		{
+			UpdateNeighborIndex(VitruvioComponent);
+
 			if (VitruvioComponent->IsBatchGenerated())
 			{
 				UnregisterVitruvioComponent(VitruvioComponent);
@@ -118,6 +153,8 @@ void UVitruvioBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	{
 		if (UVitruvioComponent* VitruvioComponent = Actor->FindComponentByClass<UVitruvioComponent>())
 		{
+			RemoveFromNeighborIndex(VitruvioComponent);
+
 			if (VitruvioComponent->IsBatchGenerated())
 			{
 				UnregisterVitruvioComponent(VitruvioComponent);
@@ -132,6 +169,8 @@ void UVitruvioBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 		if (UVitruvioComponent* VitruvioComponent = Actor->FindComponentByClass<UVitruvioComponent>())
 		{
+			UpdateNeighborIndex(VitruvioComponent);
+
 			if (VitruvioComponent->IsBatchGenerated())
 			{
 				RegisterVitruvioComponent(VitruvioComponent);
@@ -147,6 +186,8 @@ void UVitruvioBatchSubsystem::Deinitialize()
 	GEngine->OnActorsMoved().Remove(OnActorsMoved);
 	GEngine->OnLevelActorDeleted().Remove(OnActorDeleted);
 #endif
+
+	NeighborIndex.Empty();
 	
 	UWorldSubsystem::Deinitialize();
 }
@@ -16,6 +16,7 @@
 #include "VitruvioComponent.h"
 
 #include "Util/AttributeConversion.h"
+#include "Util/MaterialConversion.h"
 #include "EngineUtils.h"
 #include "GenerateCompletedCallbackProxy.h"
 #include "GeneratedModelHISMComponent.h"
@@ -28,6 +29,7 @@
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Components/SplineComponent.h"
 #include "Engine/CollisionProfile.h"
+#include "Hash/xxhash.h"
 #include "PRTUtils.h"
 #include "VitruvioBatchSubsystem.h"
 #include "UObject/ConstructorHelpers.h"
@@ -38,6 +40,16 @@
 DEFINE_LOG_CATEGORY(LogVitruvioComponent);
 
 TAutoConsoleVariable<float> CVarInterOcclusionNeighborQueryDistance(TEXT("Esri.Vitruvio.InterOcclusionNeighborQueryDistance"), 10000.0f, TEXT("The distance in cm to query for inter-occlusion neighbors."));
+TAutoConsoleVariable<bool> CVarAsyncMeshBuild(TEXT("Esri.Vitruvio.AsyncMeshBuild"), true, TEXT("Build the render data and collision of generated meshes on worker threads."));
+TAutoConsoleVariable<bool> CVarAsyncTextureLoad(TEXT("Esri.Vitruvio.AsyncTextureLoad"), true,
+												TEXT("Decode the textures of generated materials on worker threads before the materials are created instead of "
+													 "blocking the game thread until they are decoded."));
+TAutoConsoleVariable<int32> CVarInstanceComponentPoolSize(TEXT("Esri.Vitruvio.InstanceComponentPoolSize"), 16,
+														  TEXT("The maximum number of empty instance components kept per generated model to be reused "
+															   "by later generate results."));
+TAutoConsoleVariable<bool> CVarBatchGeneratePerInitialShape(TEXT("Esri.Vitruvio.BatchGeneratePerInitialShape"), true,
+															TEXT("Generate the tiles of batch actors per initial shape so that the models of unchanged initial "
+																 "shapes can be reused from the generate cache when a tile is regenerated."));
 
 namespace
 {
@@ -273,9 +285,13 @@ void ApplyMaterialReplacements(UStaticMeshComponent* StaticMeshComponent, const
 	for (int32 MaterialIndex = 0; MaterialIndex < StaticMeshComponent->GetNumMaterials(); ++MaterialIndex)
 	{
 		const UMaterialInterface* SourceMaterial = StaticMeshComponent->GetMaterial(MaterialIndex);
-		FString MaterialIdentifier = MaterialIdentifiers[SourceMaterial];
+		const FString* MaterialIdentifier = MaterialIdentifiers.Find(SourceMaterial);
+		if (!MaterialIdentifier)
+		{
+			continue;
+		}
 
-		if (UMaterialInterface** Result = ReplacementMaterials.Find(MaterialIdentifier))
+		if (UMaterialInterface** Result = ReplacementMaterials.Find(*MaterialIdentifier))
 		{
 			UMaterialInterface* ReplacementMaterial = *Result;
 			StaticMeshComponent->SetMaterial(MaterialIndex, ReplacementMaterial);
@@ -383,35 +399,332 @@ TSet<FInstance> ApplyInstanceReplacements(UGeneratedModelStaticMeshComponent* Ge
 	return Replaced;
 }
 
-FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
-									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-									 TMap<FString, Vitruvio::FTextureData>& TextureCache,
-									 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
-									 TMap<FString, int32>& UniqueMaterialIdentifiers,
-									 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-									 UWorld* World)
+void CollectInstanceComponents(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, FGenerateApplyState& State)
+{
+	TArray<USceneComponent*> ChildComponents;
+	GeneratedModelComponent->GetChildrenComponents(true, ChildComponents);
+	for (USceneComponent* ChildComponent : ChildComponents)
+	{
+		UGeneratedModelHISMComponent* InstancedComponent = Cast<UGeneratedModelHISMComponent>(ChildComponent);
+		if (InstancedComponent && InstancedComponent->IsPooled())
+		{
+			State.PooledComponents.Add(InstancedComponent);
+		}
+		else if (InstancedComponent && !InstancedComponent->GetInstanceKey().MeshId.IsEmpty() &&
+				 !State.ReusableComponents.Contains(InstancedComponent->GetInstanceKey()))
+		{
+			State.ReusableComponents.Add(InstancedComponent->GetInstanceKey(), InstancedComponent);
+		}
+		else
+		{
+			ChildComponent->DestroyComponent(true);
+			continue;
+		}
+
+		// New components must not take the names of components which are kept
+		State.NameMap.Add(ChildComponent->GetName(), 0);
+	}
+}
+
+UGeneratedModelHISMComponent* AcquireInstanceComponent(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, const FInstance& Instance,
+													   FGenerateApplyState& State)
+{
+	UGeneratedModelHISMComponent* InstancedComponent = nullptr;
+
+	TWeakObjectPtr<UGeneratedModelHISMComponent> ReusableComponent;
+	if (State.ReusableComponents.RemoveAndCopyValue(Instance.Key, ReusableComponent))
+	{
+		InstancedComponent = ReusableComponent.Get();
+	}
+
+	// Pooled components keep their name from the instance they have been created for
+	while (!InstancedComponent && !State.PooledComponents.IsEmpty())
+	{
+		InstancedComponent = State.PooledComponents.Pop().Get();
+		if (InstancedComponent)
+		{
+			InstancedComponent->SetPooled(false);
+		}
+	}
+
+	if (!InstancedComponent)
+	{
+		FString UniqueName = UniqueComponentName(Instance.Name, State.NameMap);
+		InstancedComponent = NewObject<UGeneratedModelHISMComponent>(GeneratedModelComponent, FName(UniqueName),
+																	 RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
+
+		// Attach instance component, it is registered in the physics step once all instances have been added
+		InstancedComponent->AttachToComponent(GeneratedModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
+		InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
+		GeneratedModelComponent->GetOwner()->AddOwnedComponent(InstancedComponent);
+	}
+
+	InstancedComponent->SetStaticMesh(Instance.InstanceMesh->GetStaticMesh());
+	InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
+	InstancedComponent->SetInstanceKey(Instance.Key);
+
+	// Apply override materials, reused components may still hold material replacements which are applied again afterwards
+	const int32 NumMaterials = FMath::Max(Instance.OverrideMaterials.Num(), InstancedComponent->OverrideMaterials.Num());
+	for (int32 MaterialIndex = 0; MaterialIndex < NumMaterials; ++MaterialIndex)
+	{
+		InstancedComponent->SetMaterial(MaterialIndex,
+										Instance.OverrideMaterials.IsValidIndex(MaterialIndex) ? Instance.OverrideMaterials[MaterialIndex] : nullptr);
+	}
+
+	return InstancedComponent;
+}
+
+void ReleaseInstanceComponents(FGenerateApplyState& State)
+{
+	const int32 PoolSize = FMath::Max(0, CVarInstanceComponentPoolSize.GetValueOnGameThread());
+
+	for (const auto& [Key, ReusableComponent] : State.ReusableComponents)
+	{
+		UGeneratedModelHISMComponent* InstancedComponent = ReusableComponent.Get();
+		if (!InstancedComponent)
+		{
+			continue;
+		}
+
+		if (State.PooledComponents.Num() < PoolSize)
+		{
+			// Release the mesh and materials so that they can be garbage collected while the component is pooled
+			InstancedComponent->ClearInstances();
+			InstancedComponent->EmptyOverrideMaterials();
+			InstancedComponent->SetStaticMesh(nullptr);
+			InstancedComponent->SetMeshIdentifier({});
+			InstancedComponent->SetInstanceKey({});
+			InstancedComponent->SetPooled(true);
+			State.PooledComponents.Add(InstancedComponent);
+		}
+		else
+		{
+			InstancedComponent->DestroyComponent(true);
+		}
+	}
+	State.ReusableComponents.Empty();
+
+	while (State.PooledComponents.Num() > PoolSize)
+	{
+		if (UGeneratedModelHISMComponent* InstancedComponent = State.PooledComponents.Pop().Get())
+		{
+			InstancedComponent->DestroyComponent(true);
+		}
+	}
+}
+
+FInstanceDiff UpdateInstances(UInstancedStaticMeshComponent* Component, const TArray<FTransform>& Transforms, TArray<FTransform>& OutAddedTransforms)
+{
+	FInstanceDiff Diff;
+	OutAddedTransforms.Reset();
+
+	const TArray<FInstancedStaticMeshInstanceData>& ExistingInstances = Component->PerInstanceSMData;
+	if (ExistingInstances.IsEmpty())
+	{
+		OutAddedTransforms = Transforms;
+		Diff.Added = Transforms.Num();
+		return Diff;
+	}
+
+	// Instances store the matrix of the transform they have been added with, so unchanged instances compare exactly
+	auto HashMatrix = [](const FMatrix& Matrix) { return FXxHash64::HashBuffer(&Matrix, sizeof(FMatrix)).Hash; };
+
+	TMultiMap<uint64, int32> UnmatchedInstances;
+	UnmatchedInstances.Reserve(ExistingInstances.Num());
+	for (int32 InstanceIndex = 0; InstanceIndex < ExistingInstances.Num(); ++InstanceIndex)
+	{
+		UnmatchedInstances.Add(HashMatrix(ExistingInstances[InstanceIndex].Transform), InstanceIndex);
+	}
+
+	TArray<int32> ChangedTransforms;
+	for (int32 TransformIndex = 0; TransformIndex < Transforms.Num(); ++TransformIndex)
+	{
+		const FMatrix Matrix = Transforms[TransformIndex].ToMatrixWithScale();
+		bool bMatched = false;
+		for (auto It = UnmatchedInstances.CreateKeyIterator(HashMatrix(Matrix)); It; ++It)
+		{
+			if (ExistingInstances[It.Value()].Transform.Equals(Matrix, 0.0))
+			{
+				It.RemoveCurrent();
+				bMatched = true;
+				break;
+			}
+		}
+
+		if (!bMatched)
+		{
+			ChangedTransforms.Add(TransformIndex);
+		}
+	}
+	Diff.Kept = Transforms.Num() - ChangedTransforms.Num();
+
+	// Sorted so that consecutive instances are updated by a single call and the surplus is removed from the back
+	TArray<int32> FreeInstances;
+	UnmatchedInstances.GenerateValueArray(FreeInstances);
+	FreeInstances.Sort();
+
+	const int32 NumUpdated = FMath::Min(FreeInstances.Num(), ChangedTransforms.Num());
+	TArray<FTransform> UpdatedTransforms;
+	int32 RunStart = 0;
+	for (int32 Index = 0; Index < NumUpdated; ++Index)
+	{
+		UpdatedTransforms.Add(Transforms[ChangedTransforms[Index]]);
+		if (Index + 1 == NumUpdated || FreeInstances[Index + 1] != FreeInstances[Index] + 1)
+		{
+			Component->BatchUpdateInstancesTransforms(FreeInstances[RunStart], UpdatedTransforms, false, true);
+			UpdatedTransforms.Reset();
+			RunStart = Index + 1;
+		}
+	}
+	Diff.Updated = NumUpdated;
+
+	if (FreeInstances.Num() > NumUpdated)
+	{
+		TArray<int32> RemovedInstances;
+		RemovedInstances.Reserve(FreeInstances.Num() - NumUpdated);
+		for (int32 Index = FreeInstances.Num() - 1; Index >= NumUpdated; --Index)
+		{
+			RemovedInstances.Add(FreeInstances[Index]);
+		}
+		Component->RemoveInstances(RemovedInstances, true);
+		Diff.Removed = RemovedInstances.Num();
+	}
+
+	for (int32 Index = NumUpdated; Index < ChangedTransforms.Num(); ++Index)
+	{
+		OutAddedTransforms.Add(Transforms[ChangedTransforms[Index]]);
+	}
+	Diff.Added = OutAddedTransforms.Num();
+
+	return Diff;
+}
+
+FGenerateResultBuilder::FGenerateResultBuilder(FGenerateResultDescription InGenerateResult,
+											   TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+											   FTextureCache& TextureCache,
+											   TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+											   TMap<FString, int32>& UniqueMaterialIdentifiers, UMaterial* OpaqueParent,
+											   UMaterial* MaskedParent, UMaterial* TranslucentParent, UWorld* World, bool bBuildMeshesAsync,
+											   bool bLoadTexturesAsync)
+	: GenerateResult(MoveTemp(InGenerateResult)), MaterialCache(MaterialCache), TextureCache(TextureCache),
+	  MaterialIdentifiers(MaterialIdentifiers), UniqueMaterialIdentifiers(UniqueMaterialIdentifiers), OpaqueParent(OpaqueParent),
+	  MaskedParent(MaskedParent), TranslucentParent(TranslucentParent), World(World), bBuildMeshesAsync(bBuildMeshesAsync)
 {
 	MaterialIdentifiers.Empty();
 	UniqueMaterialIdentifiers.Empty();
 
-	// Build all meshes
 	if (GenerateResult.GeneratedModel)
 	{
-		GenerateResult.GeneratedModel->Build(TEXT("GeneratedModel"), MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers,
-			OpaqueParent, MaskedParent, TranslucentParent, World);
+		Meshes.Emplace(TEXT("GeneratedModel"), GenerateResult.GeneratedModel);
 	}
 
 	for (const auto& IdAndMesh : GenerateResult.InstanceMeshes)
 	{
-		FString Name = GenerateResult.InstanceNames[IdAndMesh.Key];
-		IdAndMesh.Value->Build(Name, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers,
-			OpaqueParent, MaskedParent, TranslucentParent, World);
+		Meshes.Emplace(GenerateResult.InstanceNames[IdAndMesh.Key], IdAndMesh.Value);
+	}
+
+	Instances = GenerateResult.Instances.Array();
+
+	Result.ShapeMesh = GenerateResult.GeneratedModel;
+	Result.Reports = GenerateResult.Reports;
+
+	if (bLoadTexturesAsync)
+	{
+		auto LoadTexturesAsync = [this](const Vitruvio::FMaterialAttributeContainer& MaterialContainer) {
+			if (!MaterialCache.Contains(MaterialContainer))
+			{
+				Vitruvio::LoadTexturesAsync(MaterialContainer, TextureCache, PrefetchedTextures, PendingTextureLoads);
+			}
+		};
+
+		for (const auto& [Name, Mesh] : Meshes)
+		{
+			for (const Vitruvio::FMaterialAttributeContainer& MaterialContainer : Mesh->GetMaterials())
+			{
+				LoadTexturesAsync(MaterialContainer);
+			}
+		}
+
+		for (const auto& [Key, Transforms] : Instances)
+		{
+			for (const Vitruvio::FMaterialAttributeContainer& MaterialContainer : Key.MaterialOverrides)
+			{
+				LoadTexturesAsync(MaterialContainer);
+			}
+		}
+	}
+}
+
+bool FGenerateResultBuilder::IsReady() const
+{
+	for (const FGraphEventRef& TextureLoad : PendingTextureLoads)
+	{
+		if (!TextureLoad->IsComplete())
+		{
+			return false;
+		}
+	}
+
+	if (NextMesh < Meshes.Num() || NextFinishedMesh >= Meshes.Num())
+	{
+		return true;
+	}
+
+	for (int32 MeshIndex = NextFinishedMesh; MeshIndex < Meshes.Num(); ++MeshIndex)
+	{
+		const TSharedPtr<FVitruvioMesh>& Mesh = Meshes[MeshIndex].Value;
+		if (Mesh->IsRenderDataReady() || (MeshIndex == NextFinishedMesh && !Mesh->IsBuildPending()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FGenerateResultBuilder::Step()
+{
+	// Build all meshes
+	if (NextMesh < Meshes.Num())
+	{
+		const auto& [Name, Mesh] = Meshes[NextMesh++];
+		if (bBuildMeshesAsync)
+		{
+			Mesh->BuildAsync(Name, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent,
+							 TranslucentParent, World, &PrefetchedTextures);
+		}
+		else
+		{
+			Mesh->Build(Name, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent,
+						TranslucentParent, World, &PrefetchedTextures);
+			NextFinishedMesh = NextMesh;
+		}
+		return;
+	}
+
+	// Wait for asynchronously built meshes. Applying the render data of a single mesh is one unit of work.
+	if (NextFinishedMesh < Meshes.Num())
+	{
+		for (int32 MeshIndex = NextFinishedMesh; MeshIndex < Meshes.Num(); ++MeshIndex)
+		{
+			const TSharedPtr<FVitruvioMesh>& Mesh = Meshes[MeshIndex].Value;
+			if (Mesh->IsRenderDataReady())
+			{
+				Mesh->TryFinishBuild();
+				break;
+			}
+		}
+
+		while (NextFinishedMesh < Meshes.Num() && !Meshes[NextFinishedMesh].Value->IsBuildPending())
+		{
+			Meshes[NextFinishedMesh++].Value->TryFinishBuild();
+		}
+		return;
 	}
 
 	// Convert instances
-	TArray<FInstance> Instances;
-	for (const auto& [Key, Transform] : GenerateResult.Instances)
+	if (NextInstance < Instances.Num())
 	{
+		const auto& [Key, Transforms] = Instances[NextInstance++];
 		const TSharedPtr<FVitruvioMesh>& VitruvioMesh = GenerateResult.InstanceMeshes[Key.MeshId];
 		const FString MeshName = GenerateResult.InstanceNames[Key.MeshId];
 		TArray<UMaterialInstanceDynamic*> OverrideMaterials;
@@ -420,13 +733,28 @@ FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& G
 		{
 			const Vitruvio::FMaterialAttributeContainer& MaterialContainer = Key.MaterialOverrides[MaterialIndex];
 			OverrideMaterials.Add(CacheMaterial(OpaqueParent, MaskedParent, TranslucentParent, TextureCache, MaterialCache, MaterialContainer,
-												UniqueMaterialIdentifiers, MaterialIdentifiers, VitruvioMesh->GetStaticMesh()));
+												UniqueMaterialIdentifiers, MaterialIdentifiers, VitruvioMesh->GetStaticMesh(), &PrefetchedTextures));
 		}
 
-		Instances.Add({MeshName, VitruvioMesh, OverrideMaterials, Transform});
+		Result.Instances.Add({MeshName, VitruvioMesh, OverrideMaterials, Transforms, Key});
 	}
+}
 
-	return {GenerateResult.GeneratedModel, Instances, GenerateResult.Reports};
+FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
+									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+									 FTextureCache& TextureCache,
+									 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+									 TMap<FString, int32>& UniqueMaterialIdentifiers,
+									 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+									 UWorld* World)
+{
+	FGenerateResultBuilder Builder(GenerateResult, MaterialCache, TextureCache, MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent,
+								   MaskedParent, TranslucentParent, World);
+	while (!Builder.IsDone())
+	{
+		Builder.Step();
+	}
+	return Builder.GetResult();
 }
 
 FString UniqueComponentName(const FString& Name, TMap<FString, int32>& UsedNames)
@@ -477,29 +805,25 @@ TArray<FInitialShape> UVitruvioComponent::GetNeighboringShapes() const
 {
 	TArray<FInitialShape> NeighboringShapes;
 
-	const FVector OwnerLocation = GetOwner()->GetActorLocation();
-
-	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	const UVitruvioBatchSubsystem* VitruvioSubsystem = GetWorld()->GetSubsystem<UVitruvioBatchSubsystem>();
+	if (!VitruvioSubsystem)
 	{
-		AActor* Actor = *It;
+		return NeighboringShapes;
+	}
 
-		if (Actor == GetOwner())
-		{
-			continue;
-		}
+	const FVector OwnerLocation = GetOwner()->GetActorLocation();
+	const double QueryDistance = CVarInterOcclusionNeighborQueryDistance.GetValueOnGameThread();
 
-		UVitruvioComponent* VitruvioComponent = Actor->FindComponentByClass<UVitruvioComponent>();
-		if (!VitruvioComponent || !VitruvioComponent->bEnableOcclusionQueries  || !VitruvioComponent->InitialShape || !VitruvioComponent->InitialShape->IsValid())
+	VitruvioSubsystem->ForEachNeighbor(OwnerLocation, QueryDistance, [this, &NeighboringShapes](UVitruvioComponent* VitruvioComponent)
+	{
+		if (VitruvioComponent == this || !VitruvioComponent->bEnableOcclusionQueries || !VitruvioComponent->InitialShape ||
+			!VitruvioComponent->InitialShape->IsValid())
 		{
-			continue;
+			return;
 		}
 
-		const float Distance = FVector::Dist(OwnerLocation, Actor->GetActorLocation());
-		if (Distance < CVarInterOcclusionNeighborQueryDistance.GetValueOnGameThread())
-		{
-			NeighboringShapes.Add(VitruvioComponent->GetInitialShape());
-		}
-	}
+		NeighboringShapes.Add(VitruvioComponent->GetInitialShape());
+	});
 
 	return NeighboringShapes;
 }
@@ -882,10 +1206,18 @@ void UVitruvioComponent::Initialize()
 
 	CalculateRandomSeed();
 
+	UVitruvioBatchSubsystem* VitruvioSubsystem = GetWorld()->GetSubsystem<UVitruvioBatchSubsystem>();
+	VitruvioSubsystem->UpdateNeighborIndex(this);
+
+	if (USceneComponent* RootComponent = GetOwner()->GetRootComponent(); RootComponent && !OnTransformUpdated.IsValid())
+	{
+		TransformUpdatedSource = RootComponent;
+		OnTransformUpdated = RootComponent->TransformUpdated.AddUObject(this, &UVitruvioComponent::OnOwnerTransformUpdated);
+	}
+
 	if (bBatchGenerate)
 	{
-		UVitruvioBatchSubsystem* BatchGenerateSubsystem = GetWorld()->GetSubsystem<UVitruvioBatchSubsystem>();
-		BatchGenerateSubsystem->RegisterVitruvioComponent(this);
+		VitruvioSubsystem->RegisterVitruvioComponent(this);
 	}
 	else
 	{
@@ -895,7 +1227,7 @@ void UVitruvioComponent::Initialize()
 
 void UVitruvioComponent::ProcessGenerateQueue()
 {
-	if (GenerateQueue.IsEmpty())
+	if (GenerateQueue.IsEmpty() && !ApplyState)
 	{
 		return;
 	}
@@ -904,126 +1236,230 @@ void UVitruvioComponent::ProcessGenerateQueue()
 	{
 		RemoveGeneratedMeshes();
 		GenerateQueue.Empty();
+		ApplyState.Reset();
+		ApplyItem = {};
 		return;
 	}
-		
-	// Get from queue and build meshes
-	FGenerateQueueItem Result;
-	GenerateQueue.Dequeue(Result);
-
-	FConvertedGenerateResult ConvertedResult = BuildGenerateResult(Result.GenerateResultDescription,
-VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(),
-			MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld());
 
-	Reports = ConvertedResult.Reports;
+	FApplyBudget& ApplyBudget = VitruvioModule::Get().GetApplyBudget();
 
-	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
-
-	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = nullptr;
-
-	TArray<USceneComponent*> InitialShapeChildComponents;
-	InitialShapeSceneComponent->GetChildrenComponents(false, InitialShapeChildComponents);
-	for (USceneComponent* Component : InitialShapeChildComponents)
+	// Apply at least one step per frame, then continue as long as there is time left in the frame
+	bool bAppliedStep = false;
+	while (!bAppliedStep || ApplyBudget.HasTimeLeft(ApplyBudget.GetDefaultBudgetMs()))
 	{
-		if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
+		if (!ApplyState)
 		{
-			VitruvioModelComponent = Cast<UGeneratedModelStaticMeshComponent>(Component);
-
-			VitruvioModelComponent->SetStaticMesh(nullptr);
-
-			// Cleanup old hierarchical instances
-			TArray<USceneComponent*> InstanceComponents;
-			VitruvioModelComponent->GetChildrenComponents(true, InstanceComponents);
-			for (USceneComponent* InstanceComponent : InstanceComponents)
+			if (!GenerateQueue.Dequeue(ApplyItem))
 			{
-				InstanceComponent->DestroyComponent(true);
+				break;
 			}
 
-			break;
+			ApplyState = MakeUnique<FGenerateApplyState>();
+			ApplyState->Builder = MakeUnique<FGenerateResultBuilder>(MoveTemp(ApplyItem.GenerateResultDescription), VitruvioModule::Get().GetMaterialCache(),
+																	 VitruvioModule::Get().GetTextureCache(), MaterialIdentifiers,
+																	 UniqueMaterialIdentifiers, OpaqueParent, MaskedParent, TranslucentParent, GetWorld(),
+																	 CVarAsyncMeshBuild.GetValueOnGameThread(), CVarAsyncTextureLoad.GetValueOnGameThread());
 		}
-	}
 
-	if (!VitruvioModelComponent)
-	{
-		VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShapeSceneComponent, FName(TEXT("GeneratedModel")),
-																			   RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-		VitruvioModelComponent->CreationMethod = EComponentCreationMethod::Instance;
-		InitialShapeSceneComponent->GetOwner()->AddOwnedComponent(VitruvioModelComponent);
-		VitruvioModelComponent->AttachToComponent(InitialShapeSceneComponent, FAttachmentTransformRules::KeepRelativeTransform);
-		VitruvioModelComponent->OnComponentCreated();
-		VitruvioModelComponent->RegisterComponent();
-	}
+		// Meshes or textures are still being built on worker threads, continue in the next frame
+		if (!ApplyState->IsReady())
+		{
+			break;
+		}
 
-	if (ConvertedResult.ShapeMesh)
-	{
-		VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
-		VitruvioModelComponent->RecreatePhysicsState();
-		
-		// Reset Material replacements
-		for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+		bool bDone;
 		{
-			VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+			FApplyBudget::FStepScope StepScope(ApplyBudget, ApplyState->GetCurrentStep());
+			bDone = ApplyNextStep();
 		}
+		bAppliedStep = true;
 
-		if (!Result.GenerateOptions.bIgnoreMaterialReplacements)
+		if (bDone)
 		{
-			ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
+			FinishApply();
 		}
 	}
-	else
-	{
-		VitruvioModelComponent->SetStaticMesh(nullptr);
-	}
+}
 
-	TMap<FString, int32> NameMap;
-	TSet<FInstance> Replaced;
+bool UVitruvioComponent::ApplyNextStep()
+{
+	FGenerateApplyState& State = *ApplyState;
 
-	if (!Result.GenerateOptions.bIgnoreInstanceReplacements)
+	if (!State.Builder->IsDone())
 	{
-		Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, NameMap);
+		State.Builder->Step();
+		return false;
 	}
 
-	for (const FInstance& Instance : ConvertedResult.Instances)
+	const FConvertedGenerateResult& ConvertedResult = State.Builder->GetResult();
+	const FGenerateOptions& GenerateOptions = ApplyItem.GenerateOptions;
+
+	switch (State.Step)
+	{
+	case EApplyStep::Components:
 	{
-		if (Replaced.Contains(Instance))
+		if (State.NextIndex == 0)
 		{
-			continue;
-		}
+			QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
 
-		FString UniqueName = UniqueComponentName(Instance.Name, NameMap);
-		auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, FName(UniqueName),
-																		  RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
-		
-		UStaticMesh* StaticMesh = Instance.InstanceMesh->GetStaticMesh();
-		InstancedComponent->SetStaticMesh(StaticMesh);
-		InstancedComponent->SetMeshIdentifier(Instance.InstanceMesh->GetIdentifier());
-		InstancedComponent->RecreatePhysicsState();
+			UGeneratedModelStaticMeshComponent* VitruvioModelComponent = nullptr;
 
-		// Add all instance transforms
-		const TArray<FTransform>& Transforms = Instance.Transforms;
-		for (const FTransform& Transform : Transforms)
+			TArray<USceneComponent*> InitialShapeChildComponents;
+			InitialShapeSceneComponent->GetChildrenComponents(false, InitialShapeChildComponents);
+			for (USceneComponent* Component : InitialShapeChildComponents)
+			{
+				if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
+				{
+					VitruvioModelComponent = Cast<UGeneratedModelStaticMeshComponent>(Component);
+
+					VitruvioModelComponent->SetStaticMesh(nullptr);
+
+					// Keep the hierarchical instances of the previous generate result to only apply the changes
+					CollectInstanceComponents(VitruvioModelComponent, State);
+
+					break;
+				}
+			}
+
+			if (!VitruvioModelComponent)
+			{
+				VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShapeSceneComponent, FName(TEXT("GeneratedModel")),
+																					   RF_Transient | RF_TextExportTransient | RF_DuplicateTransient);
+				VitruvioModelComponent->CreationMethod = EComponentCreationMethod::Instance;
+				InitialShapeSceneComponent->GetOwner()->AddOwnedComponent(VitruvioModelComponent);
+				VitruvioModelComponent->AttachToComponent(InitialShapeSceneComponent, FAttachmentTransformRules::KeepRelativeTransform);
+				VitruvioModelComponent->OnComponentCreated();
+				VitruvioModelComponent->RegisterComponent();
+			}
+
+			if (ConvertedResult.ShapeMesh)
+			{
+				VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh->GetStaticMesh());
+
+				// Reset Material replacements
+				for (int32 MaterialIndex = 0; MaterialIndex < VitruvioModelComponent->GetNumMaterials(); ++MaterialIndex)
+				{
+					VitruvioModelComponent->SetMaterial(MaterialIndex, VitruvioModelComponent->GetStaticMesh()->GetMaterial(MaterialIndex));
+				}
+
+				if (!GenerateOptions.bIgnoreMaterialReplacements)
+				{
+					ApplyMaterialReplacements(VitruvioModelComponent, MaterialIdentifiers, MaterialReplacement);
+				}
+			}
+			else
+			{
+				VitruvioModelComponent->SetStaticMesh(nullptr);
+			}
+
+			if (!GenerateOptions.bIgnoreInstanceReplacements)
+			{
+				State.Replaced = ApplyInstanceReplacements(VitruvioModelComponent, ConvertedResult.Instances, InstanceReplacement, State.NameMap);
+			}
+
+			State.ModelComponent = VitruvioModelComponent;
+		}
+		else if (UGeneratedModelStaticMeshComponent* VitruvioModelComponent = State.ModelComponent.Get())
 		{
-			InstancedComponent->AddInstance(Transform);
+			const int32 InstanceIndex = State.NextIndex - 1;
+			const FInstance& Instance = ConvertedResult.Instances[InstanceIndex];
+
+			if (!State.Replaced.Contains(Instance))
+			{
+				UGeneratedModelHISMComponent* InstancedComponent = AcquireInstanceComponent(VitruvioModelComponent, Instance, State);
+
+				if (!GenerateOptions.bIgnoreMaterialReplacements)
+				{
+					ApplyMaterialReplacements(InstancedComponent, MaterialIdentifiers, MaterialReplacement);
+				}
+
+				State.InstanceComponents.Emplace(InstancedComponent, InstanceIndex);
+			}
 		}
 
-		// Apply override materials
-		for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
+		if (++State.NextIndex > ConvertedResult.Instances.Num())
 		{
-			InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
+			ReleaseInstanceComponents(State);
+			State.Step = EApplyStep::Instances;
+			State.NextIndex = 0;
 		}
+		return false;
+	}
+	case EApplyStep::Instances:
+	{
+		if (State.NextIndex < State.InstanceComponents.Num())
+		{
+			const auto& [InstancedComponent, InstanceIndex] = State.InstanceComponents[State.NextIndex];
 
-		// Attach and register instance component
-		InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
-		InstancedComponent->CreationMethod = EComponentCreationMethod::Instance;
-		InitialShapeSceneComponent->GetOwner()->AddOwnedComponent(InstancedComponent);
-		InstancedComponent->OnComponentCreated();
-		InstancedComponent->RegisterComponent();
+			// Diff against the instances of the previous generate result first, the remaining transforms are added in batches
+			if (State.NextTransformIndex == 0)
+			{
+				State.AddedTransforms.Reset();
+				if (InstancedComponent.IsValid())
+				{
+					const FInstanceDiff InstanceDiff =
+						UpdateInstances(InstancedComponent.Get(), ConvertedResult.Instances[InstanceIndex].Transforms, State.AddedTransforms);
+					VitruvioModule::Get().GetApplyBudget().AddInstanceDiff(InstanceDiff);
+				}
+			}
+
+			const TArray<FTransform>& Transforms = State.AddedTransforms;
+			const int32 NumTransforms = FMath::Min(FGenerateApplyState::InstanceBatchSize, Transforms.Num() - State.NextTransformIndex);
+
+			if (InstancedComponent.IsValid() && NumTransforms > 0)
+			{
+				InstancedComponent->AddInstances(TArray<FTransform>(Transforms.GetData() + State.NextTransformIndex, NumTransforms), false);
+			}
 
-		if (!Result.GenerateOptions.bIgnoreMaterialReplacements)
+			State.NextTransformIndex += NumTransforms;
+			if (State.NextTransformIndex < Transforms.Num())
+			{
+				return false;
+			}
+
+			State.NextTransformIndex = 0;
+			++State.NextIndex;
+		}
+
+		if (State.NextIndex >= State.InstanceComponents.Num())
 		{
-			ApplyMaterialReplacements(InstancedComponent, MaterialIdentifiers, MaterialReplacement);
+			State.Step = EApplyStep::Physics;
+			State.NextIndex = 0;
 		}
+		return false;
 	}
+	case EApplyStep::Physics:
+	{
+		if (State.NextIndex == 0)
+		{
+			if (ConvertedResult.ShapeMesh && State.ModelComponent.IsValid())
+			{
+				State.ModelComponent->RecreatePhysicsState();
+			}
+		}
+		else if (UGeneratedModelHISMComponent* InstancedComponent = State.InstanceComponents[State.NextIndex - 1].Key.Get();
+				 InstancedComponent && !InstancedComponent->IsRegistered())
+		{
+			// Reused components are registered already and have updated their physics state along with their instances
+			InstancedComponent->OnComponentCreated();
+			InstancedComponent->RegisterComponent();
+		}
+
+		return ++State.NextIndex > State.InstanceComponents.Num();
+	}
+	default:
+		return true;
+	}
+}
+
+void UVitruvioComponent::FinishApply()
+{
+	Reports = ApplyState->Builder->GetResult().Reports;
+
+	UGenerateCompletedCallbackProxy* CallbackProxy = ApplyItem.CallbackProxy;
+
+	ApplyState.Reset();
+	ApplyItem = {};
 
 	OnHierarchyChanged.Broadcast(this);
 
@@ -1031,11 +1467,11 @@ VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache(
 
 	SetInitialShapeVisible(!HideAfterGeneration);
 
-	if (Result.CallbackProxy)
+	if (CallbackProxy)
 	{
-		Result.CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
-		Result.CallbackProxy->OnGenerateCompleted.Broadcast();
-		Result.CallbackProxy->SetReadyToDestroy();
+		CallbackProxy->OnGenerateCompletedBlueprint.Broadcast();
+		CallbackProxy->OnGenerateCompleted.Broadcast();
+		CallbackProxy->SetReadyToDestroy();
 	}
 	OnGenerateCompleted.Broadcast();
 }
@@ -1160,9 +1596,10 @@ TArray<UGeneratedModelHISMComponent*> UVitruvioComponent::GetGeneratedModelHISMC
 	InitialShapeSceneComponent->GetChildrenComponents(true, InitialShapeChildComponents);
 	for (USceneComponent* Component : InitialShapeChildComponents)
 	{
-		if (Component->IsA(UGeneratedModelHISMComponent::StaticClass()))
+		UGeneratedModelHISMComponent* InstancedComponent = Cast<UGeneratedModelHISMComponent>(Component);
+		if (InstancedComponent && !InstancedComponent->IsPooled())
 		{
-			VitruvioModelHISMComponents.Add(Cast<UGeneratedModelHISMComponent>(Component));
+			VitruvioModelHISMComponents.Add(InstancedComponent);
 		}
 	}
 
@@ -1193,6 +1630,21 @@ void UVitruvioComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 
 	VitruvioModule::Get().InvalidateOcclusionHandle(InitialShapeIndex);
 
+	if (UWorld* World = GetWorld())
+	{
+		if (UVitruvioBatchSubsystem* VitruvioSubsystem = World->GetSubsystem<UVitruvioBatchSubsystem>())
+		{
+			VitruvioSubsystem->RemoveFromNeighborIndex(this);
+		}
+	}
+
+	if (USceneComponent* RootComponent = TransformUpdatedSource.Get())
+	{
+		RootComponent->TransformUpdated.Remove(OnTransformUpdated);
+	}
+	TransformUpdatedSource.Reset();
+	OnTransformUpdated.Reset();
+
 #if WITH_EDITOR
 	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangeDelegate);
 	PropertyChangeDelegate.Reset();
@@ -1205,11 +1657,24 @@ void UVitruvioComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 #endif
 }
 
+void UVitruvioComponent::OnOwnerTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags,
+												 ETeleportType Teleport)
+{
+	if (UWorld* World = GetWorld())
+	{
+		if (UVitruvioBatchSubsystem* VitruvioSubsystem = World->GetSubsystem<UVitruvioBatchSubsystem>())
+		{
+			VitruvioSubsystem->UpdateNeighborIndex(this);
+		}
+	}
+}
+
 void UVitruvioComponent::Generate(UGenerateCompletedCallbackProxy* CallbackProxy, const FGenerateOptions& GenerateOptions)
 {
 	Initialize();
 	
 	VitruvioModule::Get().InvalidateOcclusionHandle(InitialShapeIndex);
+	GetWorld()->GetSubsystem<UVitruvioBatchSubsystem>()->UpdateNeighborIndex(this);
 
 	// Since we can not abort an ongoing generate call from PRT, we invalidate the result and regenerate after the current generate call has
 	// completed.
@@ -1248,8 +1713,10 @@ void UVitruvioComponent::Generate(UGenerateCompletedCallbackProxy* CallbackProxy
 
 		GenerateToken = GenerateResult.Token;
 
+		FApplyBudget* ApplyBudget = &VitruvioModule::Get().GetApplyBudget();
+
 		// clang-format off
-		GenerateResult.Result.Next([this, CallbackProxy, GenerateOptions](const FGenerateResult::ResultType& Result)
+		GenerateResult.Result.Next([this, CallbackProxy, GenerateOptions, ApplyBudget](const FGenerateResult::ResultType& Result)
 		{
 			FScopeLock Lock(&Result.Token->Lock);
 
@@ -1259,7 +1726,7 @@ void UVitruvioComponent::Generate(UGenerateCompletedCallbackProxy* CallbackProxy
 			}
 
 			GenerateToken.Reset();
-			GenerateQueue.Enqueue({Result.Value, GenerateOptions, CallbackProxy});
+			GenerateQueue.Enqueue({Result.Value, GenerateOptions, CallbackProxy, ApplyBudget->CreateBacklogEntry()});
 		});
 		// clang-format on
 	}
@@ -14,9 +14,11 @@
  */
 
 #include "VitruvioMesh.h"
+#include "Async/Async.h"
 #include "MaterialConversion.h"
 #include "Materials/Material.h"
 #include "StaticMeshAttributes.h"
+#include "StaticMeshResources.h"
 #include "VitruvioModule.h"
 #include "PhysicsEngine/BodySetup.h"
 #include "Engine/CollisionProfile.h"
@@ -25,6 +27,12 @@
 
 namespace
 {
+// Rough per element sizes of a FMeshDescription (ids, positions, normals, tangents, colors and uvs)
+constexpr int64 ESTIMATED_BYTES_PER_VERTEX = 32;
+constexpr int64 ESTIMATED_BYTES_PER_VERTEX_INSTANCE = 96;
+constexpr int64 ESTIMATED_BYTES_PER_TRIANGLE = 48;
+constexpr int64 ESTIMATED_BYTES_PER_POLYGON = 32;
+
 FString MakeUniqueMaterialName(FString Name, TMap<FString, int32>& UniqueMaterialNames)
 {
 	if (UniqueMaterialNames.Contains(Name))
@@ -40,13 +48,179 @@ FString MakeUniqueMaterialName(FString Name, TMap<FString, int32>& UniqueMateria
 	return Name;
 }
 
+void ConfigureBodySetup(UBodySetup* BodySetup)
+{
+	BodySetup->DefaultInstance.SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	BodySetup->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
+	BodySetup->bDoubleSidedGeometry = true;
+	BodySetup->bMeshCollideAll = true;
+	BodySetup->InvalidatePhysicsData();
+}
+
+Vitruvio::FCollisionData CreateCollisionData(const FMeshDescription& MeshDescription)
+{
+	Vitruvio::FCollisionData CollisionData;
+
+	FStaticMeshConstAttributes MeshAttributes(MeshDescription);
+	const auto VertexPositions = MeshAttributes.GetVertexPositions();
+	CollisionData.Vertices.Reserve(VertexPositions.GetNumElements());
+	for (int32 VertexIndex = 0; VertexIndex < VertexPositions.GetNumElements(); ++VertexIndex)
+	{
+		CollisionData.Vertices.Add(VertexPositions[FVertexID(VertexIndex)]);
+	}
+
+	CollisionData.Indices.Reserve(MeshDescription.Triangles().Num());
+	for (const FPolygonGroupID PolygonGroupId : MeshDescription.PolygonGroups().GetElementIDs())
+	{
+		for (FPolygonID PolygonID : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+		{
+			for (FTriangleID TriangleID : MeshDescription.GetPolygonTriangles(PolygonID))
+			{
+				auto TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
+
+				FTriIndices TriIndex;
+				TriIndex.v0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]).GetValue();
+				TriIndex.v1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]).GetValue();
+				TriIndex.v2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]).GetValue();
+				CollisionData.Indices.Add(TriIndex);
+			}
+		}
+	}
+
+	return CollisionData;
+}
+
+/**
+ * \brief Fills the vertex buffers, index buffer and sections of the given LOD like UStaticMesh::BuildFromMeshDescription, without touching
+ * the static mesh. Safe to call from any thread.
+ *
+ * \param MaterialIndices the index of the static material per imported material slot name
+ */
+void BuildLODResources(const FMeshDescription& MeshDescription, const TMap<FName, int32>& MaterialIndices, FStaticMeshLODResources& LODResources)
+{
+	FStaticMeshConstAttributes MeshAttributes(MeshDescription);
+
+	const int32 NumVertexInstances = MeshDescription.VertexInstances().GetArraySize();
+	const int32 NumTriangles = MeshDescription.Triangles().Num();
+	if (NumVertexInstances == 0 || NumTriangles == 0)
+	{
+		return;
+	}
+
+	const auto VertexPositions = MeshAttributes.GetVertexPositions();
+	const auto VertexInstanceNormals = MeshAttributes.GetVertexInstanceNormals();
+	const auto VertexInstanceTangents = MeshAttributes.GetVertexInstanceTangents();
+	const auto VertexInstanceBinormalSigns = MeshAttributes.GetVertexInstanceBinormalSigns();
+	const auto VertexInstanceColors = MeshAttributes.GetVertexInstanceColors();
+	const auto VertexInstanceUVs = MeshAttributes.GetVertexInstanceUVs();
+	const int32 NumUVs = FMath::Clamp(VertexInstanceUVs.GetNumChannels(), 1, static_cast<int32>(MAX_STATIC_TEXCOORDS));
+
+	TArray<FStaticMeshBuildVertex> BuildVertices;
+	BuildVertices.SetNumZeroed(NumVertexInstances);
+	bool bHasVertexColors = false;
+	for (const FVertexInstanceID VertexInstanceID : MeshDescription.VertexInstances().GetElementIDs())
+	{
+		FStaticMeshBuildVertex& BuildVertex = BuildVertices[VertexInstanceID.GetValue()];
+
+		BuildVertex.Position = VertexPositions[MeshDescription.GetVertexInstanceVertex(VertexInstanceID)];
+		BuildVertex.TangentX = VertexInstanceTangents[VertexInstanceID];
+		BuildVertex.TangentY = FVector3f::CrossProduct(VertexInstanceNormals[VertexInstanceID], VertexInstanceTangents[VertexInstanceID]).GetSafeNormal() *
+							   VertexInstanceBinormalSigns[VertexInstanceID];
+		BuildVertex.TangentZ = VertexInstanceNormals[VertexInstanceID];
+
+		for (int32 UVIndex = 0; UVIndex < FMath::Min(NumUVs, VertexInstanceUVs.GetNumChannels()); ++UVIndex)
+		{
+			BuildVertex.UVs[UVIndex] = VertexInstanceUVs.Get(VertexInstanceID, UVIndex);
+		}
+
+		const FLinearColor Color = VertexInstanceColors.IsValid() ? FLinearColor(VertexInstanceColors[VertexInstanceID]) : FLinearColor::White;
+		bHasVertexColors |= Color != FLinearColor::White;
+		BuildVertex.Color = Color.ToFColor(true);
+	}
+
+	LODResources.VertexBuffers.PositionVertexBuffer.Init(BuildVertices);
+	LODResources.VertexBuffers.StaticMeshVertexBuffer.Init(BuildVertices, NumUVs);
+	if (bHasVertexColors)
+	{
+		LODResources.VertexBuffers.ColorVertexBuffer.Init(BuildVertices);
+	}
+	else
+	{
+		LODResources.VertexBuffers.ColorVertexBuffer.InitFromSingleColor(FColor::White, NumVertexInstances);
+	}
+
+	const auto MaterialSlotNames = MeshAttributes.GetPolygonGroupMaterialSlotNames();
+
+	TArray<uint32> Indices;
+	Indices.Reserve(NumTriangles * 3);
+	EIndexBufferStride::Type IndexBufferStride = EIndexBufferStride::Force16Bit;
+	for (const FPolygonGroupID PolygonGroupID : MeshDescription.PolygonGroups().GetElementIDs())
+	{
+		// Empty polygon groups would result in empty sections
+		if (MeshDescription.GetNumPolygonGroupPolygons(PolygonGroupID) == 0)
+		{
+			continue;
+		}
+
+		FStaticMeshSection& Section = LODResources.Sections.AddDefaulted_GetRef();
+		Section.FirstIndex = Indices.Num();
+
+		uint32 MinVertexIndex = TNumericLimits<uint32>::Max();
+		uint32 MaxVertexIndex = 0;
+		int32 SectionTriangles = 0;
+		for (const FTriangleID TriangleID : MeshDescription.GetPolygonGroupTriangles(PolygonGroupID))
+		{
+			for (const FVertexInstanceID VertexInstanceID : MeshDescription.GetTriangleVertexInstances(TriangleID))
+			{
+				const uint32 VertexIndex = static_cast<uint32>(VertexInstanceID.GetValue());
+				MinVertexIndex = FMath::Min(MinVertexIndex, VertexIndex);
+				MaxVertexIndex = FMath::Max(MaxVertexIndex, VertexIndex);
+				Indices.Add(VertexIndex);
+			}
+			++SectionTriangles;
+		}
+
+		Section.NumTriangles = SectionTriangles;
+		Section.MinVertexIndex = SectionTriangles == 0 ? 0 : MinVertexIndex;
+		Section.MaxVertexIndex = SectionTriangles == 0 ? 0 : MaxVertexIndex;
+
+		const int32* MaterialIndex = MaterialIndices.Find(MaterialSlotNames[PolygonGroupID]);
+		Section.MaterialIndex = MaterialIndex ? *MaterialIndex : 0;
+		Section.bEnableCollision = true;
+		Section.bCastShadow = true;
+
+		if (MaxVertexIndex > TNumericLimits<uint16>::Max())
+		{
+			IndexBufferStride = EIndexBufferStride::Force32Bit;
+		}
+	}
+
+	LODResources.IndexBuffer.SetIndices(Indices, IndexBufferStride);
+}
+
 } // namespace
 
+struct FVitruvioMesh::FAsyncBuildState
+{
+	/** Builds the render data and collision data on a worker thread. Neither the static mesh nor any other UObject is accessed. */
+	TFuture<void> Task;
+
+	/** The static material index per imported material slot name, gathered on the game thread. */
+	TMap<FName, int32> MaterialIndices;
+
+	TUniquePtr<FStaticMeshRenderData> RenderData;
+	Vitruvio::FCollisionData CollisionData;
+
+	bool bRenderDataApplied = false;
+	bool bPhysicsCooked = false;
+};
+
 UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-										TMap<FString, Vitruvio::FTextureData>& TextureCache,
+										FTextureCache& TextureCache,
 										TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
 										const Vitruvio::FMaterialAttributeContainer& MaterialAttributes, TMap<FString, int32>& UniqueMaterialNames,
-										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer)
+										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer,
+										const Vitruvio::FPrefetchedTextures* PrefetchedTextures)
 {
 	check(IsInGameThread());
 
@@ -61,7 +235,7 @@ UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* Mask
 
 	const FString UniqueMaterialIdentifier = MakeUniqueMaterialName(MaterialIdentifier, UniqueMaterialNames);
 	UMaterialInstanceDynamic* Material = GameThread_CreateMaterialInstance(Outer, UniqueMaterialIdentifier, OpaqueParent, MaskedParent,
-																		   TranslucentParent, MaterialAttributes, TextureCache);
+																		   TranslucentParent, MaterialAttributes, TextureCache, PrefetchedTextures);
 
 	MaterialCache.Add(MaterialAttributes, Material);
 	MaterialIdentifiers.Add(Material, MaterialIdentifier);
@@ -71,16 +245,18 @@ UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* Mask
 
 void InitializeBodySetup(UBodySetup* BodySetup)
 {
-	BodySetup->DefaultInstance.SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
-	BodySetup->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
-	BodySetup->bDoubleSidedGeometry = true;
-	BodySetup->bMeshCollideAll = true;
-	BodySetup->InvalidatePhysicsData();
+	ConfigureBodySetup(BodySetup);
 	BodySetup->CreatePhysicsMeshes();
 }
 
 FVitruvioMesh::~FVitruvioMesh()
 {
+	// The worker thread accesses the mesh description
+	if (AsyncBuild && AsyncBuild->Task.IsValid())
+	{
+		AsyncBuild->Task.Wait();
+	}
+
 	if (IsEngineExitRequested())
 	{
 		return;
@@ -93,18 +269,12 @@ FVitruvioMesh::~FVitruvioMesh()
 	}
 }
 
-void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-						  TMap<FString, Vitruvio::FTextureData>& TextureCache, TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers,
-						  TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-						  UWorld* World)
+void FVitruvioMesh::CreateStaticMesh(const FString& Name,
+									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+									 FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers,
+									 TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent,
+									 UMaterial* TranslucentParent, UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures)
 {
-	check(IsInGameThread());
-
-	if (StaticMesh)
-	{
-		return;
-	}
-
 	FString MeshName = Name.Replace(TEXT("."), TEXT(""));
 	const FName StaticMeshName = MakeUniqueObjectName(nullptr, UStaticMesh::StaticClass(), FName(MeshName));
 	StaticMesh = NewObject<UStaticMesh>(GetTransientPackage(), StaticMeshName, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
@@ -112,52 +282,63 @@ void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttribute
 	
 	VitruvioModule::Get().RegisterMesh(StaticMesh);
 
-	TMap<UMaterialInstanceDynamic*, FName> MaterialSlots;
-
 	FStaticMeshAttributes MeshAttributes(MeshDescription);
 
-	TArray<FVector3f> Vertices;
-	auto VertexPositions = MeshAttributes.GetVertexPositions();
-	for (int32 VertexIndex = 0; VertexIndex < VertexPositions.GetNumElements(); ++VertexIndex)
-	{
-		Vertices.Add(VertexPositions[FVertexID(VertexIndex)]);
-	}
-
-	TArray<FTriIndices> Indices;
 	const auto PolygonGroups = MeshDescription.PolygonGroups();
 	size_t MaterialIndex = 0;
 
 	for (const auto& PolygonGroupId : PolygonGroups.GetElementIDs())
 	{
 		UMaterialInstanceDynamic* Material = CacheMaterial(OpaqueParent, MaskedParent, TranslucentParent, TextureCache, MaterialCache,
-														   Materials[MaterialIndex], UniqueMaterialNames, UniqueMaterialIdentifiers, StaticMesh);
+														   Materials[MaterialIndex], UniqueMaterialNames, UniqueMaterialIdentifiers, StaticMesh,
+														   PrefetchedTextures);
 
 		const FName SlotName = StaticMesh->AddMaterial(Material);
 		MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = SlotName;
-		MaterialSlots.Add(Material, SlotName);
 
 		++MaterialIndex;
+	}
+}
 
-		// cache collision data
-		for (FPolygonID PolygonID : MeshDescription.GetPolygonGroupPolygonIDs(PolygonGroupId))
+void FVitruvioMesh::AddMaterialIdentifiers(TMap<UMaterialInterface*, FString>& MaterialIdentifiers) const
+{
+	// CreateStaticMesh adds one material slot per material in order
+	const TArray<FStaticMaterial>& StaticMaterials = StaticMesh->GetStaticMaterials();
+	for (int32 MaterialIndex = 0; MaterialIndex < FMath::Min(StaticMaterials.Num(), Materials.Num()); ++MaterialIndex)
+	{
+		if (UMaterialInterface* Material = StaticMaterials[MaterialIndex].MaterialInterface)
 		{
-			for (FTriangleID TriangleID : MeshDescription.GetPolygonTriangles(PolygonID))
-			{
-				auto TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
+			MaterialIdentifiers.Add(Material, Materials[MaterialIndex].GetMaterialName());
+		}
+	}
+}
 
-				auto VertexID0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]);
-				auto VertexID1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]);
-				auto VertexID2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]);
+void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+						  FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers,
+						  TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+						  UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures)
+{
+	check(IsInGameThread());
 
-				FTriIndices TriIndex;
-				TriIndex.v0 = VertexID0.GetValue();
-				TriIndex.v1 = VertexID1.GetValue();
-				TriIndex.v2 = VertexID2.GetValue();
-				Indices.Add(TriIndex);
-			}
+	if (StaticMesh)
+	{
+		// The mesh may be reused from a cached generate result whose builder emptied the identifiers
+		AddMaterialIdentifiers(UniqueMaterialIdentifiers);
+
+		// Finish a pending asynchronous build of the same mesh. Only the worker task is waited for, the render data is then applied and the
+		// collision cooked right here. If the render data has already been applied, its collision keeps cooking asynchronously.
+		if (AsyncBuild && !AsyncBuild->bRenderDataApplied)
+		{
+			AsyncBuild->Task.Wait();
+			ApplyRenderData(false);
+			AsyncBuild.Reset();
 		}
+		return;
 	}
 
+	CreateStaticMesh(Name, MaterialCache, TextureCache, UniqueMaterialIdentifiers, UniqueMaterialNames, OpaqueParent, MaskedParent,
+					 TranslucentParent, World, PrefetchedTextures);
+
 	TArray<const FMeshDescription*> MeshDescriptionPtrs;
 	MeshDescriptionPtrs.Emplace(&MeshDescription);
 
@@ -166,10 +347,136 @@ void FVitruvioMesh::Build(const FString& Name, TMap<Vitruvio::FMaterialAttribute
 	Params.bFastBuild = true;
 	StaticMesh->BuildFromMeshDescriptions(MeshDescriptionPtrs, Params);
 	
-	Vitruvio::FCollisionData CollisionData = {Indices, Vertices};
-	CollisionDataProvider->SetCollisionData(CollisionData);
+	CollisionDataProvider->SetCollisionData(CreateCollisionData(MeshDescription));
 
 	UBodySetup* BodySetup = NewObject<UBodySetup>(CollisionDataProvider, NAME_None, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient | RF_Transactional);
 	InitializeBodySetup(BodySetup);
 	StaticMesh->SetBodySetup(BodySetup);
-}
\ No newline at end of file
+}
+
+void FVitruvioMesh::BuildAsync(const FString& Name,
+							   TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+							   FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& UniqueMaterialIdentifiers,
+							   TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent,
+							   UMaterial* TranslucentParent, UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures)
+{
+	check(IsInGameThread());
+
+	if (StaticMesh)
+	{
+		AddMaterialIdentifiers(UniqueMaterialIdentifiers);
+		return;
+	}
+
+	// Only the UObjects and materials are created on the game thread
+	CreateStaticMesh(Name, MaterialCache, TextureCache, UniqueMaterialIdentifiers, UniqueMaterialNames, OpaqueParent, MaskedParent,
+					 TranslucentParent, World, PrefetchedTextures);
+
+	AsyncBuild = MakeShared<FAsyncBuildState>();
+	AsyncBuild->RenderData = MakeUnique<FStaticMeshRenderData>();
+	AsyncBuild->RenderData->AllocateLODResources(1);
+
+	const TArray<FStaticMaterial>& StaticMaterials = StaticMesh->GetStaticMaterials();
+	for (int32 MaterialIndex = 0; MaterialIndex < StaticMaterials.Num(); ++MaterialIndex)
+	{
+		AsyncBuild->MaterialIndices.Add(StaticMaterials[MaterialIndex].ImportedMaterialSlotName, MaterialIndex);
+	}
+
+	// The render data is only committed to the static mesh on the game thread in ApplyRenderData
+	AsyncBuild->Task = Async(EAsyncExecution::TaskGraph, [this, State = AsyncBuild]() {
+		BuildLODResources(MeshDescription, State->MaterialIndices, State->RenderData->LODResources[0]);
+		State->RenderData->Bounds = MeshDescription.GetBounds();
+		State->RenderData->ScreenSize[0].Default = 1.0f;
+		State->CollisionData = CreateCollisionData(MeshDescription);
+	});
+}
+
+void FVitruvioMesh::ApplyRenderData(bool bCookCollisionAsync)
+{
+	check(IsInGameThread());
+
+	StaticMesh->NeverStream = true;
+	StaticMesh->SetRenderData(MoveTemp(AsyncBuild->RenderData));
+	StaticMesh->InitResources();
+	StaticMesh->CalculateExtendedBounds();
+
+#if WITH_EDITORONLY_DATA
+	// Generated meshes are persisted from their mesh description by the cooker
+	if (StaticMesh->GetNumSourceModels() == 0)
+	{
+		StaticMesh->AddSourceModel();
+	}
+	StaticMesh->CreateMeshDescription(0, MeshDescription);
+	UStaticMesh::FCommitMeshDescriptionParams CommitParams;
+	CommitParams.bMarkPackageDirty = false;
+	CommitParams.bUseHashAsGuid = true;
+	StaticMesh->CommitMeshDescription(0, CommitParams);
+#endif
+
+	CollisionDataProvider->SetCollisionData(MoveTemp(AsyncBuild->CollisionData));
+
+	UBodySetup* BodySetup = NewObject<UBodySetup>(CollisionDataProvider, NAME_None, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient | RF_Transactional);
+	StaticMesh->SetBodySetup(BodySetup);
+
+	AsyncBuild->bRenderDataApplied = true;
+
+	if (bCookCollisionAsync)
+	{
+		ConfigureBodySetup(BodySetup);
+
+		// The cook finished callback is executed on the game thread
+		BodySetup->CreatePhysicsMeshesAsync(FOnAsyncPhysicsCookFinished::CreateLambda([State = AsyncBuild](bool bSuccess) {
+			State->bPhysicsCooked = true;
+		}));
+	}
+	else
+	{
+		InitializeBodySetup(BodySetup);
+		AsyncBuild->bPhysicsCooked = true;
+	}
+}
+
+bool FVitruvioMesh::TryFinishBuild()
+{
+	check(IsInGameThread());
+
+	if (!AsyncBuild)
+	{
+		return StaticMesh != nullptr;
+	}
+
+	if (!AsyncBuild->bRenderDataApplied)
+	{
+		if (!AsyncBuild->Task.IsReady())
+		{
+			return false;
+		}
+
+		ApplyRenderData(true);
+	}
+
+	if (!AsyncBuild->bPhysicsCooked)
+	{
+		return false;
+	}
+
+	AsyncBuild.Reset();
+	return true;
+}
+
+int64 FVitruvioMesh::GetEstimatedSize() const
+{
+	return MeshDescription.Vertices().Num() * ESTIMATED_BYTES_PER_VERTEX +
+		   MeshDescription.VertexInstances().Num() * ESTIMATED_BYTES_PER_VERTEX_INSTANCE +
+		   MeshDescription.Triangles().Num() * ESTIMATED_BYTES_PER_TRIANGLE + MeshDescription.Polygons().Num() * ESTIMATED_BYTES_PER_POLYGON;
+}
+
+bool FVitruvioMesh::IsBuildPending() const
+{
+	return AsyncBuild && !AsyncBuild->bPhysicsCooked;
+}
+
+bool FVitruvioMesh::IsRenderDataReady() const
+{
+	return AsyncBuild && !AsyncBuild->bRenderDataApplied && AsyncBuild->Task.IsReady();
+}
@@ -24,11 +24,16 @@
 
 #include "Util/PolygonWindings.h"
 
+#include "Algo/AllOf.h"
 #include "Async/Async.h"
 #include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
 #include "HAL/PlatformFileManager.h"
+#include "Hash/xxhash.h"
 #include "Interfaces/IPluginManager.h"
 #include "Modules/ModuleManager.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshOperations.h"
 
 #include "UObject/UObjectBaseUtility.h"
 #include "Util/AttributeConversion.h"
@@ -37,6 +42,58 @@
 
 DEFINE_LOG_CATEGORY(LogUnrealPrt);
 
+TAutoConsoleVariable<int32> CVarGenerateWorkerThreads(TEXT("Esri.Vitruvio.GenerateWorkerThreads"), 0,
+													  TEXT("The number of worker threads used for generate and attribute evaluation calls. "
+														   "0 chooses a value based on the number of cores. Applied on startup."));
+
+TAutoConsoleVariable<int32> CVarGenerateQueueSize(TEXT("Esri.Vitruvio.GenerateQueueSize"), 1024,
+												  TEXT("The maximum number of queued generate and attribute evaluation calls before new calls "
+													   "block until a worker becomes available. Calls from the game thread never block, they are "
+													   "queued as soon as there is room. Applied on startup."));
+
+TAutoConsoleVariable<int32> CVarGenerateHighPriorityBurst(TEXT("Esri.Vitruvio.GenerateHighPriorityBurst"), FGenerateScheduler::DefaultHighPriorityBurst,
+														  TEXT("The maximum number of consecutive interactive generate calls which are processed while batched "
+															   "calls are waiting. 0 always processes interactive calls first. Applied on startup."));
+
+TAutoConsoleVariable<bool> CVarFuseAttributeEvaluation(TEXT("Esri.Vitruvio.FuseAttributeEvaluation"), true,
+														TEXT("If enabled, batch generate calls evaluate the rule attributes in the same PRT generate pass as "
+															 "the geometry instead of running a separate attribute evaluation pass."));
+
+TAutoConsoleVariable<int32> CVarGenerateCacheBudget(TEXT("Esri.Vitruvio.GenerateCacheBudgetMB"), 256,
+													TEXT("The memory budget in MB of the cache which reuses the results of identical generate calls. "
+														 "0 disables the cache."));
+
+TAutoConsoleVariable<int32> CVarMeshCacheBudget(TEXT("Esri.Vitruvio.MeshCacheBudgetMB"), 512,
+												TEXT("The memory budget in MB of the cache which shares instance meshes between generate calls. "
+													 "Only meshes which are no longer in use are evicted."));
+
+TAutoConsoleVariable<int32> CVarRpkCacheBudget(TEXT("Esri.Vitruvio.RpkCacheBudgetMB"), 4096,
+											   TEXT("The size in MB of the persistent rule package unpack cache in Saved/Vitruvio/RpkCache. The least "
+													"recently used rule packages are deleted on startup until the cache fits. 0 disables the limit."));
+
+TAutoConsoleVariable<int32> CVarRpkCacheMaxAge(TEXT("Esri.Vitruvio.RpkCacheMaxAgeDays"), 30,
+											   TEXT("Rule packages which have not been used for this many days are deleted from the unpack cache on "
+													"startup. 0 disables the limit."));
+
+/** The interval in seconds in which unreferenced meshes are evicted from the mesh cache. */
+constexpr float MeshCacheTrimInterval = 1.0f;
+
+TAutoConsoleVariable<int32> CVarTextureCacheBudget(TEXT("Esri.Vitruvio.TextureCacheBudgetMB"), 1024,
+												  TEXT("The memory budget in MB of the cache which shares decoded textures between materials. "
+													   "Evicted textures stay alive as long as materials use them."));
+
+FAutoConsoleCommand InvalidateTextureCacheCommand(TEXT("Esri.Vitruvio.InvalidateTextureCache"),
+												  TEXT("Checks every cached texture for changes of its file on its next use."),
+												  FConsoleCommandDelegate::CreateLambda([]() { VitruvioModule::Get().InvalidateTextureCache(); }));
+
+TAutoConsoleVariable<float> CVarApplyBudget(TEXT("Esri.Vitruvio.ApplyBudgetMs"), 5.0f,
+											 TEXT("The time in ms per frame spent on applying generated models on the game thread. At least one step "
+												  "is applied per frame. 0 disables the budget."));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPK Unpack Cache Hits"), STAT_RpkUnpackCache_Hits, STATGROUP_Vitruvio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPK Unpack Cache Misses"), STAT_RpkUnpackCache_Misses, STATGROUP_Vitruvio);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("RPK Load Time (ms)"), STAT_RpkLoadTime, STATGROUP_Vitruvio);
+
 #define CHECK_PRT_INITIALIZED()                                                                                                                      \
     if (!Initialized)                                                                                                                                \
     {                                                                                                                                                \
@@ -60,9 +117,7 @@ constexpr const wchar_t* ATTRIBUTE_EVAL_ENCODER_ID = L"com.esri.prt.core.Attribu
 struct FStartRuleInfo
 {
 	ResolveMapSPtr ResolveMap;
-	FString RuleFile;
-	FString StartRule;
-	RuleFileInfoPtr RuleFileInfo;
+	FRuleInfoPtr RuleInfo;
 };
 
 class FLoadResolveMapTask
@@ -71,13 +126,15 @@ class FLoadResolveMapTask
 	TPromise<ResolveMapSPtr> Promise;
 	TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache;
 	FCriticalSection& LoadResolveMapLock;
+	FRpkLoadCounters& RpkLoadCounters;
 	FString RpkFolder;
 
 public:
 	FLoadResolveMapTask(TPromise<ResolveMapSPtr>&& InPromise, const FString RpkFolder, const TLazyObjectPtr<URulePackage> LazyRulePackagePtr,
-						TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache, FCriticalSection& LoadResolveMapLock)
+						TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache, FCriticalSection& LoadResolveMapLock,
+						FRpkLoadCounters& RpkLoadCounters)
 		: LazyRulePackagePtr(LazyRulePackagePtr), Promise(MoveTemp(InPromise)), ResolveMapCache(ResolveMapCache),
-		  LoadResolveMapLock(LoadResolveMapLock), RpkFolder(RpkFolder)
+		  LoadResolveMapLock(LoadResolveMapLock), RpkLoadCounters(RpkLoadCounters), RpkFolder(RpkFolder)
 	{
 	}
 
@@ -102,42 +159,106 @@ public:
 
 	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
 	{
-		const FString UriPath = LazyRulePackagePtr->GetPathName();
+		const double StartTime = FPlatformTime::Seconds();
+		const TArray<uint8>& Data = LazyRulePackagePtr->Data;
 
-		// Create rpk on disk for PRT
+		// Rpks are stored by content hash, so unchanged rule packages are neither written nor unpacked again
+		const FXxHash128 ContentHash = FXxHash128::HashBuffer(Data.GetData(), Data.Num());
+		const FString ContentName = FString::Printf(TEXT("%016llx%016llx"), ContentHash.HashHigh, ContentHash.HashLow);
+		const FString RpkFilePath = FPaths::Combine(RpkFolder, ContentName + TEXT(".rpk"));
+		const FString UnpackFolderPath = FPaths::Combine(RpkFolder, ContentName);
+		const FString CompleteMarkerPath = FPaths::Combine(RpkFolder, ContentName + TEXT(".complete"));
+
+		// Different rule packages with the same content share their files and must not be written or unpacked concurrently
+		FScopeLock ContentScopeLock(&GetContentLock(ContentHash));
+
+		// The marker is only written once the rpk has been written and successfully loaded, so an interrupted write or unpack (or a
+		// different file of the same size) is never mistaken for a cache hit
 		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const bool bCached = PlatformFile.FileExists(*CompleteMarkerPath) && PlatformFile.FileSize(*RpkFilePath) == Data.Num();
+		if (bCached)
+		{
+			// The marker time stamp is the last use of the rule package, the least recently used ones are pruned first (see PruneRpkCache)
+			PlatformFile.SetTimeStamp(*CompleteMarkerPath, FDateTime::UtcNow());
+		}
+		else
+		{
+			PlatformFile.DeleteFile(*CompleteMarkerPath);
+			PlatformFile.DeleteDirectoryRecursively(*UnpackFolderPath);
 
-		const FString RpkFile = FPaths::GetBaseFilename(UriPath, false) + TEXT(".rpk");
-		const FString RpkFilePath = FPaths::Combine(RpkFolder, RpkFile);
-		const FString RpkFolderPath = FPaths::GetPath(RpkFilePath);
+			if (!WriteRpk(PlatformFile, RpkFilePath, Data))
+			{
+				UE_LOG(LogUnrealPrt, Error, TEXT("Could not write rule package %s to %s"), *LazyRulePackagePtr->GetPathName(), *RpkFilePath);
+				Promise.SetValue(nullptr);
+				return;
+			}
+		}
+
+		// Create rpk
+		const std::wstring AbsoluteRpkPath(TCHAR_TO_WCHAR(*RpkFilePath));
+		const std::wstring AbsoluteUnpackPath(TCHAR_TO_WCHAR(*UnpackFolderPath));
 
-		IFileManager::Get().Delete(*RpkFilePath);
-		PlatformFile.CreateDirectoryTree(*RpkFolderPath);
+		const std::wstring RpkFileUri = prtu::toFileURI(AbsoluteRpkPath);
+		prt::Status Status;
+		const ResolveMapSPtr ResolveMapPtr(prt::createResolveMap(RpkFileUri.c_str(), AbsoluteUnpackPath.c_str(), &Status), PRTDestroyer());
 
-		IFileHandle* RpkHandle = PlatformFile.OpenWrite(*RpkFilePath);
-		if (RpkHandle)
+		if (!bCached && ResolveMapPtr && Status == prt::STATUS_OK)
 		{
-			// Write file to disk
-			RpkHandle->Write(LazyRulePackagePtr->Data.GetData(), LazyRulePackagePtr->Data.Num());
-			RpkHandle->Flush();
-			delete RpkHandle;
+			IFileHandle* MarkerHandle = PlatformFile.OpenWrite(*CompleteMarkerPath);
+			delete MarkerHandle;
+		}
 
-			// Create rpk
-			const std::wstring AbsoluteRpkPath(TCHAR_TO_WCHAR(*FPaths::ConvertRelativePathToFull(RpkFilePath)));
+		const double LoadTimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		if (bCached)
+		{
+			RpkLoadCounters.NumUnpackCacheHits.Increment();
+			RpkLoadCounters.WarmLoadTimeUs.Add(static_cast<int64>(LoadTimeMs * 1000.0));
+			INC_DWORD_STAT(STAT_RpkUnpackCache_Hits);
+		}
+		else
+		{
+			RpkLoadCounters.NumUnpackCacheMisses.Increment();
+			RpkLoadCounters.ColdLoadTimeUs.Add(static_cast<int64>(LoadTimeMs * 1000.0));
+			INC_DWORD_STAT(STAT_RpkUnpackCache_Misses);
+		}
+		INC_FLOAT_STAT_BY(STAT_RpkLoadTime, LoadTimeMs);
 
-			const std::wstring RpkFileUri = prtu::toFileURI(AbsoluteRpkPath);
-			prt::Status Status;
-			const ResolveMapSPtr ResolveMapPtr(prt::createResolveMap(RpkFileUri.c_str(), nullptr, &Status), PRTDestroyer());
+		{
+			// Failed loads are not cached so that the rule package is loaded again on its next use
+			FScopeLock Lock(&LoadResolveMapLock);
+			if (ResolveMapPtr)
 			{
-				FScopeLock Lock(&LoadResolveMapLock);
 				ResolveMapCache.Add(LazyRulePackagePtr, ResolveMapPtr);
-				Promise.SetValue(ResolveMapPtr);
 			}
+			Promise.SetValue(ResolveMapPtr);
 		}
-		else
+	}
+
+private:
+	static FCriticalSection& GetContentLock(const FXxHash128& ContentHash)
+	{
+		// Striped by content hash, rule packages with different content rarely share a lock
+		static constexpr int32 NumContentLocks = 64;
+		static FCriticalSection ContentLocks[NumContentLocks];
+		return ContentLocks[ContentHash.HashLow % NumContentLocks];
+	}
+
+	static bool WriteRpk(IPlatformFile& PlatformFile, const FString& RpkFilePath, const TArray<uint8>& Data)
+	{
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(RpkFilePath));
+
+		// Write to a temporary file first so that an interrupted write never leaves a truncated rpk in the cache
+		const FString TempFilePath = RpkFilePath + TEXT(".tmp");
+		IFileHandle* RpkHandle = PlatformFile.OpenWrite(*TempFilePath);
+		if (!RpkHandle)
 		{
-			Promise.SetValue(nullptr);
+			return false;
 		}
+
+		const bool bWritten = RpkHandle->Write(Data.GetData(), Data.Num()) && RpkHandle->Flush();
+		delete RpkHandle;
+
+		return bWritten && IFileManager::Get().Move(*RpkFilePath, *TempFilePath, true);
 	}
 };
 
@@ -247,6 +368,136 @@ AttributeMapUPtr EvaluateRuleAttributes(const std::wstring& RuleFile, const std:
 	return AttributeMapUPtr(AttributeMapBuilders[0]->createAttributeMap());
 }
 
+/**
+ * \brief Creates the options of the Unreal geometry encoder. The meshIds of all cached instance meshes are passed to the encoder so that it
+ * does not serialize these prototypes again. The callbacks pin the mesh cache until the generate call is done.
+ */
+AttributeMapUPtr CreateUnrealEncoderOptions(UnrealCallbacks& Callbacks, FMeshCache& MeshCache, bool bEmitPerInitialShape)
+{
+	// Encoders which do not know the option would drop the meshIds anyway, so the mesh cache is not pinned at all
+	static const bool bEncoderSupportsCachedMeshIds = [] {
+		const AttributeMapUPtr DefaultOptions = prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID);
+		return DefaultOptions && DefaultOptions->hasKey(UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS);
+	}();
+
+	AttributeMapBuilderUPtr UnrealEncoderOptionsBuilder(prt::AttributeMapBuilder::create());
+	UnrealEncoderOptionsBuilder->setBool(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE, bEmitPerInitialShape);
+	UnrealEncoderOptionsBuilder->setInt(UNREAL_GEOMETRY_ENCODER_MESH_FORMAT, UNREAL_GEOMETRY_ENCODER_MESH_FORMAT_V2);
+	UnrealEncoderOptionsBuilder->setBool(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS, true);
+	if (bEncoderSupportsCachedMeshIds)
+	{
+		// The ids are only recollected after the cached meshes have changed
+		const FCachedMeshIds& CachedMeshIds = Callbacks.PinCachedMeshes(MeshCache);
+		if (!CachedMeshIds.IdPtrs.empty())
+		{
+			UnrealEncoderOptionsBuilder->setStringArray(UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS, CachedMeshIds.IdPtrs.data(), CachedMeshIds.IdPtrs.size());
+		}
+	}
+	const AttributeMapUPtr UnrealEncoderUnvalidatedOptions(UnrealEncoderOptionsBuilder->createAttributeMapAndReset());
+	AttributeMapUPtr UnrealEncoderOptions = prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID, UnrealEncoderUnvalidatedOptions.get());
+
+	// Encoders built before per initial shape output was added drop the option and only emit the merged model
+	if (bEmitPerInitialShape && !(UnrealEncoderOptions && UnrealEncoderOptions->hasKey(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE)))
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("UnrealGeometryEncoder does not support per initial shape output, falling back to merged models."))
+	}
+
+	// Attribute map addresses only identify materials if the encoder keeps them alive for the whole generate call
+	const bool bEncoderCachesMaterials = UnrealEncoderOptions && UnrealEncoderOptions->hasKey(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS) &&
+										 UnrealEncoderOptions->getBool(UNREAL_GEOMETRY_ENCODER_CACHE_MATERIALS);
+	Callbacks.SetCacheConvertedMaterials(bEncoderCachesMaterials);
+
+	return UnrealEncoderOptions;
+}
+
+/**
+ * \brief Merges the given meshes into one mesh with one polygon group per unique material.
+ */
+TSharedPtr<FVitruvioMesh> MergeMeshes(const TArray<TTuple<TSharedPtr<FVitruvioMesh>, FTransform>>& Meshes)
+{
+	if (Meshes.IsEmpty())
+	{
+		return {};
+	}
+	if (Meshes.Num() == 1 && Meshes[0].Get<1>().Equals(FTransform::Identity))
+	{
+		return Meshes[0].Get<0>();
+	}
+
+	FMeshDescription MergedDescription;
+	FStaticMeshAttributes Attributes(MergedDescription);
+	Attributes.Register();
+	Attributes.GetVertexInstanceUVs().SetNumChannels(8);
+
+	TArray<Vitruvio::FMaterialAttributeContainer> Materials;
+	TMap<Vitruvio::FMaterialAttributeContainer, FPolygonGroupID> PolygonGroupByMaterial;
+
+	for (const TTuple<TSharedPtr<FVitruvioMesh>, FTransform>& MeshAndTransform : Meshes)
+	{
+		const TSharedPtr<FVitruvioMesh>& Mesh = MeshAndTransform.Get<0>();
+
+		FStaticMeshOperations::FAppendSettings AppendSettings;
+		AppendSettings.MeshTransform = MeshAndTransform.Get<1>();
+		AppendSettings.PolygonGroupsDelegate = FAppendPolygonGroupsDelegate::CreateLambda(
+			[&Mesh, &Materials, &PolygonGroupByMaterial](const FMeshDescription& Source, FMeshDescription& Target, PolygonGroupMap& RemapPolygonGroups) {
+				// The materials of a mesh are in polygon group order
+				int32 MaterialIndex = 0;
+				for (const FPolygonGroupID SourcePolygonGroup : Source.PolygonGroups().GetElementIDs())
+				{
+					const Vitruvio::FMaterialAttributeContainer Material = Mesh->GetMaterials().IsValidIndex(MaterialIndex)
+																			   ? Mesh->GetMaterials()[MaterialIndex]
+																			   : Vitruvio::FMaterialAttributeContainer();
+					MaterialIndex++;
+
+					const FPolygonGroupID* TargetPolygonGroup = PolygonGroupByMaterial.Find(Material);
+					if (!TargetPolygonGroup)
+					{
+						TargetPolygonGroup = &PolygonGroupByMaterial.Add(Material, Target.CreatePolygonGroup());
+						Materials.Add(Material);
+					}
+					RemapPolygonGroups.Add(SourcePolygonGroup, *TargetPolygonGroup);
+				}
+			});
+		FStaticMeshOperations::AppendMeshDescription(Mesh->GetMeshDescription(), MergedDescription, AppendSettings);
+	}
+
+	return MakeShared<FVitruvioMesh>(TEXT("GeneratedMesh"), MergedDescription, Materials);
+}
+
+/**
+ * \brief Recomposes the merged model and instances of a batch from the per initial shape results which are relative to their initial
+ * shape positions.
+ */
+void ComposeInitialShapeResults(FGenerateResultDescription& Result, const TMap<int64, FVector>& Positions)
+{
+	TArray<TTuple<TSharedPtr<FVitruvioMesh>, FTransform>> Meshes;
+	if (Result.GeneratedModel)
+	{
+		Meshes.Emplace(Result.GeneratedModel, FTransform::Identity);
+	}
+
+	for (const auto& [InitialShapeIndex, InitialShapeResult] : Result.InitialShapeResults)
+	{
+		const FVector Position = Positions.FindRef(InitialShapeIndex);
+		if (InitialShapeResult.GeneratedModel)
+		{
+			Meshes.Emplace(InitialShapeResult.GeneratedModel, FTransform(Position));
+		}
+
+		for (const auto& [InstanceKey, Transforms] : InitialShapeResult.Instances)
+		{
+			TArray<FTransform>& MergedTransforms = Result.Instances.FindOrAdd(InstanceKey);
+			for (FTransform Transform : Transforms)
+			{
+				Transform.AddToTranslation(Position);
+				MergedTransforms.Add(Transform);
+			}
+		}
+	}
+
+	Result.GeneratedModel = MergeMeshes(Meshes);
+}
+
 TArray<int64> GetInitialShapeIndices(const TArray<FInitialShape>& InitialShapes)
 {
 	TArray<int64> Indices;
@@ -257,6 +508,70 @@ TArray<int64> GetInitialShapeIndices(const TArray<FInitialShape>& InitialShapes)
 	return Indices;
 }
 
+TMap<int64, FVector> GetInitialShapePositions(const TArray<FInitialShape>& InitialShapes)
+{
+	TMap<int64, FVector> Positions;
+	Positions.Reserve(InitialShapes.Num());
+	for (const FInitialShape& InitialShape : InitialShapes)
+	{
+		Positions.Add(InitialShape.InitialShapeIndex, InitialShape.Position);
+	}
+	return Positions;
+}
+
+bool EncoderSupportsPerInitialShape()
+{
+	static const bool bEncoderSupportsPerInitialShape = [] {
+		const AttributeMapUPtr DefaultOptions = prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID);
+		return DefaultOptions && DefaultOptions->hasKey(UNREAL_GEOMETRY_ENCODER_EMIT_PER_INITIAL_SHAPE);
+	}();
+	return bEncoderSupportsPerInitialShape;
+}
+
+/**
+ * \brief Creates the generate cache entry of a single initial shape from a batch generated per initial shape. The entry holds the model and
+ * instances relative to the initial shape, the instance meshes it uses and its evaluated attributes.
+ */
+FGenerateResultDescription CreateInitialShapeCacheEntry(const FGenerateResultDescription& BatchResult, int64 InitialShapeIndex)
+{
+	FGenerateResultDescription Entry;
+	const FInitialShapeGenerateResult* InitialShapeResult = BatchResult.InitialShapeResults.Find(InitialShapeIndex);
+	if (!InitialShapeResult)
+	{
+		return Entry;
+	}
+
+	Entry.GeneratedModel = InitialShapeResult->GeneratedModel;
+	Entry.Instances = InitialShapeResult->Instances;
+	for (const auto& [InstanceKey, Transforms] : Entry.Instances)
+	{
+		Entry.InstanceMeshes.Add(InstanceKey.MeshId, BatchResult.InstanceMeshes.FindRef(InstanceKey.MeshId));
+		if (const FString* InstanceName = BatchResult.InstanceNames.Find(InstanceKey.MeshId))
+		{
+			Entry.InstanceNames.Add(InstanceKey.MeshId, *InstanceName);
+		}
+	}
+	if (InitialShapeResult->EvaluatedAttributes)
+	{
+		Entry.EvaluatedAttributes.Add(InitialShapeResult->EvaluatedAttributes);
+	}
+	return Entry;
+}
+
+/**
+ * \brief Adds a cache entry created by CreateInitialShapeCacheEntry to the per initial shape results of a batch.
+ */
+void AddInitialShapeCacheEntry(FGenerateResultDescription& BatchResult, int64 InitialShapeIndex, const FGenerateResultDescription& Entry)
+{
+	FInitialShapeGenerateResult& InitialShapeResult = BatchResult.InitialShapeResults.Add(InitialShapeIndex);
+	InitialShapeResult.GeneratedModel = Entry.GeneratedModel;
+	InitialShapeResult.Instances = Entry.Instances;
+	InitialShapeResult.EvaluatedAttributes = Entry.EvaluatedAttributes.IsEmpty() ? nullptr : Entry.EvaluatedAttributes[0];
+
+	BatchResult.InstanceMeshes.Append(Entry.InstanceMeshes);
+	BatchResult.InstanceNames.Append(Entry.InstanceNames);
+}
+
 void CleanupTempRpkFolder()
 {
 	FString TempDir(WCHAR_TO_TCHAR(prtu::temp_directory_path().c_str()));
@@ -265,12 +580,95 @@ void CleanupTempRpkFolder()
 	PlatformFile.DeleteDirectoryRecursively(*RpkUnpackFolder);
 }
 
+/**
+ * \brief Deletes the rule packages from the unpack cache which have not been used within MaxAge, then the least recently used ones until
+ * the cache is at most MaxSizeBytes large. Incomplete entries of interrupted writes or unpacks are always deleted. Must not run concurrently
+ * with loading rule packages.
+ */
+void PruneRpkCache(const FString& RpkFolder, int64 MaxSizeBytes, const FTimespan& MaxAge)
+{
+	struct FRpkCacheEntry
+	{
+		FString ContentName;
+		FDateTime LastUseTime;
+		int64 Size = 0;
+	};
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Every entry consists of <ContentName>.rpk, the unpack folder <ContentName> and the marker <ContentName>.complete
+	TArray<FRpkCacheEntry> Entries;
+	TArray<FString> IncompleteContentNames;
+	PlatformFile.IterateDirectoryStat(*RpkFolder, [&](const TCHAR* Path, const FFileStatData& StatData) {
+		if (StatData.bIsDirectory || FPaths::GetExtension(Path) != TEXT("rpk"))
+		{
+			return true;
+		}
+
+		const FString ContentName = FPaths::GetBaseFilename(Path);
+		const FString CompleteMarkerPath = FPaths::Combine(RpkFolder, ContentName + TEXT(".complete"));
+		if (!PlatformFile.FileExists(*CompleteMarkerPath))
+		{
+			IncompleteContentNames.Add(ContentName);
+			return true;
+		}
+
+		FRpkCacheEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.ContentName = ContentName;
+		Entry.LastUseTime = PlatformFile.GetTimeStamp(*CompleteMarkerPath);
+		Entry.Size = StatData.FileSize;
+		PlatformFile.IterateDirectoryStatRecursively(*FPaths::Combine(RpkFolder, ContentName), [&Entry](const TCHAR*, const FFileStatData& UnpackedStatData) {
+			Entry.Size += UnpackedStatData.bIsDirectory ? 0 : UnpackedStatData.FileSize;
+			return true;
+		});
+		return true;
+	});
+
+	auto DeleteEntry = [&PlatformFile, &RpkFolder](const FString& ContentName) {
+		// The marker goes first so that a partially deleted entry is never considered complete
+		PlatformFile.DeleteFile(*FPaths::Combine(RpkFolder, ContentName + TEXT(".complete")));
+		PlatformFile.DeleteFile(*FPaths::Combine(RpkFolder, ContentName + TEXT(".rpk")));
+		PlatformFile.DeleteDirectoryRecursively(*FPaths::Combine(RpkFolder, ContentName));
+	};
+
+	for (const FString& ContentName : IncompleteContentNames)
+	{
+		DeleteEntry(ContentName);
+	}
+
+	Entries.Sort([](const FRpkCacheEntry& A, const FRpkCacheEntry& B) { return A.LastUseTime > B.LastUseTime; });
+
+	const FDateTime Now = FDateTime::UtcNow();
+	int64 CacheSize = 0;
+	int32 NumPruned = 0;
+	int64 PrunedSize = 0;
+	for (const FRpkCacheEntry& Entry : Entries)
+	{
+		if (Now - Entry.LastUseTime > MaxAge || CacheSize + Entry.Size > MaxSizeBytes)
+		{
+			DeleteEntry(Entry.ContentName);
+			NumPruned++;
+			PrunedSize += Entry.Size;
+			continue;
+		}
+		CacheSize += Entry.Size;
+	}
+
+	if (NumPruned > 0 || !IncompleteContentNames.IsEmpty())
+	{
+		UE_LOG(LogUnrealPrt, Display, TEXT("Pruned %d rule packages (%.1f MiB) and %d incomplete entries from the unpack cache, %.1f MiB left"),
+			   NumPruned, PrunedSize / (1024.0 * 1024.0), IncompleteContentNames.Num(), CacheSize / (1024.0 * 1024.0));
+	}
+}
+
 FString GetPlatformName()
 {
 #if PLATFORM_64BITS && PLATFORM_WINDOWS
 	return "Win64";
 #elif PLATFORM_MAC
 	return "Mac";
+#elif PLATFORM_LINUX
+	return "Linux";
 #else
 	return "Unknown";
 #endif
@@ -307,45 +705,107 @@ FString GetPrtBinDir()
 
 FString GetPrtDllPath()
 {
-	const FString BaseDir = GetPrtBinDir();
-	return FPaths::Combine(*BaseDir, TEXT("com.esri.prt.core.dll"));
+	// The Windows SDK ships the core library in bin, the Linux and Mac SDKs next to the extension libraries in lib
+#if PLATFORM_WINDOWS
+	return FPaths::Combine(*GetPrtBinDir(), TEXT("com.esri.prt.core.dll"));
+#elif PLATFORM_LINUX
+	return FPaths::Combine(*GetPrtLibDir(), TEXT("libcom.esri.prt.core.so"));
+#else
+	return FPaths::Combine(*GetPrtLibDir(), TEXT("libcom.esri.prt.core.dylib"));
+#endif
 }
 
 } // namespace
 
-void VitruvioModule::InitializePrt()
+void VitruvioModule::InitializePrtLibrary()
 {
-	const FString PrtLibPath = GetPrtDllPath();
-	const FString PrtBinDir = GetPrtBinDir();
-	const FString PrtLibDir = GetPrtLibDir();
+#if !WITH_UNREAL_GEOMETRY_ENCODER
+	UE_LOG(LogUnrealPrt, Warning, TEXT("Vitruvio has been built without the UnrealGeometryEncoder extension for %s, PRT is not initialized"),
+		   *GetPlatformName());
+#else
+	if (!PrtDllHandle)
+	{
+		PrtDllHandle = FPlatformProcess::GetDllHandle(*GetPrtDllPath());
+	}
 
-	FPlatformProcess::AddDllDirectory(*PrtBinDir);
-	FPlatformProcess::AddDllDirectory(*PrtLibDir);
-	PrtDllHandle = FPlatformProcess::GetDllHandle(*PrtLibPath);
+	// TCHAR and wchar_t only have the same size on Windows, so the converted paths need to outlive the conversion
+	const std::wstring EncoderExtensionPath(TCHAR_TO_WCHAR(*GetEncoderExtensionPath()));
+	const std::wstring PrtExtensionPath(TCHAR_TO_WCHAR(*GetPrtLibDir()));
+	TArray<const wchar_t*> PRTPluginsPaths;
+	PRTPluginsPaths.Add(EncoderExtensionPath.c_str());
+	PRTPluginsPaths.Add(PrtExtensionPath.c_str());
 
-	TArray<wchar_t*> PRTPluginsPaths;
-	const FString EncoderExtensionPath = GetEncoderExtensionPath();
-	const FString PrtExtensionPaths = GetPrtLibDir();
-	PRTPluginsPaths.Add(const_cast<wchar_t*>(TCHAR_TO_WCHAR(*EncoderExtensionPath)));
-	PRTPluginsPaths.Add(const_cast<wchar_t*>(TCHAR_TO_WCHAR(*PrtExtensionPaths)));
+	prt::Status Status;
+	PrtLibrary = prt::init(PRTPluginsPaths.GetData(), PRTPluginsPaths.Num(), prt::LogLevel::LOG_TRACE, &Status);
+	Initialized = Status == prt::STATUS_OK;
+#endif
+}
 
+void VitruvioModule::InitializePrt()
+{
+	FPlatformProcess::AddDllDirectory(*GetPrtBinDir());
+	FPlatformProcess::AddDllDirectory(*GetPrtLibDir());
+
+	// Registered once for the lifetime of the module, PRT keeps a pointer to it
 	LogHandler = MakeUnique<UnrealLogHandler>();
 	prt::addLogHandler(LogHandler.Get());
 
-	prt::Status Status;
-	PrtLibrary = prt::init(PRTPluginsPaths.GetData(), PRTPluginsPaths.Num(), prt::LogLevel::LOG_TRACE, &Status);
-	Initialized = Status == prt::STATUS_OK;
+	InitializePrtLibrary();
 
 	PrtCache.reset(prt::CacheObject::create(prt::CacheObject::CACHE_TYPE_DEFAULT));
 
-	const FString TempDir(WCHAR_TO_TCHAR(prtu::temp_directory_path().c_str()));
-	RpkFolder = FPaths::CreateTempFilename(*TempDir, TEXT("Vitruvio_"), TEXT(""));
+	// Persistent across sessions so that unchanged rule packages are loaded from the unpack cache
+	RpkFolder = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Vitruvio"), TEXT("RpkCache")));
+
+	// No rule packages have been loaded yet, so the unpack cache can be pruned without interfering with loads
+	const int32 RpkCacheBudgetMB = CVarRpkCacheBudget.GetValueOnAnyThread();
+	const int32 RpkCacheMaxAgeDays = CVarRpkCacheMaxAge.GetValueOnAnyThread();
+	PruneRpkCache(RpkFolder, RpkCacheBudgetMB > 0 ? static_cast<int64>(RpkCacheBudgetMB) * 1024 * 1024 : MAX_int64,
+				  RpkCacheMaxAgeDays > 0 ? FTimespan::FromDays(RpkCacheMaxAgeDays) : FTimespan::MaxValue());
 
-	OcclusionSet.reset(prt::OcclusionSet::create());
+	// Every generate call spreads its work over multiple PRT worker threads, so only a few concurrent calls are needed to saturate all cores
+	int32 NumWorkers = CVarGenerateWorkerThreads.GetValueOnAnyThread();
+	if (NumWorkers <= 0)
+	{
+		NumWorkers = FMath::Clamp(FPlatformMisc::NumberOfCores() / 4, 2, 8);
+	}
+	GenerateScheduler.Start(NumWorkers, CVarGenerateQueueSize.GetValueOnAnyThread(), CVarGenerateHighPriorityBurst.GetValueOnAnyThread());
+
+	auto UpdateGenerateCacheBudget = [this](IConsoleVariable* Variable) {
+		GenerateCache.SetMemoryBudget(static_cast<int64>(Variable->GetInt()) * 1024 * 1024);
+	};
+	UpdateGenerateCacheBudget(CVarGenerateCacheBudget.AsVariable());
+	CVarGenerateCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(UpdateGenerateCacheBudget));
+
+	auto UpdateMeshCacheBudget = [this](IConsoleVariable* Variable) {
+		MeshCache.SetMemoryBudget(static_cast<int64>(Variable->GetInt()) * 1024 * 1024);
+	};
+	UpdateMeshCacheBudget(CVarMeshCacheBudget.AsVariable());
+	CVarMeshCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(UpdateMeshCacheBudget));
+
+	// Meshes which were in use when the cache exceeded its budget are only evicted once released
+	MeshCacheTrimHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateLambda([this](float) {
+			MeshCache.Trim();
+			return true;
+		}),
+		MeshCacheTrimInterval);
+
+	auto UpdateTextureCacheBudget = [this](IConsoleVariable* Variable) {
+		TextureCache.SetMemoryBudget(static_cast<int64>(Variable->GetInt()) * 1024 * 1024);
+	};
+	UpdateTextureCacheBudget(CVarTextureCacheBudget.AsVariable());
+	CVarTextureCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(UpdateTextureCacheBudget));
 }
 
 void VitruvioModule::StartupModule()
 {
+	auto UpdateApplyBudget = [this](IConsoleVariable* Variable) {
+		ApplyBudget.SetDefaultBudgetMs(Variable->GetFloat());
+	};
+	UpdateApplyBudget(CVarApplyBudget.AsVariable());
+	CVarApplyBudget->SetOnChangedCallback(FConsoleVariableDelegate::CreateLambda(UpdateApplyBudget));
+
 	// During cooking we do not start Vitruvio
 	if (IsRunningCommandlet())
 	{
@@ -355,6 +815,24 @@ void VitruvioModule::StartupModule()
 	InitializePrt();
 }
 
+bool VitruvioModule::EnsureInitialized()
+{
+	if (!Initialized && FPaths::FileExists(GetPrtDllPath()))
+	{
+		// The log handler is only created by the one-time setup, afterwards only the failed prt::init is retried
+		if (!LogHandler)
+		{
+			InitializePrt();
+		}
+		else
+		{
+			InitializePrtLibrary();
+		}
+	}
+
+	return Initialized;
+}
+
 void VitruvioModule::ShutdownModule()
 {
 	if (!Initialized)
@@ -368,6 +846,15 @@ void VitruvioModule::ShutdownModule()
 		   TEXT("Shutting down Vitruvio. Waiting for ongoing generate calls (%d), RPK loading tasks (%d) and attribute loading tasks (%d)"),
 		   GenerateCallsCounter.GetValue(), RpkLoadingTasksCounter.GetValue(), LoadAttributesCounter.GetValue())
 
+	// Queued calls return immediately since PRT is no longer marked as initialized
+	GenerateScheduler.Stop();
+
+	CVarGenerateCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate());
+	GenerateCache.Empty();
+	CVarMeshCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate());
+	FTSTicker::GetCoreTicker().RemoveTicker(MeshCacheTrimHandle);
+	CVarTextureCacheBudget->SetOnChangedCallback(FConsoleVariableDelegate());
+
 	// Wait until no more PRT calls are ongoing
 	FGenericPlatformProcess::ConditionalSleep(
 		[this]() { return GenerateCallsCounter.GetValue() == 0 && RpkLoadingTasksCounter.GetValue() == 0 && LoadAttributesCounter.GetValue() == 0; },
@@ -375,6 +862,8 @@ void VitruvioModule::ShutdownModule()
 
 	UE_LOG(LogUnrealPrt, Display, TEXT("PRT calls finished. Shutting down."))
 
+	OcclusionHandleCache.Reset();
+
 	if (PrtDllHandle)
 	{
 		FPlatformProcess::FreeDllHandle(PrtDllHandle);
@@ -405,21 +894,23 @@ Vitruvio::FTextureData VitruvioModule::DecodeTexture(UObject* Outer, const FStri
 	return Vitruvio::DecodeTexture(Outer, Key, Path, TextureMetadata, std::move(Buffer), BufferSize);
 }
 
-FBatchGenerateResult VitruvioModule::BatchGenerateAsync(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes) const
+FBatchGenerateResult VitruvioModule::BatchGenerateAsync(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+														bool bGeneratePerInitialShape) const
 {
     const FBatchGenerateResult::FTokenPtr Token = MakeShared<FGenerateToken>();
     	
 	CHECK_PRT_INITIALIZED_ASYNC(FBatchGenerateResult, Token)
 
-	FBatchGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::Thread, [this, Token, bEnableOcclusionQueries, InitialShapes = MoveTemp(InitialShapes), OccluderOnlyShapes = MoveTemp(OccluderOnlyShapes)]() mutable {
-		FGenerateResultDescription Result = BatchGenerate(MoveTemp(InitialShapes), bEnableOcclusionQueries, MoveTemp(OccluderOnlyShapes));
+	FBatchGenerateResult::FFutureType ResultFuture = GenerateScheduler.Submit(EGeneratePriority::Normal, [this, Token, bEnableOcclusionQueries, bGeneratePerInitialShape, InitialShapes = MoveTemp(InitialShapes), OccluderOnlyShapes = MoveTemp(OccluderOnlyShapes)]() mutable {
+		FGenerateResultDescription Result = BatchGenerate(MoveTemp(InitialShapes), bEnableOcclusionQueries, MoveTemp(OccluderOnlyShapes), bGeneratePerInitialShape);
 		return FBatchGenerateResult::ResultType { Token, MoveTemp(Result) };
 	});
 
 	return FBatchGenerateResult { MoveTemp(ResultFuture), Token };
 }
 
-FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes) const
+FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+														 bool bGeneratePerInitialShape) const
 {
 	if (InitialShapes.IsEmpty())
 	{
@@ -428,6 +919,128 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	
 	CHECK_PRT_INITIALIZED()
 
+	const bool bUseGenerateCache = GenerateCache.IsEnabled();
+
+	// Occluders depend on the neighbors, so only results without occlusion queries can be cached per initial shape
+	if (bUseGenerateCache && bGeneratePerInitialShape && !bEnableOcclusionQueries && EncoderSupportsPerInitialShape())
+	{
+		return BatchGeneratePerInitialShapeCached(MoveTemp(InitialShapes));
+	}
+
+	const FXxHash128 GenerateCacheKey = bUseGenerateCache
+		? FGenerateCache::ComputeBatchKey(InitialShapes, bEnableOcclusionQueries, OccluderOnlyShapes, bGeneratePerInitialShape)
+		: FXxHash128{};
+	if (bUseGenerateCache)
+	{
+		if (const TSharedPtr<const FGenerateResultDescription> CachedResult = GenerateCache.Find(GenerateCacheKey))
+		{
+			NotifyGenerateCompleted();
+			return *CachedResult;
+		}
+	}
+
+	const TMap<int64, FVector> Positions = GetInitialShapePositions(InitialShapes);
+
+	FGenerateResultDescription Result;
+	TMap<URulePackage*, ResolveMapSPtr> ResolveMaps;
+	if (!GenerateBatch(MoveTemp(InitialShapes), bEnableOcclusionQueries, MoveTemp(OccluderOnlyShapes), bGeneratePerInitialShape, Result, ResolveMaps))
+	{
+		return {};
+	}
+
+	if (bGeneratePerInitialShape)
+	{
+		ComposeInitialShapeResults(Result, Positions);
+	}
+
+	if (bUseGenerateCache)
+	{
+		// Results generated with a resolve map which has been evicted in the meantime must not be added back to the emptied cache
+		FScopeLock Lock(&LoadResolveMapLock);
+		if (AreResolveMapsCached(ResolveMaps))
+		{
+			GenerateCache.Add(GenerateCacheKey, Result);
+		}
+	}
+
+	return Result;
+}
+
+FGenerateResultDescription VitruvioModule::BatchGeneratePerInitialShapeCached(TArray<FInitialShape> InitialShapes) const
+{
+	const TMap<int64, FVector> Positions = GetInitialShapePositions(InitialShapes);
+	const TArray<int64> InitialShapeIndices = GetInitialShapeIndices(InitialShapes);
+
+	FGenerateResultDescription Result;
+	TArray<TTuple<int64, FXxHash128>> MissedKeys;
+	TArray<FInitialShape> MissedInitialShapes;
+	for (FInitialShape& InitialShape : InitialShapes)
+	{
+		const FXxHash128 Key = FGenerateCache::ComputeInitialShapeKey(InitialShape);
+		if (const TSharedPtr<const FGenerateResultDescription> CachedResult = GenerateCache.Find(Key))
+		{
+			AddInitialShapeCacheEntry(Result, InitialShape.InitialShapeIndex, *CachedResult);
+		}
+		else
+		{
+			MissedKeys.Emplace(InitialShape.InitialShapeIndex, Key);
+			MissedInitialShapes.Add(MoveTemp(InitialShape));
+		}
+	}
+
+	if (MissedInitialShapes.IsEmpty())
+	{
+		NotifyGenerateCompleted();
+	}
+	else
+	{
+		FGenerateResultDescription GeneratedResult;
+		TMap<URulePackage*, ResolveMapSPtr> ResolveMaps;
+		if (!GenerateBatch(MoveTemp(MissedInitialShapes), false, {}, true, GeneratedResult, ResolveMaps))
+		{
+			return {};
+		}
+
+		TArray<FGenerateResultDescription> Entries;
+		Entries.Reserve(MissedKeys.Num());
+		for (const auto& [InitialShapeIndex, Key] : MissedKeys)
+		{
+			Entries.Add(CreateInitialShapeCacheEntry(GeneratedResult, InitialShapeIndex));
+			AddInitialShapeCacheEntry(Result, InitialShapeIndex, Entries.Last());
+		}
+
+		// Results generated with a resolve map which has been evicted in the meantime must not be added back to the emptied cache
+		FScopeLock Lock(&LoadResolveMapLock);
+		if (AreResolveMapsCached(ResolveMaps))
+		{
+			for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+			{
+				GenerateCache.Add(MissedKeys[EntryIndex].Get<1>(), Entries[EntryIndex]);
+			}
+		}
+	}
+
+	// Evaluated attributes are returned in the order of the given initial shapes
+	for (const int64 InitialShapeIndex : InitialShapeIndices)
+	{
+		const FInitialShapeGenerateResult* InitialShapeResult = Result.InitialShapeResults.Find(InitialShapeIndex);
+		if (InitialShapeResult && InitialShapeResult->EvaluatedAttributes)
+		{
+			Result.EvaluatedAttributes.Add(InitialShapeResult->EvaluatedAttributes);
+		}
+	}
+
+	ComposeInitialShapeResults(Result, Positions);
+
+	return Result;
+}
+
+bool VitruvioModule::GenerateBatch(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+								   bool bGeneratePerInitialShape, FGenerateResultDescription& OutResult,
+								   TMap<URulePackage*, ResolveMapSPtr>& OutResolveMaps) const
+{
+	CHECK_PRT_INITIALIZED()
+
 	GenerateCallsCounter.Add(InitialShapes.Num());
 
 	const int NumInitialShapes = InitialShapes.Num();
@@ -457,16 +1070,15 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	for (auto& [ResolveMapFuture, InitialShapesByRpk] : ResolveMapFutures)
 	{
 		const ResolveMapSPtr ResolveMap = ResolveMapFuture.Get();
+		const FRuleInfoPtr RuleInfo = GetRuleInfo(InitialShapesByRpk[0].RulePackage, ResolveMap);
+		if (!RuleInfo)
+		{
+			GenerateCallsCounter.Subtract(NumInitialShapes);
+			return {};
+		}
 
-		const std::wstring RuleFile = ResolveMap->findCGBKey();
-		const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
-
-		const RuleFileInfoPtr RuleFileInfo = prt_make_shared<const prt::RuleFileInfo>(prt::createRuleFileInfo(RuleFileUri));
-		const std::wstring StartRule = prtu::detectStartRule(RuleFileInfo);
-		
-		FStartRuleInfo StartRuleInfo { ResolveMap, RuleFile.c_str(), StartRule.c_str(), RuleFileInfo };
-
-		RuleInfoInitialShapes.Add(MakeTuple(StartRuleInfo, MoveTemp(InitialShapesByRpk)));
+		OutResolveMaps.Add(InitialShapesByRpk[0].RulePackage, ResolveMap);
+		RuleInfoInitialShapes.Add(MakeTuple(FStartRuleInfo { ResolveMap, RuleInfo }, MoveTemp(InitialShapesByRpk)));
 	}
 	
 	auto ForeachInitialShape = [&RuleInfoInitialShapes](bool bOccluders, bool bNonOccluders, auto Fun)
@@ -491,14 +1103,20 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	
 	TMap<int64, const prt::InitialShape*> InitialShapeByIndex;
 	TMap<const prt::InitialShape*, int64> IndexByInitialShape;
+	TMap<int64, FXxHash128> OccluderKeys;
 
 	ForeachInitialShape(false, true, [&](int32, const FInitialShape& InitialShape, const FStartRuleInfo& StartRuleInfo)
 	{
+		if (bEnableOcclusionQueries)
+		{
+			OccluderKeys.Add(InitialShape.InitialShapeIndex, FGenerateCache::ComputeOccluderKey(InitialShape));
+		}
+
 		InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
 		SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
 
 		AttributeMapUPtr Attributes = Vitruvio::CreateAttributeMap(InitialShape.Attributes);
-		InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleFile, *StartRuleInfo.StartRule, InitialShape.RandomSeed, L"",
+		InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleInfo->RuleFile, *StartRuleInfo.RuleInfo->StartRule, InitialShape.RandomSeed, L"",
 			Attributes.get(), StartRuleInfo.ResolveMap.get());
 		InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShape());
 
@@ -509,8 +1127,12 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	});
 
 	TArray<FAttributeMapPtr> EvaluatedAttributes;
+
+	// The attribute evaluation encoder can run alongside the geometry encoder which saves a full CGA execution per initial shape
+	const bool bFuseAttributeEvaluation = CVarFuseAttributeEvaluation.GetValueOnAnyThread();
 	
-	// Evaluate attributes
+	// Evaluate attributes in a separate pass
+	if (!bFuseAttributeEvaluation)
 	{
 		TArray<AttributeMapBuilderUPtr> EvaluateAttributeMapBuilders;
 		for (int32 InitialShapeIndex = 0; InitialShapeIndex < NumInitialShapes; ++InitialShapeIndex)
@@ -524,7 +1146,7 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 		const AttributeMapNOPtrVector EncoderOptions = {AttributeEncodeOptions.get()};
 
 		AttributeMapBuilderUPtr GenerateOptionsBuilder(prt::AttributeMapBuilder::create());
-		GenerateOptionsBuilder->setInt(L"numberWorkerThreads", FPlatformMisc::NumberOfCores());
+		GenerateOptionsBuilder->setInt(L"numberWorkerThreads", GetNumPrtWorkerThreads());
 		const AttributeMapUPtr GenerateOptions(GenerateOptionsBuilder->createAttributeMapAndReset());
 
 		TArray<const prt::InitialShape*> InitialShapesPtrs;
@@ -544,38 +1166,37 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 		{
 			const FAttributeMapPtr AttributeMap = MakeShared<FAttributeMap>(
 				AttributeMapUPtr(EvaluateAttributeMapBuilders[Index]->createAttributeMapAndReset()),
-				StartRuleInfo.RuleFileInfo);
+				StartRuleInfo.RuleInfo);
 			EvaluatedAttributes.Add(AttributeMap);
 		});
 	}
 
 	// Generate Occluders
 	TArray<AttributeMapBuilderUPtr> GenerateAttributeMapBuilders;
-	TSharedPtr<UnrealCallbacks> GenerateOutputHandler(new UnrealCallbacks(GenerateAttributeMapBuilders));
-	
-	auto UnlockOcclusionLock = [bEnableOcclusionQueries](FCriticalSection& OcclusionLock)
+	if (bFuseAttributeEvaluation)
 	{
-		if (bEnableOcclusionQueries)
+		for (int32 InitialShapeIndex = 0; InitialShapeIndex < NumInitialShapes; ++InitialShapeIndex)
 		{
-			OcclusionLock.Unlock();
+			GenerateAttributeMapBuilders.Add(AttributeMapBuilderUPtr(prt::AttributeMapBuilder::create()));
 		}
-	};
+	}
+	TSharedPtr<UnrealCallbacks> GenerateOutputHandler(new UnrealCallbacks(GenerateAttributeMapBuilders));
+	
+	FOcclusionHandleCache::FScope OcclusionScope = OcclusionHandleCache.BeginScope();
 
 	if (bEnableOcclusionQueries)
 	{
-		OcclusionLock.Lock();
-					
-		InvalidateOcclusionHandles(InitialShapeIndices);
-
 		ForeachInitialShape(true, false, [&]
 			(int32, const FInitialShape& InitialShape, const FStartRuleInfo& StartRuleInfo)
 		{
+			OccluderKeys.Add(InitialShape.InitialShapeIndex, FGenerateCache::ComputeOccluderKey(InitialShape));
+
 			InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
 			AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
 			SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
 			
 			AttributeMapUPtr Attributes = Vitruvio::CreateAttributeMap(InitialShape.Attributes);
-			InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleFile, *StartRuleInfo.StartRule, InitialShape.RandomSeed, L"",
+			InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleInfo->RuleFile, *StartRuleInfo.RuleInfo->StartRule, InitialShape.RandomSeed, L"",
 				Attributes.get(), StartRuleInfo.ResolveMap.get());
 			
 			InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShape());
@@ -591,9 +1212,10 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 			TArray<prt::OcclusionSet::Handle> NewOcclusionHandles;
 			TArray<const prt::InitialShape*> OcclusionShapesArray;
 
+			// Occluders of initial shapes which did not change since the last generate call are reused
 			for (const auto& [InitialShape, InitialShapeIndex] : IndexByInitialShape)
 			{
-				if (!OcclusionHandleCache.Contains(InitialShapeIndex))
+				if (!OcclusionScope.Acquire(InitialShapeIndex, OccluderKeys[InitialShapeIndex]))
 				{
 					OcclusionShapesArray.Add(InitialShape);
 				}
@@ -602,14 +1224,12 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 			NewOcclusionHandles.SetNum(OcclusionShapesArray.Num());
 	
 			const prt::Status GenerateOccludersStatus =  generateOccluders(OcclusionShapesArray.GetData(), OcclusionShapesArray.Num(), NewOcclusionHandles.GetData(), nullptr, 0,
-	nullptr, GenerateOutputHandler.Get(), PrtCache.get(), OcclusionSet.get());
+	nullptr, GenerateOutputHandler.Get(), PrtCache.get(), OcclusionScope.GetOcclusionSet());
 
 			if (GenerateOccludersStatus != prt::STATUS_OK)
 			{
 				GenerateCallsCounter.Decrement();
 
-				UnlockOcclusionLock(OcclusionLock);
-				
 				UE_LOG(LogUnrealPrt, Error, TEXT("PRT generateOccluders failed: %hs"), prt::getStatusDescription(GenerateOccludersStatus))
 				return {};
 			}
@@ -620,7 +1240,7 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 				prt::OcclusionSet::Handle OcclusionHandle = NewOcclusionHandles[OcclusionShapeIndex];
 				int64 OcclusionInitialShapeIndex = IndexByInitialShape[InitialShape];
 
-				OcclusionHandleCache.Add(OcclusionInitialShapeIndex, OcclusionHandle);
+				OcclusionScope.Add(OcclusionInitialShapeIndex, OccluderKeys[OcclusionInitialShapeIndex], OcclusionHandle);
 			}
 		}
 	}
@@ -628,26 +1248,38 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	// Generate
 	AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
 
-	const std::vector UnrealEncoderIds = { UNREAL_GEOMETRY_ENCODER_ID };
-	const AttributeMapUPtr UnrealEncoderOptions(prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID));
-	const AttributeMapNOPtrVector GenerateEncoderOptions = {UnrealEncoderOptions.get()};
+	std::vector UnrealEncoderIds = { UNREAL_GEOMETRY_ENCODER_ID };
+	const AttributeMapUPtr UnrealEncoderOptions = CreateUnrealEncoderOptions(*GenerateOutputHandler, MeshCache, bGeneratePerInitialShape);
+	AttributeMapNOPtrVector GenerateEncoderOptions = {UnrealEncoderOptions.get()};
+
+	AttributeMapUPtr AttributeEncodeOptions;
+	if (bFuseAttributeEvaluation)
+	{
+		AttributeEncodeOptions = prtu::createValidatedOptions(ATTRIBUTE_EVAL_ENCODER_ID);
+		UnrealEncoderIds.push_back(ATTRIBUTE_EVAL_ENCODER_ID);
+		GenerateEncoderOptions.push_back(AttributeEncodeOptions.get());
+	}
 
 	AttributeMapBuilderUPtr GenerateOptionsBuilder(prt::AttributeMapBuilder::create());
-	GenerateOptionsBuilder->setInt(L"numberWorkerThreads", FPlatformMisc::NumberOfCores());
+	GenerateOptionsBuilder->setInt(L"numberWorkerThreads", GetNumPrtWorkerThreads());
 	const AttributeMapUPtr GenerateOptions(GenerateOptionsBuilder->createAttributeMapAndReset());
 
-	prt::OcclusionSet* OcclusionSetPtr = bEnableOcclusionQueries ? OcclusionSet.get() : nullptr;
+	prt::OcclusionSet* OcclusionSetPtr = bEnableOcclusionQueries ? OcclusionScope.GetOcclusionSet() : nullptr;
 	TArray<const prt::InitialShape*> InitialShapePtrs;
+	TArray<int64> GeneratedInitialShapeIndices;
+	TArray<FVector> GeneratedInitialShapePositions;
 	TArray<prt::OcclusionSet::Handle> OcclusionHandles;
 
 	ForeachInitialShape(false,  true, [&](int32, const FInitialShape& InitialShape, const FStartRuleInfo& StartRuleInfo)
 	{
 		const prt::InitialShape* InitialShapePtr = InitialShapeByIndex[InitialShape.InitialShapeIndex];
 		InitialShapePtrs.Add(InitialShapePtr);
+		GeneratedInitialShapeIndices.Add(InitialShape.InitialShapeIndex);
+		GeneratedInitialShapePositions.Add(InitialShape.Position);
 
 		if (bEnableOcclusionQueries)
 		{
-			OcclusionHandles.Add(OcclusionHandleCache[InitialShape.InitialShapeIndex]);
+			OcclusionHandles.Add(OcclusionScope.GetHandle(InitialShape.InitialShapeIndex));
 		}
 	});
 
@@ -655,10 +1287,16 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	{
 		ForeachInitialShape(true, false, [&](int32, const FInitialShape& InitialShape, const FStartRuleInfo& StartRuleInfo)
 		{
-			OcclusionHandles.Add(OcclusionHandleCache[InitialShape.InitialShapeIndex]);
+			OcclusionHandles.Add(OcclusionScope.GetHandle(InitialShape.InitialShapeIndex));
 		});
 	}
 
+	// Geometry emitted per initial shape is relative to its initial shape so that it can be reused independently of the other shapes
+	if (bGeneratePerInitialShape)
+	{
+		GenerateOutputHandler->SetInitialShapeOffsets(MoveTemp(GeneratedInitialShapePositions));
+	}
+
 	prt::OcclusionSet::Handle* OcclusionHandlesPtr = bEnableOcclusionQueries ? OcclusionHandles.GetData() : nullptr;
 	
 	prt::Status GenerateStatus = generate(InitialShapePtrs.GetData(), InitialShapePtrs.Num(), OcclusionHandlesPtr,
@@ -668,7 +1306,6 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	if (GenerateStatus != prt::STATUS_OK)
 	{
 		GenerateCallsCounter.Subtract(NumInitialShapes);
-		UnlockOcclusionLock(OcclusionLock);
 		
 		UE_LOG(LogUnrealPrt, Error, TEXT("PRT generate failed: %hs"), prt::getStatusDescription(GenerateStatus))
 		return {};
@@ -677,12 +1314,43 @@ FGenerateResultDescription VitruvioModule::BatchGenerate(TArray<FInitialShape> I
 	CHECK_PRT_INITIALIZED()
 
 	GenerateCallsCounter.Subtract(NumInitialShapes);
-	UnlockOcclusionLock(OcclusionLock);
 
 	NotifyGenerateCompleted();
+
+	if (bFuseAttributeEvaluation)
+	{
+		// The attribute evaluation encoder reports by index into the generated initial shapes array which follows the same order
+		ForeachInitialShape(false, true, [&](int32 Index, const FInitialShape&, const FStartRuleInfo& StartRuleInfo)
+		{
+			const FAttributeMapPtr AttributeMap = MakeShared<FAttributeMap>(
+				AttributeMapUPtr(GenerateAttributeMapBuilders[Index]->createAttributeMapAndReset()),
+				StartRuleInfo.RuleInfo);
+			EvaluatedAttributes.Add(AttributeMap);
+		});
+	}
+
+	// The encoder reports the index into the generated initial shapes array which we map back to the actual initial shape indices
+	TMap<int64, FInitialShapeGenerateResult> InitialShapeResults;
+	for (const auto& [EncoderInitialShapeIndex, InitialShapeModel] : GenerateOutputHandler->GetInitialShapeGeneratedModels())
+	{
+		InitialShapeResults.FindOrAdd(GeneratedInitialShapeIndices[EncoderInitialShapeIndex]).GeneratedModel = InitialShapeModel;
+	}
+	for (const auto& [EncoderInitialShapeIndex, InitialShapeInstances] : GenerateOutputHandler->GetInitialShapeInstances())
+	{
+		InitialShapeResults.FindOrAdd(GeneratedInitialShapeIndices[EncoderInitialShapeIndex]).Instances = InitialShapeInstances;
+	}
+	if (bGeneratePerInitialShape)
+	{
+		for (int32 EvaluatedIndex = 0; EvaluatedIndex < EvaluatedAttributes.Num(); ++EvaluatedIndex)
+		{
+			InitialShapeResults.FindOrAdd(GeneratedInitialShapeIndices[EvaluatedIndex]).EvaluatedAttributes = EvaluatedAttributes[EvaluatedIndex];
+		}
+	}
     
-    return FGenerateResultDescription { GenerateOutputHandler->GetGeneratedModel(), GenerateOutputHandler->GetInstances(),
-    	GenerateOutputHandler->GetInstanceMeshes(), GenerateOutputHandler->GetInstanceNames(), {}, EvaluatedAttributes };
+	OutResult = FGenerateResultDescription { GenerateOutputHandler->GetGeneratedModel(), GenerateOutputHandler->GetInstances(),
+		GenerateOutputHandler->GetInstanceMeshes(), GenerateOutputHandler->GetInstanceNames(), {}, EvaluatedAttributes, MoveTemp(InitialShapeResults) };
+
+	return true;
 }
 
 FAttributeMapsResult VitruvioModule::BatchEvaluateRuleAttributesAsync(TArray<FInitialShape> InitialShapes) const
@@ -691,7 +1359,7 @@ FAttributeMapsResult VitruvioModule::BatchEvaluateRuleAttributesAsync(TArray<FIn
 
 	CHECK_PRT_INITIALIZED_ASYNC(FAttributeMapsResult, InvalidationToken)
 
-	FAttributeMapsResult::FFutureType AttributeMapPtrFuture = Async(EAsyncExecution::Thread, [this, InvalidationToken, InitialShapes = MoveTemp(InitialShapes)]() mutable {
+	FAttributeMapsResult::FFutureType AttributeMapPtrFuture = GenerateScheduler.Submit(EGeneratePriority::Normal, [this, InvalidationToken, InitialShapes = MoveTemp(InitialShapes)]() mutable {
 		TArray<FAttributeMapPtr> Result = BatchEvaluateRuleAttributes(MoveTemp(InitialShapes));
 		return FAttributeMapsResult::ResultType { InvalidationToken, MoveTemp(Result) };
 	});
@@ -705,7 +1373,7 @@ FGenerateResult VitruvioModule::GenerateAsync(TArray<FInitialShape> InitialShape
 
 	CHECK_PRT_INITIALIZED_ASYNC(FGenerateResult, Token)
 
-	FGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::Thread, [this, Token, InitialShapes = MoveTemp(InitialShapes)]() mutable {
+	FGenerateResult::FFutureType ResultFuture = GenerateScheduler.Submit(EGeneratePriority::High, [this, Token, InitialShapes = MoveTemp(InitialShapes)]() mutable {
 		FGenerateResultDescription Result = Generate(MoveTemp(InitialShapes));
 		return FGenerateResult::ResultType{Token, MoveTemp(Result)};
 	});
@@ -722,24 +1390,41 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 		return {};
 	}
 
+	// Additional initial shapes are used for occlusion queries in which case the result also depends on the current occlusion set
+	const bool bUseGenerateCache = InitialShapes.Num() == 1 && GenerateCache.IsEnabled();
+	const FXxHash128 GenerateCacheKey = bUseGenerateCache ? FGenerateCache::ComputeKey(InitialShapes[0]) : FXxHash128{};
+	if (bUseGenerateCache)
+	{
+		if (const TSharedPtr<const FGenerateResultDescription> CachedResult = GenerateCache.Find(GenerateCacheKey))
+		{
+			NotifyGenerateCompleted();
+			return *CachedResult;
+		}
+	}
+
 	GenerateCallsCounter.Increment();
 
 	const FInitialShape& FirstInitialShape = InitialShapes[0];
 	const ResolveMapSPtr ResolveMap = LoadResolveMapAsync(FirstInitialShape.RulePackage).Get();
 
-	const std::wstring RuleFile = ResolveMap->findCGBKey();
-	const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
-
-	const RuleFileInfoPtr StartRuleInfo = prt_make_shared<const prt::RuleFileInfo>(prt::createRuleFileInfo(RuleFileUri));
-	const std::wstring StartRule = prtu::detectStartRule(StartRuleInfo);
+	const FRuleInfoPtr RuleInfo = GetRuleInfo(FirstInitialShape.RulePackage, ResolveMap);
+	if (!RuleInfo)
+	{
+		GenerateCallsCounter.Decrement();
+		return {};
+	}
 
 	TArray<AttributeMapBuilderUPtr> AttributeMapBuilders;
 	AttributeMapBuilders.Add(AttributeMapBuilderUPtr(prt::AttributeMapBuilder::create()));
 	const TSharedPtr<UnrealCallbacks> OutputHandler(new UnrealCallbacks(AttributeMapBuilders, FirstInitialShape.Position));
 
 	const std::vector<const wchar_t*> EncoderIds = {UNREAL_GEOMETRY_ENCODER_ID};
-	const AttributeMapUPtr UnrealEncoderOptions(prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID));
+	const AttributeMapUPtr UnrealEncoderOptions = CreateUnrealEncoderOptions(*OutputHandler, MeshCache, false);
 	const AttributeMapNOPtrVector EncoderOptions = {UnrealEncoderOptions.get()};
+
+	AttributeMapBuilderUPtr GenerateOptionsBuilder(prt::AttributeMapBuilder::create());
+	GenerateOptionsBuilder->setInt(L"numberWorkerThreads", GetNumPrtWorkerThreads());
+	const AttributeMapUPtr GenerateOptions(GenerateOptionsBuilder->createAttributeMapAndReset());
 	
 	AttributeMapVector AttributeMaps;
 	InitialShapeNOPtrVector Shapes = {};
@@ -751,7 +1436,7 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 		SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
 
 		AttributeMapUPtr Attributes = Vitruvio::CreateAttributeMap(InitialShape.Attributes);
-		InitialShapeBuilder->setAttributes(RuleFile.c_str(), StartRule.c_str(), InitialShape.RandomSeed, L"", Attributes.get(), ResolveMap.get());
+		InitialShapeBuilder->setAttributes(*RuleInfo->RuleFile, *RuleInfo->StartRule, InitialShape.RandomSeed, L"", Attributes.get(), ResolveMap.get());
 
 		InitialShapeUPtr InitialShapePtr(InitialShapeBuilder->createInitialShapeAndReset());
 		Shapes.push_back(InitialShapePtr.get());
@@ -761,19 +1446,22 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 
 	bool bInterOcclusion = InitialShapes.Num() > 1;
 	TArray<prt::OcclusionSet::Handle> OcclusionHandles;
+	FOcclusionHandleCache::FScope OcclusionScope = OcclusionHandleCache.BeginScope();
 	
 	if (bInterOcclusion)
 	{
-		OcclusionLock.Lock();
-	
+		// Occluders of initial shapes which did not change since the last generate call are reused
 		TMap<const prt::InitialShape*, int64> OcclusionInitialShapeIndexMap;
+		TMap<int64, FXxHash128> OccluderKeys;
 		for (int ShapeIndex = 0; ShapeIndex < InitialShapes.Num(); ++ShapeIndex)
 		{
 			const FInitialShape& InitialShape = InitialShapes[ShapeIndex];
+			const FXxHash128 OccluderKey = FGenerateCache::ComputeOccluderKey(InitialShape);
 
-			if (!OcclusionHandleCache.Contains(InitialShape.InitialShapeIndex))
+			if (!OcclusionScope.Acquire(InitialShape.InitialShapeIndex, OccluderKey))
 			{
 				OcclusionInitialShapeIndexMap.Add(Shapes[ShapeIndex], InitialShape.InitialShapeIndex);
+				OccluderKeys.Add(InitialShape.InitialShapeIndex, OccluderKey);
 			}
 		}
 
@@ -786,13 +1474,12 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 			OcclusionInitialShapeIndexMap.GenerateKeyArray(OcclusionShapesArray);
 	
 			const prt::Status GenerateOccludersStatus =  generateOccluders(OcclusionShapesArray.GetData(), OcclusionShapesArray.Num(), NewOcclusionHandles.GetData(), nullptr, 0,
-	nullptr, OutputHandler.Get(), PrtCache.get(), OcclusionSet.get());
+	nullptr, OutputHandler.Get(), PrtCache.get(), OcclusionScope.GetOcclusionSet());
 
 			if (GenerateOccludersStatus != prt::STATUS_OK)
 			{
 				GenerateCallsCounter.Decrement();
 
-				OcclusionLock.Unlock();
 				UE_LOG(LogUnrealPrt, Error, TEXT("PRT generateOccluders failed: %hs"), prt::getStatusDescription(GenerateOccludersStatus))
 				return {};
 			}
@@ -803,27 +1490,20 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 				prt::OcclusionSet::Handle OcclusionHandle = NewOcclusionHandles[OcclusionShapeIndex];
 				int64 OcclusionInitialShapeIndex = OcclusionInitialShapeIndexMap[InitialShape];
 
-				OcclusionHandleCache.Add(OcclusionInitialShapeIndex, OcclusionHandle);
+				OcclusionScope.Add(OcclusionInitialShapeIndex, OccluderKeys[OcclusionInitialShapeIndex], OcclusionHandle);
 			}
 		}
 
 		for (const FInitialShape& InitialShape : InitialShapes)
 		{
-			if (OcclusionHandleCache.Contains(InitialShape.InitialShapeIndex))
-			{
-				OcclusionHandles.Add(OcclusionHandleCache[InitialShape.InitialShapeIndex]);
-			}
+			OcclusionHandles.Add(OcclusionScope.GetHandle(InitialShape.InitialShapeIndex));
 		}
 	}
 
 	const prt::Status GenerateStatus = generate(Shapes.data(), 1, bInterOcclusion ? OcclusionHandles.GetData() : nullptr, EncoderIds.data(), EncoderIds.size(),
-													 EncoderOptions.data(), OutputHandler.Get(), PrtCache.get(), bInterOcclusion ? OcclusionSet.get() : nullptr);
+													 EncoderOptions.data(), OutputHandler.Get(), PrtCache.get(), bInterOcclusion ? OcclusionScope.GetOcclusionSet() : nullptr,
+													 GenerateOptions.get());
 
-	if (bInterOcclusion)
-	{
-		OcclusionLock.Unlock();
-	}
-	
 	GenerateCallsCounter.Decrement();
 	if (GenerateStatus != prt::STATUS_OK)
 	{
@@ -835,8 +1515,20 @@ FGenerateResultDescription VitruvioModule::Generate(TArray<FInitialShape> Initia
 	
 	NotifyGenerateCompleted();
 
-	return FGenerateResultDescription{ OutputHandler->GetGeneratedModel(), OutputHandler->GetInstances(), OutputHandler->GetInstanceMeshes(),
+	FGenerateResultDescription Result{ OutputHandler->GetGeneratedModel(), OutputHandler->GetInstances(), OutputHandler->GetInstanceMeshes(),
 									  OutputHandler->GetInstanceNames(), OutputHandler->GetReports() };
+
+	if (bUseGenerateCache)
+	{
+		// Results generated with a resolve map which has been evicted in the meantime must not be added back to the emptied cache
+		FScopeLock Lock(&LoadResolveMapLock);
+		if (IsResolveMapCached(FirstInitialShape.RulePackage, ResolveMap))
+		{
+			GenerateCache.Add(GenerateCacheKey, Result);
+		}
+	}
+
+	return Result;
 }
 
 FAttributeMapResult VitruvioModule::EvaluateRuleAttributesAsync(FInitialShape InitialShape) const
@@ -847,28 +1539,21 @@ FAttributeMapResult VitruvioModule::EvaluateRuleAttributesAsync(FInitialShape In
 
 	LoadAttributesCounter.Increment();
 
-	FAttributeMapResult::FFutureType AttributeMapPtrFuture = Async(EAsyncExecution::Thread, [this, InvalidationToken, InitialShape = MoveTemp(InitialShape)]() mutable {
+	FAttributeMapResult::FFutureType AttributeMapPtrFuture = GenerateScheduler.Submit(EGeneratePriority::High, [this, InvalidationToken, InitialShape = MoveTemp(InitialShape)]() mutable {
 		const ResolveMapSPtr ResolveMap = LoadResolveMapAsync(InitialShape.RulePackage).Get();
 
-		const std::wstring RuleFile = ResolveMap->findCGBKey();
-		const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
-
-		const RuleFileInfoPtr StartRuleInfo = prt_make_shared<const prt::RuleFileInfo>(prt::createRuleFileInfo(RuleFileUri));
-		const std::wstring StartRule = prtu::detectStartRule(StartRuleInfo);
-
-		prt::Status InfoStatus;
-		RuleFileInfoUPtr RuleInfo(prt::createRuleFileInfo(RuleFileUri, PrtCache.get(), &InfoStatus));
-		if (!RuleInfo || InfoStatus != prt::STATUS_OK)
+		const FRuleInfoPtr RuleInfo = GetRuleInfo(InitialShape.RulePackage, ResolveMap);
+		if (!RuleInfo)
 		{
-			UE_LOG(LogUnrealPrt, Error, TEXT("could not get rule file info from rule file %s"), RuleFileUri)
+			LoadAttributesCounter.Decrement();
 			return FAttributeMapResult::ResultType{
 				InvalidationToken,
 				nullptr,
 			};
 		}
 
-		AttributeMapUPtr DefaultAttributeMap(EvaluateRuleAttributes(RuleFile.c_str(),
-			StartRule.c_str(), ResolveMap, InitialShape, PrtCache.get()));
+		AttributeMapUPtr DefaultAttributeMap(EvaluateRuleAttributes(*RuleInfo->RuleFile,
+			*RuleInfo->StartRule, ResolveMap, InitialShape, PrtCache.get()));
 
 		LoadAttributesCounter.Decrement();
 
@@ -877,7 +1562,7 @@ FAttributeMapResult VitruvioModule::EvaluateRuleAttributesAsync(FInitialShape In
 			return FAttributeMapResult::ResultType{InvalidationToken, nullptr};
 		}
 
-		const TSharedPtr<FAttributeMap> AttributeMap = MakeShared<FAttributeMap>(std::move(DefaultAttributeMap), std::move(RuleInfo));
+		const TSharedPtr<FAttributeMap> AttributeMap = MakeShared<FAttributeMap>(std::move(DefaultAttributeMap), RuleInfo);
 		return FAttributeMapResult::ResultType{InvalidationToken, AttributeMap};
 	});
 
@@ -906,16 +1591,14 @@ TArray<FAttributeMapPtr> VitruvioModule::BatchEvaluateRuleAttributes(TArray<FIni
 	for (auto& [ResolveMapFuture, InitialShapesByRpk] : ResolveMapFutures)
 	{
 		const ResolveMapSPtr ResolveMap = ResolveMapFuture.Get();
+		const FRuleInfoPtr RuleInfo = GetRuleInfo(InitialShapesByRpk[0].RulePackage, ResolveMap);
+		if (!RuleInfo)
+		{
+			LoadAttributesCounter.Subtract(InitialShapes.Num());
+			return {};
+		}
 
-		const std::wstring RuleFile = ResolveMap->findCGBKey();
-		const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
-
-		const RuleFileInfoPtr RuleFileInfo = prt_make_shared<const prt::RuleFileInfo>(prt::createRuleFileInfo(RuleFileUri));
-		const std::wstring StartRule = prtu::detectStartRule(RuleFileInfo);
-		
-		FStartRuleInfo StartRuleInfo { ResolveMap, RuleFile.c_str(), StartRule.c_str(), RuleFileInfo };
-
-		RuleInfoInitialShapes.Add(MakeTuple(StartRuleInfo, MoveTemp(InitialShapesByRpk)));
+		RuleInfoInitialShapes.Add(MakeTuple(FStartRuleInfo { ResolveMap, RuleInfo }, MoveTemp(InitialShapesByRpk)));
 	}
 	
 	auto ForeachInitialShape = [&](auto Fun)
@@ -943,7 +1626,7 @@ TArray<FAttributeMapPtr> VitruvioModule::BatchEvaluateRuleAttributes(TArray<FIni
 		SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
 
 		AttributeMapUPtr Attributes = Vitruvio::CreateAttributeMap(InitialShape.Attributes);
-		InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleFile, *StartRuleInfo.StartRule, InitialShape.RandomSeed, L"",
+		InitialShapeBuilder->setAttributes(*StartRuleInfo.RuleInfo->RuleFile, *StartRuleInfo.RuleInfo->StartRule, InitialShape.RandomSeed, L"",
 			Attributes.get(), StartRuleInfo.ResolveMap.get());
 		InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShape());
 		InitialShapePtrs.push_back(Shape.get());
@@ -968,7 +1651,7 @@ TArray<FAttributeMapPtr> VitruvioModule::BatchEvaluateRuleAttributes(TArray<FIni
 		const AttributeMapNOPtrVector EncoderOptions = {AttributeEncodeOptions.get()};
 
 		AttributeMapBuilderUPtr GenerateOptionsBuilder(prt::AttributeMapBuilder::create());
-		GenerateOptionsBuilder->setInt(L"numberWorkerThreads", FPlatformMisc::NumberOfCores());
+		GenerateOptionsBuilder->setInt(L"numberWorkerThreads", GetNumPrtWorkerThreads());
 		const AttributeMapUPtr GenerateOptions(GenerateOptionsBuilder->createAttributeMapAndReset());
 
 		prt::Status GenerateStatus = generate(InitialShapePtrs.data(), InitialShapePtrs.size(), nullptr, EncoderIds.data(),
@@ -986,7 +1669,7 @@ TArray<FAttributeMapPtr> VitruvioModule::BatchEvaluateRuleAttributes(TArray<FIni
 		{
 			const FAttributeMapPtr AttributeMap = MakeShared<FAttributeMap>(
 				AttributeMapUPtr(EvaluateAttributeMapBuilders[InitialShapeIndex]->createAttributeMapAndReset()),
-				StartRuleInfo.RuleFileInfo);
+				StartRuleInfo.RuleInfo);
 			EvaluatedAttributes.Add(AttributeMap);
 		});
 	}
@@ -1002,7 +1685,14 @@ void VitruvioModule::EvictFromResolveMapCache(URulePackage* RulePackage)
 	const TLazyObjectPtr<URulePackage> LazyRulePackagePtr(RulePackage);
 	FScopeLock Lock(&LoadResolveMapLock);
 	ResolveMapCache.Remove(LazyRulePackagePtr);
+	RuleInfoCache.Remove(LazyRulePackagePtr);
 	PrtCache->flushAll();
+
+	// Cached results are keyed by the rule package and might have been generated with the old rules
+	GenerateCache.Empty();
+
+	// Textures of the reimported rule package are unpacked again and might have changed
+	TextureCache.Invalidate();
 }
 
 void VitruvioModule::RegisterMesh(UStaticMesh* StaticMesh)
@@ -1019,41 +1709,17 @@ void VitruvioModule::UnregisterMesh(UStaticMesh* StaticMesh)
 
 void VitruvioModule::InvalidateOcclusionHandle(int64 InitialShapeIndex)
 {
-	FScopeLock Lock(&OcclusionLock);
-
-	if (OcclusionHandleCache.Contains(InitialShapeIndex))
-	{
-		TArray InvalidateHandles = { OcclusionHandleCache[InitialShapeIndex] };
-		OcclusionSet->dispose(InvalidateHandles.GetData(), InvalidateHandles.Num());
-		OcclusionHandleCache.Remove(InitialShapeIndex);
-	}
+	OcclusionHandleCache.Invalidate({InitialShapeIndex});
 }
 
 void VitruvioModule::InvalidateOcclusionHandles(const TArray<int64>& InitialShapeIndices) const
 {
-	FScopeLock Lock(&OcclusionLock);
-
-	TArray<prt::OcclusionSet::Handle> InvalidateHandles;
-	for (int32 Index = 0; Index < InitialShapeIndices.Num(); ++Index)
-	{
-		int64 InitialShapeIndex = InitialShapeIndices[Index];
-		if (OcclusionHandleCache.Contains(InitialShapeIndex))
-		{
-			InvalidateHandles.Add(OcclusionHandleCache[InitialShapeIndex]);
-		}
-
-		OcclusionHandleCache.Remove(InitialShapeIndex);
-	}
-
-	OcclusionSet->dispose(InvalidateHandles.GetData(), InvalidateHandles.Num());
+	OcclusionHandleCache.Invalidate(InitialShapeIndices);
 }
 
 void VitruvioModule::InvalidateAllOcclusionHandles()
 {
-	FScopeLock Lock(&OcclusionLock);
-
-	OcclusionHandleCache.Empty();
-	OcclusionSet.reset(prt::OcclusionSet::create());
+	OcclusionHandleCache.Reset();
 }
 
 void VitruvioModule::NotifyGenerateCompleted() const
@@ -1092,6 +1758,86 @@ void VitruvioModule::NotifyGenerateCompleted() const
 	});
 }
 
+FRuleInfoPtr VitruvioModule::GetRuleInfo(URulePackage* RulePackage, const ResolveMapSPtr& ResolveMap) const
+{
+	const TLazyObjectPtr<URulePackage> LazyRulePackagePtr(RulePackage);
+
+	{
+		FScopeLock Lock(&LoadResolveMapLock);
+		if (const FRuleInfoPtr* CachedRuleInfo = RuleInfoCache.Find(LazyRulePackagePtr))
+		{
+			return *CachedRuleInfo;
+		}
+	}
+
+	const std::wstring RuleFile = ResolveMap->findCGBKey();
+	const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
+
+	prt::Status InfoStatus;
+	const RuleFileInfoPtr RuleFileInfo = prt_make_shared<const prt::RuleFileInfo>(prt::createRuleFileInfo(RuleFileUri, PrtCache.get(), &InfoStatus));
+	if (!RuleFileInfo || InfoStatus != prt::STATUS_OK)
+	{
+		UE_LOG(LogUnrealPrt, Error, TEXT("could not get rule file info from rule file %s"), RuleFileUri)
+		return {};
+	}
+
+	const FRuleInfoPtr RuleInfo = Vitruvio::CreateRuleInfo(RuleFileInfo, RuleFile);
+
+	FScopeLock Lock(&LoadResolveMapLock);
+
+	// Only cache the rule info if the resolve map has not been evicted in the meantime
+	if (IsResolveMapCached(RulePackage, ResolveMap))
+	{
+		// Another thread might have created the rule info concurrently, in which case we keep the first one
+		return RuleInfoCache.FindOrAdd(LazyRulePackagePtr, RuleInfo);
+	}
+
+	return RuleInfo;
+}
+
+bool VitruvioModule::IsResolveMapCached(URulePackage* RulePackage, const ResolveMapSPtr& ResolveMap) const
+{
+	const ResolveMapSPtr* CachedResolveMap = ResolveMapCache.Find(TLazyObjectPtr<URulePackage>(RulePackage));
+	return CachedResolveMap && *CachedResolveMap == ResolveMap;
+}
+
+bool VitruvioModule::AreResolveMapsCached(const TMap<URulePackage*, ResolveMapSPtr>& ResolveMaps) const
+{
+	return Algo::AllOf(ResolveMaps, [this](const TPair<URulePackage*, ResolveMapSPtr>& Entry) { return IsResolveMapCached(Entry.Key, Entry.Value); });
+}
+
+int32 VitruvioModule::GetNumPrtWorkerThreads() const
+{
+	// Share the cores between all concurrently running generate calls instead of letting each of them use all cores
+	return FMath::Max(1, FPlatformMisc::NumberOfCores() / FMath::Max(1, GenerateScheduler.GetNumWorkers()));
+}
+
+void VitruvioModule::EmptyResolveMapCache(bool bEmptyUnpackCache)
+{
+	FScopeLock Lock(&LoadResolveMapLock);
+	ResolveMapCache.Empty();
+	RuleInfoCache.Empty();
+	PrtCache->flushAll();
+	GenerateCache.Empty();
+	TextureCache.Invalidate();
+
+	if (bEmptyUnpackCache)
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteDirectoryRecursively(*RpkFolder);
+	}
+}
+
+FRpkLoadStats VitruvioModule::GetRpkLoadStats() const
+{
+	FRpkLoadStats Stats;
+	Stats.NumUnpackCacheHits = RpkLoadCounters.NumUnpackCacheHits.GetValue();
+	Stats.NumUnpackCacheMisses = RpkLoadCounters.NumUnpackCacheMisses.GetValue();
+	Stats.NumLoads = Stats.NumUnpackCacheHits + Stats.NumUnpackCacheMisses;
+	Stats.ColdLoadTimeMs = RpkLoadCounters.ColdLoadTimeUs.GetValue() / 1000.0;
+	Stats.WarmLoadTimeMs = RpkLoadCounters.WarmLoadTimeUs.GetValue() / 1000.0;
+	return Stats;
+}
+
 TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const RulePackage) const
 {
 	TPromise<ResolveMapSPtr> Promise;
@@ -1105,24 +1851,19 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 
 	const TLazyObjectPtr<URulePackage> LazyRulePackagePtr(RulePackage);
 
+	// Lookup and scheduling happen under the same lock so that concurrent requests for the same rule package share a single load task
+	// while independent rule packages are loaded concurrently
+	FScopeLock Lock(&LoadResolveMapLock);
+
 	// Check if has already been cached
+	if (const ResolveMapSPtr* CachedResolveMap = ResolveMapCache.Find(LazyRulePackagePtr))
 	{
-		FScopeLock Lock(&LoadResolveMapLock);
-		const auto CachedResolveMap = ResolveMapCache.Find(LazyRulePackagePtr);
-		if (CachedResolveMap)
-		{
-			Promise.SetValue(*CachedResolveMap);
-			return Future;
-		}
+		Promise.SetValue(*CachedResolveMap);
+		return Future;
 	}
 
 	// Check if a task is already running for loading the specified resolve map
-	FGraphEventRef* ScheduledTaskEvent;
-	{
-		FScopeLock Lock(&LoadResolveMapLock);
-		ScheduledTaskEvent = ResolveMapEventGraphRefCache.Find(LazyRulePackagePtr);
-	}
-	if (ScheduledTaskEvent)
+	if (const FGraphEventRef* ScheduledTaskEvent = ResolveMapEventGraphRefCache.Find(LazyRulePackagePtr))
 	{
 		// Add task which only fetches the result from the cache once the actual loading has finished
 		FGraphEventArray Prerequisites;
@@ -1131,7 +1872,8 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 			.ConstructAndDispatchWhenReady(
 				[this, LazyRulePackagePtr]() {
 					FScopeLock Lock(&LoadResolveMapLock);
-					return ResolveMapCache[LazyRulePackagePtr];
+					const ResolveMapSPtr* ResolveMap = ResolveMapCache.Find(LazyRulePackagePtr);
+					return ResolveMap ? *ResolveMap : ResolveMapSPtr();
 				},
 				MoveTemp(Promise), ENamedThreads::AnyThread);
 	}
@@ -1139,14 +1881,10 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 	{
 		RpkLoadingTasksCounter.Increment();
 
-		FGraphEventRef LoadTask;
-		{
-			FScopeLock Lock(&LoadResolveMapLock);
-			// Task which does the actual resolve map loading which might take a long time
-			LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(MoveTemp(Promise), RpkFolder, LazyRulePackagePtr,
-																								   ResolveMapCache, LoadResolveMapLock);
-			ResolveMapEventGraphRefCache.Add(LazyRulePackagePtr, LoadTask);
-		}
+		// Task which does the actual resolve map loading which might take a long time
+		const FGraphEventRef LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(
+			MoveTemp(Promise), RpkFolder, LazyRulePackagePtr, ResolveMapCache, LoadResolveMapLock, RpkLoadCounters);
+		ResolveMapEventGraphRefCache.Add(LazyRulePackagePtr, LoadTask);
 
 		// Task which removes the event from the cache once finished
 		FFunctionGraphTask::CreateAndDispatchWhenReady(
@@ -15,9 +15,13 @@
 
 #include "VitruvioTypes.h"
 
+#include "Hash/xxhash.h"
+#include "Misc/ScopeRWLock.h"
 #include "Runtime/Core/Public/Containers/UnrealString.h"
 #include "Runtime/Core/Public/Templates/TypeHash.h"
 
+#include <cwchar>
+
 namespace
 {
 enum class EMaterialPropertyType
@@ -28,26 +32,77 @@ enum class EMaterialPropertyType
 	String
 };
 
+struct FMaterialKey
+{
+	const wchar_t* Key;
+	EMaterialPropertyType Type;
+	FString Name;
+};
+
 // clang-format off
-const TMap<FString, EMaterialPropertyType> KeyToTypeMap = {
-	{TEXT("diffuseMap"), EMaterialPropertyType::Texture},
-	{TEXT("opacityMap"), EMaterialPropertyType::Texture},
-	{TEXT("emissiveMap"), EMaterialPropertyType::Texture},
-	{TEXT("metallicMap"), EMaterialPropertyType::Texture},
-	{TEXT("roughnessMap"), EMaterialPropertyType::Texture},
-	{TEXT("normalMap"), EMaterialPropertyType::Texture},
+const FMaterialKey MaterialKeys[] = {
+	{L"diffuseMap", EMaterialPropertyType::Texture, TEXT("diffuseMap")},
+	{L"opacityMap", EMaterialPropertyType::Texture, TEXT("opacityMap")},
+	{L"emissiveMap", EMaterialPropertyType::Texture, TEXT("emissiveMap")},
+	{L"metallicMap", EMaterialPropertyType::Texture, TEXT("metallicMap")},
+	{L"roughnessMap", EMaterialPropertyType::Texture, TEXT("roughnessMap")},
+	{L"normalMap", EMaterialPropertyType::Texture, TEXT("normalMap")},
 	
-	{TEXT("diffuseColor"), EMaterialPropertyType::LinearColor},
-	{TEXT("emissiveColor"), EMaterialPropertyType::LinearColor},
+	{L"diffuseColor", EMaterialPropertyType::LinearColor, TEXT("diffuseColor")},
+	{L"emissiveColor", EMaterialPropertyType::LinearColor, TEXT("emissiveColor")},
 
-	{TEXT("metallic"), EMaterialPropertyType::Scalar},
-	{TEXT("opacity"), EMaterialPropertyType::Scalar},
-	{TEXT("roughness"), EMaterialPropertyType::Scalar},
+	{L"metallic", EMaterialPropertyType::Scalar, TEXT("metallic")},
+	{L"opacity", EMaterialPropertyType::Scalar, TEXT("opacity")},
+	{L"roughness", EMaterialPropertyType::Scalar, TEXT("roughness")},
 
-	{TEXT("shader"), EMaterialPropertyType::String},
+	{L"shader", EMaterialPropertyType::String, TEXT("shader")},
 };
 // clang-format on
 
+/**
+ * \brief Filters the keys of PRT materials by their first character before comparing them to the supported keys. Most keys of a PRT
+ * material (bumpMap, specularColor, ...) are rejected without a single string comparison or allocation.
+ */
+class FMaterialKeyFilter
+{
+public:
+	FMaterialKeyFilter()
+	{
+		for (int32 KeyIndex = 0; KeyIndex < UE_ARRAY_COUNT(MaterialKeys); ++KeyIndex)
+		{
+			const uint32 FirstChar = static_cast<uint32>(MaterialKeys[KeyIndex].Key[0]);
+			check(FirstChar < 128);
+			KeysByFirstChar[FirstChar].Add(KeyIndex);
+		}
+	}
+
+	/**
+	 * \return the supported material key matching Key or nullptr if the key is ignored
+	 */
+	const FMaterialKey* Find(const wchar_t* Key) const
+	{
+		const uint32 FirstChar = static_cast<uint32>(Key[0]);
+		if (FirstChar >= 128)
+		{
+			return nullptr;
+		}
+
+		for (const int32 KeyIndex : KeysByFirstChar[FirstChar])
+		{
+			if (std::wcscmp(Key, MaterialKeys[KeyIndex].Key) == 0)
+			{
+				return &MaterialKeys[KeyIndex];
+			}
+		}
+		return nullptr;
+	}
+
+private:
+	TArray<int32, TInlineAllocator<4>> KeysByFirstChar[128];
+};
+
+const FMaterialKeyFilter MaterialKeyFilter;
+
 FString FirstValidTextureUri(const prt::AttributeMap* MaterialAttributes, wchar_t const* Key)
 {
 	size_t ValuesCount = 0;
@@ -91,6 +146,129 @@ FLinearColor GetLinearColor(const prt::AttributeMap* MaterialAttributes, wchar_t
 	return FLinearColor(Color);
 }
 
+void HashString(FXxHash64Builder& Builder, const FString& Value)
+{
+	const int32 Len = Value.Len();
+	Builder.Update(&Len, sizeof(Len));
+	Builder.Update(*Value, Len * sizeof(TCHAR));
+}
+
+void HashValue(FXxHash64Builder& Builder, const FString& Value)
+{
+	HashString(Builder, Value);
+}
+
+template <typename T>
+void HashValue(FXxHash64Builder& Builder, const T& Value)
+{
+	Builder.Update(&Value, sizeof(T));
+}
+
+/**
+ * Hashes the entries sorted by key, so that the hash does not depend on the insertion order.
+ */
+template <typename V>
+void HashMap(FXxHash64Builder& Builder, const TMap<FString, V>& Map)
+{
+	TArray<const TPair<FString, V>*> Entries;
+	Entries.Reserve(Map.Num());
+	for (const TPair<FString, V>& Entry : Map)
+	{
+		Entries.Add(&Entry);
+	}
+	Entries.Sort([](const TPair<FString, V>& A, const TPair<FString, V>& B) { return A.Key < B.Key; });
+
+	HashValue(Builder, Entries.Num());
+	for (const TPair<FString, V>* Entry : Entries)
+	{
+		HashString(Builder, Entry->Key);
+		HashValue(Builder, Entry->Value);
+	}
+}
+
+/**
+ * The material table is emptied once it holds this many materials, see EmptyMaterialTable.
+ */
+constexpr int32 MaxInternedMaterials = 1 << 16;
+
+/**
+ * Assigns stable ids to unique materials. Materials with the same hash are compared by their properties, so hash collisions do not merge
+ * different materials. Ids are never reused, not even after the table has been emptied.
+ */
+class FMaterialTable
+{
+public:
+	int32 Intern(const Vitruvio::FMaterialAttributeContainer& Material, uint64 Hash)
+	{
+		{
+			FReadScopeLock ReadLock(Lock);
+			const int32 Id = Find(Material, Hash);
+			if (Id != INDEX_NONE)
+			{
+				return Id;
+			}
+		}
+
+		FWriteScopeLock WriteLock(Lock);
+		int32 Id = Find(Material, Hash);
+		if (Id == INDEX_NONE)
+		{
+			if (Materials.Num() >= MaxInternedMaterials)
+			{
+				EmptyLocked();
+			}
+
+			Id = FirstId + Materials.Add(Material);
+			IdsByHash.Add(Hash, Id);
+		}
+		return Id;
+	}
+
+	int32 Num()
+	{
+		FReadScopeLock ReadLock(Lock);
+		return Materials.Num();
+	}
+
+	void Empty()
+	{
+		FWriteScopeLock WriteLock(Lock);
+		EmptyLocked();
+	}
+
+private:
+	int32 Find(const Vitruvio::FMaterialAttributeContainer& Material, uint64 Hash) const
+	{
+		for (auto It = IdsByHash.CreateConstKeyIterator(Hash); It; ++It)
+		{
+			if (Materials[It.Value() - FirstId].HasEqualProperties(Material))
+			{
+				return It.Value();
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	void EmptyLocked()
+	{
+		FirstId += Materials.Num();
+		Materials.Empty();
+		IdsByHash.Empty();
+	}
+
+	FRWLock Lock;
+	/** The id of the first material, increased by the number of removed materials whenever the table is emptied. */
+	int32 FirstId = 0;
+	TArray<Vitruvio::FMaterialAttributeContainer> Materials;
+	TMultiMap<uint64, int32> IdsByHash;
+};
+
+FMaterialTable& GetMaterialTable()
+{
+	static FMaterialTable MaterialTable;
+	return MaterialTable;
+}
+
 } // namespace
 
 namespace Vitruvio
@@ -102,14 +280,14 @@ FMaterialAttributeContainer::FMaterialAttributeContainer(const prt::AttributeMap
 	for (size_t KeyIndex = 0; KeyIndex < KeyCount; KeyIndex++)
 	{
 		const wchar_t* Key = Keys[KeyIndex];
-		const FString KeyString(Key);
-
-		if (!KeyToTypeMap.Contains(KeyString))
+		const FMaterialKey* MaterialKey = MaterialKeyFilter.Find(Key);
+		if (!MaterialKey)
 		{
 			continue;
 		}
-		const EMaterialPropertyType Type = KeyToTypeMap[KeyString];
-		switch (Type)
+
+		const FString& KeyString = MaterialKey->Name;
+		switch (MaterialKey->Type)
 		{
 		case EMaterialPropertyType::Texture:
 			if (KeyString.Equals(TEXT("diffuseMap")))
@@ -160,20 +338,49 @@ FMaterialAttributeContainer::FMaterialAttributeContainer(const prt::AttributeMap
 	}
 }
 
+void FMaterialAttributeContainer::Intern()
+{
+	Id = INDEX_NONE;
+	Hash = ComputeHash();
+	Id = GetMaterialTable().Intern(*this, Hash);
+}
+
+uint64 FMaterialAttributeContainer::ComputeHash() const
+{
+	FXxHash64Builder Builder;
+	HashMap(Builder, TextureProperties);
+	HashMap(Builder, ColorProperties);
+	HashMap(Builder, ScalarProperties);
+	HashMap(Builder, StringProperties);
+	HashString(Builder, BlendMode);
+	return Builder.Finalize().Hash;
+}
+
 uint32 GetTypeHash(const FMaterialAttributeContainer& Object)
 {
-	uint32 Hash = 0x274110C5;
-	Hash = HashCombine(Hash, GetMapHash<FString, FString>(Object.TextureProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, FLinearColor>(Object.ColorProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, double>(Object.ScalarProperties));
-	Hash = HashCombine(Hash, GetMapHash<FString, FString>(Object.StringProperties));
-	Hash = HashCombine(Hash, GetTypeHash(Object.BlendMode));
-	return Hash;
+	// Equal materials have equal hashes whether they are interned or not
+	const uint64 Hash = Object.Id != INDEX_NONE ? Object.Hash : Object.ComputeHash();
+	return static_cast<uint32>(Hash ^ (Hash >> 32));
 }
 
 uint32 GetTypeHash(const FInstanceCacheKey& Object)
 {
-	return HashCombine(GetTypeHash(Object.MeshId), GetArrayHash(Object.MaterialOverrides));
+	uint32 Hash = GetTypeHash(Object.MeshId);
+	for (const FMaterialAttributeContainer& MaterialOverride : Object.MaterialOverrides)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(MaterialOverride));
+	}
+	return Hash;
+}
+
+int32 GetNumInternedMaterials()
+{
+	return GetMaterialTable().Num();
+}
+
+void EmptyMaterialTable()
+{
+	GetMaterialTable().Empty();
 }
 
 } // namespace Vitruvio
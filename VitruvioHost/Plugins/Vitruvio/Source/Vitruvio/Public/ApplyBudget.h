@@ -0,0 +1,166 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/**
+ * \brief The steps in which a generate result is applied on the game thread.
+ */
+enum class EApplyStep : uint8
+{
+	MeshBuild,
+	Materials,
+	Components,
+	Instances,
+	Physics,
+	Num
+};
+
+/**
+ * \brief The number of instances of a component which have been kept, updated in place, added and removed when applying a new generate
+ * result to it.
+ */
+struct FInstanceDiff
+{
+	int64 Kept = 0;
+	int64 Updated = 0;
+	int64 Added = 0;
+	int64 Removed = 0;
+};
+
+struct FApplyStats
+{
+	static constexpr int32 NumFrameTimeBins = 6;
+
+	/** Upper bounds in ms of the frame time histogram bins. The last bin is unbounded. */
+	static constexpr double FrameTimeBinBounds[NumFrameTimeBins - 1] = {1, 2, 4, 8, 16};
+
+	/** The number of frames by the total time spent applying generate results in that frame. */
+	int64 FrameTimeHistogram[NumFrameTimeBins] = {};
+
+	/** Accumulated time and number of executed units per apply step. */
+	double StepTimeMs[static_cast<int32>(EApplyStep::Num)] = {};
+	int64 StepCount[static_cast<int32>(EApplyStep::Num)] = {};
+
+	/** The number of generate results which are queued or currently being applied. */
+	int32 Backlog = 0;
+
+	/** Time the game thread waited for textures to be decoded while creating materials. */
+	double MaterialBlockedTimeMs = 0;
+	int64 MaterialBlockedCount = 0;
+
+	/** Accumulated instance changes of all applied generate results. */
+	FInstanceDiff InstanceDiff;
+};
+
+/**
+ * \brief Per frame time budget for applying generate results on the game thread.
+ *
+ * Applying a generate result is split into small units (a single mesh build, the materials of a single instance, a single component, ...)
+ * which are executed as long as the time spent applying generate results in the current frame is below the budget. The budget is shared by
+ * all batch actors and components of a frame. Every caller may execute at least one unit per frame, so results never starve.
+ */
+class FApplyBudget
+{
+public:
+	/**
+	 * \brief Marks a generate result as queued for as long as it is referenced.
+	 */
+	class FBacklogEntry
+	{
+	public:
+		explicit FBacklogEntry(FThreadSafeCounter& Backlog) : Backlog(Backlog)
+		{
+			Backlog.Increment();
+		}
+
+		~FBacklogEntry()
+		{
+			Backlog.Decrement();
+		}
+
+	private:
+		FThreadSafeCounter& Backlog;
+	};
+
+	/**
+	 * \brief Measures a single unit of work and adds its cost to the current frame.
+	 */
+	class FStepScope
+	{
+	public:
+		FStepScope(FApplyBudget& Budget, EApplyStep Step) : Budget(Budget), Step(Step), StartTime(FPlatformTime::Seconds()) {}
+
+		~FStepScope()
+		{
+			Budget.AddStepTime(Step, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		}
+
+	private:
+		FApplyBudget& Budget;
+		EApplyStep Step;
+		double StartTime;
+	};
+
+	/**
+	 * \return whether there is time left in the current frame for the given budget. A budget of 0 or less is unlimited.
+	 */
+	VITRUVIO_API bool HasTimeLeft(double BudgetMs);
+
+	/**
+	 * \brief Creates an entry which counts towards the backlog until it is destroyed. May be called from any thread.
+	 */
+	VITRUVIO_API TSharedPtr<FBacklogEntry> CreateBacklogEntry();
+
+	/**
+	 * \brief The budget used by batch actors and components which do not override it.
+	 */
+	void SetDefaultBudgetMs(double BudgetMs)
+	{
+		DefaultBudgetMs = BudgetMs;
+	}
+
+	double GetDefaultBudgetMs() const
+	{
+		return DefaultBudgetMs;
+	}
+
+	VITRUVIO_API FApplyStats GetStats() const;
+
+	/**
+	 * \brief Records time the game thread was blocked waiting for textures while creating a material.
+	 */
+	void AddMaterialBlockedTime(double TimeMs);
+
+	/**
+	 * \brief Records the instance changes of a component.
+	 */
+	void AddInstanceDiff(const FInstanceDiff& InstanceDiff);
+
+private:
+	void AddStepTime(EApplyStep Step, double TimeMs);
+	void UpdateFrame();
+
+	double DefaultBudgetMs = 5.0;
+
+	uint64 CurrentFrame = 0;
+	double CurrentFrameTimeMs = 0;
+
+	FApplyStats Stats;
+	FThreadSafeCounter Backlog;
+};
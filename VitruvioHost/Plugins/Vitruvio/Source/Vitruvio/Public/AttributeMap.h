@@ -16,6 +16,7 @@
 #pragma once
 
 #include "RuleAttributes.h"
+#include "RuleInfo.h"
 
 #include "PRTTypes.h"
 
@@ -24,12 +25,12 @@ class VITRUVIO_API FAttributeMap
 public:
 	FAttributeMap() {}
 
-	FAttributeMap(AttributeMapUPtr AttributeMap, const RuleFileInfoPtr& RuleInfo) : AttributeMap(std::move(AttributeMap)), RuleInfo(RuleInfo) {}
+	FAttributeMap(AttributeMapUPtr AttributeMap, const FRuleInfoPtr& RuleInfo) : AttributeMap(std::move(AttributeMap)), RuleInfo(RuleInfo) {}
 
 	void UpdateUnrealAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, UObject* const Outer);
 
 	const AttributeMapUPtr AttributeMap;
-	const RuleFileInfoPtr RuleInfo;
+	const FRuleInfoPtr RuleInfo;
 };
 
 using FAttributeMapPtr = TSharedPtr<FAttributeMap>;
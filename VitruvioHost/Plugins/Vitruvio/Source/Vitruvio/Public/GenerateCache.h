@@ -0,0 +1,117 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Containers/List.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Hash/xxhash.h"
+#include "Templates/Atomic.h"
+
+struct FInitialShape;
+struct FGenerateResultDescription;
+
+struct FGenerateCacheStats
+{
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+	int64 NumEvictions = 0;
+	int32 NumEntries = 0;
+	int64 MemoryUsage = 0;
+	int64 MemoryBudget = 0;
+};
+
+/**
+ * \brief Content addressed cache of generate results.
+ *
+ * Results are keyed by a hash over everything which influences the generated model (initial shape geometry, rule package, user set
+ * attributes and random seed). Once the estimated memory usage exceeds the budget, the least recently used results are evicted.
+ */
+class FGenerateCache
+{
+public:
+	/**
+	 * \brief Computes the key of a single initial shape generate call. The position of the initial shape is not part of the key since the
+	 * result of a single generate call is relative to it.
+	 */
+	static VITRUVIO_API FXxHash128 ComputeKey(const FInitialShape& InitialShape);
+
+	/**
+	 * \brief Computes the key of the result of a single initial shape generated as part of a batch with per initial shape output. Such
+	 * results are relative to the initial shape position, so duplicated initial shapes share their entry independent of their position.
+	 */
+	static VITRUVIO_API FXxHash128 ComputeInitialShapeKey(const FInitialShape& InitialShape);
+
+	/**
+	 * \brief Computes the key of a batch generate call. Batch results are in world space, so the initial shape positions are part of the key.
+	 * Only used for batches which cannot be cached per initial shape (see ComputeInitialShapeKey).
+	 */
+	static VITRUVIO_API FXxHash128 ComputeBatchKey(const TArray<FInitialShape>& InitialShapes, bool bEnableOcclusionQueries,
+												   const TArray<FInitialShape>& OccluderOnlyShapes, bool bGeneratePerInitialShape);
+
+	/**
+	 * \brief Computes the key of the occluder of an initial shape. Occluders are in world space, so the position is part of the key.
+	 */
+	static VITRUVIO_API FXxHash128 ComputeOccluderKey(const FInitialShape& InitialShape);
+
+	/**
+	 * \return the cached result for the given key or nullptr if it is not cached.
+	 */
+	VITRUVIO_API TSharedPtr<const FGenerateResultDescription> Find(const FXxHash128& Key);
+
+	/**
+	 * \brief Caches the given result and evicts the least recently used results if the memory budget is exceeded.
+	 */
+	VITRUVIO_API void Add(const FXxHash128& Key, const FGenerateResultDescription& Result);
+
+	VITRUVIO_API void Empty();
+
+	/**
+	 * \brief Sets the memory budget in bytes. A budget of 0 disables caching.
+	 */
+	VITRUVIO_API void SetMemoryBudget(int64 NewMemoryBudget);
+
+	bool IsEnabled() const
+	{
+		return MemoryBudget > 0;
+	}
+
+	VITRUVIO_API FGenerateCacheStats GetStats() const;
+
+private:
+	using FLruList = TDoubleLinkedList<FXxHash128>;
+
+	struct FEntry
+	{
+		TSharedPtr<const FGenerateResultDescription> Result;
+		int64 Size = 0;
+		FLruList::TDoubleLinkedListNode* LruNode = nullptr;
+	};
+
+	void EvictToBudget();
+
+	mutable FCriticalSection CacheLock;
+	TMap<FXxHash128, FEntry> Entries;
+
+	/** Most recently used keys at the head. */
+	FLruList LruList;
+
+	int64 MemoryUsage = 0;
+	TAtomic<int64> MemoryBudget = 0;
+
+	FThreadSafeCounter64 NumHits;
+	FThreadSafeCounter64 NumMisses;
+	FThreadSafeCounter64 NumEvictions;
+};
@@ -0,0 +1,172 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "HAL/Event.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/Atomic.h"
+#include "Templates/Function.h"
+
+enum class EGeneratePriority : uint8
+{
+	/** Interactive requests (eg. a single edited component) which should be processed before any batched work. */
+	High,
+	Normal
+};
+
+struct FGenerateSchedulerStats
+{
+	int32 NumWorkers = 0;
+	int32 NumActiveWorkers = 0;
+	int32 QueueDepth = 0;
+	int32 HighPriorityQueueDepth = 0;
+	int32 MaxQueueDepth = 0;
+	/** Tasks submitted from the game thread while the queue was full, they are moved to the queue as soon as there is room. */
+	int32 OverflowQueueDepth = 0;
+	int64 NumCompletedTasks = 0;
+	double AverageWaitTimeMs = 0;
+	double MaxWaitTimeMs = 0;
+	/** Wait time percentiles, approximated by the upper bound of the matching histogram bucket. */
+	double P50WaitTimeMs = 0;
+	double P95WaitTimeMs = 0;
+	double P99WaitTimeMs = 0;
+};
+
+/**
+ * \brief Fixed size pool of worker threads which executes all PRT calls of the VitruvioModule.
+ *
+ * Submitted tasks are queued in a high and a normal priority lane and processed in FIFO order within each lane. High priority tasks are
+ * preferred, but after a burst of consecutive high priority tasks one normal priority task is processed so that a steady stream of
+ * interactive requests cannot starve batched work. The total number of
+ * queued tasks is bounded, submitting to a full queue blocks the caller until a worker has dequeued a task. The game thread never blocks,
+ * its tasks are parked in an unbounded overflow queue instead and moved to the queue whenever a worker dequeues a task.
+ */
+class FGenerateScheduler
+{
+public:
+	static constexpr int32 DefaultHighPriorityBurst = 8;
+
+	~FGenerateScheduler();
+
+	/**
+	 * \brief Starts the worker threads. Does nothing if the scheduler is already running.
+	 *
+	 * \param NumWorkers the number of worker threads.
+	 * \param MaxQueueDepth the maximum number of queued tasks before Submit blocks (or overflows on the game thread).
+	 * \param HighPriorityBurst the maximum number of consecutive high priority tasks while normal priority tasks are waiting, 0 to always
+	 * process high priority tasks first.
+	 */
+	VITRUVIO_API void Start(int32 NumWorkers, int32 MaxQueueDepth, int32 HighPriorityBurst = DefaultHighPriorityBurst);
+
+	/**
+	 * \brief Executes all remaining queued tasks and stops the worker threads. Tasks submitted after stopping are executed on the calling thread.
+	 */
+	VITRUVIO_API void Stop();
+
+	/**
+	 * \brief Queues the given function for execution on a worker thread.
+	 *
+	 * \return a future which holds the result of the function once it has been executed.
+	 */
+	template <typename FunctionType>
+	auto Submit(EGeneratePriority Priority, FunctionType&& Function) -> TFuture<decltype(Function())>
+	{
+		using ResultType = decltype(Function());
+
+		TPromise<ResultType> Promise;
+		TFuture<ResultType> Future = Promise.GetFuture();
+
+		Enqueue(Priority, [Promise = MoveTemp(Promise), Function = Forward<FunctionType>(Function)]() mutable {
+			Promise.SetValue(Function());
+		});
+
+		return Future;
+	}
+
+	/**
+	 * \return the number of worker threads.
+	 */
+	int32 GetNumWorkers() const
+	{
+		return Workers.Num();
+	}
+
+	/**
+	 * \return true if called from one of the worker threads of this scheduler.
+	 */
+	VITRUVIO_API bool IsWorkerThread() const;
+
+	VITRUVIO_API FGenerateSchedulerStats GetStats() const;
+
+private:
+	struct FTask
+	{
+		TUniqueFunction<void()> Function;
+		double EnqueueTime = 0;
+	};
+
+	class FWorker : public FRunnable
+	{
+	public:
+		explicit FWorker(FGenerateScheduler& Scheduler) : Scheduler(Scheduler) {}
+
+		uint32 Run() override;
+
+	private:
+		FGenerateScheduler& Scheduler;
+	};
+
+	/** Wait time histogram bucket i counts the wait times in [2^(i-1), 2^i) microseconds, the last bucket everything above. */
+	static constexpr int32 NumWaitTimeBuckets = 32;
+
+	VITRUVIO_API void Enqueue(EGeneratePriority Priority, TUniqueFunction<void()> Function);
+	void EnqueueLocked(EGeneratePriority Priority, FTask&& Task);
+	bool TryDequeue(FTask& OutTask);
+	void Execute(FTask& Task);
+	double GetWaitTimePercentileMs(double Percentile) const;
+
+	mutable FCriticalSection QueueLock;
+	TQueue<FTask> HighPriorityQueue;
+	TQueue<FTask> NormalPriorityQueue;
+	TQueue<TPair<EGeneratePriority, FTask>> OverflowQueue;
+	int32 NumHighPriorityTasks = 0;
+	int32 NumNormalPriorityTasks = 0;
+	int32 NumOverflowTasks = 0;
+	int32 MaxQueueDepth = 0;
+	int32 HighPriorityBurst = 0;
+	int32 NumConsecutiveHighPriorityTasks = 0;
+
+	FEvent* WorkAvailableEvent = nullptr;
+	FEvent* SpaceAvailableEvent = nullptr;
+
+	TArray<TUniquePtr<FWorker>> Workers;
+	TArray<TUniquePtr<FRunnableThread>> Threads;
+	TSet<uint32> WorkerThreadIds;
+
+	FThreadSafeBool bRunning = false;
+	FThreadSafeBool bStopping = false;
+
+	FThreadSafeCounter NumActiveWorkers;
+	FThreadSafeCounter64 NumCompletedTasks;
+	FThreadSafeCounter64 TotalWaitTimeUs;
+	TAtomic<int64> MaxWaitTimeUs = 0;
+	FThreadSafeCounter64 WaitTimeHistogram[NumWaitTimeBuckets];
+};
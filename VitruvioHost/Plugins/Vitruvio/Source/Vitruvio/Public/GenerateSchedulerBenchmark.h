@@ -0,0 +1,45 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FGenerateSchedulerBenchmarkResult
+{
+	/** The maximum number of consecutive high priority tasks while normal priority tasks are waiting, 0 for strict priority. */
+	int32 HighPriorityBurst = 0;
+
+	int32 NumTasks = 0;
+
+	/** Time from submitting the first task until all tasks have been executed. */
+	double WallTimeMs = 0;
+
+	/** Queue wait times of the high priority (interactive) tasks. */
+	double HighPriorityAverageWaitMs = 0;
+	double HighPriorityMaxWaitMs = 0;
+
+	/** Queue wait times of the normal priority (batched) tasks. */
+	double NormalPriorityAverageWaitMs = 0;
+	double NormalPriorityMaxWaitMs = 0;
+};
+
+/**
+ * \brief Submits NumTasks short tasks, four high priority tasks for every normal priority task, to a separate FGenerateScheduler with
+ * NumWorkers workers and measures the queue wait times per priority. Runs once with strict priority and once with the default high
+ * priority burst. Neither PRT nor the VitruvioModule scheduler are used.
+ */
+VITRUVIO_API TArray<FGenerateSchedulerBenchmarkResult> RunGenerateSchedulerBenchmark(int32 NumTasks, int32 NumWorkers);
@@ -17,6 +17,7 @@
 
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Interfaces/Interface_CollisionDataProvider.h"
+#include "VitruvioTypes.h"
 
 #include "GeneratedModelHISMComponent.generated.h"
 
@@ -36,6 +37,34 @@ public:
 		MeshIdentifier = NewMeshIdentifier;
 	}
 
+	/**
+	 * \return the instance this component holds the transforms of. Empty for instance replacements and pooled components.
+	 */
+	const Vitruvio::FInstanceCacheKey& GetInstanceKey() const
+	{
+		return InstanceKey;
+	}
+
+	void SetInstanceKey(const Vitruvio::FInstanceCacheKey& NewInstanceKey)
+	{
+		InstanceKey = NewInstanceKey;
+	}
+
+	/**
+	 * \return whether this component has no instances and is kept to be reused by a later generate result.
+	 */
+	bool IsPooled() const
+	{
+		return bPooled;
+	}
+
+	void SetPooled(bool bNewPooled)
+	{
+		bPooled = bNewPooled;
+	}
+
 private:
 	FString MeshIdentifier;
+	Vitruvio::FInstanceCacheKey InstanceKey;
+	bool bPooled = false;
 };
\ No newline at end of file
@@ -97,6 +97,12 @@ struct VITRUVIO_API FInitialShapePolygon
 
 	void FixOrientation();
 
+	/**
+	 * \brief Whether the polygon can be used as initial shape: it has at least one face with an area (three or more distinct vertices) and
+	 * all faces and holes reference existing vertices with finite coordinates.
+	 */
+	bool HasValidGeometry() const;
+
 	friend bool operator==(const FInitialShapePolygon& Lhs, const FInitialShapePolygon& RHS)
 	{
 		return Lhs.Faces == RHS.Faces && Lhs.Vertices == RHS.Vertices && Lhs.TextureCoordinateSets == RHS.TextureCoordinateSets;
@@ -192,6 +198,10 @@ public:
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
 
+	/** Vertices of the static mesh which are closer than this on every axis are merged when creating the initial shape polygon. */
+	UPROPERTY(EditAnywhere, Category = "Vitruvio", AdvancedDisplay, Meta = (ClampMin = 0))
+	double VertexWeldTolerance = UE_KINDA_SMALL_NUMBER;
+
 #if WITH_EDITORONLY_DATA
 	UPROPERTY(EditAnywhere, Category = "Vitruvio")
 	TSoftObjectPtr<UStaticMesh> InitialShapeMesh;
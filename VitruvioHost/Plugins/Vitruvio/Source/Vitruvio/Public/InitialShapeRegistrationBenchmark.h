@@ -0,0 +1,47 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FInitialShapeRegistrationBenchmarkResult
+{
+	/** The number of registered shapes, 0 if the world has no batch subsystem. */
+	int32 NumShapes = 0;
+
+	/** Time to check the validity of all shapes by triangulating a mesh description, as initial shapes used to. */
+	double MeshDescriptionValidityMs = 0;
+
+	/** Time to check the validity of all shapes directly (see FInitialShapePolygon::HasValidGeometry). */
+	double ValidityMs = 0;
+
+	/** Time to set the polygons of all initial shapes and register their components with the batch subsystem. */
+	double RegisterMs = 0;
+
+	/** Time to set the unchanged polygons of all initial shapes again, as on property changes which do not affect the geometry. */
+	double UnchangedPolygonMs = 0;
+
+	/** Whether both validity checks agree for all shapes. */
+	bool bEquivalent = false;
+};
+
+/**
+ * \brief Registers NumShapes batch generated components with quad lots, every tenth of which is degenerate, in the batch subsystem of
+ * World. The components are not registered with the world, so only setting the initial shape polygons and the batch registration itself
+ * are measured.
+ */
+VITRUVIO_API FInitialShapeRegistrationBenchmarkResult RunInitialShapeRegistrationBenchmark(UWorld* World, int32 NumShapes);
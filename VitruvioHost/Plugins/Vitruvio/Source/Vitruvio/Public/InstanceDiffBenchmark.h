@@ -0,0 +1,43 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "ApplyBudget.h"
+#include "CoreMinimal.h"
+
+struct FInstanceDiffBenchmarkResult
+{
+	/** The attribute of the synthetic building which has been changed (floors, floorHeight). */
+	FString Scenario;
+
+	int32 NumInstances = 0;
+
+	/** Time to apply the changed instances by destroying the previous component and creating a new one. */
+	double RecreateMs = 0;
+
+	/** Time to apply the changed instances by diffing them against the previous component (see UpdateInstances). */
+	double DiffMs = 0;
+
+	FInstanceDiff Diff;
+};
+
+/**
+ * \brief Changes a single attribute of a synthetic building facade with NumInstances window instances and measures applying the changed
+ * instances to a registered HISM component, once by recreating the component and once by diffing. The engine cube is used as instance
+ * mesh so that physics bodies are created as for generated instances.
+ */
+VITRUVIO_API TArray<FInstanceDiffBenchmarkResult> RunInstanceDiffBenchmark(UWorld* World, int32 NumInstances);
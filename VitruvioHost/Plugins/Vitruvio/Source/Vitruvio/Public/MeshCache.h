@@ -16,15 +16,163 @@
 #pragma once
 #include "VitruvioMesh.h"
 
+#include "Containers/List.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/Atomic.h"
+
+#include <string>
+#include <vector>
+
+/** Interned mesh identifier. The lower bits select the shard of the cache. */
+using FMeshHandle = uint32;
+
+struct FMeshCacheStats
+{
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+	int64 NumEvictions = 0;
+	int32 NumEntries = 0;
+	int64 MemoryUsage = 0;
+	int64 MemoryBudget = 0;
+
+	/** Prototypes which the encoder did not serialize because they were already cached, and their estimated size. */
+	int64 NumSkippedPrototypes = 0;
+	int64 SkippedPrototypeBytes = 0;
+};
+
+/** The identifiers of the cached meshes in the form they are passed to the encoder (see UNREAL_GEOMETRY_ENCODER_CACHED_MESH_IDS). */
+struct FCachedMeshIds
+{
+	std::vector<std::wstring> Ids;
+	std::vector<const wchar_t*> IdPtrs;
+};
+
+/**
+ * \brief Cache of instance meshes by their PRT mesh identifier.
+ *
+ * Identifiers are interned into integer handles so that lookups do not compare strings. The cache is split into shards by handle, each
+ * with its own lock and least recently used list. Once the estimated memory usage of a shard exceeds its share of the budget, the least
+ * recently used meshes which are no longer referenced outside of the cache are evicted. Meshes in use are never evicted, and no meshes are
+ * evicted while the cache is pinned by a generate call (see FPin). Meshes which were still in use are evicted by the next Trim once they
+ * have been released.
+ */
 class FMeshCache
 {
 public:
-	VITRUVIO_API TSharedPtr<FVitruvioMesh> Get(const FString& Uri);
-	VITRUVIO_API TSharedPtr<FVitruvioMesh> InsertOrGet(const FString& Uri, const TSharedPtr<FVitruvioMesh>& Mesh);
+	/**
+	 * \brief Keeps all cached meshes from being evicted while alive so that the meshes announced to the encoder by their ids can still be
+	 * resolved by handle when the encoder reuses them. Evictions which were held back are done once the last pin is released.
+	 */
+	class FPin
+	{
+	public:
+		VITRUVIO_API explicit FPin(FMeshCache& MeshCache);
+		VITRUVIO_API ~FPin();
+
+		UE_NONCOPYABLE(FPin)
+
+		/**
+		 * \return the ids of the meshes which were cached when the pin was created.
+		 */
+		const FCachedMeshIds& GetCachedMeshIds() const
+		{
+			return *CachedMeshIds;
+		}
+
+	private:
+		FMeshCache& MeshCache;
+		TSharedPtr<const FCachedMeshIds> CachedMeshIds;
+	};
+
+	/**
+	 * \return the handle of the given mesh identifier. The handles of identifiers without a cached mesh are released on eviction, Empty and
+	 * Trim. Handles are never reused, so a released handle does not refer to another mesh, Get just misses.
+	 */
+	VITRUVIO_API FMeshHandle GetHandle(const FString& Uri);
+
+	VITRUVIO_API TSharedPtr<FVitruvioMesh> Get(FMeshHandle Handle);
+
+	/**
+	 * \brief Inserts the mesh under the handle of its identifier. If the handle has been released in the meantime, the identifier is interned
+	 * again.
+	 */
+	VITRUVIO_API TSharedPtr<FVitruvioMesh> InsertOrGet(FMeshHandle Handle, const TSharedPtr<FVitruvioMesh>& Mesh);
 	VITRUVIO_API void Empty();
 
+	/**
+	 * \brief Evicts unreferenced meshes until the cache is within its budget, unless it is pinned, and releases handles of identifiers
+	 * without a cached mesh. Called periodically since meshes which are in use while the cache is over its budget can only be evicted
+	 * after they have been released.
+	 */
+	VITRUVIO_API void Trim();
+
+	/**
+	 * \brief Counts a prototype of the given size which the encoder did not serialize because it was already cached.
+	 */
+	VITRUVIO_API void AddSkippedBytes(int64 Bytes);
+
+	/**
+	 * \brief Sets the memory budget in bytes. With a budget of 0 meshes are only shared while they are in use.
+	 */
+	VITRUVIO_API void SetMemoryBudget(int64 NewMemoryBudget);
+
+	VITRUVIO_API FMeshCacheStats GetStats() const;
+
 private:
-	FCriticalSection MeshCacheCriticalSection;
+	static constexpr uint32 NumShardBits = 4;
+	static constexpr uint32 NumShards = 1 << NumShardBits;
 
-	TMap<FString, TSharedPtr<FVitruvioMesh>> Cache;
-};
+	using FLruList = TDoubleLinkedList<FMeshHandle>;
+
+	struct FEntry
+	{
+		TSharedPtr<FVitruvioMesh> Mesh;
+		int64 Size = 0;
+		FLruList::TDoubleLinkedListNode* LruNode = nullptr;
+	};
+
+	struct FShard
+	{
+		mutable FCriticalSection Lock;
+
+		TMap<FString, FMeshHandle> Handles;
+		TMap<FMeshHandle, FEntry> Entries;
+
+		/** The index of the next handle of this shard. */
+		uint32 NextHandleIndex = 0;
+
+		/** Most recently used handles at the head. */
+		FLruList LruList;
+
+		int64 MemoryUsage = 0;
+	};
+
+	static uint32 GetShardIndex(FMeshHandle Handle)
+	{
+		return Handle & (NumShards - 1);
+	}
+
+	/**
+	 * Removes unreferenced meshes until the shard is within its share of the budget, unless the cache is pinned. Evicted meshes are returned
+	 * to be destroyed outside of the lock.
+	 */
+	void EvictToBudget(FShard& Shard, TArray<TSharedPtr<FVitruvioMesh>>& OutEvicted);
+
+	FShard Shards[NumShards];
+
+	/** Guards the cached mesh ids and the pins. Acquired after a shard lock. */
+	FCriticalSection CachedMeshIdsLock;
+	/** Ids of the cached meshes, updated on insertion and eviction. */
+	TMap<FMeshHandle, std::wstring> CachedMeshIdsByHandle;
+	/** Snapshot of CachedMeshIdsByHandle shared by pins, recreated only after the cached meshes have changed. */
+	TSharedPtr<const FCachedMeshIds> CachedMeshIdsSnapshot;
+	int32 NumPins = 0;
+
+	TAtomic<int64> MemoryBudget = 512 * 1024 * 1024;
+
+	FThreadSafeCounter64 NumHits;
+	FThreadSafeCounter64 NumMisses;
+	FThreadSafeCounter64 NumEvictions;
+	FThreadSafeCounter64 NumSkippedPrototypes;
+	FThreadSafeCounter64 SkippedPrototypeBytes;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FMeshTransferBenchmarkResult
+{
+	int64 NumTriangles = 0;
+
+	/** Bytes passed across the encoder callback boundary per mesh format. */
+	int64 BytesV1 = 0;
+	int64 BytesV2 = 0;
+
+	/** Time spent converting the mesh into a FMeshDescription per mesh format. */
+	double ConvertSecondsV1 = 0;
+	double ConvertSecondsV2 = 0;
+};
+
+/**
+ * \brief Passes the same synthetic grid mesh to UnrealCallbacks::addMesh (double arrays with per attribute indices) and
+ * UnrealCallbacks::addMeshV2 (float arrays with a shared index buffer) and measures the transferred bytes and conversion times.
+ *
+ * PRT has to be initialized since the meshes reference (empty) PRT materials.
+ */
+VITRUVIO_API FMeshTransferBenchmarkResult RunMeshTransferBenchmark(int32 NumTriangles);
@@ -0,0 +1,53 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FNeighborQueryBenchmarkResult
+{
+	int32 NumShapes = 0;
+
+	/** The average number of neighbors found per query. */
+	double AverageNeighbors = 0;
+
+	/** Time to insert the bounds of all shapes into the neighbor index. */
+	double BuildMs = 0;
+
+	/** Time to query the neighbors of every shape. */
+	double QueryMs = 0;
+
+	/** Time to move every shape by half a lot, as when dragging a selection of actors. */
+	double MoveMs = 0;
+
+	/** Time to remove all shapes from the neighbor index. */
+	double RemoveMs = 0;
+
+	/** Average time per query of the neighbor index and of a linear search over all shapes. */
+	double QueryUs = 0;
+	double LinearQueryUs = 0;
+
+	/** Whether the neighbor index finds the same neighbors as the linear search. */
+	bool bEquivalent = false;
+};
+
+/**
+ * \brief Measures building, querying and updating the neighbor index of the batch subsystem (see Vitruvio::TLooseQuadtree) with the
+ * bounds of NumShapes lots on a grid, querying the inter-occlusion neighbors of every lot at the default query distance. A sample of the
+ * queries is checked against a linear search over all lots, which is also timed for comparison.
+ */
+VITRUVIO_API FNeighborQueryBenchmarkResult RunNeighborQueryBenchmark(int32 NumShapes);
@@ -0,0 +1,136 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "prt/OcclusionSet.h"
+
+#include "HAL/ThreadSafeCounter64.h"
+#include "Hash/xxhash.h"
+#include "Templates/Atomic.h"
+
+#include <memory>
+
+struct FOcclusionStats
+{
+	int32 NumHandles = 0;
+	int64 NumReusedHandles = 0;
+	int64 NumGeneratedHandles = 0;
+
+	/** Accumulated time spent waiting on occlusion locks. */
+	double LockWaitTimeMs = 0;
+};
+
+/**
+ * \brief Cache of occlusion handles by initial shape index.
+ *
+ * Handles are reference counted per generate call and reused as long as the occluder key (geometry, position, rule package and attributes)
+ * of the initial shape is unchanged. Only inserting and removing handles is synchronized, using a lock per shard of initial shape indices,
+ * so concurrent generate calls do not serialize on the occlusion set. Invalidated handles which are still in use are disposed once their last
+ * user releases them.
+ */
+class FOcclusionHandleCache
+{
+	struct FShard;
+
+public:
+	/**
+	 * \brief The handles acquired by a single generate call. Releases all acquired handles on destruction.
+	 */
+	class FScope
+	{
+	public:
+		FScope(FScope&&) = default;
+		FScope(const FScope&) = delete;
+		FScope& operator=(const FScope&) = delete;
+		VITRUVIO_API ~FScope();
+
+		/**
+		 * \brief Acquires the cached handle of the given initial shape if its occluder key is unchanged.
+		 * \return true if a handle was acquired, false if the occluder has to be generated and added using Add.
+		 */
+		VITRUVIO_API bool Acquire(int64 InitialShapeIndex, const FXxHash128& Key);
+
+		/**
+		 * \brief Adds a newly generated handle to the cache and acquires it for this scope.
+		 */
+		VITRUVIO_API void Add(int64 InitialShapeIndex, const FXxHash128& Key, prt::OcclusionSet::Handle Handle);
+
+		/**
+		 * \return the handle acquired for the given initial shape index.
+		 */
+		prt::OcclusionSet::Handle GetHandle(int64 InitialShapeIndex) const
+		{
+			return Handles.FindChecked(InitialShapeIndex);
+		}
+
+		prt::OcclusionSet* GetOcclusionSet() const
+		{
+			return OcclusionSet.get();
+		}
+
+	private:
+		friend class FOcclusionHandleCache;
+
+		FScope(FOcclusionHandleCache& Cache, std::shared_ptr<prt::OcclusionSet> OcclusionSet, uint32 Generation)
+			: Cache(Cache), OcclusionSet(MoveTemp(OcclusionSet)), Generation(Generation)
+		{
+		}
+
+		FOcclusionHandleCache& Cache;
+		std::shared_ptr<prt::OcclusionSet> OcclusionSet;
+		uint32 Generation;
+
+		TMap<int64, prt::OcclusionSet::Handle> Handles;
+	};
+
+	VITRUVIO_API FOcclusionHandleCache();
+	VITRUVIO_API ~FOcclusionHandleCache();
+
+	/**
+	 * \brief Starts a new generate call which uses the current occlusion set.
+	 */
+	VITRUVIO_API FScope BeginScope();
+
+	/**
+	 * \brief Removes the handles of the given initial shapes. Handles which are still in use are disposed once they are released.
+	 */
+	VITRUVIO_API void Invalidate(const TArray<int64>& InitialShapeIndices);
+
+	/**
+	 * \brief Removes all handles and replaces the occlusion set. Scopes which are still running keep using the previous occlusion set.
+	 */
+	VITRUVIO_API void Reset();
+
+	VITRUVIO_API FOcclusionStats GetStats() const;
+
+private:
+	static constexpr int32 NumShards = 16;
+
+	FShard& GetShard(int64 InitialShapeIndex) const;
+	void Release(const FScope& Scope);
+
+	TArray<TUniquePtr<FShard>> Shards;
+
+	mutable FCriticalSection OcclusionSetLock;
+	std::shared_ptr<prt::OcclusionSet> OcclusionSet;
+
+	/** Incremented on every reset. Handles of scopes from a previous generation belong to a previous occlusion set. */
+	TAtomic<uint32> Generation = 0;
+
+	FThreadSafeCounter64 NumReusedHandles;
+	FThreadSafeCounter64 NumGeneratedHandles;
+	mutable FThreadSafeCounter64 LockWaitTimeUs;
+};
@@ -0,0 +1,41 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FPolygonWindingBenchmarkResult
+{
+	/** The number of triangle edges of the synthetic footprint. */
+	int32 NumEdges = 0;
+
+	int32 NumFaces = 0;
+	int32 NumHoles = 0;
+
+	/** Time to extract the faces and holes from the triangles (see Vitruvio::GetPolygon). */
+	double GetPolygonMs = 0;
+
+	/** Whether the faces and holes match the construction of the synthetic footprint. */
+	bool bValid = false;
+};
+
+/**
+ * \brief Extracts the faces and holes of a synthetic triangulated footprint with about NumEdges edges and checks them against its
+ * construction. The footprint is a single connected grid with holes. Some holes contain islands, some islands have a hole with another
+ * island in it, and some triangles are degenerate.
+ */
+VITRUVIO_API FPolygonWindingBenchmarkResult RunPolygonWindingBenchmark(int32 NumEdges);
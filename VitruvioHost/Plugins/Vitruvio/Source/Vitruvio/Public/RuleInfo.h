@@ -0,0 +1,57 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "PRTTypes.h"
+
+/**
+ * \brief Value independent information about a rule attribute, parsed once from the RuleFileInfo and its annotations.
+ */
+struct FRuleAttributeInfo
+{
+	/** Owned by the RuleFileInfo of the FRuleInfo this attribute belongs to. */
+	const prt::RuleFileInfo::Entry* Entry = nullptr;
+
+	FString Name;
+	FString DisplayName;
+	FString ImportPath;
+
+	TArray<FString> Groups;
+	int Order = INT32_MAX;
+	int GroupOrder = INT32_MAX;
+	int ImportOrder = INT32_MAX;
+
+	bool bHidden = false;
+};
+
+/**
+ * \brief Information about the rule file of a rule package which is shared by all generate and attribute evaluation calls.
+ */
+struct FRuleInfo
+{
+	RuleFileInfoPtr RuleFileInfo;
+
+	FString RuleFile;
+	FString StartRule;
+
+	/** All attributes with the default style and without parameters, sorted by their display order. */
+	TArray<FRuleAttributeInfo> Attributes;
+
+	/** The index into Attributes by attribute name. */
+	TMap<FString, int32> AttributeIndices;
+};
+
+using FRuleInfoPtr = TSharedPtr<const FRuleInfo>;
@@ -0,0 +1,149 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Containers/List.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/Atomic.h"
+#include "UObject/GCObject.h"
+
+struct FTextureCacheStats
+{
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+	int64 NumEvictions = 0;
+
+	/** Decoded textures which were dropped because a texture with identical content was already cached. */
+	int64 NumDeduplicated = 0;
+
+	/** Cached textures which were reloaded because their file changed. */
+	int64 NumChanged = 0;
+
+	int32 NumTextures = 0;
+	int32 NumPaths = 0;
+	int64 MemoryUsage = 0;
+	int64 MemoryBudget = 0;
+	uint32 Generation = 0;
+};
+
+/**
+ * \brief Thread-safe cache of decoded textures by their path.
+ *
+ * Textures are stored by content hash (see FTextureData::ContentHash), so identical images referenced by different paths share a single
+ * texture. Paths and textures are split into shards with their own lock and least recently used list. The budget applies to all shards
+ * together: once the memory usage exceeds it, the least recently used textures over all shards are dropped from the cache. The most
+ * recently added texture is always kept, even if it exceeds the budget on its own. Textures still used by materials stay alive until the
+ * materials are destroyed.
+ *
+ * Files are not checked for changes on every lookup. Instead, a path is checked once per generation: the first lookup after Invalidate
+ * compares the file time stamp against the time the texture was loaded.
+ */
+class FTextureCache
+{
+public:
+	/**
+	 * \return whether a texture for Path is cached and its file has not changed since it was loaded.
+	 */
+	VITRUVIO_API bool Find(const FString& Path, Vitruvio::FTextureData& OutTextureData);
+
+	/**
+	 * \brief Adds a decoded texture for Path. If a texture with the same content is already cached, the given one is dropped.
+	 * \return the cached texture
+	 */
+	VITRUVIO_API Vitruvio::FTextureData InsertOrGet(const FString& Path, const Vitruvio::FTextureData& TextureData);
+
+	/**
+	 * \brief Starts a new generation. Every cached path is checked for changes once on its next lookup.
+	 */
+	VITRUVIO_API void Invalidate();
+
+	VITRUVIO_API void Empty();
+
+	/**
+	 * \brief Sets the memory budget in bytes. With a budget of 0 only the most recently added texture is kept.
+	 */
+	VITRUVIO_API void SetMemoryBudget(int64 NewMemoryBudget);
+
+	VITRUVIO_API FTextureCacheStats GetStats() const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	static constexpr uint32 NumShardBits = 4;
+	static constexpr uint32 NumShards = 1 << NumShardBits;
+
+	using FLruList = TDoubleLinkedList<uint64>;
+
+	struct FPathEntry
+	{
+		uint64 ContentHash = 0;
+		FDateTime LoadTime;
+
+		/** The generation in which the file has last been checked for changes. */
+		uint32 Generation = 0;
+	};
+
+	struct FTextureEntry
+	{
+		Vitruvio::FTextureData TextureData;
+		FLruList::TDoubleLinkedListNode* LruNode = nullptr;
+
+		/** Value of UseClock when the texture was last used, orders the least recently used textures of different shards. */
+		uint64 LastUse = 0;
+	};
+
+	struct FShard
+	{
+		mutable FCriticalSection Lock;
+
+		/** Paths by the hash of the path, textures by the content hash. A lookup never holds the locks of two shards at the same time. */
+		TMap<FString, FPathEntry> Paths;
+		TMap<uint64, FTextureEntry> Textures;
+
+		/** Most recently used content hashes at the head. */
+		FLruList LruList;
+	};
+
+	FShard& GetShard(uint32 Hash)
+	{
+		return Shards[Hash & (NumShards - 1)];
+	}
+
+	void Touch(FShard& Shard, FTextureEntry& Entry);
+
+	/**
+	 * \brief Evicts the least recently used textures of all shards until the memory usage is within the budget. Must be called without
+	 * holding a shard lock.
+	 * \param KeepContentHash the texture which is never evicted, usually the one which has just been added
+	 */
+	void EvictToBudget(TOptional<uint64> KeepContentHash);
+
+	FShard Shards[NumShards];
+
+	TAtomic<int64> MemoryBudget = 1024 * 1024 * 1024;
+	TAtomic<int64> MemoryUsage = 0;
+	TAtomic<uint64> UseClock = 0;
+	TAtomic<uint32> Generation = 0;
+
+	FThreadSafeCounter64 NumHits;
+	FThreadSafeCounter64 NumMisses;
+	FThreadSafeCounter64 NumEvictions;
+	FThreadSafeCounter64 NumDeduplicated;
+	FThreadSafeCounter64 NumChanged;
+};
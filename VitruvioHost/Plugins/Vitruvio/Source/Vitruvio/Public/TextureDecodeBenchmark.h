@@ -0,0 +1,40 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FTextureDecodeBenchmarkResult
+{
+	/** The PRT pixel format (GREY8, RGB8, ...). */
+	FString Format;
+
+	/** Megapixels per second converted into the first mip. */
+	double ConvertMegapixelsPerSecond = 0;
+
+	/** Megapixels of the first mip per second for which the remaining mip chain has been generated. */
+	double MipChainMegapixelsPerSecond = 0;
+
+	/** Megapixels per second classified as opaque, masked or translucent opacity map (0 for formats which are never classified). */
+	double OpacityMegapixelsPerSecond = 0;
+};
+
+/**
+ * \brief Measures the pixel conversion, mip generation and opacity classification of texture decoding for all PRT pixel formats on a
+ * synthetic Size x Size texture. Neither PRT nor a texture object is needed, so this also runs headless on build machines.
+ */
+VITRUVIO_API TArray<FTextureDecodeBenchmarkResult> RunTextureDecodeBenchmark(int32 Size);
@@ -17,10 +17,13 @@
 
 #include "PRTTypes.h"
 #include "RuleAttributes.h"
+#include "RuleInfo.h"
 
 namespace Vitruvio
 {
-void UpdateAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, const AttributeMapUPtr& AttributeMap, const RuleFileInfoPtr& RuleInfo,
+FRuleInfoPtr CreateRuleInfo(const RuleFileInfoPtr& RuleFileInfo, const std::wstring& RuleFile);
+
+void UpdateAttributeMap(TMap<FString, URuleAttribute*>& AttributeMapOut, const AttributeMapUPtr& AttributeMap, const FRuleInfo& RuleInfo,
 						UObject* const Outer);
 
 AttributeMapUPtr CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes);
@@ -0,0 +1,259 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Vitruvio
+{
+
+/**
+ * \brief Dynamic loose quadtree over 2D bounds.
+ *
+ * Every node covers twice the area of its quadrant so that an element can be stored in the smallest node whose size is at least its extent,
+ * only depending on its center. This makes insertion and removal O(log N) and radius queries O(log N + k). The root grows towards elements
+ * which are inserted outside of it, so the tree does not need to know the world bounds upfront. Nodes which become empty are pruned and
+ * reused by later insertions.
+ */
+template <typename ElementType>
+class TLooseQuadtree
+{
+	struct FNodeElement
+	{
+		ElementType Element;
+		FBox2D Bounds;
+	};
+
+	struct FNode
+	{
+		FVector2D Center;
+		double HalfSize;
+		int32 Parent = INDEX_NONE;
+		int32 Children[4] = {INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE};
+		TArray<FNodeElement> Elements;
+
+		FNode(const FVector2D& Center, double HalfSize) : Center(Center), HalfSize(HalfSize) {}
+
+		FBox2D GetLooseBounds() const
+		{
+			return FBox2D(Center - 2.0 * HalfSize, Center + 2.0 * HalfSize);
+		}
+
+		bool ContainsCenter(const FVector2D& Point) const
+		{
+			return Point.X >= Center.X - HalfSize && Point.X < Center.X + HalfSize && Point.Y >= Center.Y - HalfSize && Point.Y < Center.Y + HalfSize;
+		}
+
+		int32 GetQuadrant(const FVector2D& Point) const
+		{
+			return (Point.X >= Center.X ? 1 : 0) | (Point.Y >= Center.Y ? 2 : 0);
+		}
+
+		bool IsEmpty() const
+		{
+			return Elements.IsEmpty() && Children[0] == INDEX_NONE && Children[1] == INDEX_NONE && Children[2] == INDEX_NONE &&
+				   Children[3] == INDEX_NONE;
+		}
+	};
+
+public:
+	/**
+	 * \param MinNodeSize the size of the smallest nodes. Elements smaller than this are all stored in nodes of this size.
+	 */
+	explicit TLooseQuadtree(double MinNodeSize = 1000.0) : MinHalfSize(MinNodeSize / 2.0) {}
+
+	/**
+	 * \brief Inserts the element or moves it if it has already been added with different bounds.
+	 */
+	void Update(const ElementType& Element, const FBox2D& Bounds)
+	{
+		if (const int32* NodeIndex = NodeByElement.Find(Element))
+		{
+			const FNodeElement* NodeElement = Nodes[*NodeIndex].Elements.FindByPredicate([&Element](const FNodeElement& Candidate) {
+				return Candidate.Element == Element;
+			});
+			if (NodeElement && NodeElement->Bounds == Bounds)
+			{
+				return;
+			}
+			Remove(Element);
+		}
+
+		const FVector2D Center = Bounds.GetCenter();
+		const double Extent = Bounds.GetExtent().GetMax();
+
+		if (Root == INDEX_NONE)
+		{
+			double HalfSize = MinHalfSize;
+			while (HalfSize < Extent)
+			{
+				HalfSize *= 2.0;
+			}
+			Root = AddNode(Center, HalfSize);
+		}
+
+		// Grow the root until it contains the center of the element and is large enough for its extent
+		while (!Nodes[Root].ContainsCenter(Center) || Nodes[Root].HalfSize < Extent)
+		{
+			const FNode& OldRoot = Nodes[Root];
+			const FVector2D Direction(Center.X >= OldRoot.Center.X ? 1.0 : -1.0, Center.Y >= OldRoot.Center.Y ? 1.0 : -1.0);
+			const int32 NewRoot = AddNode(OldRoot.Center + Direction * OldRoot.HalfSize, OldRoot.HalfSize * 2.0);
+			Nodes[NewRoot].Children[Nodes[NewRoot].GetQuadrant(Nodes[Root].Center)] = Root;
+			Nodes[Root].Parent = NewRoot;
+			Root = NewRoot;
+		}
+
+		// Descend to the smallest node which can hold the element
+		int32 NodeIndex = Root;
+		while (Nodes[NodeIndex].HalfSize * 0.5 >= FMath::Max(Extent, MinHalfSize))
+		{
+			const int32 Quadrant = Nodes[NodeIndex].GetQuadrant(Center);
+			int32 ChildIndex = Nodes[NodeIndex].Children[Quadrant];
+			if (ChildIndex == INDEX_NONE)
+			{
+				const double ChildHalfSize = Nodes[NodeIndex].HalfSize * 0.5;
+				const FVector2D Offset((Quadrant & 1) ? ChildHalfSize : -ChildHalfSize, (Quadrant & 2) ? ChildHalfSize : -ChildHalfSize);
+				ChildIndex = AddNode(Nodes[NodeIndex].Center + Offset, ChildHalfSize);
+				Nodes[ChildIndex].Parent = NodeIndex;
+				Nodes[NodeIndex].Children[Quadrant] = ChildIndex;
+			}
+			NodeIndex = ChildIndex;
+		}
+
+		Nodes[NodeIndex].Elements.Add({Element, Bounds});
+		NodeByElement.Add(Element, NodeIndex);
+	}
+
+	void Remove(const ElementType& Element)
+	{
+		int32 NodeIndex;
+		if (!NodeByElement.RemoveAndCopyValue(Element, NodeIndex))
+		{
+			return;
+		}
+
+		Nodes[NodeIndex].Elements.RemoveAllSwap([&Element](const FNodeElement& Candidate) { return Candidate.Element == Element; },
+											   EAllowShrinking::No);
+
+		if (NodeByElement.IsEmpty())
+		{
+			Empty();
+			return;
+		}
+
+		// Prune the leaves which became empty, so that queries do not keep visiting them
+		while (NodeIndex != Root && Nodes[NodeIndex].IsEmpty())
+		{
+			const int32 ParentIndex = Nodes[NodeIndex].Parent;
+			for (int32& ChildIndex : Nodes[ParentIndex].Children)
+			{
+				if (ChildIndex == NodeIndex)
+				{
+					ChildIndex = INDEX_NONE;
+				}
+			}
+			FreeNode(NodeIndex);
+			NodeIndex = ParentIndex;
+		}
+	}
+
+	bool Contains(const ElementType& Element) const
+	{
+		return NodeByElement.Contains(Element);
+	}
+
+	int32 Num() const
+	{
+		return NodeByElement.Num();
+	}
+
+	void Empty()
+	{
+		Nodes.Empty();
+		FreeNodes.Empty();
+		NodeByElement.Empty();
+		Root = INDEX_NONE;
+	}
+
+	/**
+	 * \brief Calls Visitor for every element whose bounds are closer than Radius to Position.
+	 */
+	template <typename VisitorType>
+	void ForEachInRadius(const FVector2D& Position, double Radius, VisitorType Visitor) const
+	{
+		if (Root == INDEX_NONE)
+		{
+			return;
+		}
+
+		const FBox2D QueryBounds(Position - Radius, Position + Radius);
+		const double RadiusSquared = Radius * Radius;
+
+		TArray<int32, TInlineAllocator<64>> Stack;
+		Stack.Add(Root);
+		while (!Stack.IsEmpty())
+		{
+			const FNode& Node = Nodes[Stack.Pop(EAllowShrinking::No)];
+			if (!Node.GetLooseBounds().Intersect(QueryBounds))
+			{
+				continue;
+			}
+
+			for (const FNodeElement& NodeElement : Node.Elements)
+			{
+				if (NodeElement.Bounds.ComputeSquaredDistanceToPoint(Position) < RadiusSquared)
+				{
+					Visitor(NodeElement.Element);
+				}
+			}
+
+			for (const int32 ChildIndex : Node.Children)
+			{
+				if (ChildIndex != INDEX_NONE)
+				{
+					Stack.Add(ChildIndex);
+				}
+			}
+		}
+	}
+
+private:
+	int32 AddNode(const FVector2D& Center, double HalfSize)
+	{
+		if (FreeNodes.IsEmpty())
+		{
+			return Nodes.Emplace(Center, HalfSize);
+		}
+
+		const int32 NodeIndex = FreeNodes.Pop(EAllowShrinking::No);
+		Nodes[NodeIndex] = FNode(Center, HalfSize);
+		return NodeIndex;
+	}
+
+	void FreeNode(int32 NodeIndex)
+	{
+		Nodes[NodeIndex] = FNode(FVector2D::ZeroVector, 0.0);
+		FreeNodes.Add(NodeIndex);
+	}
+
+	double MinHalfSize;
+	int32 Root = INDEX_NONE;
+	TArray<FNode> Nodes;
+	TArray<int32> FreeNodes;
+	TMap<ElementType, int32> NodeByElement;
+};
+
+} // namespace Vitruvio
@@ -0,0 +1,40 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FVertexWeldBenchmarkResult
+{
+	int32 NumVertices = 0;
+	int32 NumWeldedVertices = 0;
+
+	/** Time to weld the vertices with the spatial hash (see Vitruvio::WeldVertices). */
+	double WeldMs = 0;
+
+	/** Time to weld the vertices with a linear search over the welded vertices per vertex, as initial shapes used to. */
+	double ReferenceMs = 0;
+
+	/** Whether both welds produced the same vertices and indices. */
+	bool bEquivalent = false;
+};
+
+/**
+ * \brief Welds a synthetic static mesh footprint with NumVertices vertices, in which every position is shared by the vertices of four
+ * quads with jitter in the order of the weld tolerance, and compares the result and time against the linear search reference.
+ */
+VITRUVIO_API FVertexWeldBenchmarkResult RunVertexWeldBenchmark(int32 NumVertices);
@@ -23,6 +23,8 @@
 
 #include "VitruvioBatchActor.generated.h"
 
+class UVitruvioBatchSubsystem;
+
 UCLASS()
 class UTile : public UObject
 {
@@ -96,7 +98,7 @@ struct FGrid
 	void UnmarkAllForGenerate();
 	void UnmarkAllForAttributeEvaluation();
 
-	TArray<FInitialShape> GetNeighboringShapes(const UTile* Tile, const TArray<FInitialShape>& Initial);
+	TArray<FInitialShape> GetNeighboringShapes(const UTile* Tile, const TArray<FInitialShape>& InitialShapes, const UVitruvioBatchSubsystem& Subsystem) const;
 };
 
 struct FBatchGenerateQueueItem
@@ -104,6 +106,7 @@ struct FBatchGenerateQueueItem
 	FGenerateResultDescription GenerateResultDescription;
 	UTile* Tile;
 	TArray<UVitruvioComponent*> VitruvioComponents;
+	TSharedPtr<FApplyBudget::FBacklogEntry> BacklogEntry;
 };
 
 struct FEvaluateAttributesQueueItem
@@ -125,6 +128,10 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Vitruvio")
 	bool bEnableOcclusionQueries = false;
 
+	/** Maximum time in ms spent per frame on applying generated models. 0 uses the budget of Esri.Vitruvio.ApplyBudgetMs. */
+	UPROPERTY(EditAnywhere, Category = "Vitruvio", meta = (ClampMin = "0", Units = "ms"))
+	float ApplyBudgetMs = 0.0f;
+
 #if WITH_EDITORONLY_DATA
 	UPROPERTY(EditAnywhere, Category = "Vitruvio")
 	bool bDebugVisualizeGrid = false;
@@ -137,6 +144,10 @@ private:
 	TQueue<FBatchGenerateQueueItem> GenerateQueue;
 	TQueue<FEvaluateAttributesQueueItem> AttributeEvaluationQueue;
 
+	/** The generate result which is currently being applied, possibly over multiple frames. */
+	FBatchGenerateQueueItem ApplyItem;
+	TUniquePtr<FGenerateApplyState> ApplyState;
+
 	UPROPERTY(Transient)
 	TMap<UMaterialInterface*, FString> MaterialIdentifiers;
 	TMap<FString, int32> UniqueMaterialIdentifiers;
@@ -208,6 +219,13 @@ private:
 	void ProcessGenerateQueue();
 	void ProcessAttributeEvaluationQueue();
 
+	/**
+	 * \brief Executes the next unit of work of the generate result which is currently being applied.
+	 * \return true if the generate result has been fully applied.
+	 */
+	bool ApplyNextStep();
+	void FinishApply();
+
 	FCriticalSection ProcessGenerateQueueCriticalSection;
 	FCriticalSection ProcessAttributeEvaluationQueueCriticalSection;
 
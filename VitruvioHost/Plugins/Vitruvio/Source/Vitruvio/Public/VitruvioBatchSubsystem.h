@@ -16,6 +16,7 @@
 #pragma once
 
 #include "VitruvioBatchActor.h"
+#include "Util/LooseQuadtree.h"
 #include "Runtime/Engine/Public/Subsystems/WorldSubsystem.h"
 
 #include "VitruvioBatchSubsystem.generated.h"
@@ -44,6 +45,23 @@ public:
 	AVitruvioBatchActor* GetBatchActor();
 	bool HasRegisteredVitruvioComponents() const;
 
+	/** Adds or moves the initial shape of the given component in the neighbor index, or removes it if it has no valid initial shape. */
+	void UpdateNeighborIndex(UVitruvioComponent* VitruvioComponent);
+	void RemoveFromNeighborIndex(UVitruvioComponent* VitruvioComponent);
+
+	/** Calls Visitor for every indexed component whose initial shape bounds are closer than Radius to Position. */
+	template <typename VisitorType>
+	void ForEachNeighbor(const FVector& Position, double Radius, VisitorType Visitor) const
+	{
+		// Components which have been garbage collected without being removed are skipped
+		NeighborIndex.ForEachInRadius(FVector2D(Position), Radius, [&Visitor](const TWeakObjectPtr<UVitruvioComponent>& VitruvioComponent) {
+			if (UVitruvioComponent* Component = VitruvioComponent.Get())
+			{
+				Visitor(Component);
+			}
+		});
+	}
+
 	DECLARE_MULTICAST_DELEGATE(FOnComponentRegistered);
 	FOnComponentRegistered OnComponentRegistered;
 
@@ -58,6 +76,9 @@ private:
 	UPROPERTY()
 	TSet<UVitruvioComponent*> RegisteredComponents;
 
+	/** Initial shape bounds of all Vitruvio components in the world, used for inter-occlusion neighbor queries. */
+	Vitruvio::TLooseQuadtree<TWeakObjectPtr<UVitruvioComponent>> NeighborIndex;
+
 #if WITH_EDITORONLY_DATA
 	FDelegateHandle OnActorMoved;
 	FDelegateHandle OnActorsMoved;
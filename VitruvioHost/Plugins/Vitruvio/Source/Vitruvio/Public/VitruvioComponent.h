@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include "ApplyBudget.h"
 #include "RuleAttributes.h"
 #include "RulePackage.h"
 #include "VitruvioModule.h"
@@ -34,6 +35,10 @@ DECLARE_LOG_CATEGORY_EXTERN(LogVitruvioComponent, Log, All);
 class UGenerateCompletedCallbackProxy;
 
 extern TAutoConsoleVariable<float> CVarInterOcclusionNeighborQueryDistance;
+extern TAutoConsoleVariable<bool> CVarAsyncMeshBuild;
+extern TAutoConsoleVariable<bool> CVarAsyncTextureLoad;
+extern TAutoConsoleVariable<int32> CVarInstanceComponentPoolSize;
+extern TAutoConsoleVariable<bool> CVarBatchGeneratePerInitialShape;
 
 USTRUCT(BlueprintType)
 struct FGenerateOptions
@@ -58,6 +63,7 @@ struct FGenerateQueueItem
 	FGenerateResultDescription GenerateResultDescription;
 	FGenerateOptions GenerateOptions;
 	UGenerateCompletedCallbackProxy* CallbackProxy;
+	TSharedPtr<FApplyBudget::FBacklogEntry> BacklogEntry;
 };
 
 struct FInstance
@@ -66,6 +72,7 @@ struct FInstance
 	TSharedPtr<FVitruvioMesh> InstanceMesh;
 	TArray<UMaterialInstanceDynamic*> OverrideMaterials;
 	TArray<FTransform> Transforms;
+	Vitruvio::FInstanceCacheKey Key;
 
 	friend FORCEINLINE uint32 GetTypeHash(const FInstance& Request)
 	{
@@ -90,9 +97,122 @@ struct FConvertedGenerateResult
 	TMap<FString, FReport> Reports;
 };
 
-FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
+/**
+ * \brief Converts a generate result in small units of work so that it can be spread over multiple frames. Every step either builds a
+ * single mesh (including its materials) or creates the override materials of a single instance.
+ */
+class VITRUVIO_API FGenerateResultBuilder
+{
+public:
+	FGenerateResultBuilder(FGenerateResultDescription GenerateResult,
+						   TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+						   FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+						   TMap<FString, int32>& UniqueMaterialIdentifiers, UMaterial* OpaqueParent, UMaterial* MaskedParent,
+						   UMaterial* TranslucentParent, UWorld* World, bool bBuildMeshesAsync = false, bool bLoadTexturesAsync = false);
+
+	/**
+	 * \return whether all meshes and materials have been built.
+	 */
+	bool IsDone() const
+	{
+		return NextMesh >= Meshes.Num() && NextFinishedMesh >= Meshes.Num() && NextInstance >= Instances.Num();
+	}
+
+	/**
+	 * \return whether the next step can make progress. False if it would only wait for asynchronously built meshes or for textures which
+	 * are still being decoded.
+	 */
+	bool IsReady() const;
+
+	/**
+	 * \return the step the next unit of work belongs to, either EApplyStep::MeshBuild or EApplyStep::Materials.
+	 */
+	EApplyStep GetCurrentStep() const
+	{
+		return NextMesh < Meshes.Num() || NextFinishedMesh < Meshes.Num() ? EApplyStep::MeshBuild : EApplyStep::Materials;
+	}
+
+	/**
+	 * \brief Executes the next unit of work.
+	 */
+	void Step();
+
+	const FConvertedGenerateResult& GetResult() const
+	{
+		return Result;
+	}
+
+private:
+	FGenerateResultDescription GenerateResult;
+
+	TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache;
+	FTextureCache& TextureCache;
+	TMap<UMaterialInterface*, FString>& MaterialIdentifiers;
+	TMap<FString, int32>& UniqueMaterialIdentifiers;
+	UMaterial* OpaqueParent;
+	UMaterial* MaskedParent;
+	UMaterial* TranslucentParent;
+	UWorld* World;
+	bool bBuildMeshesAsync;
+
+	TArray<TPair<FString, TSharedPtr<FVitruvioMesh>>> Meshes;
+	TArray<TPair<Vitruvio::FInstanceCacheKey, TArray<FTransform>>> Instances;
+
+	/** Decodes the textures of all materials which are not cached yet. No material is created before these have completed. */
+	FGraphEventArray PendingTextureLoads;
+	/** The textures of all materials, decoded by PendingTextureLoads or taken from the cache. Kept alive until the builder is destroyed. */
+	Vitruvio::FPrefetchedTextures PrefetchedTextures;
+	int32 NextMesh = 0;
+	/** The first mesh which has not finished building yet. Materials are only converted once all meshes are built. */
+	int32 NextFinishedMesh = 0;
+	int32 NextInstance = 0;
+
+	FConvertedGenerateResult Result;
+};
+
+/**
+ * \brief Progress of applying a generate result to the generated model components, which may be spread over multiple frames.
+ */
+struct FGenerateApplyState
+{
+	/** The maximum number of instances added to a component in a single step. */
+	static constexpr int32 InstanceBatchSize = 1024;
+
+	TUniquePtr<FGenerateResultBuilder> Builder;
+
+	/** The current step once the builder is done. */
+	EApplyStep Step = EApplyStep::Components;
+
+	/** The next component or instance to process in the current step. */
+	int32 NextIndex = 0;
+	int32 NextTransformIndex = 0;
+
+	TWeakObjectPtr<UGeneratedModelStaticMeshComponent> ModelComponent;
+	TArray<TPair<TWeakObjectPtr<UGeneratedModelHISMComponent>, int32>> InstanceComponents;
+	TMap<FString, int32> NameMap;
+	TSet<FInstance> Replaced;
+
+	/** Instance components of the previous generate result which have not been reused yet. */
+	TMap<Vitruvio::FInstanceCacheKey, TWeakObjectPtr<UGeneratedModelHISMComponent>> ReusableComponents;
+	/** Empty instance components which can be reused for any instance. */
+	TArray<TWeakObjectPtr<UGeneratedModelHISMComponent>> PooledComponents;
+	/** The transforms which still have to be added to the current instance component. */
+	TArray<FTransform> AddedTransforms;
+
+	EApplyStep GetCurrentStep() const
+	{
+		return !Builder->IsDone() ? Builder->GetCurrentStep() : Step;
+	}
+
+	bool IsReady() const
+	{
+		return Builder->IsDone() || Builder->IsReady();
+	}
+};
+
+VITRUVIO_API FConvertedGenerateResult BuildGenerateResult(const FGenerateResultDescription& GenerateResult,
 									 TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-									 TMap<FString, Vitruvio::FTextureData>& TextureCache,
+									 FTextureCache& TextureCache,
 									 TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
 									 TMap<FString, int32>& UniqueMaterialIdentifiers,
 									 UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
@@ -106,6 +226,34 @@ void ApplyMaterialReplacements(UStaticMeshComponent* StaticMeshComponent, const
 TSet<FInstance> ApplyInstanceReplacements(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, 
 											  const TArray<FInstance>& Instances, UInstanceReplacementAsset* Replacement, TMap<FString, int32>& NameMap);
 
+/**
+ * \brief Collects the instance components of the model component so that they can be reused by the generate result which is about to be
+ * applied. Instance replacement components are destroyed since they are recreated anyway.
+ */
+void CollectInstanceComponents(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, FGenerateApplyState& State);
+
+/**
+ * \return the component of the previous generate result for the same instance, a pooled component or a new component. New components are
+ * attached to the model component but not registered yet.
+ */
+UGeneratedModelHISMComponent* AcquireInstanceComponent(UGeneratedModelStaticMeshComponent* GeneratedModelComponent, const FInstance& Instance,
+													   FGenerateApplyState& State);
+
+/**
+ * \brief Pools the instance components of the previous generate result which have not been reused, up to
+ * Esri.Vitruvio.InstanceComponentPoolSize pooled components per model component. The rest is destroyed.
+ */
+void ReleaseInstanceComponents(FGenerateApplyState& State);
+
+/**
+ * \brief Changes the instances of the component to Transforms with as few changes as possible. Instances whose transform is still used are
+ * kept, the remaining ones are updated in place in bulk and the surplus is removed in bulk. The order of instances is not preserved.
+ * Transforms which are left over have to be added by the caller and are returned in OutAddedTransforms, so that adding them can be spread
+ * over multiple frames.
+ */
+VITRUVIO_API FInstanceDiff UpdateInstances(UInstancedStaticMeshComponent* Component, const TArray<FTransform>& Transforms,
+										   TArray<FTransform>& OutAddedTransforms);
+
 void InitializeBodySetup(UBodySetup* BodySetup);
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
@@ -530,6 +678,10 @@ private:
 	TQueue<FGenerateQueueItem> GenerateQueue;
 	TQueue<FAttributesEvaluationQueueItem> AttributesEvaluationQueue;
 
+	/** The generate result which is currently being applied, possibly over multiple frames. */
+	FGenerateQueueItem ApplyItem;
+	TUniquePtr<FGenerateApplyState> ApplyState;
+
 	FGenerateResult::FTokenPtr GenerateToken;
 	FAttributeMapResult::FTokenPtr EvalAttributesInvalidationToken;
 
@@ -541,6 +693,12 @@ private:
 	TMap<FString, int32> UniqueMaterialIdentifiers;
 
 	TArray<FInitialShape> GetNeighboringShapes() const;
+
+	/** The owner's root component whose TransformUpdated keeps the neighbor index up to date, also for runtime moves. */
+	TWeakObjectPtr<USceneComponent> TransformUpdatedSource;
+	FDelegateHandle OnTransformUpdated;
+
+	void OnOwnerTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
 	
 	void CalculateRandomSeed();
 
@@ -549,6 +707,13 @@ private:
 	void ProcessGenerateQueue();
 	void ProcessAttributesEvaluationQueue();
 
+	/**
+	 * \brief Executes the next unit of work of the generate result which is currently being applied.
+	 * \return true if the generate result has been fully applied.
+	 */
+	bool ApplyNextStep();
+	void FinishApply();
+
 #if WITH_EDITOR
 	FDelegateHandle PropertyChangeDelegate;
 
@@ -17,17 +17,19 @@
 
 #include "CustomCollisionProvider.h"
 #include "MeshDescription.h"
+#include "TextureCache.h"
 #include "VitruvioTypes.h"
 #include "Runtime/PhysicsCore/Public/Interface_CollisionDataProviderCore.h"
 
 
 UMaterialInstanceDynamic* CacheMaterial(UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-										TMap<FString, Vitruvio::FTextureData>& TextureCache,
+										FTextureCache& TextureCache,
 										TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
 										const Vitruvio::FMaterialAttributeContainer& MaterialAttributes, TMap<FString, int32>& UniqueMaterialNames,
-										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer);
+										TMap<UMaterialInterface*, FString>& MaterialIdentifiers, UObject* Outer,
+										const Vitruvio::FPrefetchedTextures* PrefetchedTextures = nullptr);
 
-class FVitruvioMesh
+class VITRUVIO_API FVitruvioMesh
 {
 	FString Identifier;
 
@@ -37,6 +39,25 @@ class FVitruvioMesh
 	UStaticMesh* StaticMesh;
 	UCustomCollisionDataProvider* CollisionDataProvider;
 
+	struct FAsyncBuildState;
+	TSharedPtr<FAsyncBuildState> AsyncBuild;
+
+	/**
+	 * \brief Commits the render data of a finished asynchronous build to the static mesh and creates its collision, either cooked right
+	 * away or asynchronously.
+	 */
+	void ApplyRenderData(bool bCookCollisionAsync);
+
+	/**
+	 * \brief Adds the identifier of every material of the already created static mesh.
+	 */
+	void AddMaterialIdentifiers(TMap<UMaterialInterface*, FString>& MaterialIdentifiers) const;
+
+	void CreateStaticMesh(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+						  FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+						  TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+						  UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures);
+
 public:
 	FVitruvioMesh(const FString& Identifier, const FMeshDescription& MeshDescription,
 				  const TArray<Vitruvio::FMaterialAttributeContainer>& Materials)
@@ -51,6 +72,11 @@ public:
 		return Identifier;
 	}
 
+	const FMeshDescription& GetMeshDescription() const
+	{
+		return MeshDescription;
+	}
+
 	const TArray<Vitruvio::FMaterialAttributeContainer>& GetMaterials() const
 	{
 		return Materials;
@@ -61,8 +87,41 @@ public:
 		return StaticMesh;
 	}
 
+	/**
+	 * \return the estimated memory usage of the mesh description in bytes.
+	 */
+	int64 GetEstimatedSize() const;
+
 	void Build(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
-			   TMap<FString, Vitruvio::FTextureData>& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+			   FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
 			   TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
-			   UWorld* World);
+			   UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures = nullptr);
+
+	/**
+	 * \brief Creates the static mesh and its materials on the game thread and builds the render and collision data on a worker thread. The
+	 * worker thread only reads the mesh description, the render data is committed to the static mesh in TryFinishBuild.
+	 *
+	 * The static mesh may only be used once TryFinishBuild returned true.
+	 */
+	void BuildAsync(const FString& Name, TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>>& MaterialCache,
+					FTextureCache& TextureCache, TMap<UMaterialInterface*, FString>& MaterialIdentifiers,
+					TMap<FString, int32>& UniqueMaterialNames, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+					UWorld* World, const Vitruvio::FPrefetchedTextures* PrefetchedTextures = nullptr);
+
+	/**
+	 * \brief Applies the render data of a finished asynchronous build and starts cooking its collision. Never blocks.
+	 *
+	 * \return whether the static mesh is built and its collision is cooked.
+	 */
+	bool TryFinishBuild();
+
+	/**
+	 * \return whether an asynchronous build has been started and the mesh is not ready to be used yet.
+	 */
+	bool IsBuildPending() const;
+
+	/**
+	 * \return whether the worker thread of a pending build has finished and TryFinishBuild can apply its render data.
+	 */
+	bool IsRenderDataReady() const;
 };
@@ -15,17 +15,25 @@
 
 #pragma once
 
+#include "ApplyBudget.h"
 #include "AttributeMap.h"
+#include "GenerateCache.h"
+#include "GenerateScheduler.h"
 #include "InitialShape.h"
 #include "MeshCache.h"
+#include "TextureCache.h"
+#include "OcclusionHandleCache.h"
 #include "PRTTypes.h"
 #include "Report.h"
+#include "RuleInfo.h"
 #include "RulePackage.h"
 
 #include "prt/Object.h"
 
+#include "Containers/Ticker.h"
 #include "Engine/StaticMesh.h"
 #include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
 #include "HAL/ThreadSafeBool.h"
 #include "Modules/ModuleManager.h"
 
@@ -36,6 +44,14 @@
 #include <string>
 
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealPrt, Log, All);
+DECLARE_STATS_GROUP(TEXT("Vitruvio"), STATGROUP_Vitruvio, STATCAT_Advanced);
+
+struct FInitialShapeGenerateResult
+{
+	TSharedPtr<FVitruvioMesh> GeneratedModel;
+	Vitruvio::FInstanceMap Instances;
+	FAttributeMapPtr EvaluatedAttributes;
+};
 
 struct FGenerateResultDescription
 {
@@ -48,6 +64,32 @@ struct FGenerateResultDescription
 	TMap<FString, FReport> Reports;
 
 	TArray<FAttributeMapPtr> EvaluatedAttributes;
+
+	/**
+	 * The generated geometry per initial shape by FInitialShape::InitialShapeIndex, relative to the initial shape position. Only filled if the
+	 * models were generated per initial shape.
+	 */
+	TMap<int64, FInitialShapeGenerateResult> InitialShapeResults;
+};
+
+struct FRpkLoadStats
+{
+	int32 NumLoads = 0;
+	int32 NumUnpackCacheHits = 0;
+	int32 NumUnpackCacheMisses = 0;
+
+	/** Accumulated load time of rule packages which had to be written to the unpack cache first. */
+	double ColdLoadTimeMs = 0;
+	/** Accumulated load time of rule packages which were already in the unpack cache. */
+	double WarmLoadTimeMs = 0;
+};
+
+struct FRpkLoadCounters
+{
+	FThreadSafeCounter NumUnpackCacheHits;
+	FThreadSafeCounter NumUnpackCacheMisses;
+	FThreadSafeCounter64 ColdLoadTimeUs;
+	FThreadSafeCounter64 WarmLoadTimeUs;
 };
 
 class FInvalidationToken
@@ -131,9 +173,13 @@ public:
 	 * \param InitialShapes
 	 * \param bEnableOcclusionQueries
 	 * \param OccluderOnlyShapes
+	 * \param bGeneratePerInitialShape if true, the models are additionally returned per initial shape in InitialShapeResults, relative to the
+	 * initial shape position. The merged model is composed from them. Falls back to the merged model only if the UnrealGeometryEncoder does not
+	 * support per initial shape output.
 	 * \return the generated UStaticMesh.
 	 */
-	VITRUVIO_API FBatchGenerateResult BatchGenerateAsync(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes) const;
+	VITRUVIO_API FBatchGenerateResult BatchGenerateAsync(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+														 bool bGeneratePerInitialShape = false) const;
 
 	/**
 	 * \brief Generate the models with the given InitialShapes.
@@ -141,9 +187,13 @@ public:
 	 * \param InitialShapes
 	 * \param bEnableOcclusionQueries
 	 * \param OccluderOnlyShapes
+	 * \param bGeneratePerInitialShape if true, the models are additionally returned per initial shape in InitialShapeResults, relative to the
+	 * initial shape position. The merged model is composed from them. Falls back to the merged model only if the UnrealGeometryEncoder does not
+	 * support per initial shape output.
 	 * \return the generated UStaticMesh.
 	 */
-	VITRUVIO_API FGenerateResultDescription BatchGenerate(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes) const;
+	VITRUVIO_API FGenerateResultDescription BatchGenerate(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+														  bool bGeneratePerInitialShape = false) const;
 
 	/**
 	 * \brief Asynchronously Evaluates attributes for the given initial shapes and rule packages.
@@ -196,6 +246,12 @@ public:
 		return Initialized;
 	}
 
+	/**
+	 * \brief Initializes PRT if the module has been started without it, which is the case when running a commandlet.
+	 * \return whether PRT is initialized.
+	 */
+	VITRUVIO_API bool EnsureInitialized();
+
 	/**
 	 * \return true if currently at least one generate call ongoing.
 	 */
@@ -220,6 +276,97 @@ public:
 		return RpkLoadingTasksCounter.GetValue() > 0;
 	}
 
+	/**
+	 * \return the unpack cache hits and misses as well as the accumulated cold and warm load times of rule packages.
+	 */
+	VITRUVIO_API FRpkLoadStats GetRpkLoadStats() const;
+
+	/**
+	 * \brief Drops all loaded resolve maps so that rule packages are loaded again on their next use, as after restarting the editor. Must
+	 * not be called while rule packages are being loaded (see IsLoadingRpks).
+	 *
+	 * \param bEmptyUnpackCache whether to also delete the persistent unpack cache, so that rule packages are written and unpacked again.
+	 */
+	VITRUVIO_API void EmptyResolveMapCache(bool bEmptyUnpackCache);
+
+	/**
+	 * \return the number of cached occlusion handles, how often they were reused and the time spent waiting on occlusion locks.
+	 */
+	VITRUVIO_API FOcclusionStats GetOcclusionStats() const
+	{
+		return OcclusionHandleCache.GetStats();
+	}
+
+	/**
+	 * \return the current queue depth, wait times and worker utilization of the generate scheduler.
+	 */
+	VITRUVIO_API FGenerateSchedulerStats GetGenerateSchedulerStats() const
+	{
+		return GenerateScheduler.GetStats();
+	}
+
+	/**
+	 * \return the hit, miss and eviction counts as well as the memory usage of the generate cache.
+	 */
+	VITRUVIO_API FGenerateCacheStats GetGenerateCacheStats() const
+	{
+		return GenerateCache.GetStats();
+	}
+
+	/**
+	 * \return the hit, miss and eviction counts as well as the memory usage of the instance mesh cache.
+	 */
+	VITRUVIO_API FMeshCacheStats GetMeshCacheStats() const
+	{
+		return MeshCache.GetStats();
+	}
+
+	VITRUVIO_API FTextureCacheStats GetTextureCacheStats() const
+	{
+		return TextureCache.GetStats();
+	}
+
+	/**
+	 * \brief Checks every cached texture once for changes of its file on its next use.
+	 */
+	VITRUVIO_API void InvalidateTextureCache()
+	{
+		TextureCache.Invalidate();
+	}
+
+	/**
+	 * \returns the per frame budget for applying generate results on the game thread.
+	 */
+	VITRUVIO_API FApplyBudget& GetApplyBudget()
+	{
+		return ApplyBudget;
+	}
+
+	/**
+	 * \return the frame time histogram, the accumulated time per apply step and the number of generate results waiting to be applied.
+	 */
+	VITRUVIO_API FApplyStats GetApplyStats() const
+	{
+		return ApplyBudget.GetStats();
+	}
+
+	/**
+	 * \brief Removes all cached generate results.
+	 */
+	VITRUVIO_API void EmptyGenerateCache()
+	{
+		GenerateCache.Empty();
+	}
+
+	/**
+	 * \brief Removes all cached materials and empties the global material table (see Vitruvio::EmptyMaterialTable).
+	 */
+	VITRUVIO_API void EmptyMaterialCache()
+	{
+		MaterialCache.Empty();
+		Vitruvio::EmptyMaterialTable();
+	}
+
 	/**
 	 * \returns the cache used for materials generated by PRT.
 	 */
@@ -237,9 +384,9 @@ public:
 	}
 
 	/**
-	 * \returns the cache used for materials generated by PRT.
+	 * \returns the cache used for textures of materials generated by PRT.
 	 */
-	VITRUVIO_API TMap<FString, Vitruvio::FTextureData>& GetTextureCache()
+	VITRUVIO_API FTextureCache& GetTextureCache()
 	{
 		return TextureCache;
 	}
@@ -291,6 +438,7 @@ public:
 	{
 		Collector.AddReferencedObjects(MaterialCache);
 		Collector.AddReferencedObjects(RegisteredMeshes);
+		TextureCache.AddReferencedObjects(Collector);
 	}
 
 	FString GetReferencerName() const override
@@ -318,6 +466,7 @@ private:
 	TAtomic<bool> Initialized = false;
 
 	mutable TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr> ResolveMapCache;
+	mutable TMap<TLazyObjectPtr<URulePackage>, FRuleInfoPtr> RuleInfoCache;
 	mutable TMap<TLazyObjectPtr<URulePackage>, FGraphEventRef> ResolveMapEventGraphRefCache;
 
 	mutable FCriticalSection LoadResolveMapLock;
@@ -327,23 +476,70 @@ private:
 	mutable FThreadSafeCounter LoadAttributesCounter;
 
 	FString RpkFolder;
+	mutable FRpkLoadCounters RpkLoadCounters;
+
+	mutable FGenerateScheduler GenerateScheduler;
+	mutable FGenerateCache GenerateCache;
 
 	TMap<Vitruvio::FMaterialAttributeContainer, TObjectPtr<UMaterialInstanceDynamic>> MaterialCache;
-	TMap<FString, Vitruvio::FTextureData> TextureCache;
-	FMeshCache MeshCache;
+	FTextureCache TextureCache;
+	mutable FMeshCache MeshCache;
+	FTSTicker::FDelegateHandle MeshCacheTrimHandle;
 
-	mutable FCriticalSection OcclusionLock;
-	mutable TMap<int64, prt::OcclusionSet::Handle> OcclusionHandleCache;
+	mutable FOcclusionHandleCache OcclusionHandleCache;
 
-	mutable OcclusionSetUPtr OcclusionSet;
+	FApplyBudget ApplyBudget;
 
 	FCriticalSection RegisterMeshLock;
 	TSet<TObjectPtr<UStaticMesh>> RegisteredMeshes;
 
 	void NotifyGenerateCompleted() const;
+	int32 GetNumPrtWorkerThreads() const;
 
 	TFuture<ResolveMapSPtr> LoadResolveMapAsync(URulePackage* RulePackage) const;
+
+	/**
+	 * \brief Returns the rule file info, start rule and attribute infos of the given rule package, which are parsed only once per loaded
+	 * resolve map.
+	 */
+	FRuleInfoPtr GetRuleInfo(URulePackage* RulePackage, const ResolveMapSPtr& ResolveMap) const;
+
+	/**
+	 * \return whether the given resolve map is still the cached one of the rule package, ie. it has not been evicted by a reimport.
+	 * LoadResolveMapLock must be held.
+	 */
+	bool IsResolveMapCached(URulePackage* RulePackage, const ResolveMapSPtr& ResolveMap) const;
+
+	/**
+	 * \return whether all given resolve maps are still cached (see IsResolveMapCached). LoadResolveMapLock must be held.
+	 */
+	bool AreResolveMapsCached(const TMap<URulePackage*, ResolveMapSPtr>& ResolveMaps) const;
+
+	/**
+	 * \brief Generates the given initial shapes without looking up or adding to the generate cache.
+	 *
+	 * \param OutResult the generate result. Per initial shape results are not yet composed into the merged model.
+	 * \param OutResolveMaps the resolve maps used per rule package, to check whether the result may still be cached.
+	 * \return whether generate succeeded.
+	 */
+	bool GenerateBatch(TArray<FInitialShape> InitialShapes, bool bEnableOcclusionQueries, TArray<FInitialShape> OccluderOnlyShapes,
+					   bool bGeneratePerInitialShape, FGenerateResultDescription& OutResult, TMap<URulePackage*, ResolveMapSPtr>& OutResolveMaps) const;
+
+	/**
+	 * \brief Generates the given initial shapes per initial shape and caches the result of every initial shape separately so that unchanged or
+	 * duplicated initial shapes are reused independently of their position and the other initial shapes of the batch.
+	 */
+	FGenerateResultDescription BatchGeneratePerInitialShapeCached(TArray<FInitialShape> InitialShapes) const;
+
+	/**
+	 * \brief One-time setup of the module (log handler, caches, scheduler and console variable callbacks) followed by InitializePrtLibrary.
+	 */
 	void InitializePrt();
 
+	/**
+	 * \brief Loads the PRT library and calls prt::init. May be called again if initialization failed.
+	 */
+	void InitializePrtLibrary();
+
 	VITRUVIO_API void EvictFromResolveMapCache(URulePackage* RulePackage);
 };
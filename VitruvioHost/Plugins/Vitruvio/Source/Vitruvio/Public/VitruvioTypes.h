@@ -15,9 +15,11 @@
 
 #pragma once
 
+#include "Engine/Texture2D.h"
 #include "Interface_CollisionDataProviderCore.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
 
 #include "prt/AttributeMap.h"
 
@@ -92,19 +94,48 @@ struct FMaterialAttributeContainer
 	FString BlendMode;
 	FString Name; // ignored on purpose for hash and equality
 
+	/** Stable id in the global material table. Equal materials have equal ids. INDEX_NONE if not interned. */
+	int32 Id = INDEX_NONE;
+
+	/** Order independent 64 bit hash of the properties. Only set if interned. */
+	uint64 Hash = 0;
+
+	/** A material without any properties which uses the default parent material. */
+	FMaterialAttributeContainer() = default;
+
+	/**
+	 * Reads the material properties from the given attribute map. Call Intern once all properties are set.
+	 */
 	explicit FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap);
 
-	friend bool operator==(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
+	/**
+	 * Computes the hash and looks up the id of this material in the global material table, adding it if it is new. Comparing and hashing
+	 * interned materials does not touch the properties. Must be called again after the properties have been modified.
+	 */
+	void Intern();
+
+	uint64 ComputeHash() const;
+
+	bool HasEqualProperties(const FMaterialAttributeContainer& Other) const
 	{
 		// clang-format off
-		return Lhs.TextureProperties.OrderIndependentCompareEqual(RHS.TextureProperties) &&
-			   Lhs.ColorProperties.OrderIndependentCompareEqual(RHS.ColorProperties) &&
-			   Lhs.ScalarProperties.OrderIndependentCompareEqual(RHS.ScalarProperties) &&
-			   Lhs.StringProperties.OrderIndependentCompareEqual(RHS.StringProperties) && 
-			   Lhs.BlendMode == RHS.BlendMode;
+		return TextureProperties.OrderIndependentCompareEqual(Other.TextureProperties) &&
+			   ColorProperties.OrderIndependentCompareEqual(Other.ColorProperties) &&
+			   ScalarProperties.OrderIndependentCompareEqual(Other.ScalarProperties) &&
+			   StringProperties.OrderIndependentCompareEqual(Other.StringProperties) && 
+			   BlendMode == Other.BlendMode;
 		// clang-format on
 	}
 
+	friend bool operator==(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
+	{
+		if (Lhs.Id != INDEX_NONE && RHS.Id != INDEX_NONE)
+		{
+			return Lhs.Id == RHS.Id;
+		}
+		return Lhs.HasEqualProperties(RHS);
+	}
+
 	friend bool operator!=(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
 	{
 		return !(Lhs == RHS);
@@ -151,6 +182,16 @@ struct FTextureData
 	uint32 NumChannels = 0;
 	FDateTime LoadTime;
 
+	/** Hash of the pixel data and texture settings. Equal for identical images loaded from different paths. */
+	uint64 ContentHash = 0;
+
+	/** The size in bytes of all mips. */
+	int64 MemorySize = 0;
+
+	/** The blend mode required if this texture is used as opacity map with its alpha or red channel as opacity, see ClassifyOpacity. */
+	TEnumAsByte<EBlendMode> AlphaBlendMode = BLEND_Opaque;
+	TEnumAsByte<EBlendMode> RedBlendMode = BLEND_Opaque;
+
 	friend bool operator==(const FTextureData& Lhs, const FTextureData& Rhs)
 	{
 		return Lhs.Texture == Rhs.Texture && Lhs.NumChannels == Rhs.NumChannels;
@@ -162,6 +203,17 @@ struct FTextureData
 	}
 };
 
+/**
+ * \brief A texture decoded ahead of material creation. Holds a strong reference so the texture survives until its material is created even
+ * if the texture cache has already evicted it.
+ */
+struct FPrefetchedTexture
+{
+	FTextureData TextureData;
+	TStrongObjectPtr<UTexture2D> TextureRef;
+};
+using FPrefetchedTextures = TMap<FString, TSharedRef<FPrefetchedTexture, ESPMode::ThreadSafe>>;
+
 struct FCollisionData
 {
 	TArray<FTriIndices> Indices;
@@ -173,4 +225,16 @@ struct FCollisionData
 	}
 };
 
+/**
+ * \return the number of unique materials in the global material table.
+ */
+VITRUVIO_API int32 GetNumInternedMaterials();
+
+/**
+ * \brief Removes all materials from the global material table. Ids are not reused, so materials which have been interned before keep
+ * comparing correctly among each other, but they are no longer equal to equal materials interned afterwards. The table is also emptied
+ * automatically once it grows too large.
+ */
+VITRUVIO_API void EmptyMaterialTable();
+
 } // namespace Vitruvio
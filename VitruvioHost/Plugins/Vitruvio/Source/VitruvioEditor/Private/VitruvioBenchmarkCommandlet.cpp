@@ -0,0 +1,1205 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VitruvioBenchmarkCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMemory.h"
+#include "GenerateSchedulerBenchmark.h"
+#include "MeshTransferBenchmark.h"
+#include "NeighborQueryBenchmark.h"
+#include "InitialShapeRegistrationBenchmark.h"
+#include "InstanceDiffBenchmark.h"
+#include "PolygonWindingBenchmark.h"
+#include "TextureDecodeBenchmark.h"
+#include "VertexWeldBenchmark.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RuleAttributes.h"
+#include "RulePackage.h"
+#include "Serialization/JsonSerializer.h"
+#include "StaticMeshAttributes.h"
+#include "UObject/StrongObjectPtr.h"
+#include "VitruvioComponent.h"
+#include "VitruvioMesh.h"
+#include "VitruvioModule.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVitruvioBenchmark, Log, All);
+
+namespace
+{
+
+constexpr double LotSpacing = 3000.0;
+constexpr double MinLotHalfSize = 500.0;
+constexpr double MaxLotHalfSize = 1400.0;
+constexpr double LotVertexJitter = 100.0;
+constexpr double MinStandInHeight = 300.0;
+constexpr double MaxStandInHeight = 6000.0;
+
+struct FBenchmarkBatch
+{
+	TArray<FInitialShape> InitialShapes;
+	FGenerateResultDescription GenerateResult;
+};
+
+/**
+ * \brief Creates a square grid of jittered quad lots. The same seed always results in the same city.
+ */
+TArray<FInitialShape> CreateSyntheticCity(int32 NumLots, int32 Seed, const TArray<URulePackage*>& RulePackages)
+{
+	FRandomStream Random(Seed);
+
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<double>(NumLots)));
+
+	TArray<FInitialShape> InitialShapes;
+	InitialShapes.Reserve(NumLots);
+	for (int32 LotIndex = 0; LotIndex < NumLots; ++LotIndex)
+	{
+		const double HalfSizeX = Random.FRandRange(MinLotHalfSize, MaxLotHalfSize);
+		const double HalfSizeY = Random.FRandRange(MinLotHalfSize, MaxLotHalfSize);
+
+		FInitialShape& InitialShape = InitialShapes.AddDefaulted_GetRef();
+		InitialShape.InitialShapeIndex = LotIndex;
+		InitialShape.Position = FVector((LotIndex % GridSize) * LotSpacing, (LotIndex / GridSize) * LotSpacing, 0);
+		InitialShape.RandomSeed = Random.RandHelper(MAX_int32);
+		InitialShape.RulePackage = RulePackages.IsEmpty() ? nullptr : RulePackages[LotIndex % RulePackages.Num()];
+
+		const FVector2D Corners[] = {{-HalfSizeX, -HalfSizeY}, {HalfSizeX, -HalfSizeY}, {HalfSizeX, HalfSizeY}, {-HalfSizeX, HalfSizeY}};
+		for (const FVector2D& Corner : Corners)
+		{
+			const FVector2D Jitter(Random.FRandRange(-LotVertexJitter, LotVertexJitter), Random.FRandRange(-LotVertexJitter, LotVertexJitter));
+			InitialShape.Polygon.Vertices.Add(FVector(Corner + Jitter, 0));
+		}
+		InitialShape.Polygon.Faces.Add(FInitialShapeFace{{0, 1, 2, 3}});
+		InitialShape.Polygon.FixOrientation();
+	}
+
+	return InitialShapes;
+}
+
+/**
+ * \brief Splits the initial shapes into batches which only use a single rule package, keeping the order of the initial shapes per batch.
+ */
+TArray<FBenchmarkBatch> CreateBatches(const TArray<FInitialShape>& InitialShapes, int32 BatchSize)
+{
+	TMap<URulePackage*, TArray<FInitialShape>> ShapesByRulePackage;
+	for (const FInitialShape& InitialShape : InitialShapes)
+	{
+		ShapesByRulePackage.FindOrAdd(InitialShape.RulePackage).Add(InitialShape);
+	}
+
+	TArray<FBenchmarkBatch> Batches;
+	for (const auto& [RulePackage, Shapes] : ShapesByRulePackage)
+	{
+		for (int32 StartIndex = 0; StartIndex < Shapes.Num(); StartIndex += BatchSize)
+		{
+			FBenchmarkBatch& Batch = Batches.AddDefaulted_GetRef();
+			Batch.InitialShapes.Append(Shapes.GetData() + StartIndex, FMath::Min(BatchSize, Shapes.Num() - StartIndex));
+		}
+	}
+	return Batches;
+}
+
+/**
+ * \return the stand-in material with the given index. Materials with different indices differ in their color and roughness.
+ */
+Vitruvio::FMaterialAttributeContainer CreateStandInMaterial(int32 MaterialIndex)
+{
+	FRandomStream Random(MaterialIndex);
+
+	Vitruvio::FMaterialAttributeContainer Material;
+	Material.Name = FString::Printf(TEXT("StandIn%d"), MaterialIndex);
+	Material.ColorProperties.Add(TEXT("diffuseColor"), FLinearColor(Random.FRand(), Random.FRand(), Random.FRand()));
+	Material.ScalarProperties.Add(TEXT("opacity"), 1.0);
+	Material.ScalarProperties.Add(TEXT("roughness"), (MaterialIndex % 1000) / 1000.0);
+	Material.StringProperties.Add(TEXT("shader"), FString());
+	Material.Intern();
+	return Material;
+}
+
+/**
+ * \brief Generates a merged model of all initial shapes of the batch by extruding them. Used if PRT is not available. If NumMaterials is
+ * positive, every lot uses one of that many distinct materials, otherwise all lots share the default material.
+ */
+FGenerateResultDescription GenerateStandIn(const TArray<FInitialShape>& InitialShapes, int32 NumMaterials = 0)
+{
+	FMeshDescription MeshDescription;
+	FStaticMeshAttributes Attributes(MeshDescription);
+	Attributes.Register();
+
+	const TVertexAttributesRef<FVector3f> Positions = Attributes.GetVertexPositions();
+	const TVertexInstanceAttributesRef<FVector3f> Normals = Attributes.GetVertexInstanceNormals();
+
+	// One polygon group per used material, in the order of the materials of the mesh
+	TArray<Vitruvio::FMaterialAttributeContainer> Materials;
+	TMap<int32, FPolygonGroupID> PolygonGroupsByMaterial;
+	FPolygonGroupID PolygonGroupId;
+
+	const auto CreatePolygon = [&](const TArray<FVertexID>& Vertices, const FVector3f& Normal) {
+		TArray<FVertexInstanceID> VertexInstances;
+		for (const FVertexID& VertexId : Vertices)
+		{
+			const FVertexInstanceID VertexInstanceId = MeshDescription.CreateVertexInstance(VertexId);
+			Normals[VertexInstanceId] = Normal;
+			VertexInstances.Add(VertexInstanceId);
+		}
+		MeshDescription.CreatePolygon(PolygonGroupId, VertexInstances);
+	};
+
+	for (const FInitialShape& InitialShape : InitialShapes)
+	{
+		const double Height = FRandomStream(InitialShape.RandomSeed).FRandRange(MinStandInHeight, MaxStandInHeight);
+
+		const int32 MaterialIndex = NumMaterials > 0 ? InitialShape.RandomSeed % NumMaterials : INDEX_NONE;
+		if (const FPolygonGroupID* ExistingPolygonGroupId = PolygonGroupsByMaterial.Find(MaterialIndex))
+		{
+			PolygonGroupId = *ExistingPolygonGroupId;
+		}
+		else
+		{
+			PolygonGroupId = MeshDescription.CreatePolygonGroup();
+			PolygonGroupsByMaterial.Add(MaterialIndex, PolygonGroupId);
+			Materials.Add(MaterialIndex != INDEX_NONE ? CreateStandInMaterial(MaterialIndex) : Vitruvio::FMaterialAttributeContainer{});
+		}
+
+		for (const FInitialShapeFace& Face : InitialShape.Polygon.Faces)
+		{
+			TArray<FVertexID> Bottom;
+			TArray<FVertexID> Top;
+			for (const int32 Index : Face.Indices)
+			{
+				const FVector Position = InitialShape.Position + InitialShape.Polygon.Vertices[Index];
+
+				const FVertexID BottomId = MeshDescription.CreateVertex();
+				Positions[BottomId] = FVector3f(Position);
+				Bottom.Add(BottomId);
+
+				const FVertexID TopId = MeshDescription.CreateVertex();
+				Positions[TopId] = FVector3f(Position + FVector(0, 0, Height));
+				Top.Add(TopId);
+			}
+
+			CreatePolygon(Top, FVector3f::UpVector);
+
+			for (int32 Index = 0; Index < Face.Indices.Num(); ++Index)
+			{
+				const int32 NextIndex = (Index + 1) % Face.Indices.Num();
+				const FVector3f Edge = Positions[Bottom[NextIndex]] - Positions[Bottom[Index]];
+				const FVector3f Normal = FVector3f::CrossProduct(Edge, FVector3f::UpVector).GetSafeNormal();
+				CreatePolygon({Bottom[Index], Top[Index], Top[NextIndex], Bottom[NextIndex]}, Normal);
+			}
+		}
+	}
+
+	FGenerateResultDescription Result;
+	Result.GeneratedModel = MakeShared<FVitruvioMesh>(TEXT("StandIn"), MeshDescription, Materials);
+	return Result;
+}
+
+/**
+ * \brief Forwards all calls to the engine allocator and counts the allocations, reallocations and frees going through it.
+ */
+class FCountingMalloc final : public FMalloc
+{
+public:
+	FThreadSafeCounter64 NumAllocations;
+	FThreadSafeCounter64 NumReallocations;
+	FThreadSafeCounter64 NumFrees;
+	FThreadSafeCounter64 AllocatedBytes;
+
+	explicit FCountingMalloc(FMalloc* InnerMalloc) : InnerMalloc(InnerMalloc) {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		NumAllocations.Increment();
+		AllocatedBytes.Add(Count);
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+	{
+		NumAllocations.Increment();
+		AllocatedBytes.Add(Count);
+		return InnerMalloc->TryMalloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		NumReallocations.Increment();
+		AllocatedBytes.Add(Count);
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		NumReallocations.Increment();
+		AllocatedBytes.Add(Count);
+		return InnerMalloc->TryRealloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		NumFrees.Increment();
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual void InitializeStatsMetadata() override
+	{
+		InnerMalloc->InitializeStatsMetadata();
+	}
+
+	virtual void UpdateStats() override
+	{
+		InnerMalloc->UpdateStats();
+	}
+
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+	{
+		InnerMalloc->GetAllocatorStats(OutStats);
+	}
+
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+	{
+		InnerMalloc->DumpAllocatorStats(Ar);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return InnerMalloc->ValidateHeap();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return InnerMalloc->GetDescriptiveName();
+	}
+
+private:
+	FMalloc* InnerMalloc;
+};
+
+/** Installed as GMalloc with -CountAllocations. Never deleted since other threads may still be inside of it. */
+FCountingMalloc* CountingMalloc = nullptr;
+
+/**
+ * \brief Runs the given phase and returns its wall time, throughput and memory usage, and its allocation counts with -CountAllocations.
+ */
+template <typename PhaseType>
+TSharedRef<FJsonObject> MeasurePhase(const FString& Name, int32 NumLots, PhaseType Phase)
+{
+	const FPlatformMemoryStats MemoryBefore = FPlatformMemory::GetStats();
+	const int64 NumAllocationsBefore = CountingMalloc ? CountingMalloc->NumAllocations.GetValue() : 0;
+	const int64 NumReallocationsBefore = CountingMalloc ? CountingMalloc->NumReallocations.GetValue() : 0;
+	const int64 NumFreesBefore = CountingMalloc ? CountingMalloc->NumFrees.GetValue() : 0;
+	const int64 AllocatedBytesBefore = CountingMalloc ? CountingMalloc->AllocatedBytes.GetValue() : 0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	Phase();
+
+	const double WallTime = FPlatformTime::Seconds() - StartTime;
+	const FPlatformMemoryStats MemoryAfter = FPlatformMemory::GetStats();
+
+	const int64 UsedPhysicalDelta = static_cast<int64>(MemoryAfter.UsedPhysical) - static_cast<int64>(MemoryBefore.UsedPhysical);
+	const double ShapesPerSecond = WallTime > 0 ? NumLots / WallTime : 0;
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("%-10s %10.3f s %10.1f shapes/s %+10.1f MiB"), *Name, WallTime, ShapesPerSecond,
+		   UsedPhysicalDelta / (1024.0 * 1024.0));
+
+	TSharedRef<FJsonObject> PhaseObject = MakeShared<FJsonObject>();
+	PhaseObject->SetNumberField(TEXT("wallTimeSeconds"), WallTime);
+	PhaseObject->SetNumberField(TEXT("shapesPerSecond"), ShapesPerSecond);
+	PhaseObject->SetNumberField(TEXT("usedPhysicalDeltaBytes"), static_cast<double>(UsedPhysicalDelta));
+	PhaseObject->SetNumberField(TEXT("peakUsedPhysicalBytes"), static_cast<double>(MemoryAfter.PeakUsedPhysical));
+
+	if (CountingMalloc)
+	{
+		const int64 NumAllocations = CountingMalloc->NumAllocations.GetValue() - NumAllocationsBefore;
+		const int64 NumReallocations = CountingMalloc->NumReallocations.GetValue() - NumReallocationsBefore;
+		const int64 NumFrees = CountingMalloc->NumFrees.GetValue() - NumFreesBefore;
+		const int64 AllocatedBytes = CountingMalloc->AllocatedBytes.GetValue() - AllocatedBytesBefore;
+
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("%-10s %10lld allocations %10lld reallocations %10lld frees %10.1f MiB allocated"), *Name,
+			   NumAllocations, NumReallocations, NumFrees, AllocatedBytes / (1024.0 * 1024.0));
+
+		PhaseObject->SetNumberField(TEXT("allocations"), static_cast<double>(NumAllocations));
+		PhaseObject->SetNumberField(TEXT("allocationsPerShape"), NumLots > 0 ? static_cast<double>(NumAllocations) / NumLots : 0.0);
+		PhaseObject->SetNumberField(TEXT("reallocations"), static_cast<double>(NumReallocations));
+		PhaseObject->SetNumberField(TEXT("frees"), static_cast<double>(NumFrees));
+		PhaseObject->SetNumberField(TEXT("allocatedBytes"), static_cast<double>(AllocatedBytes));
+	}
+
+	return PhaseObject;
+}
+
+/**
+ * \brief Compares the bytes transferred and conversion times of the encoder mesh formats, normalized to one million triangles.
+ */
+TSharedRef<FJsonObject> MeasureMeshTransfer(int32 NumTriangles)
+{
+	const FMeshTransferBenchmarkResult Result = RunMeshTransferBenchmark(NumTriangles);
+	const double Scale = 1000000.0 / FMath::Max<int64>(1, Result.NumTriangles);
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("MeshTransfer V1 %10.1f MiB %10.3f s per million triangles"), Result.BytesV1 * Scale / (1024.0 * 1024.0),
+		   Result.ConvertSecondsV1 * Scale);
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("MeshTransfer V2 %10.1f MiB %10.3f s per million triangles"), Result.BytesV2 * Scale / (1024.0 * 1024.0),
+		   Result.ConvertSecondsV2 * Scale);
+
+	TSharedRef<FJsonObject> MeshTransferObject = MakeShared<FJsonObject>();
+	MeshTransferObject->SetNumberField(TEXT("triangles"), static_cast<double>(Result.NumTriangles));
+	MeshTransferObject->SetNumberField(TEXT("bytesPerMillionTrianglesV1"), Result.BytesV1 * Scale);
+	MeshTransferObject->SetNumberField(TEXT("bytesPerMillionTrianglesV2"), Result.BytesV2 * Scale);
+	MeshTransferObject->SetNumberField(TEXT("convertSecondsPerMillionTrianglesV1"), Result.ConvertSecondsV1 * Scale);
+	MeshTransferObject->SetNumberField(TEXT("convertSecondsPerMillionTrianglesV2"), Result.ConvertSecondsV2 * Scale);
+	return MeshTransferObject;
+}
+
+/**
+ * \brief Measures texture decoding throughput per PRT pixel format on a synthetic Size x Size texture.
+ */
+TSharedRef<FJsonObject> MeasureTextureDecode(int32 Size)
+{
+	TSharedRef<FJsonObject> TextureDecodeObject = MakeShared<FJsonObject>();
+	TextureDecodeObject->SetNumberField(TEXT("size"), Size);
+
+	for (const FTextureDecodeBenchmarkResult& Result : RunTextureDecodeBenchmark(Size))
+	{
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("TextureDecode %-8s %10.1f MP/s convert %10.1f MP/s mip chain %10.1f MP/s opacity"),
+			   *Result.Format, Result.ConvertMegapixelsPerSecond, Result.MipChainMegapixelsPerSecond, Result.OpacityMegapixelsPerSecond);
+
+		TSharedRef<FJsonObject> FormatObject = MakeShared<FJsonObject>();
+		FormatObject->SetNumberField(TEXT("convertMegapixelsPerSecond"), Result.ConvertMegapixelsPerSecond);
+		FormatObject->SetNumberField(TEXT("mipChainMegapixelsPerSecond"), Result.MipChainMegapixelsPerSecond);
+		FormatObject->SetNumberField(TEXT("opacityMegapixelsPerSecond"), Result.OpacityMegapixelsPerSecond);
+		TextureDecodeObject->SetObjectField(Result.Format, FormatObject);
+	}
+	return TextureDecodeObject;
+}
+
+/**
+ * \brief Measures applying a single attribute change to a model with NumInstances instances, by recreating and by diffing the instances.
+ */
+TSharedRef<FJsonObject> MeasureInstanceDiff(int32 NumInstances)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::None, false);
+
+	TSharedRef<FJsonObject> InstanceDiffObject = MakeShared<FJsonObject>();
+	for (const FInstanceDiffBenchmarkResult& Result : RunInstanceDiffBenchmark(World, NumInstances))
+	{
+		UE_LOG(LogVitruvioBenchmark, Display,
+			   TEXT("InstanceDiff %-12s %6d instances %10.3f ms recreate %10.3f ms diff (%lld kept, %lld updated, %lld added, %lld removed)"),
+			   *Result.Scenario, Result.NumInstances, Result.RecreateMs, Result.DiffMs, Result.Diff.Kept, Result.Diff.Updated,
+			   Result.Diff.Added, Result.Diff.Removed);
+
+		TSharedRef<FJsonObject> ScenarioObject = MakeShared<FJsonObject>();
+		ScenarioObject->SetNumberField(TEXT("instances"), Result.NumInstances);
+		ScenarioObject->SetNumberField(TEXT("recreateMs"), Result.RecreateMs);
+		ScenarioObject->SetNumberField(TEXT("diffMs"), Result.DiffMs);
+		ScenarioObject->SetNumberField(TEXT("kept"), static_cast<double>(Result.Diff.Kept));
+		ScenarioObject->SetNumberField(TEXT("updated"), static_cast<double>(Result.Diff.Updated));
+		ScenarioObject->SetNumberField(TEXT("added"), static_cast<double>(Result.Diff.Added));
+		ScenarioObject->SetNumberField(TEXT("removed"), static_cast<double>(Result.Diff.Removed));
+		InstanceDiffObject->SetObjectField(Result.Scenario, ScenarioObject);
+	}
+
+	World->DestroyWorld(false);
+	return InstanceDiffObject;
+}
+
+/**
+ * \brief Measures welding the vertices of static mesh initial shapes with 1k, 10k and 100k vertices against the linear search reference.
+ */
+TSharedRef<FJsonObject> MeasureVertexWeld()
+{
+	TSharedRef<FJsonObject> VertexWeldObject = MakeShared<FJsonObject>();
+	for (const int32 NumVertices : {1000, 10000, 100000})
+	{
+		const FVertexWeldBenchmarkResult Result = RunVertexWeldBenchmark(NumVertices);
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("VertexWeld %6d vertices %10.3f ms weld %10.3f ms reference (%d welded, %s)"),
+			   Result.NumVertices, Result.WeldMs, Result.ReferenceMs, Result.NumWeldedVertices,
+			   Result.bEquivalent ? TEXT("equivalent") : TEXT("NOT equivalent"));
+		if (!Result.bEquivalent)
+		{
+			UE_LOG(LogVitruvioBenchmark, Error, TEXT("Welding %d vertices differs from the reference"), Result.NumVertices);
+		}
+
+		TSharedRef<FJsonObject> SizeObject = MakeShared<FJsonObject>();
+		SizeObject->SetNumberField(TEXT("weldedVertices"), Result.NumWeldedVertices);
+		SizeObject->SetNumberField(TEXT("weldMs"), Result.WeldMs);
+		SizeObject->SetNumberField(TEXT("referenceMs"), Result.ReferenceMs);
+		SizeObject->SetBoolField(TEXT("equivalent"), Result.bEquivalent);
+		VertexWeldObject->SetObjectField(FString::FromInt(Result.NumVertices), SizeObject);
+	}
+	return VertexWeldObject;
+}
+
+/**
+ * \brief Measures extracting the faces and holes of a synthetic footprint with about NumEdges triangle edges and checks the result.
+ */
+TSharedRef<FJsonObject> MeasurePolygonWinding(int32 NumEdges)
+{
+	const FPolygonWindingBenchmarkResult Result = RunPolygonWindingBenchmark(NumEdges);
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("PolygonWinding %d edges %10.3f ms (%d faces, %d holes, %s)"), Result.NumEdges,
+		   Result.GetPolygonMs, Result.NumFaces, Result.NumHoles, Result.bValid ? TEXT("valid") : TEXT("NOT valid"));
+	if (!Result.bValid)
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("The faces and holes of the synthetic footprint do not match its construction"));
+	}
+
+	TSharedRef<FJsonObject> PolygonWindingObject = MakeShared<FJsonObject>();
+	PolygonWindingObject->SetNumberField(TEXT("edges"), Result.NumEdges);
+	PolygonWindingObject->SetNumberField(TEXT("faces"), Result.NumFaces);
+	PolygonWindingObject->SetNumberField(TEXT("holes"), Result.NumHoles);
+	PolygonWindingObject->SetNumberField(TEXT("getPolygonMs"), Result.GetPolygonMs);
+	PolygonWindingObject->SetBoolField(TEXT("valid"), Result.bValid);
+	return PolygonWindingObject;
+}
+
+/**
+ * \brief Measures checking the validity of NumShapes initial shapes and registering them with the batch subsystem.
+ */
+TSharedRef<FJsonObject> MeasureInitialShapeRegistration(int32 NumShapes)
+{
+	// Only editor and game worlds have world subsystems
+	UWorld* World = UWorld::CreateWorld(EWorldType::Editor, false);
+	const FInitialShapeRegistrationBenchmarkResult Result = RunInitialShapeRegistrationBenchmark(World, NumShapes);
+	World->DestroyWorld(false);
+
+	TSharedRef<FJsonObject> RegistrationObject = MakeShared<FJsonObject>();
+	if (Result.NumShapes == 0)
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("The benchmark world has no batch subsystem, skipping the initial shape registration benchmark"));
+		return RegistrationObject;
+	}
+
+	UE_LOG(LogVitruvioBenchmark, Display,
+		   TEXT("InitialShapeRegistration %d shapes %10.3f ms mesh description validity %10.3f ms validity %10.3f ms register %10.3f ms unchanged (%s)"),
+		   Result.NumShapes, Result.MeshDescriptionValidityMs, Result.ValidityMs, Result.RegisterMs, Result.UnchangedPolygonMs,
+		   Result.bEquivalent ? TEXT("equivalent") : TEXT("NOT equivalent"));
+	if (!Result.bEquivalent)
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("The initial shape validity differs from the mesh description validity"));
+	}
+
+	RegistrationObject->SetNumberField(TEXT("shapes"), Result.NumShapes);
+	RegistrationObject->SetNumberField(TEXT("meshDescriptionValidityMs"), Result.MeshDescriptionValidityMs);
+	RegistrationObject->SetNumberField(TEXT("validityMs"), Result.ValidityMs);
+	RegistrationObject->SetNumberField(TEXT("registerMs"), Result.RegisterMs);
+	RegistrationObject->SetNumberField(TEXT("unchangedPolygonMs"), Result.UnchangedPolygonMs);
+	RegistrationObject->SetBoolField(TEXT("equivalent"), Result.bEquivalent);
+	return RegistrationObject;
+}
+
+/**
+ * \brief Measures the queue wait times of interactive and batched tasks when submitting NumTasks tasks to a scheduler with strict priority
+ * and with the default high priority burst.
+ */
+TSharedRef<FJsonObject> MeasureGenerateScheduler(int32 NumTasks)
+{
+	constexpr int32 NumWorkers = 4;
+
+	TSharedRef<FJsonObject> SchedulerObject = MakeShared<FJsonObject>();
+	SchedulerObject->SetNumberField(TEXT("tasks"), NumTasks);
+	SchedulerObject->SetNumberField(TEXT("workers"), NumWorkers);
+
+	for (const FGenerateSchedulerBenchmarkResult& Result : RunGenerateSchedulerBenchmark(NumTasks, NumWorkers))
+	{
+		UE_LOG(LogVitruvioBenchmark, Display,
+			   TEXT("GenerateScheduler burst %2d %10.3f ms wall, high wait %8.3f ms avg %8.3f ms max, normal wait %8.3f ms avg %8.3f ms max"),
+			   Result.HighPriorityBurst, Result.WallTimeMs, Result.HighPriorityAverageWaitMs, Result.HighPriorityMaxWaitMs,
+			   Result.NormalPriorityAverageWaitMs, Result.NormalPriorityMaxWaitMs);
+
+		TSharedRef<FJsonObject> BurstObject = MakeShared<FJsonObject>();
+		BurstObject->SetNumberField(TEXT("wallTimeMs"), Result.WallTimeMs);
+		BurstObject->SetNumberField(TEXT("highPriorityAverageWaitMs"), Result.HighPriorityAverageWaitMs);
+		BurstObject->SetNumberField(TEXT("highPriorityMaxWaitMs"), Result.HighPriorityMaxWaitMs);
+		BurstObject->SetNumberField(TEXT("normalPriorityAverageWaitMs"), Result.NormalPriorityAverageWaitMs);
+		BurstObject->SetNumberField(TEXT("normalPriorityMaxWaitMs"), Result.NormalPriorityMaxWaitMs);
+		SchedulerObject->SetObjectField(FString::Printf(TEXT("burst%d"), Result.HighPriorityBurst), BurstObject);
+	}
+	return SchedulerObject;
+}
+
+/**
+ * \brief Loads every rule package once with an empty unpack cache (cold) and once more from the unpack cache (warm) by evaluating the
+ * attributes of a single lot per rule package, and reports the load times and unpack cache hits of both passes.
+ */
+TSharedRef<FJsonObject> MeasureRpkLoad(VitruvioModule& Module, const TArray<URulePackage*>& RulePackages)
+{
+	const TArray<FInitialShape> InitialShapes = CreateSyntheticCity(RulePackages.Num(), 0, RulePackages);
+
+	TSharedRef<FJsonObject> RpkLoadObject = MakeShared<FJsonObject>();
+	RpkLoadObject->SetNumberField(TEXT("rulePackages"), RulePackages.Num());
+
+	for (const bool bCold : {true, false})
+	{
+		Module.EmptyResolveMapCache(bCold);
+
+		const FRpkLoadStats StatsBefore = Module.GetRpkLoadStats();
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FInitialShape& InitialShape : InitialShapes)
+		{
+			Module.BatchEvaluateRuleAttributes({InitialShape});
+		}
+		const double WallTimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		const FRpkLoadStats StatsAfter = Module.GetRpkLoadStats();
+
+		const int32 NumHits = StatsAfter.NumUnpackCacheHits - StatsBefore.NumUnpackCacheHits;
+		const int32 NumMisses = StatsAfter.NumUnpackCacheMisses - StatsBefore.NumUnpackCacheMisses;
+		const double LoadTimeMs = StatsAfter.ColdLoadTimeMs + StatsAfter.WarmLoadTimeMs - StatsBefore.ColdLoadTimeMs - StatsBefore.WarmLoadTimeMs;
+
+		const TCHAR* PassName = bCold ? TEXT("cold") : TEXT("warm");
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("RpkLoad %-4s %10.3f ms load %10.3f ms evaluate (%d unpack cache hits, %d misses)"), PassName,
+			   LoadTimeMs, WallTimeMs, NumHits, NumMisses);
+
+		TSharedRef<FJsonObject> PassObject = MakeShared<FJsonObject>();
+		PassObject->SetNumberField(TEXT("loadTimeMs"), LoadTimeMs);
+		PassObject->SetNumberField(TEXT("wallTimeMs"), WallTimeMs);
+		PassObject->SetNumberField(TEXT("unpackCacheHits"), NumHits);
+		PassObject->SetNumberField(TEXT("unpackCacheMisses"), NumMisses);
+		RpkLoadObject->SetObjectField(PassName, PassObject);
+	}
+	return RpkLoadObject;
+}
+
+/**
+ * \brief Generates all batches with attribute evaluation in a separate pass and fused into the generate pass (see
+ * Esri.Vitruvio.FuseAttributeEvaluation), each with an empty generate cache, and reports the wall time of both.
+ */
+TSharedRef<FJsonObject> MeasureAttributeEvaluation(const TArray<FBenchmarkBatch>& Batches)
+{
+	VitruvioModule& Module = VitruvioModule::Get();
+
+	IConsoleVariable* FuseAttributeEvaluation = IConsoleManager::Get().FindConsoleVariable(TEXT("Esri.Vitruvio.FuseAttributeEvaluation"));
+	const bool bPreviousFuseAttributeEvaluation = FuseAttributeEvaluation->GetBool();
+
+	int32 NumLots = 0;
+	for (const FBenchmarkBatch& Batch : Batches)
+	{
+		NumLots += Batch.InitialShapes.Num();
+	}
+
+	TSharedRef<FJsonObject> AttributeEvaluationObject = MakeShared<FJsonObject>();
+	double WallTimes[2] = {};
+	for (const bool bFused : {false, true})
+	{
+		FuseAttributeEvaluation->Set(bFused);
+		Module.EmptyGenerateCache();
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		TArray<FBatchGenerateResult::FFutureType> Futures;
+		for (const FBenchmarkBatch& Batch : Batches)
+		{
+			Futures.Add(MoveTemp(Module.BatchGenerateAsync(Batch.InitialShapes, false, {}).Result));
+		}
+		for (FBatchGenerateResult::FFutureType& Future : Futures)
+		{
+			Future.Wait();
+		}
+
+		const double WallTime = FPlatformTime::Seconds() - StartTime;
+		WallTimes[bFused] = WallTime;
+
+		const TCHAR* ModeName = bFused ? TEXT("fused") : TEXT("twoPass");
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("AttributeEvaluation %-8s %10.3f s %10.1f shapes/s"), ModeName, WallTime,
+			   WallTime > 0 ? NumLots / WallTime : 0.0);
+
+		TSharedRef<FJsonObject> ModeObject = MakeShared<FJsonObject>();
+		ModeObject->SetNumberField(TEXT("wallTimeSeconds"), WallTime);
+		ModeObject->SetNumberField(TEXT("shapesPerSecond"), WallTime > 0 ? NumLots / WallTime : 0.0);
+		AttributeEvaluationObject->SetObjectField(ModeName, ModeObject);
+	}
+
+	FuseAttributeEvaluation->Set(bPreviousFuseAttributeEvaluation);
+
+	// Run the generate completed notifications which have been queued on the game thread
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+	AttributeEvaluationObject->SetNumberField(TEXT("speedup"), WallTimes[1] > 0 ? WallTimes[0] / WallTimes[1] : 0.0);
+	return AttributeEvaluationObject;
+}
+
+/**
+ * \brief Measures building, querying and updating the inter-occlusion neighbor index with NumShapes lots.
+ */
+TSharedRef<FJsonObject> MeasureNeighborQuery(int32 NumShapes)
+{
+	const FNeighborQueryBenchmarkResult Result = RunNeighborQueryBenchmark(NumShapes);
+	UE_LOG(LogVitruvioBenchmark, Display,
+		   TEXT("NeighborQuery %d shapes %10.3f ms build %10.3f ms query %10.3f ms move %10.3f ms remove, %.2f us per query (linear %.2f us, "
+				"%.1f neighbors, %s)"),
+		   Result.NumShapes, Result.BuildMs, Result.QueryMs, Result.MoveMs, Result.RemoveMs, Result.QueryUs, Result.LinearQueryUs,
+		   Result.AverageNeighbors, Result.bEquivalent ? TEXT("equivalent") : TEXT("NOT equivalent"));
+	if (!Result.bEquivalent)
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("The neighbor index differs from the linear search"));
+	}
+
+	TSharedRef<FJsonObject> NeighborQueryObject = MakeShared<FJsonObject>();
+	NeighborQueryObject->SetNumberField(TEXT("shapes"), Result.NumShapes);
+	NeighborQueryObject->SetNumberField(TEXT("averageNeighbors"), Result.AverageNeighbors);
+	NeighborQueryObject->SetNumberField(TEXT("buildMs"), Result.BuildMs);
+	NeighborQueryObject->SetNumberField(TEXT("queryMs"), Result.QueryMs);
+	NeighborQueryObject->SetNumberField(TEXT("moveMs"), Result.MoveMs);
+	NeighborQueryObject->SetNumberField(TEXT("removeMs"), Result.RemoveMs);
+	NeighborQueryObject->SetNumberField(TEXT("queryUs"), Result.QueryUs);
+	NeighborQueryObject->SetNumberField(TEXT("linearQueryUs"), Result.LinearQueryUs);
+	NeighborQueryObject->SetBoolField(TEXT("equivalent"), Result.bEquivalent);
+	return NeighborQueryObject;
+}
+
+/**
+ * \brief Generates the batches per initial shape with an empty generate cache, then generates NumCopies translated copies of them and
+ * reports the generate cache hit rate of every pass. All initial shapes of the copies should be reused from the first pass.
+ */
+TSharedRef<FJsonObject> MeasureGenerateCacheReuse(const TArray<FBenchmarkBatch>& Batches, int32 NumCopies)
+{
+	VitruvioModule& Module = VitruvioModule::Get();
+	Module.EmptyGenerateCache();
+
+	int64 NumLots = 0;
+	for (const FBenchmarkBatch& Batch : Batches)
+	{
+		NumLots += Batch.InitialShapes.Num();
+	}
+	const double CopySpacing = (FMath::CeilToInt(FMath::Sqrt(static_cast<double>(NumLots))) + 1) * LotSpacing;
+
+	TArray<TSharedPtr<FJsonValue>> PassValues;
+	for (int32 CopyIndex = 0; CopyIndex <= NumCopies; ++CopyIndex)
+	{
+		const FGenerateCacheStats StatsBefore = Module.GetGenerateCacheStats();
+		const double StartTime = FPlatformTime::Seconds();
+
+		TArray<FBatchGenerateResult::FFutureType> Futures;
+		for (const FBenchmarkBatch& Batch : Batches)
+		{
+			TArray<FInitialShape> InitialShapes = Batch.InitialShapes;
+			for (FInitialShape& InitialShape : InitialShapes)
+			{
+				InitialShape.InitialShapeIndex += CopyIndex * NumLots;
+				InitialShape.Position.Y += CopyIndex * CopySpacing;
+			}
+			Futures.Add(MoveTemp(Module.BatchGenerateAsync(MoveTemp(InitialShapes), false, {}, true).Result));
+		}
+		for (FBatchGenerateResult::FFutureType& Future : Futures)
+		{
+			Future.Wait();
+		}
+
+		const double WallTime = FPlatformTime::Seconds() - StartTime;
+		const FGenerateCacheStats StatsAfter = Module.GetGenerateCacheStats();
+		const int64 NumHits = StatsAfter.NumHits - StatsBefore.NumHits;
+		const int64 NumMisses = StatsAfter.NumMisses - StatsBefore.NumMisses;
+		const double HitRate = NumHits + NumMisses > 0 ? static_cast<double>(NumHits) / (NumHits + NumMisses) : 0;
+
+		UE_LOG(LogVitruvioBenchmark, Display, TEXT("GenerateCache %-8s %10.3f s %8lld hits %8lld misses %6.1f%% hit rate"),
+			   CopyIndex == 0 ? TEXT("original") : TEXT("copy"), WallTime, NumHits, NumMisses, HitRate * 100.0);
+
+		TSharedRef<FJsonObject> PassObject = MakeShared<FJsonObject>();
+		PassObject->SetNumberField(TEXT("wallTimeSeconds"), WallTime);
+		PassObject->SetNumberField(TEXT("hits"), static_cast<double>(NumHits));
+		PassObject->SetNumberField(TEXT("misses"), static_cast<double>(NumMisses));
+		PassObject->SetNumberField(TEXT("hitRate"), HitRate);
+		PassValues.Add(MakeShared<FJsonValueObject>(PassObject));
+	}
+
+	// Run the generate completed notifications which have been queued on the game thread
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+	TSharedRef<FJsonObject> GenerateCacheObject = MakeShared<FJsonObject>();
+	GenerateCacheObject->SetNumberField(TEXT("copies"), NumCopies);
+	GenerateCacheObject->SetArrayField(TEXT("passes"), PassValues);
+	return GenerateCacheObject;
+}
+
+/**
+ * \brief Builds NumMeshes single lot models once synchronously with BuildGenerateResult and once through FGenerateResultBuilder with
+ * asynchronously built meshes and prefetched textures. The builders are stepped round robin like the apply queue of the components and
+ * the time spent on the game thread is reported for both.
+ */
+TSharedRef<FJsonObject> MeasureAsyncApply(int32 NumMeshes, int32 Seed, UMaterial* OpaqueParent, UMaterial* MaskedParent,
+										  UMaterial* TranslucentParent, UWorld* World)
+{
+	VitruvioModule& Module = VitruvioModule::Get();
+	const TArray<FInitialShape> InitialShapes = CreateSyntheticCity(NumMeshes, Seed, {});
+
+	// Meshes are only built once, so both runs get their own
+	const auto CreateResults = [&InitialShapes]() {
+		TArray<FGenerateResultDescription> Results;
+		Results.SetNum(InitialShapes.Num());
+		ParallelFor(InitialShapes.Num(), [&](int32 Index) { Results[Index] = GenerateStandIn({InitialShapes[Index]}); });
+		return Results;
+	};
+
+	TArray<TMap<UMaterialInterface*, FString>> MaterialIdentifiers;
+	TArray<TMap<FString, int32>> UniqueMaterialIdentifiers;
+	MaterialIdentifiers.SetNum(InitialShapes.Num());
+	UniqueMaterialIdentifiers.SetNum(InitialShapes.Num());
+
+	const TArray<FGenerateResultDescription> SyncResults = CreateResults();
+	TArray<FConvertedGenerateResult> ConvertedResults;
+	ConvertedResults.Reserve(SyncResults.Num());
+
+	const double SyncStartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < SyncResults.Num(); ++Index)
+	{
+		ConvertedResults.Add(BuildGenerateResult(SyncResults[Index], Module.GetMaterialCache(), Module.GetTextureCache(), MaterialIdentifiers[Index],
+												 UniqueMaterialIdentifiers[Index], OpaqueParent, MaskedParent, TranslucentParent, World));
+	}
+	const double SyncTime = FPlatformTime::Seconds() - SyncStartTime;
+	ConvertedResults.Empty();
+
+	TArray<FGenerateResultDescription> AsyncResults = CreateResults();
+	TArray<TUniquePtr<FGenerateResultBuilder>> Builders;
+	Builders.Reserve(AsyncResults.Num());
+
+	const double AsyncStartTime = FPlatformTime::Seconds();
+	double GameThreadTime = 0;
+	double MaxStepTime = 0;
+	int32 NumSteps = 0;
+	for (int32 Index = 0; Index < AsyncResults.Num(); ++Index)
+	{
+		const double StepStartTime = FPlatformTime::Seconds();
+		Builders.Add(MakeUnique<FGenerateResultBuilder>(MoveTemp(AsyncResults[Index]), Module.GetMaterialCache(), Module.GetTextureCache(),
+														MaterialIdentifiers[Index], UniqueMaterialIdentifiers[Index], OpaqueParent, MaskedParent,
+														TranslucentParent, World, true, true));
+		GameThreadTime += FPlatformTime::Seconds() - StepStartTime;
+	}
+
+	for (bool bPending = true; bPending;)
+	{
+		bPending = false;
+		bool bStepped = false;
+		for (const TUniquePtr<FGenerateResultBuilder>& Builder : Builders)
+		{
+			if (Builder->IsDone())
+			{
+				continue;
+			}
+
+			bPending = true;
+			if (Builder->IsReady())
+			{
+				const double StepStartTime = FPlatformTime::Seconds();
+				Builder->Step();
+				const double StepTime = FPlatformTime::Seconds() - StepStartTime;
+
+				GameThreadTime += StepTime;
+				MaxStepTime = FMath::Max(MaxStepTime, StepTime);
+				++NumSteps;
+				bStepped = true;
+			}
+		}
+
+		// Nothing to do on the game thread until the next mesh has been built by a worker
+		if (bPending && !bStepped)
+		{
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FPlatformProcess::Sleep(0);
+		}
+	}
+	const double AsyncTime = FPlatformTime::Seconds() - AsyncStartTime;
+	Builders.Empty();
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("AsyncApply %d meshes: sync %.3f s, async %.3f s wall %.3f s game thread (%d steps, max %.2f ms)"),
+		   NumMeshes, SyncTime, AsyncTime, GameThreadTime, NumSteps, MaxStepTime * 1000.0);
+
+	TSharedRef<FJsonObject> AsyncApplyObject = MakeShared<FJsonObject>();
+	AsyncApplyObject->SetNumberField(TEXT("meshes"), NumMeshes);
+	AsyncApplyObject->SetNumberField(TEXT("syncGameThreadSeconds"), SyncTime);
+	AsyncApplyObject->SetNumberField(TEXT("asyncWallTimeSeconds"), AsyncTime);
+	AsyncApplyObject->SetNumberField(TEXT("asyncGameThreadSeconds"), GameThreadTime);
+	AsyncApplyObject->SetNumberField(TEXT("asyncSteps"), NumSteps);
+	AsyncApplyObject->SetNumberField(TEXT("asyncMaxStepMs"), MaxStepTime * 1000.0);
+	return AsyncApplyObject;
+}
+
+} // namespace
+
+UVitruvioBenchmarkCommandlet::UVitruvioBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UVitruvioBenchmarkCommandlet::Main(const FString& Params)
+{
+	const TCHAR* Parms = *Params;
+
+	int32 NumLots = 1000;
+	int32 Seed = 0;
+	int32 BatchSize = 256;
+	float AttributeVariation = 0.0f;
+	int32 MeshTransferTriangles = 0;
+	int32 TextureDecodeSize = 0;
+	int32 InstanceDiffCount = 0;
+	int32 PolygonWindingEdges = 0;
+	int32 InitialShapeRegistrations = 0;
+	int32 GenerateCacheCopies = 0;
+	int32 AsyncApplyMeshes = 0;
+	int32 StandInMaterials = 0;
+	int32 SchedulerTasks = 0;
+	int32 NeighborQueries = 0;
+	FString RulePackagePaths;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Vitruvio") / TEXT("Benchmark.json");
+
+	FParse::Value(Parms, TEXT("Lots="), NumLots);
+	FParse::Value(Parms, TEXT("Seed="), Seed);
+	FParse::Value(Parms, TEXT("BatchSize="), BatchSize);
+	FParse::Value(Parms, TEXT("AttributeVariation="), AttributeVariation);
+	FParse::Value(Parms, TEXT("Rpks="), RulePackagePaths, false);
+	FParse::Value(Parms, TEXT("Output="), OutputPath);
+	FParse::Value(Parms, TEXT("MeshTransferTriangles="), MeshTransferTriangles);
+	FParse::Value(Parms, TEXT("TextureDecodeSize="), TextureDecodeSize);
+	FParse::Value(Parms, TEXT("InstanceDiffCount="), InstanceDiffCount);
+	FParse::Value(Parms, TEXT("PolygonWindingEdges="), PolygonWindingEdges);
+	FParse::Value(Parms, TEXT("InitialShapeRegistrations="), InitialShapeRegistrations);
+	FParse::Value(Parms, TEXT("GenerateCacheCopies="), GenerateCacheCopies);
+	FParse::Value(Parms, TEXT("AsyncApplyMeshes="), AsyncApplyMeshes);
+	FParse::Value(Parms, TEXT("StandInMaterials="), StandInMaterials);
+	FParse::Value(Parms, TEXT("SchedulerTasks="), SchedulerTasks);
+	FParse::Value(Parms, TEXT("NeighborQueries="), NeighborQueries);
+
+	if (NumLots <= 0 || BatchSize <= 0)
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("Lots and BatchSize must be positive"));
+		return 1;
+	}
+
+	TArray<FString> RulePackagePathArray;
+	RulePackagePaths.ParseIntoArray(RulePackagePathArray, TEXT(","));
+
+	TArray<URulePackage*> RulePackages;
+	for (const FString& RulePackagePath : RulePackagePathArray)
+	{
+		URulePackage* RulePackage = LoadObject<URulePackage>(nullptr, *RulePackagePath);
+		if (!RulePackage)
+		{
+			UE_LOG(LogVitruvioBenchmark, Error, TEXT("Could not load rule package %s"), *RulePackagePath);
+			return 1;
+		}
+		RulePackages.Add(RulePackage);
+	}
+
+	// Counting contends on every allocation, so it is opt-in and wall times measured with it are not comparable to runs without
+	if (FParse::Param(Parms, TEXT("CountAllocations")) && !CountingMalloc)
+	{
+		CountingMalloc = new FCountingMalloc(GMalloc);
+		GMalloc = CountingMalloc;
+	}
+
+	VitruvioModule& Module = VitruvioModule::Get();
+
+	bool bStandIn = FParse::Param(Parms, TEXT("StandIn")) || RulePackages.IsEmpty();
+	if (!bStandIn && !Module.EnsureInitialized())
+	{
+		UE_LOG(LogVitruvioBenchmark, Warning, TEXT("PRT is not available, falling back to the stand-in generator"));
+		bStandIn = true;
+	}
+
+	if (bStandIn)
+	{
+		RulePackages.Empty();
+	}
+
+	TArray<FBenchmarkBatch> Batches = CreateBatches(CreateSyntheticCity(NumLots, Seed, RulePackages), BatchSize);
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("Running benchmark with %d lots in %d batches (seed %d, %s)"), NumLots, Batches.Num(), Seed,
+		   bStandIn ? TEXT("stand-in generator") : TEXT("PRT"));
+
+	TSharedRef<FJsonObject> PhasesObject = MakeShared<FJsonObject>();
+
+	// Keeps the varied attributes alive since initial shapes only hold weak references to them
+	TArray<TStrongObjectPtr<URuleAttribute>> Attributes;
+
+	if (!bStandIn)
+	{
+		TArray<TArray<FAttributeMapPtr>> EvaluatedAttributes;
+		EvaluatedAttributes.SetNum(Batches.Num());
+
+		PhasesObject->SetObjectField(TEXT("evaluate"), MeasurePhase(TEXT("Evaluate"), NumLots, [&]() {
+										 TArray<FAttributeMapsResult::FFutureType> Futures;
+										 for (const FBenchmarkBatch& Batch : Batches)
+										 {
+											 Futures.Add(MoveTemp(Module.BatchEvaluateRuleAttributesAsync(Batch.InitialShapes).Result));
+										 }
+										 for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+										 {
+											 EvaluatedAttributes[BatchIndex] = Futures[BatchIndex].Get().Value;
+										 }
+									 }));
+
+		if (AttributeVariation > 0)
+		{
+			FRandomStream Random(Seed);
+			for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+			{
+				TArray<FInitialShape>& InitialShapes = Batches[BatchIndex].InitialShapes;
+				for (int32 ShapeIndex = 0; ShapeIndex < InitialShapes.Num() && ShapeIndex < EvaluatedAttributes[BatchIndex].Num(); ++ShapeIndex)
+				{
+					const FAttributeMapPtr& AttributeMap = EvaluatedAttributes[BatchIndex][ShapeIndex];
+					if (!AttributeMap)
+					{
+						continue;
+					}
+
+					TMap<FString, URuleAttribute*> UnrealAttributes;
+					AttributeMap->UpdateUnrealAttributeMap(UnrealAttributes, GetTransientPackage());
+					for (const auto& [Name, Attribute] : UnrealAttributes)
+					{
+						if (UFloatAttribute* FloatAttribute = Cast<UFloatAttribute>(Attribute); FloatAttribute && !FloatAttribute->bHidden)
+						{
+							FloatAttribute->Value *= 1.0 + Random.FRandRange(-AttributeVariation, AttributeVariation);
+							FloatAttribute->bUserSet = true;
+						}
+						Attributes.Emplace(Attribute);
+						InitialShapes[ShapeIndex].Attributes.Add(Name, Attribute);
+					}
+				}
+			}
+		}
+	}
+
+	PhasesObject->SetObjectField(TEXT("generate"), MeasurePhase(TEXT("Generate"), NumLots, [&]() {
+									 if (bStandIn)
+									 {
+										 ParallelFor(Batches.Num(), [&Batches, StandInMaterials](int32 BatchIndex) {
+											 Batches[BatchIndex].GenerateResult = GenerateStandIn(Batches[BatchIndex].InitialShapes, StandInMaterials);
+										 });
+										 return;
+									 }
+
+									 TArray<FBatchGenerateResult::FFutureType> Futures;
+									 for (const FBenchmarkBatch& Batch : Batches)
+									 {
+										 Futures.Add(MoveTemp(Module.BatchGenerateAsync(Batch.InitialShapes, false, {}).Result));
+									 }
+									 for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+									 {
+										 Batches[BatchIndex].GenerateResult = Futures[BatchIndex].Get().Value;
+									 }
+								 }));
+
+	// Run the generate completed notifications which have been queued on the game thread
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+	UMaterial* OpaqueParent = LoadObject<UMaterial>(nullptr, TEXT("/Vitruvio/Materials/M_OpaqueParent.M_OpaqueParent"));
+	UMaterial* MaskedParent = LoadObject<UMaterial>(nullptr, TEXT("/Vitruvio/Materials/M_MaskedParent.M_MaskedParent"));
+	UMaterial* TranslucentParent = LoadObject<UMaterial>(nullptr, TEXT("/Vitruvio/Materials/M_TranslucentParent.M_TranslucentParent"));
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::None, false);
+
+	TMap<UMaterialInterface*, FString> MaterialIdentifiers;
+	TMap<FString, int32> UniqueMaterialIdentifiers;
+	TArray<FConvertedGenerateResult> ConvertedResults;
+	ConvertedResults.Reserve(Batches.Num());
+
+	PhasesObject->SetObjectField(TEXT("apply"), MeasurePhase(TEXT("Apply"), NumLots, [&]() {
+									 for (const FBenchmarkBatch& Batch : Batches)
+									 {
+										 ConvertedResults.Add(BuildGenerateResult(Batch.GenerateResult, Module.GetMaterialCache(), Module.GetTextureCache(),
+																				  MaterialIdentifiers, UniqueMaterialIdentifiers, OpaqueParent, MaskedParent,
+																				  TranslucentParent, World));
+									 }
+								 }));
+
+	int32 NumInstances = 0;
+	for (const FConvertedGenerateResult& ConvertedResult : ConvertedResults)
+	{
+		NumInstances += ConvertedResult.Instances.Num();
+	}
+
+	ConvertedResults.Empty();
+
+	// Materials are pruned together with the material cache, the table should be empty afterwards
+	const int32 NumUniqueMaterials = Vitruvio::GetNumInternedMaterials();
+	const int32 NumCachedMaterials = Module.GetMaterialCache().Num();
+	Module.EmptyMaterialCache();
+	const int32 NumMaterialsAfterPrune = Vitruvio::GetNumInternedMaterials();
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("Materials: %d interned, %d cached, %d interned after emptying the material cache"),
+		   NumUniqueMaterials, NumCachedMaterials, NumMaterialsAfterPrune);
+
+	TSharedPtr<FJsonObject> AsyncApplyObject;
+	if (AsyncApplyMeshes > 0)
+	{
+		AsyncApplyObject = MeasureAsyncApply(AsyncApplyMeshes, Seed, OpaqueParent, MaskedParent, TranslucentParent, World);
+	}
+
+	World->DestroyWorld(false);
+
+	TArray<TSharedPtr<FJsonValue>> RulePackageValues;
+	for (const URulePackage* RulePackage : RulePackages)
+	{
+		RulePackageValues.Add(MakeShared<FJsonValueString>(RulePackage->GetPathName()));
+	}
+
+	TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+	ResultObject->SetNumberField(TEXT("lots"), NumLots);
+	ResultObject->SetNumberField(TEXT("seed"), Seed);
+	ResultObject->SetNumberField(TEXT("batchSize"), BatchSize);
+	ResultObject->SetNumberField(TEXT("batches"), Batches.Num());
+	ResultObject->SetNumberField(TEXT("attributeVariation"), AttributeVariation);
+	ResultObject->SetBoolField(TEXT("standIn"), bStandIn);
+	ResultObject->SetArrayField(TEXT("rulePackages"), RulePackageValues);
+	ResultObject->SetNumberField(TEXT("instances"), NumInstances);
+	ResultObject->SetNumberField(TEXT("uniqueMaterials"), NumUniqueMaterials);
+	ResultObject->SetNumberField(TEXT("cachedMaterials"), NumCachedMaterials);
+	ResultObject->SetNumberField(TEXT("uniqueMaterialsAfterPrune"), NumMaterialsAfterPrune);
+	ResultObject->SetNumberField(TEXT("materialBlockedMs"), Module.GetApplyStats().MaterialBlockedTimeMs);
+	ResultObject->SetNumberField(TEXT("peakUsedPhysicalBytes"), static_cast<double>(FPlatformMemory::GetStats().PeakUsedPhysical));
+	ResultObject->SetObjectField(TEXT("phases"), PhasesObject);
+
+	if (AsyncApplyObject)
+	{
+		ResultObject->SetObjectField(TEXT("asyncApply"), AsyncApplyObject);
+	}
+
+	if (MeshTransferTriangles > 0)
+	{
+		if (Module.EnsureInitialized())
+		{
+			ResultObject->SetObjectField(TEXT("meshTransfer"), MeasureMeshTransfer(MeshTransferTriangles));
+		}
+		else
+		{
+			UE_LOG(LogVitruvioBenchmark, Warning, TEXT("PRT is not available, skipping the mesh transfer benchmark"));
+		}
+	}
+
+	if (TextureDecodeSize > 0)
+	{
+		ResultObject->SetObjectField(TEXT("textureDecode"), MeasureTextureDecode(TextureDecodeSize));
+	}
+
+	if (InstanceDiffCount > 0)
+	{
+		ResultObject->SetObjectField(TEXT("instanceDiff"), MeasureInstanceDiff(InstanceDiffCount));
+	}
+
+	if (FParse::Param(Parms, TEXT("VertexWeld")))
+	{
+		ResultObject->SetObjectField(TEXT("vertexWeld"), MeasureVertexWeld());
+	}
+
+	if (PolygonWindingEdges > 0)
+	{
+		ResultObject->SetObjectField(TEXT("polygonWinding"), MeasurePolygonWinding(PolygonWindingEdges));
+	}
+
+	if (InitialShapeRegistrations > 0)
+	{
+		ResultObject->SetObjectField(TEXT("initialShapeRegistration"), MeasureInitialShapeRegistration(InitialShapeRegistrations));
+	}
+
+	if (NeighborQueries > 0)
+	{
+		ResultObject->SetObjectField(TEXT("neighborQuery"), MeasureNeighborQuery(NeighborQueries));
+	}
+
+	if (SchedulerTasks > 0)
+	{
+		ResultObject->SetObjectField(TEXT("generateScheduler"), MeasureGenerateScheduler(SchedulerTasks));
+	}
+
+	if (GenerateCacheCopies > 0)
+	{
+		if (bStandIn)
+		{
+			UE_LOG(LogVitruvioBenchmark, Warning, TEXT("The generate cache benchmark requires PRT and rule packages, skipping it"));
+		}
+		else if (!Module.GetGenerateCacheStats().MemoryBudget)
+		{
+			UE_LOG(LogVitruvioBenchmark, Warning, TEXT("The generate cache is disabled, skipping the generate cache benchmark"));
+		}
+		else
+		{
+			ResultObject->SetObjectField(TEXT("generateCache"), MeasureGenerateCacheReuse(Batches, GenerateCacheCopies));
+		}
+	}
+
+	if (FParse::Param(Parms, TEXT("CompareAttributeEvaluation")))
+	{
+		if (bStandIn)
+		{
+			UE_LOG(LogVitruvioBenchmark, Warning, TEXT("The attribute evaluation benchmark requires PRT and rule packages, skipping it"));
+		}
+		else
+		{
+			ResultObject->SetObjectField(TEXT("attributeEvaluation"), MeasureAttributeEvaluation(Batches));
+		}
+	}
+
+	// Runs last since it drops all loaded rule packages and cached generate results
+	if (FParse::Param(Parms, TEXT("RpkLoad")))
+	{
+		if (bStandIn)
+		{
+			UE_LOG(LogVitruvioBenchmark, Warning, TEXT("The rule package load benchmark requires PRT and rule packages, skipping it"));
+		}
+		else
+		{
+			ResultObject->SetObjectField(TEXT("rpkLoad"), MeasureRpkLoad(Module, RulePackages));
+		}
+	}
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(ResultObject, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogVitruvioBenchmark, Error, TEXT("Could not write benchmark results to %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogVitruvioBenchmark, Display, TEXT("Wrote benchmark results to %s"), *OutputPath);
+	return 0;
+}
@@ -27,6 +27,7 @@
 #include "Editor/LevelEditor/Public/LevelEditor.h"
 #include "Editor/Transactor.h"
 #include "EngineUtils.h"
+#include "Framework/Application/SlateApplication.h"
 #include "Framework/Notifications/NotificationManager.h"
 #include "GenerateCompletedCallbackProxy.h"
 #include "IAssetTools.h"
@@ -245,6 +246,11 @@ void VitruvioEditorModule::ShutdownModule()
 	FEditorDelegates::EndPIE.Remove(EndPIEHandle);
 
 	FEditorDelegates::PostUndoRedo.Remove(PostUndoRedoDelegate);
+
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnApplicationActivationStateChanged().Remove(ApplicationActivationHandle);
+	}
 }
 
 void VitruvioEditorModule::BlockUntilGenerated() const
@@ -295,6 +301,14 @@ void VitruvioEditorModule::OnPostEngineInit()
 		}
 	});
 	// clang-format on
+
+	// Textures might have been edited in an external application while the editor was in the background
+	ApplicationActivationHandle = FSlateApplication::Get().OnApplicationActivationStateChanged().AddLambda([](bool bIsActive) {
+		if (bIsActive)
+		{
+			VitruvioModule::Get().InvalidateTextureCache();
+		}
+	});
 }
 
 void VitruvioEditorModule::OnMapChanged(UWorld* World, EMapChangeType ChangeType)
@@ -302,6 +316,8 @@ void VitruvioEditorModule::OnMapChanged(UWorld* World, EMapChangeType ChangeType
 	if (ChangeType == EMapChangeType::TearDownWorld)
 	{
 		VitruvioModule::Get().GetMeshCache().Empty();
+		VitruvioModule::Get().EmptyGenerateCache();
+		VitruvioModule::Get().EmptyMaterialCache();
 		VitruvioModule::Get().InvalidateAllOcclusionHandles();
 
 		// Close all open editor of transient meshes generated by Vitruvio to prevent GC issues while loading a new map
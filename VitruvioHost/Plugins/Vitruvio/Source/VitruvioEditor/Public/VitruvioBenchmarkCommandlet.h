@@ -0,0 +1,61 @@
+/* Copyright 2024 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "VitruvioBenchmarkCommandlet.generated.h"
+
+/**
+ * \brief Headless benchmark of the evaluate, generate and apply phases on a deterministic synthetic city.
+ *
+ * Usage: UnrealEditor-Cmd <Project> -run=VitruvioBenchmark -nullrhi [-Rpks=/Game/A.A,/Game/B.B] [-Lots=1000] [-Seed=0] [-BatchSize=256]
+ *        [-AttributeVariation=0.25] [-StandIn] [-StandInMaterials=5000] [-CountAllocations] [-MeshTransferTriangles=1000000]
+ *        [-TextureDecodeSize=4096] [-InstanceDiffCount=10000] [-VertexWeld]
+ *        [-PolygonWindingEdges=100000] [-InitialShapeRegistrations=50000] [-GenerateCacheCopies=3] [-AsyncApplyMeshes=1000]
+ *        [-NeighborQueries=50000] [-SchedulerTasks=10000] [-RpkLoad] [-CompareAttributeEvaluation] [-Output=<Path>.json]
+ *
+ * Without rule packages, or if the PRT runtime is not available (or -StandIn is given), lots are extruded by a stand-in generator instead
+ * of PRT so that the apply phase can still be measured. -StandInMaterials gives every stand-in lot one of that many distinct materials to
+ * measure material heavy models, with PRT a material heavy rule package is used instead. The number of interned materials is reported
+ * before and after emptying the material cache. -CountAllocations counts the allocations of every phase by routing GMalloc through a
+ * counting proxy, which slows down allocations, so the wall times are not comparable to runs without it. -MeshTransferTriangles
+ * additionally compares the encoder mesh formats (see RunMeshTransferBenchmark). -TextureDecodeSize measures texture decoding and opacity
+ * map classification throughput per pixel format (see RunTextureDecodeBenchmark), -TextureDecodeSize=4096 covers 4k RGBA opacity maps.
+ * -InstanceDiffCount measures applying a single attribute change to a model with that many instances (see RunInstanceDiffBenchmark).
+ * -VertexWeld compares welding static mesh initial shape vertices against the previous linear search for 1k, 10k and 100k vertices (see
+ * RunVertexWeldBenchmark). -PolygonWindingEdges measures and checks extracting faces and holes from a footprint with holes and nested
+ * islands (see RunPolygonWindingBenchmark). -InitialShapeRegistrations measures checking the validity of that many initial shapes and
+ * registering them with the batch subsystem (see RunInitialShapeRegistrationBenchmark). -NeighborQueries measures building, querying and
+ * updating the inter-occlusion neighbor index with that many lots (see RunNeighborQueryBenchmark). -GenerateCacheCopies regenerates the
+ * lots per initial shape as that many translated copies of the city and reports the generate cache hit rate of every pass.
+ * -AsyncApplyMeshes builds that many single lot models synchronously and through FGenerateResultBuilder with asynchronously built meshes
+ * and reports the game thread time of both. -SchedulerTasks submits that many interactive and batched tasks to a generate scheduler and
+ * reports the queue wait times per priority with and without the high priority burst limit (see RunGenerateSchedulerBenchmark). -RpkLoad
+ * loads the rule packages with an empty unpack cache and again from the unpack cache and reports the cold and warm load times.
+ * -CompareAttributeEvaluation generates the city with attribute evaluation in a separate pass and fused into the generate pass and reports
+ * the wall time of both.
+ */
+UCLASS()
+class UVitruvioBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVitruvioBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -46,4 +46,5 @@ private:
 	FDelegateHandle PostUndoRedoDelegate;
 	FDelegateHandle StartPIEHandle;
 	FDelegateHandle EndPIEHandle;
+	FDelegateHandle ApplicationActivationHandle;
 };
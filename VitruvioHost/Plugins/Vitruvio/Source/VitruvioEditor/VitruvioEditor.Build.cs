@@ -55,6 +55,7 @@ public class VitruvioEditor : ModuleRules
 				"Slate",
 				"AppFramework",
 				"UMGEditor",
+				"Json",
 				"Vitruvio",
 			}
 		);
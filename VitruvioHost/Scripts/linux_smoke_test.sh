@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# Copyright 2024 Esri
+#
+# Licensed under the Apache License Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Builds the host editor on Linux and runs the benchmark commandlet headless on a few stand-in lots. This checks that the plugin builds,
+# loads and applies models on Linux, also without the UnrealGeometryEncoder extension (in which case PRT stays uninitialized).
+#
+# Usage: UE_ROOT=<Engine install> linux_smoke_test.sh [Rpk asset paths for -Rpks=]
+
+set -euo pipefail
+
+: "${UE_ROOT:?UE_ROOT must point to the Unreal Engine installation}"
+
+HOST_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="${HOST_DIR}/VitruvioHost.uproject"
+OUTPUT="${HOST_DIR}/Saved/Vitruvio/LinuxSmokeTest.json"
+RPKS="${1:-}"
+
+"${UE_ROOT}/Engine/Build/BatchFiles/Linux/Build.sh" VitruvioHostEditor Linux Development -Project="${PROJECT}" -WaitMutex
+
+rm -f "${OUTPUT}"
+
+BENCHMARK_ARGS=(-run=VitruvioBenchmark -nullrhi -unattended -nopause -Lots=16 -BatchSize=4 -Output="${OUTPUT}")
+if [[ -n "${RPKS}" ]]; then
+	BENCHMARK_ARGS+=(-Rpks="${RPKS}")
+else
+	BENCHMARK_ARGS+=(-StandIn)
+fi
+
+"${UE_ROOT}/Engine/Binaries/Linux/UnrealEditor-Cmd" "${PROJECT}" "${BENCHMARK_ARGS[@]}"
+
+if [[ ! -s "${OUTPUT}" ]]; then
+	echo "The benchmark commandlet did not write ${OUTPUT}" >&2
+	exit 1
+fi
+
+echo "Linux smoke test passed, results in ${OUTPUT}"